@@ -71,7 +71,6 @@ public:
     versionString += "Fuzzy Control Language Library\n";
     versionString += "Version: " +  major + "." + minor + "." + mini + "\n";
     //versionString += "Build: " + buildDate + "Release: " + releaseDate;
-    cout << versionString;
     #ifdef DEBUG
     cout << versionString;
     #endif
@@ -12,13 +12,15 @@
 FCL_keyword* FuzzyControlClass::FindFCLKeywordFromMap ( string key, 
 							bool err = true ) {
 
-  if ( keywords.find(key) == keywords.end() ) {
+  map< string, FCL_keyword* >::const_iterator ki = keywords.find(key);
+
+  if ( ki == keywords.end() ) {
     if ( err ) {
       ErrMsg("Failed to find keyword in map" , key, -1);
     }
     return 0;
   }
-  return keywords[key];
+  return ki->second;
 }
 
 //--------------------------------------------------------------
@@ -0,0 +1,723 @@
+#include "FuzzyControl.h"
+#include "FCL_CAPI.h"
+#include "FuzzyInstances.h"
+
+//---------------------------------------------------------------------
+// struct FCL_Model
+//
+// Purpose: A parsed FCL file held as a SaveModel() image, contexts
+//          are loaded from it. The variable names are kept so that
+//          FCL_ModelInputName() returns a pointer without a copy.
+//---------------------------------------------------------------------
+struct FCL_Model {
+  string           FCLFileName;
+  string           image;
+  vector< string > inputNames;  // VAR_INPUT declaration order
+  vector< string > outputNames; // VAR_OUTPUT declaration order
+  vector< string > termNames;   // input terms, GetMemberships() order
+  vector< int >    termInputs;  // input handle of each input term
+  vector< string > ruleNames;   // GetRuleStrengths() order
+};
+
+//---------------------------------------------------------------------
+// struct FCL_Context
+//
+// Purpose: The evaluation state of one caller, a FuzzyControlClass
+//          loaded from the model image
+//---------------------------------------------------------------------
+struct FCL_Context {
+  FuzzyControlClass* lpFC;
+  int                nInputs;
+  int                nOutputs;
+};
+
+//---------------------------------------------------------------------
+// struct FCL_Instances
+//
+// Purpose: A FuzzyControlClass loaded from the model image and the
+//          FuzzyInstancesClass that evaluates it for the instances
+//---------------------------------------------------------------------
+struct FCL_Instances {
+  FuzzyControlClass*   lpFC;
+  FuzzyInstancesClass* lpInstances;
+};
+
+//--------------------------------------------------------------
+// CAPIException
+//
+// Purpose: Report a C++ exception caught by an entry point, none
+//          reaches the C caller
+//
+// Arguments: function : the entry point
+//
+// Return: status of the entry point, -1
+//--------------------------------------------------------------
+static int CAPIException( const char* function ) {
+
+  int status = -1;
+  ErrMsg( function, "Failed with a C++ exception", status );
+  return status;
+}
+
+//--------------------------------------------------------------
+// FCL_ModelLoad
+//
+// Purpose: Read and parse an FCL file into a new model
+//
+// Arguments: FCLFile : FCL file name
+//            model   : set to the new model, 0 on failure
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_ModelLoad( const char* FCLFile, FCL_Model** model ) {
+
+  int status = 0;
+
+  if ( not FCLFile or not model ) {
+    status = -1;
+    ErrMsg( "FCL_ModelLoad()", "Invalid argument", status );
+    return status;
+  }
+  *model = 0;
+
+  FCL_Model* lpModel = 0;
+  try {
+    lpModel = new FCL_Model;
+    lpModel->FCLFileName = FCLFile;
+
+    FuzzyControlClass parser( lpModel->FCLFileName, "", "" );
+
+    status = FuzzyControl_ReadFCL( &parser );
+    if ( status == 0 and ( parser.InputVariablesVector().empty() or
+			   parser.OutputVariablesVector().empty() ) ) {
+      status = -1;
+      ErrMsg( "FCL_ModelLoad() FCL file has no inputs or outputs",
+	      lpModel->FCLFileName, status );
+    }
+    if ( status == 0 ) {
+      status = parser.SaveModel( &(lpModel->image) );
+    }
+    if ( status == 0 ) {
+      vector< FuzzyInputClass* >  &inputs  = parser.InputVariablesVector();
+      vector< FuzzyOutputClass* > &outputs = parser.OutputVariablesVector();
+      for ( unsigned int i = 0; i < inputs.size(); i++ ) {
+	lpModel->inputNames.push_back( inputs[i]->varName );
+      }
+      for ( unsigned int i = 0; i < outputs.size(); i++ ) {
+	lpModel->outputNames.push_back( outputs[i]->varName );
+      }
+      for ( unsigned int i = 0; i < inputs.size(); i++ ) {
+	map< string, FuzzyInputTerm* >::const_iterator fti;
+	for ( fti = inputs[i]->InputTerms.begin(); 
+	      fti != inputs[i]->InputTerms.end(); ++fti ) {
+	  lpModel->termNames.push_back( fti->first );
+	  lpModel->termInputs.push_back( i );
+	}
+      }
+      const map< string, FuzzyRuleClass* > &rules = parser.RulesMap();
+      map< string, FuzzyRuleClass* >::const_iterator fri;
+      for ( fri = rules.begin(); fri != rules.end(); ++fri ) {
+	lpModel->ruleNames.push_back( fri->first );
+      }
+    }
+  }
+  catch ( ... ) {
+    status = CAPIException( "FCL_ModelLoad()" );
+  }
+
+  if ( status != 0 ) {
+    ErrMsg( "FCL_ModelLoad() Failed to load", FCLFile, status );
+    delete lpModel;
+    return status;
+  }
+
+  *model = lpModel;
+  return status;
+}
+
+//--------------------------------------------------------------
+// FCL_ModelDestroy
+//
+// Purpose: Delete a model, its contexts remain valid
+//
+// Arguments: model
+//
+// Return:
+//--------------------------------------------------------------
+void FCL_ModelDestroy( FCL_Model* model ) {
+
+  delete model;
+}
+
+//--------------------------------------------------------------
+// FCL_ModelNumInputs, FCL_ModelNumOutputs
+//
+// Purpose: Number of input, output variables of the model
+//
+// Arguments: model
+//
+// Return: number of variables, -1 if model is 0
+//--------------------------------------------------------------
+int FCL_ModelNumInputs( const FCL_Model* model ) {
+
+  return model ? (int) model->inputNames.size() : -1;
+}
+
+int FCL_ModelNumOutputs( const FCL_Model* model ) {
+
+  return model ? (int) model->outputNames.size() : -1;
+}
+
+//--------------------------------------------------------------
+// FCL_ModelInputName, FCL_ModelOutputName
+//
+// Purpose: Name of an input, output variable, valid until the
+//          model is destroyed
+//
+// Arguments: model
+//            i : index in declaration order
+//
+// Return: variable name, 0 if i is out of range
+//--------------------------------------------------------------
+const char* FCL_ModelInputName( const FCL_Model* model, int i ) {
+
+  if ( not model or i < 0 or i >= (int) model->inputNames.size() ) {
+    return 0;
+  }
+  return model->inputNames[i].c_str();
+}
+
+const char* FCL_ModelOutputName( const FCL_Model* model, int i ) {
+
+  if ( not model or i < 0 or i >= (int) model->outputNames.size() ) {
+    return 0;
+  }
+  return model->outputNames[i].c_str();
+}
+
+//--------------------------------------------------------------
+// FCL_ModelInputHandle, FCL_ModelOutputHandle
+//
+// Purpose: Resolve a variable name to the handle used by
+//          FCL_SetInput() and FCL_GetOutput()
+//
+// Arguments: model
+//            name : input, output variable name
+//
+// Return: handle, index in declaration order, -1 if not found
+//--------------------------------------------------------------
+int FCL_ModelInputHandle( const FCL_Model* model, const char* name ) {
+
+  if ( not model or not name ) {
+    return -1;
+  }
+  for ( unsigned int i = 0; i < model->inputNames.size(); i++ ) {
+    if ( model->inputNames[i] == name ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int FCL_ModelOutputHandle( const FCL_Model* model, const char* name ) {
+
+  if ( not model or not name ) {
+    return -1;
+  }
+  for ( unsigned int i = 0; i < model->outputNames.size(); i++ ) {
+    if ( model->outputNames[i] == name ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+//--------------------------------------------------------------
+// FCL_ModelNumInputTerms, FCL_ModelInputTermName, 
+// FCL_ModelInputTermInput
+//
+// Purpose: The input terms in FCL_GetMemberships() order
+//
+// Arguments: model
+//            i : index in FCL_GetMemberships() order
+//
+// Return: number of terms, term name (0 if i is out of range),
+//         input handle of the term (-1 if i is out of range)
+//--------------------------------------------------------------
+int FCL_ModelNumInputTerms( const FCL_Model* model ) {
+
+  return model ? (int) model->termNames.size() : -1;
+}
+
+const char* FCL_ModelInputTermName( const FCL_Model* model, int i ) {
+
+  if ( not model or i < 0 or i >= (int) model->termNames.size() ) {
+    return 0;
+  }
+  return model->termNames[i].c_str();
+}
+
+int FCL_ModelInputTermInput( const FCL_Model* model, int i ) {
+
+  if ( not model or i < 0 or i >= (int) model->termInputs.size() ) {
+    return -1;
+  }
+  return model->termInputs[i];
+}
+
+//--------------------------------------------------------------
+// FCL_ModelNumRules, FCL_ModelRuleName
+//
+// Purpose: The rules in FCL_GetRuleStrengths() order
+//
+// Arguments: model
+//            i : index in FCL_GetRuleStrengths() order
+//
+// Return: number of rules, rule name (0 if i is out of range)
+//--------------------------------------------------------------
+int FCL_ModelNumRules( const FCL_Model* model ) {
+
+  return model ? (int) model->ruleNames.size() : -1;
+}
+
+const char* FCL_ModelRuleName( const FCL_Model* model, int i ) {
+
+  if ( not model or i < 0 or i >= (int) model->ruleNames.size() ) {
+    return 0;
+  }
+  return model->ruleNames[i].c_str();
+}
+
+//--------------------------------------------------------------
+// FCL_ContextCreate
+//
+// Purpose: Create an evaluation context from a model
+//
+// Arguments: model
+//            context : set to the new context, 0 on failure
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_ContextCreate( const FCL_Model* model, FCL_Context** context ) {
+
+  int status = 0;
+
+  if ( not model or not context ) {
+    status = -1;
+    ErrMsg( "FCL_ContextCreate()", "Invalid argument", status );
+    return status;
+  }
+  *context = 0;
+
+  FCL_Context* lpContext = 0;
+  try {
+    lpContext       = new FCL_Context();
+    lpContext->lpFC = new FuzzyControlClass( model->FCLFileName, "", "" );
+    status = lpContext->lpFC->LoadModel( model->image.data(),
+					 model->image.size() );
+    lpContext->nInputs  = lpContext->lpFC->NumInputs();
+    lpContext->nOutputs = lpContext->lpFC->NumOutputs();
+  }
+  catch ( ... ) {
+    status = CAPIException( "FCL_ContextCreate()" );
+  }
+
+  if ( status != 0 ) {
+    ErrMsg( "FCL_ContextCreate() Failed to load", model->FCLFileName,
+	    status );
+    FCL_ContextDestroy( lpContext );
+    return status;
+  }
+
+  *context = lpContext;
+  return status;
+}
+
+//--------------------------------------------------------------
+// FCL_ContextDestroy
+//
+// Purpose: Delete a context
+//
+// Arguments: context
+//
+// Return:
+//--------------------------------------------------------------
+void FCL_ContextDestroy( FCL_Context* context ) {
+
+  if ( not context ) {
+    return;
+  }
+  delete context->lpFC;
+  delete context;
+}
+
+//--------------------------------------------------------------
+// FCL_SetInputs
+//
+// Purpose: Fuzzify the input values
+//
+// Arguments: context
+//            inputs : NumInputs() values in declaration order
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_SetInputs( FCL_Context* context, const double* inputs ) {
+
+  if ( not context or not inputs ) {
+    return -1;
+  }
+  try {
+    return context->lpFC->SetInputs( inputs );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_SetInputs()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_Evaluate
+//
+// Purpose: Evaluate the rules on the fuzzified inputs
+//
+// Arguments: context
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_Evaluate( FCL_Context* context ) {
+
+  if ( not context ) {
+    return -1;
+  }
+  try {
+    return context->lpFC->Evaluate();
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_Evaluate()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_GetOutputs
+//
+// Purpose: Copy the defuzzified outputs
+//
+// Arguments: context
+//            outputs : NumOutputs() values in declaration order
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_GetOutputs( FCL_Context* context, double* outputs ) {
+
+  if ( not context or not outputs ) {
+    return -1;
+  }
+  try {
+    return context->lpFC->GetOutputs( outputs );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_GetOutputs()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_SetInput
+//
+// Purpose: Fuzzify one input value
+//
+// Arguments: context
+//            handle : from FCL_ModelInputHandle()
+//            input
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_SetInput( FCL_Context* context, int handle, double input ) {
+
+  if ( not context ) {
+    return -1;
+  }
+  try {
+    return context->lpFC->SetInput( handle, input );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_SetInput()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_GetOutput
+//
+// Purpose: Copy one defuzzified output
+//
+// Arguments: context
+//            handle : from FCL_ModelOutputHandle()
+//            output : set to the output value
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_GetOutput( FCL_Context* context, int handle, double* output ) {
+
+  if ( not context or not output ) {
+    return -1;
+  }
+  try {
+    return context->lpFC->GetOutput( handle, output );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_GetOutput()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_EvaluateBatch
+//
+// Purpose: Evaluate nPoints input rows in order
+//
+// Arguments: context
+//            nPoints : number of rows
+//            inputs  : nPoints rows of NumInputs() values
+//            outputs : nPoints rows of NumOutputs() values
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_EvaluateBatch( FCL_Context* context, int nPoints,
+		       const double* inputs, double* outputs ) {
+
+  if ( not context or nPoints < 0 or
+       ( nPoints and ( not inputs or not outputs ) ) ) {
+    return -1;
+  }
+  try {
+    return FuzzyControl_EvaluateBatch( context->lpFC, nPoints,
+				       inputs, outputs );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_EvaluateBatch()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_EvaluateJacobian
+//
+// Purpose: Evaluate one input row and the derivatives of the
+//          outputs with respect to the inputs
+//
+// Arguments: context
+//            inputs   : NumInputs() values
+//            outputs  : NumOutputs() values, 0 if not needed
+//            jacobian : NumOutputs() rows of NumInputs() values
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_EvaluateJacobian( FCL_Context* context, const double* inputs,
+			  double* outputs, double* jacobian ) {
+
+  if ( not context or not inputs or not jacobian ) {
+    return -1;
+  }
+  try {
+    return FuzzyControl_Jacobian( context->lpFC, inputs, outputs, jacobian );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_EvaluateJacobian()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_GetMemberships
+//
+// Purpose: Copy the input term memberships of the last SetInputs()
+//
+// Arguments: context
+//            memberships : FCL_ModelNumInputTerms() values
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_GetMemberships( const FCL_Context* context, double* memberships ) {
+
+  if ( not context or not memberships ) {
+    return -1;
+  }
+  try {
+    return context->lpFC->GetMemberships( memberships );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_GetMemberships()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_GetRuleStrengths
+//
+// Purpose: Copy the rule strengths of the last Evaluate()
+//
+// Arguments: context
+//            strengths : FCL_ModelNumRules() values
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_GetRuleStrengths( const FCL_Context* context, double* strengths ) {
+
+  if ( not context or not strengths ) {
+    return -1;
+  }
+  try {
+    return context->lpFC->GetRuleStrengths( strengths );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_GetRuleStrengths()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_SetInputTermPoints, FCL_SetOutputTermPoints
+//
+// Purpose: Move the breakpoints of a term of the context
+//
+// Arguments: context
+//            handle   : input or output handle
+//            termName : TERM of the variable
+//            x, y     : nPoints new points
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_SetInputTermPoints( FCL_Context* context, int handle,
+			    const char* termName, const double* x,
+			    const double* y, int nPoints ) {
+
+  if ( not context or not termName or not x or not y ) {
+    return -1;
+  }
+  try {
+    return context->lpFC->SetInputTermPoints( handle, termName, 
+					      x, y, nPoints );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_SetInputTermPoints()" );
+  }
+}
+
+int FCL_SetOutputTermPoints( FCL_Context* context, int handle,
+			     const char* termName, const double* x,
+			     const double* y, int nPoints ) {
+
+  if ( not context or not termName or not x or not y ) {
+    return -1;
+  }
+  try {
+    return context->lpFC->SetOutputTermPoints( handle, termName, 
+					       x, y, nPoints );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_SetOutputTermPoints()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_InstancesCreate
+//
+// Purpose: Create the instance evaluation of a model
+//
+// Arguments: model
+//            instances : set to the new instances, 0 on failure
+//
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FCL_InstancesCreate( const FCL_Model* model, FCL_Instances** instances ) {
+
+  int status = 0;
+
+  if ( not model or not instances ) {
+    status = -1;
+    ErrMsg( "FCL_InstancesCreate()", "Invalid argument", status );
+    return status;
+  }
+  *instances = 0;
+
+  FCL_Instances* lpInstances = 0;
+  try {
+    lpInstances       = new FCL_Instances();
+    lpInstances->lpFC = new FuzzyControlClass( model->FCLFileName, "", "" );
+    status = lpInstances->lpFC->LoadModel( model->image.data(),
+					   model->image.size() );
+    if ( status == 0 ) {
+      lpInstances->lpInstances = 
+	new FuzzyInstancesClass( lpInstances->lpFC );
+    }
+  }
+  catch ( ... ) {
+    status = CAPIException( "FCL_InstancesCreate()" );
+  }
+
+  if ( status != 0 ) {
+    ErrMsg( "FCL_InstancesCreate() Failed to load", model->FCLFileName,
+	    status );
+    FCL_InstancesDestroy( lpInstances );
+    return status;
+  }
+
+  *instances = lpInstances;
+  return status;
+}
+
+//--------------------------------------------------------------
+// FCL_InstancesDestroy
+//
+// Purpose: Delete an instance evaluation, the instance arrays
+//          belong to the caller
+//
+// Arguments: instances
+//
+// Return:
+//--------------------------------------------------------------
+void FCL_InstancesDestroy( FCL_Instances* instances ) {
+
+  if ( not instances ) {
+    return;
+  }
+  delete instances->lpInstances;
+  delete instances->lpFC;
+  delete instances;
+}
+
+//--------------------------------------------------------------
+// FCL_InstancesEvaluate
+//
+// Purpose: Evaluate the model for each instance
+//
+// Arguments: instances
+//            nInstances : number of instances
+//            inputs     : NumInputs() arrays of nInstances values
+//            outputs    : NumOutputs() arrays of nInstances values,
+//                         the previous outputs, replaced
+//
+// Return: status, 0 = OK, nonzero = ERR or an instance failed
+//--------------------------------------------------------------
+int FCL_InstancesEvaluate( FCL_Instances* instances, long nInstances,
+			   const double* const* inputs,
+			   double* const* outputs ) {
+
+  if ( not instances or not inputs or not outputs ) {
+    return -1;
+  }
+  try {
+    return instances->lpInstances->Evaluate( nInstances, inputs, outputs );
+  }
+  catch ( ... ) {
+    return CAPIException( "FCL_InstancesEvaluate()" );
+  }
+}
+
+//--------------------------------------------------------------
+// FCL_InstancesNumFailed
+//
+// Purpose: Number of instances that failed in the last
+//          FCL_InstancesEvaluate()
+//
+// Arguments: instances
+//
+// Return: number of instances, -1 if instances is 0
+//--------------------------------------------------------------
+long FCL_InstancesNumFailed( const FCL_Instances* instances ) {
+
+  return instances ? instances->lpInstances->NumFailed() : -1;
+}
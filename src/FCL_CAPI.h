@@ -0,0 +1,96 @@
+#ifndef FCL_CAPI_H
+#define FCL_CAPI_H
+
+//---------------------------------------------------------------------
+// libfcl.so C interface
+//
+// An FCL_Model is a parsed FCL file, it is read only once loaded and
+// may be shared by threads. An FCL_Context is an evaluation state
+// created from a model, one per thread. Inputs and outputs are arrays
+// of double in VAR_INPUT and VAR_OUTPUT declaration order, owned by
+// the caller, a variable handle is its index in that order. The
+// evaluation functions do not allocate once a context has evaluated
+// every rule term.
+//
+// All functions return 0 = OK, nonzero = ERR, unless noted.
+//---------------------------------------------------------------------
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FCL_Model   FCL_Model;
+typedef struct FCL_Context FCL_Context;
+typedef struct FCL_Instances FCL_Instances;
+
+// Model
+int         FCL_ModelLoad      ( const char* FCLFile, FCL_Model** model );
+void        FCL_ModelDestroy   ( FCL_Model* model );
+int         FCL_ModelNumInputs ( const FCL_Model* model );
+int         FCL_ModelNumOutputs( const FCL_Model* model );
+// name of input or output i, 0 if i is out of range
+const char* FCL_ModelInputName ( const FCL_Model* model, int i );
+const char* FCL_ModelOutputName( const FCL_Model* model, int i );
+// handle, the index of a variable by name, -1 if not found
+int         FCL_ModelInputHandle ( const FCL_Model* model, const char* name );
+int         FCL_ModelOutputHandle( const FCL_Model* model, const char* name );
+// input terms, the GetMemberships() order, and rules, the
+// GetRuleStrengths() order. InputTermInput() is the input handle of
+// term i, -1 if i is out of range.
+int         FCL_ModelNumInputTerms( const FCL_Model* model );
+const char* FCL_ModelInputTermName( const FCL_Model* model, int i );
+int         FCL_ModelInputTermInput( const FCL_Model* model, int i );
+int         FCL_ModelNumRules     ( const FCL_Model* model );
+const char* FCL_ModelRuleName     ( const FCL_Model* model, int i );
+
+// Context
+int  FCL_ContextCreate ( const FCL_Model* model, FCL_Context** context );
+void FCL_ContextDestroy( FCL_Context* context );
+
+// Evaluation
+int FCL_SetInputs    ( FCL_Context* context, const double* inputs );
+int FCL_Evaluate     ( FCL_Context* context );
+int FCL_GetOutputs   ( FCL_Context* context, double* outputs );
+int FCL_SetInput     ( FCL_Context* context, int handle, double input );
+int FCL_GetOutput    ( FCL_Context* context, int handle, double* output );
+// nPoints rows of NumInputs() values into nPoints rows of NumOutputs()
+int FCL_EvaluateBatch( FCL_Context* context, int nPoints,
+		       const double* inputs, double* outputs );
+// Evaluate one row, and d outputs[k] / d inputs[j] into jacobian, 
+// NumOutputs() rows of NumInputs() values. outputs may be 0.
+int FCL_EvaluateJacobian( FCL_Context* context, const double* inputs,
+			  double* outputs, double* jacobian );
+
+// Move the nPoints breakpoints of a term of this context, the term
+// type must not change
+int FCL_SetInputTermPoints ( FCL_Context* context, int handle, 
+			     const char* termName, const double* x,
+			     const double* y, int nPoints );
+int FCL_SetOutputTermPoints( FCL_Context* context, int handle, 
+			     const char* termName, const double* x,
+			     const double* y, int nPoints );
+
+// Sampling, NumInputTerms() memberships and NumRules() strengths
+int FCL_GetMemberships  ( const FCL_Context* context, double* memberships );
+int FCL_GetRuleStrengths( const FCL_Context* context, double* strengths );
+
+// Instances, the model evaluated for nInstances independent states
+// held by the caller as an array per variable: inputs[handle][i] and
+// outputs[handle][i]. outputs holds the previous outputs, the value
+// of an NC output when no rule fires, and is replaced. An instance
+// that fails keeps its previous outputs. The instances are spread
+// over FCL_THREADS threads.
+int  FCL_InstancesCreate   ( const FCL_Model* model, 
+			     FCL_Instances** instances );
+void FCL_InstancesDestroy  ( FCL_Instances* instances );
+int  FCL_InstancesEvaluate ( FCL_Instances* instances, long nInstances,
+			     const double* const* inputs,
+			     double* const* outputs );
+// number of instances that failed in the last FCL_InstancesEvaluate()
+long FCL_InstancesNumFailed( const FCL_Instances* instances );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,4 +1,5 @@
 #include "FuzzyControl.h"
+#include <sstream> // ostringstream
 
 //------------------------------------------------------------
 // ReadFCLFile
@@ -69,6 +70,283 @@ int FuzzyControlClass::ReadFCLFile() {
   return 0;
 }
 
+//------------------------------------------------------------
+// FCLNumbers
+//
+// Purpose: The numbers of a TERM value or of the WITH weights of
+//          a THEN part, for WriteFCLFile() to keep unchanged text
+//
+// Arguments: text    : TERM value text, or THEN part
+//            weights : true to read the number after each WITH of
+//                      a THEN part, 1 for a conclusion without one
+//
+// Return: numbers
+//------------------------------------------------------------
+static vector< double > FCLNumbers( const string& text, bool weights ) {
+
+  vector< double > numbers;
+
+  if ( weights ) {
+    string::size_type begin = 0;
+    while ( begin <= text.length() ) {
+      string::size_type end  = text.find( ',', begin );
+      string conclusion      = text.substr( begin, end == string::npos ?
+					    string::npos : end - begin );
+      string::size_type with = conclusion.find( "WITH" );
+      numbers.push_back( with == string::npos ? 1. :
+			 atof( conclusion.c_str() + with + 4 ) );
+      if ( end == string::npos ) break;
+      begin = end + 1;
+    }
+    return numbers;
+  }
+
+  const char* lpText = text.c_str();
+  while ( *lpText ) {
+    char* lpEnd = 0;
+    double number = strtod( lpText, &lpEnd );
+    if ( lpEnd != lpText ) {
+      numbers.push_back( number );
+      lpText = lpEnd;
+    }
+    else {
+      lpText++;
+    }
+  }
+  return numbers;
+}
+
+//------------------------------------------------------------
+// WriteFCLFile
+//
+// Purpose: Write the FCL file with the current term points and
+//          WITH weights of the model, for a model changed by
+//          SetInputTermPoints(), SetRuleWeight() or FuzzyTuneClass.
+//          The FCL file is copied line by line, comments included.
+//          The value of a TERM and the THEN part of a RULE whose
+//          values changed are written from the model. A RULE that
+//          is not in the model, or of another FUNCTION_BLOCK, is
+//          copied.
+//
+// Arguments: fileName : FCL file to write
+//
+// Return: status
+//------------------------------------------------------------
+int FuzzyControlClass::WriteFCLFile( string *fileName ) {
+
+  ifstream inStream;
+  ofstream outStream;
+  string   line;
+  string   lineEnd;
+  string   varName;        // variable of the FUZZIFY/DEFUZZIFY block
+  bool     isInput = false;
+  bool     inBlock = true; // in the FUNCTION_BLOCK of the model
+
+  const string& whitespace = " \t\r\n";
+
+  inStream.open( FCLFileName.c_str(), ios::in );
+  if ( not inStream ) {
+    ErrMsg( "WriteFCLFile() Failed to open file:", FCLFileName, -1 );
+    return -1;
+  }
+  outStream.open( fileName->c_str(), ios::out );
+  if ( not outStream ) {
+    ErrMsg( "WriteFCLFile() Failed to open file:", *fileName, -1 );
+    return -1;
+  }
+
+  while ( getline( inStream, line ) ) {
+
+    // Keep the line end of the file
+    lineEnd = "\n";
+    if ( line.length() and line[ line.length() - 1 ] == '\r' ) {
+      line.erase( line.length() - 1 );
+      lineEnd = "\r\n";
+    }
+
+    string::size_type first = line.find_first_not_of( whitespace );
+    if ( first == string::npos or CommentLine( &line ) ) {
+      outStream << line << lineEnd;
+      continue;
+    }
+    string::size_type firstEnd = line.find_first_of( whitespace + ":", 
+						     first );
+    string word = line.substr( first, firstEnd == string::npos ? 
+			       string::npos : firstEnd - first );
+    string secondWord;
+    if ( firstEnd != string::npos ) {
+      string::size_type second = line.find_first_not_of( whitespace, 
+							 firstEnd );
+      if ( second != string::npos ) {
+	string::size_type secondEnd = line.find_first_of( whitespace + ";", 
+							  second );
+	secondWord = line.substr( second, secondEnd == string::npos ?
+				  string::npos : secondEnd - second );
+      }
+    }
+
+    if ( word == "FUNCTION_BLOCK" ) {
+      inBlock = functionBlockName.empty() or secondWord == functionBlockName;
+    }
+    else if ( word == "FUZZIFY" or word == "DEFUZZIFY" ) {
+      isInput = ( word == "FUZZIFY" );
+      varName = secondWord;
+    }
+    else if ( word == "END_FUZZIFY" or word == "END_DEFUZZIFY" ) {
+      varName.clear();
+    }
+    else if ( inBlock and word == "TERM" and varName.length() ) {
+      //--------------------------------------------------------
+      // TERM name := (x, y) ... ; the points from the model
+      string::size_type assign    = line.find( ":=" );
+      string::size_type semicolon = line.find( ';' );
+      if ( assign != string::npos and semicolon != string::npos and
+	   semicolon > assign ) {
+	string termName = line.substr( firstEnd, assign - firstEnd );
+	termName.erase( 0, termName.find_first_not_of( whitespace ) );
+	termName.erase( termName.find_last_not_of( whitespace ) + 1 );
+
+	vector< XY* >*   lpXY = 0;
+	vector< double > values;
+	if ( isInput and InputVariables.count( varName ) and
+	     InputVariables[ varName ]->InputTerms.count( termName ) ) {
+	  lpXY = &( InputVariables[ varName ]->InputTerms[ termName ]->xy );
+	}
+	else if ( not isInput and OutputVariables.count( varName ) and
+		  OutputVariables[ varName ]->OutputTerms.count( termName ) ) {
+	  FuzzyOutputTerm* fot = 
+	    OutputVariables[ varName ]->OutputTerms[ termName ];
+	  if ( fot->termType == Singleton ) {
+	    values.push_back( fot->singleton.x );
+	  }
+	  else {
+	    lpXY = &( fot->xy );
+	  }
+	}
+	for ( unsigned int i = 0; lpXY and i < lpXY->size(); i++ ) {
+	  values.push_back( (*lpXY)[i]->x );
+	  values.push_back( (*lpXY)[i]->y );
+	}
+
+	if ( values.size() and values != 
+	     FCLNumbers( line.substr( assign + 2, semicolon - assign - 2 ),
+			 false ) ) {
+	  ostringstream points;
+	  points.precision( 10 );
+	  if ( lpXY ) {
+	    for ( unsigned int i = 0; i < values.size(); i += 2 ) {
+	      points << ( i ? " (" : "(" ) << values[i] << ", " 
+		     << values[i+1] << ")";
+	    }
+	  }
+	  else {
+	    points << values[0];
+	  }
+	  outStream << line.substr( 0, assign + 2 ) << " " << points.str() 
+		    << line.substr( semicolon ) << lineEnd;
+	  continue;
+	}
+      }
+    }
+    else if ( inBlock and word == "RULE" ) {
+      //--------------------------------------------------------
+      // RULE name : IF ... THEN var IS term [WITH w], ... ;
+      // the THEN part from the model
+      string::size_type colon = line.find( ':', firstEnd );
+      string ruleName;
+      if ( colon != string::npos ) {
+	ruleName = line.substr( firstEnd, colon - firstEnd );
+	ruleName.erase( 0, ruleName.find_first_not_of( whitespace ) );
+	ruleName.erase( ruleName.find_last_not_of( whitespace ) + 1 );
+      }
+      map< string, FuzzyRuleClass* >::iterator fri = Rules.find( ruleName );
+      if ( fri == Rules.end() ) {
+	outStream << line << lineEnd;
+	continue;
+      }
+
+      // The lines of the RULE, up to the ';'
+      vector< string > ruleLines( 1, line );
+      vector< string > ruleLineEnds( 1, lineEnd );
+      while ( line.find( ';' ) == string::npos and 
+	      getline( inStream, line ) ) {
+	lineEnd = "\n";
+	if ( line.length() and line[ line.length() - 1 ] == '\r' ) {
+	  line.erase( line.length() - 1 );
+	  lineEnd = "\r\n";
+	}
+	ruleLines.push_back( line );
+	ruleLineEnds.push_back( lineEnd );
+      }
+
+      // The line with THEN, and the THEN part
+      unsigned int thenLine = 0;
+      string::size_type then = string::npos;
+      string thenPart;
+      for ( unsigned int i = 0; i < ruleLines.size(); i++ ) {
+	if ( then == string::npos ) {
+	  then = ruleLines[i].find( "THEN" );
+	  thenLine = i;
+	  if ( then != string::npos ) {
+	    thenPart = ruleLines[i].substr( then + 4 );
+	  }
+	}
+	else {
+	  thenPart += " " + ruleLines[i];
+	}
+      }
+      thenPart = thenPart.substr( 0, thenPart.find( ';' ) );
+
+      FuzzyRuleClass*  lpFRC = fri->second;
+      vector< double > weights;
+      for ( unsigned int i = 0; i < lpFRC->Conclusions.size(); i++ ) {
+	weights.push_back( lpFRC->Conclusions[i]->weight );
+      }
+
+      if ( then == string::npos or weights == FCLNumbers( thenPart, true ) ) {
+	for ( unsigned int i = 0; i < ruleLines.size(); i++ ) {
+	  outStream << ruleLines[i] << ruleLineEnds[i];
+	}
+	continue;
+      }
+
+      // Copy the lines up to THEN, and the text after the ';'
+      ostringstream conclusions;
+      conclusions.precision( 10 );
+      for ( unsigned int i = 0; i < lpFRC->Conclusions.size(); i++ ) {
+	Conclusion* lpConc = lpFRC->Conclusions[i];
+	conclusions << ( i ? ", " : "" ) 
+		    << lpConc->outputVariable->varName << " IS "
+		    << lpConc->outputDefuzzify->termName;
+	if ( lpConc->weight != 1. ) {
+	  conclusions << " WITH " << lpConc->weight;
+	}
+      }
+      for ( unsigned int i = 0; i < thenLine; i++ ) {
+	outStream << ruleLines[i] << ruleLineEnds[i];
+      }
+      string lastLine = ruleLines.back();
+      string::size_type semicolon = lastLine.find( ';' );
+      outStream << ruleLines[ thenLine ].substr( 0, then ) << "THEN "
+		<< conclusions.str() << ";" 
+		<< ( semicolon == string::npos ? 
+		     string() : lastLine.substr( semicolon + 1 ) )
+		<< ruleLineEnds.back();
+      continue;
+    }
+
+    outStream << line << lineEnd;
+  }
+
+  inStream.close();
+  outStream.close();
+  if ( not outStream ) {
+    ErrMsg( "WriteFCLFile() Failed to write file:", *fileName, -1 );
+    return -1;
+  }
+  return 0;
+}
+
 //------------------------------------------------------------
 // ReadInputDataFile
 //
@@ -95,6 +373,25 @@ int FuzzyControlClass::ReadFCLFile() {
 //------------------------------------------------------------
 int FuzzyControlClass::ReadInputDataFile( string *fileName ) {
 
+  return ReadInputDataColumns( fileName, 0 );
+}
+
+//------------------------------------------------------------
+// ReadInputDataColumns
+//
+// Purpose: ReadInputDataFile() of the named columns instead of
+//          the VAR_INPUT variables, for readers of the input data
+//          file format that are not a single model
+//
+// Arguments: fileName  : input data file
+//            lpColumns : column names, 0 for the VAR_INPUT variables
+//           
+// Return:  Number of points read, or error code
+//------------------------------------------------------------
+int FuzzyControlClass::ReadInputDataColumns( string *fileName, 
+					     const vector< string >* lpColumns ) {
+
+  FuzzyGzipBufferClass InputBuffer; // InputDataStream of a .gz file
   ifstream InputDataStream;
   string   inputLine;
   vector< string > inputWords;
@@ -110,9 +407,9 @@ int FuzzyControlClass::ReadInputDataFile( string *fileName ) {
   const string& whitespace = " \t\r\n";
   const char&   CR         = '\r';
 
-  // Open the FuzzyInput variable data file for reading
-  InputDataStream.open( fileName->c_str(), ios::in );
-  if ( not InputDataStream ) {
+  // Open the FuzzyInput variable data file for reading, a .gz file
+  // is decompressed on its own thread as it is read
+  if ( FCL_OpenInputStream( &InputDataStream, *fileName, &InputBuffer ) ) {
     ErrMsg( "Failed to open input data file:", *fileName, -1 );
     return -1;
   }
@@ -172,6 +469,14 @@ int FuzzyControlClass::ReadInputDataFile( string *fileName ) {
       continue;
     }    
 
+    if ( lpColumns ) {
+      if ( find( lpColumns->begin(), lpColumns->end(), varName ) == 
+	   lpColumns->end() ) {
+	// The varName is not one of the columns
+	dataColumnToDelete.push_back( varName );
+      }
+      continue;
+    }
     fii = InputVariables.find( varName );
     if ( fii == InputVariables.end() ) {
       // The varName is not a key in the InputVariable Map
@@ -275,7 +580,10 @@ int FuzzyControlClass::ReadInputDataFile( string *fileName ) {
     numPointsRead++;
   }
 
-  InputDataStream.close();
+  if ( FCL_CloseStream( &InputDataStream, &InputBuffer ) != 0 ) {
+    ErrMsg( "Failed to read input data file:", *fileName, -1 );
+    return -1;
+  }
   DebugAllMsg("Closed input data file ", *fileName, status);
 
   return numPointsRead;
@@ -294,8 +602,9 @@ int FuzzyControlClass::OpenOutputFile( string *fileName ) {
 
   int status = 0;
 
-  OutputDataStream.open(fileName->c_str(), ios::out);
-  if ( not OutputDataStream ) {
+  // A .gz file is compressed on its own thread as it is written
+  if ( FCL_OpenOutputStream( &OutputDataStream, *fileName, ios::out,
+			     &OutputBuffer ) ) {
     status = -1;
     ErrMsg("Failed to open output data file:", *fileName, status);
     return status;
@@ -319,7 +628,11 @@ int FuzzyControlClass::CloseOutputFile() {
 
   int status = 0;
 
-  OutputDataStream.close();
+  status = FCL_CloseStream( &OutputDataStream, &OutputBuffer );
+  if ( status != 0 ) {
+    ErrMsg("Failed to write output data file:", this->outputFileName, status);
+    return status;
+  }
   DebugAllMsg("Closed output data file ", this->outputFileName, status);
 
   return status;
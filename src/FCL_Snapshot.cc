@@ -0,0 +1,631 @@
+#include "FuzzyControl.h"
+#include <cstring>    // memcpy, memcmp
+#include <cstdio>     // rename, remove
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <fcntl.h>    // open
+#include <unistd.h>   // close, getpid
+
+//--------------------------------------------------------------
+// Snapshot file layout, all values in host byte order:
+//
+//   char     magic[8]    "FCLSNAP"
+//   uint32_t version     FCL_SNAPSHOT_VERSION
+//   uint32_t byteOrder   FCL_SNAPSHOT_BYTE_ORDER
+//   uint64_t FCLHash     FNV-1a hash of the FCL file text
+//   uint64_t modelSize   bytes of model data that follow
+//   char     model[modelSize]  written by SaveModel()
+//
+// Strings are a uint32_t length followed by the characters,
+// keywords are stored by their keyword string, "" if not set.
+//--------------------------------------------------------------
+static const char SnapshotMagic[8] = { 'F','C','L','S','N','A','P','\0' };
+
+struct SnapshotHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t FCLHash;
+  uint64_t modelSize;
+};
+
+//--------------------------------------------------------------
+// Snapshot buffer writers
+//--------------------------------------------------------------
+static void PutInt( string* buffer, int value ) {
+  int32_t v = value;
+  buffer->append( (const char*) &v, sizeof( v ) );
+}
+
+static void PutDouble( string* buffer, double value ) {
+  buffer->append( (const char*) &value, sizeof( value ) );
+}
+
+static void PutString( string* buffer, const string& value ) {
+  uint32_t length = value.length();
+  buffer->append( (const char*) &length, sizeof( length ) );
+  buffer->append( value );
+}
+
+static void PutKeyword( string* buffer, FCL_keyword* keyword ) {
+  PutString( buffer, keyword ? keyword->keyword : string() );
+}
+
+static void PutXY( string* buffer, vector<XY*>& xy ) {
+  PutInt( buffer, xy.size() );
+  for ( vector<XY*>::iterator xyi = xy.begin(); xyi != xy.end(); ++xyi ) {
+    PutDouble( buffer, (*xyi)->x );
+    PutDouble( buffer, (*xyi)->y );
+  }
+}
+
+//--------------------------------------------------------------
+// struct SnapshotCursor
+//
+// Purpose: Bounds checked read position in a snapshot model,
+//          ok is cleared on the first read past the end
+//--------------------------------------------------------------
+struct SnapshotCursor {
+  const char* position;
+  const char* end;
+  bool        ok;
+};
+
+static int GetInt( SnapshotCursor* cursor ) {
+  int32_t v = 0;
+  if ( cursor->ok and cursor->end - cursor->position >= (long) sizeof(v) ) {
+    memcpy( &v, cursor->position, sizeof( v ) );
+    cursor->position += sizeof( v );
+  }
+  else {
+    cursor->ok = false;
+  }
+  return v;
+}
+
+static double GetDouble( SnapshotCursor* cursor ) {
+  double v = 0.;
+  if ( cursor->ok and cursor->end - cursor->position >= (long) sizeof(v) ) {
+    memcpy( &v, cursor->position, sizeof( v ) );
+    cursor->position += sizeof( v );
+  }
+  else {
+    cursor->ok = false;
+  }
+  return v;
+}
+
+static string GetString( SnapshotCursor* cursor ) {
+  uint32_t length = 0;
+  if ( cursor->ok and
+       cursor->end - cursor->position >= (long) sizeof(length) ) {
+    memcpy( &length, cursor->position, sizeof( length ) );
+    cursor->position += sizeof( length );
+    if ( cursor->end - cursor->position >= (long) length ) {
+      string value( cursor->position, length );
+      cursor->position += length;
+      return value;
+    }
+  }
+  cursor->ok = false;
+  return string();
+}
+
+static int GetXY( SnapshotCursor* cursor, vector<XY*>& xy ) {
+  int nXY = GetInt( cursor );
+  if ( nXY < 0 or nXY > 4 ) {
+    cursor->ok = false;
+    return -1;
+  }
+  for ( int i = 0; i < nXY; i++ ) {
+    XY* lpXY = new XY;
+    if ( not lpXY ) {
+      cursor->ok = false;
+      return -1;
+    }
+    lpXY->x = GetDouble( cursor );
+    lpXY->y = GetDouble( cursor );
+    xy.push_back( lpXY );
+  }
+  return cursor->ok ? 0 : -1;
+}
+
+//--------------------------------------------------------------
+// FCLTextHash
+//
+// Purpose: 64 bit FNV-1a hash of the raw FCL file text, the key
+//          that ties a snapshot to the FCL file it was built from
+//
+// Arguments: hash : pointer to hash value to fill in
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyControlClass::FCLTextHash( uint64_t* hash ) {
+
+  int status = 0;
+
+  ifstream FCLTextStream( FCLFileName.c_str(), ios::in | ios::binary );
+  if ( not FCLTextStream ) {
+    status = -1;
+    ErrMsg( "FCLTextHash() Failed to open file", FCLFileName, status );
+    return status;
+  }
+
+  uint64_t h = 14695981039346656037ULL;
+  char     block[ 65536 ];
+
+  while ( FCLTextStream ) {
+    FCLTextStream.read( block, sizeof( block ) );
+    streamsize nRead = FCLTextStream.gcount();
+    for ( streamsize i = 0; i < nRead; i++ ) {
+      h ^= (unsigned char) block[i];
+      h *= 1099511628211ULL;
+    }
+  }
+  FCLTextStream.close();
+
+  *hash = h;
+  return status;
+}
+
+//--------------------------------------------------------------
+// SaveModel
+//
+// Purpose: Serialize the parsed model: InputVariables,
+//          OutputVariables and Rules with their terms,
+//          conditions and conclusions
+//
+// Arguments: buffer : string the model data is appended to
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyControlClass::SaveModel( string* buffer ) {
+
+  int status = 0;
+
+  map< string, FuzzyRuleClass*   >::iterator fri;
+  map< string, FuzzyInputTerm*   >::iterator iti;
+  map< string, FuzzyOutputTerm*  >::iterator oti;
+
+  // Input variables and fuzzify terms, in declaration order
+  PutInt( buffer, InputVariableVector.size() );
+  for ( vector< FuzzyInputClass* >::iterator fivi = 
+	  InputVariableVector.begin(); 
+	fivi != InputVariableVector.end(); ++fivi ) {
+    FuzzyInputClass* lpFIC = *fivi;
+    PutString( buffer, lpFIC->varName );
+    PutString( buffer, lpFIC->varType );
+    PutInt   ( buffer, lpFIC->InputTerms.size() );
+    for ( iti = lpFIC->InputTerms.begin();
+	  iti != lpFIC->InputTerms.end(); ++iti ) {
+      PutString( buffer, iti->second->termName );
+      PutInt   ( buffer, iti->second->termType );
+      PutXY    ( buffer, iti->second->xy );
+    }
+  }
+
+  // Output variables, defuzzify and accumulation terms, in
+  // declaration order
+  PutInt( buffer, OutputVariableVector.size() );
+  for ( vector< FuzzyOutputClass* >::iterator fovi = 
+	  OutputVariableVector.begin(); 
+	fovi != OutputVariableVector.end(); ++fovi ) {
+    FuzzyOutputClass* lpFOC = *fovi;
+    PutString ( buffer, lpFOC->varName );
+    PutString ( buffer, lpFOC->varType );
+    PutKeyword( buffer, lpFOC->accumulation );
+    PutKeyword( buffer, lpFOC->method );
+    PutKeyword( buffer, lpFOC->defaultNC );
+    PutDouble ( buffer, lpFOC->defaultOut );
+    PutDouble ( buffer, lpFOC->maxOut );
+    PutDouble ( buffer, lpFOC->minOut );
+    PutInt    ( buffer, lpFOC->OutputTerms.size() );
+    for ( oti = lpFOC->OutputTerms.begin();
+	  oti != lpFOC->OutputTerms.end(); ++oti ) {
+      FuzzyOutputTerm* lpFOT  = oti->second;
+      FuzzyOutputTerm* lpFACC = lpFOC->AccumulationTerms[ oti->first ];
+      PutString( buffer, lpFOT->termName );
+      PutInt   ( buffer, lpFOT->termType );
+      PutDouble( buffer, lpFOT->singleton.x );
+      PutDouble( buffer, lpFOT->singleton.y );
+      PutXY    ( buffer, lpFOT->xy );
+      // the accumulation term only carries its type and singleton,
+      // the xy points are rebuilt by each Accumulation()
+      PutInt   ( buffer, lpFACC->termType );
+      PutDouble( buffer, lpFACC->singleton.x );
+      PutDouble( buffer, lpFACC->singleton.y );
+    }
+  }
+
+  // Rules
+  PutInt( buffer, Rules.size() );
+  for ( fri = Rules.begin(); fri != Rules.end(); ++fri ) {
+    FuzzyRuleClass* lpFRC = fri->second;
+    PutString ( buffer, lpFRC->ruleName );
+    PutKeyword( buffer, lpFRC->andMethod );
+    PutKeyword( buffer, lpFRC->orMethod );
+    PutKeyword( buffer, lpFRC->actMethod );
+    PutInt    ( buffer, lpFRC->nSubConditions );
+    PutInt    ( buffer, lpFRC->nSubConclusions );
+
+    PutInt( buffer, lpFRC->Conditions.size() );
+    for ( vector<Condition*>::iterator ci = lpFRC->Conditions.begin();
+	  ci != lpFRC->Conditions.end(); ++ci ) {
+      vector<SubCondition*>* subConditions[2] =
+	{ &((*ci)->AND_SubConditions), &((*ci)->OR_SubConditions) };
+      for ( int andOr = 0; andOr < 2; andOr++ ) {
+	PutInt( buffer, subConditions[andOr]->size() );
+	for ( vector<SubCondition*>::iterator sci =
+		subConditions[andOr]->begin();
+	      sci != subConditions[andOr]->end(); ++sci ) {
+	  PutString( buffer, (*sci)->inputVariable->varName );
+	  PutString( buffer, (*sci)->inputFuzzifyTerm->termName );
+	  PutInt   ( buffer, (*sci)->notCondition );
+	  PutInt   ( buffer, (*sci)->notTerm );
+	}
+      }
+    }
+
+    PutInt( buffer, lpFRC->Conclusions.size() );
+    for ( vector<Conclusion*>::iterator conci = lpFRC->Conclusions.begin();
+	  conci != lpFRC->Conclusions.end(); ++conci ) {
+      PutString( buffer, (*conci)->outputVariable->varName );
+      PutString( buffer, (*conci)->outputDefuzzify->termName );
+      PutDouble( buffer, (*conci)->weight );
+    }
+  }
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// LoadModel
+//
+// Purpose: Rebuild InputVariables, OutputVariables and Rules from
+//          model data written by SaveModel(), in place of
+//          ReadFCLFile() and ParseFCLFile()
+//
+// Arguments: data : start of the model data
+//            size : bytes of model data
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyControlClass::LoadModel( const char* data, size_t size ) {
+
+  int status = 0;
+
+  if ( not InputVariables.empty() or not OutputVariables.empty() or
+       not Rules.empty() ) {
+    status = -1;
+    ErrMsg( "LoadModel() Model is already loaded", FCLFileName, status );
+    return status;
+  }
+
+  SnapshotCursor cursor;
+  cursor.position = data;
+  cursor.end      = data + size;
+  cursor.ok       = true;
+
+  // Input variables and fuzzify terms
+  int nInputs = GetInt( &cursor );
+  for ( int i = 0; i < nInputs and cursor.ok; i++ ) {
+    FuzzyInputClass* lpFIC = new FuzzyInputClass;
+    if ( not lpFIC ) {
+      status = -1;
+      ErrMsg( "LoadModel() Failed to create FuzzyInputClass", "", status );
+      return status;
+    }
+    lpFIC->varName = GetString( &cursor );
+    lpFIC->varType = GetString( &cursor );
+    InputVariables[ lpFIC->varName ] = lpFIC;
+    InputVariableVector.push_back( lpFIC );
+
+    int nTerms = GetInt( &cursor );
+    for ( int j = 0; j < nTerms and cursor.ok; j++ ) {
+      FuzzyInputTerm* fit = new FuzzyInputTerm;
+      if ( not fit ) {
+	status = -1;
+	ErrMsg( "LoadModel() Failed to create FuzzyInputTerm for",
+		lpFIC->varName, status );
+	return status;
+      }
+      fit->varName    = lpFIC->varName;
+      fit->termName   = GetString( &cursor );
+      fit->termType   = GetInt( &cursor );
+      fit->membership = 0;
+      GetXY( &cursor, fit->xy );
+      lpFIC->InputTerms[ fit->termName ] = fit;
+    }
+  }
+
+  // Output variables, defuzzify and accumulation terms
+  int nOutputs = GetInt( &cursor );
+  for ( int i = 0; i < nOutputs and cursor.ok; i++ ) {
+    FuzzyOutputClass* lpFOC = new FuzzyOutputClass(keyword_Max, keyword_COGS);
+    if ( not lpFOC ) {
+      status = -1;
+      ErrMsg( "LoadModel() Failed to create FuzzyOutputClass", "", status );
+      return status;
+    }
+    lpFOC->varName      = GetString( &cursor );
+    lpFOC->varType      = GetString( &cursor );
+    OutputVariables[ lpFOC->varName ] = lpFOC;
+    OutputVariableVector.push_back( lpFOC );
+
+    string accumulation = GetString( &cursor );
+    string method       = GetString( &cursor );
+    string defaultNC    = GetString( &cursor );
+    lpFOC->accumulation = FindFCLKeywordFromMap( accumulation, true );
+    lpFOC->method       = FindFCLKeywordFromMap( method, true );
+    if ( not defaultNC.empty() ) {
+      lpFOC->defaultNC  = FindFCLKeywordFromMap( defaultNC, true );
+    }
+    lpFOC->defaultOut   = GetDouble( &cursor );
+    lpFOC->maxOut       = GetDouble( &cursor );
+    lpFOC->minOut       = GetDouble( &cursor );
+    if ( not lpFOC->accumulation or not lpFOC->method or
+	 ( not defaultNC.empty() and not lpFOC->defaultNC ) ) {
+      cursor.ok = false;
+      break;
+    }
+
+    int nTerms = GetInt( &cursor );
+    for ( int j = 0; j < nTerms and cursor.ok; j++ ) {
+      FuzzyOutputTerm* fot = new FuzzyOutputTerm;
+      FuzzyOutputTerm* fat = new FuzzyOutputTerm; // accumulation term
+      if ( not fot or not fat ) {
+	status = -1;
+	ErrMsg( "LoadModel() Failed to create FuzzyOutputTerm for",
+		lpFOC->varName, status );
+	return status;
+      }
+      fot->varName     = lpFOC->varName;
+      fot->termName    = GetString( &cursor );
+      fot->termType    = GetInt   ( &cursor );
+      fot->singleton.x = GetDouble( &cursor );
+      fot->singleton.y = GetDouble( &cursor );
+      GetXY( &cursor, fot->xy );
+      fat->varName     = lpFOC->varName;
+      fat->termName    = fot->termName;
+      fat->termType    = GetInt   ( &cursor );
+      fat->singleton.x = GetDouble( &cursor );
+      fat->singleton.y = GetDouble( &cursor );
+      lpFOC->OutputTerms      [ fot->termName ] = fot;
+      lpFOC->AccumulationTerms[ fat->termName ] = fat;
+    }
+  }
+
+  // Rules
+  int nRules = GetInt( &cursor );
+  for ( int i = 0; i < nRules and cursor.ok; i++ ) {
+    FuzzyRuleClass* frc = new FuzzyRuleClass(keyword_Min,
+					     keyword_Max,  keyword_Prod,
+					     keyword_Bdif, keyword_Asum,
+					     keyword_Bsum);
+    if ( not frc ) {
+      status = -1;
+      ErrMsg( "LoadModel() Failed to create FuzzyRuleClass", "", status );
+      return status;
+    }
+    frc->ruleName      = GetString( &cursor );
+    Rules[ frc->ruleName ] = frc;
+    tangentIndexValid = false;
+
+    frc->andMethod       = FindFCLKeywordFromMap( GetString(&cursor), true );
+    frc->orMethod        = FindFCLKeywordFromMap( GetString(&cursor), true );
+    frc->actMethod       = FindFCLKeywordFromMap( GetString(&cursor), true );
+    frc->nSubConditions  = GetInt( &cursor );
+    frc->nSubConclusions = GetInt( &cursor );
+    if ( not frc->andMethod or not frc->orMethod or not frc->actMethod ) {
+      cursor.ok = false;
+      break;
+    }
+
+    int nConditions = GetInt( &cursor );
+    for ( int j = 0; j < nConditions and cursor.ok; j++ ) {
+      Condition* condition = new Condition;
+      if ( not condition ) {
+	status = -1;
+	ErrMsg( "LoadModel() Failed to create condition struct for",
+		frc->ruleName, status );
+	return status;
+      }
+      condition->result = 0.;
+      frc->Conditions.push_back( condition );
+
+      vector<SubCondition*>* subConditions[2] =
+	{ &(condition->AND_SubConditions), &(condition->OR_SubConditions) };
+      for ( int andOr = 0; andOr < 2 and cursor.ok; andOr++ ) {
+	int nSubConditions = GetInt( &cursor );
+	for ( int k = 0; k < nSubConditions and cursor.ok; k++ ) {
+	  string variableName = GetString( &cursor );
+	  string termName     = GetString( &cursor );
+	  map< string, FuzzyInputClass* >::iterator fii =
+	    InputVariables.find( variableName );
+	  if ( fii == InputVariables.end() or
+	       fii->second->InputTerms.find( termName ) ==
+	       fii->second->InputTerms.end() ) {
+	    cursor.ok = false;
+	    break;
+	  }
+	  SubCondition* subCondition = new SubCondition;
+	  if ( not subCondition ) {
+	    status = -1;
+	    ErrMsg( "LoadModel() Failed to create subCondition struct for",
+		    frc->ruleName, status );
+	    return status;
+	  }
+	  subCondition->inputVariable    = fii->second;
+	  subCondition->inputFuzzifyTerm =
+	    fii->second->InputTerms.find( termName )->second;
+	  subCondition->notCondition     = GetInt( &cursor );
+	  subCondition->notTerm          = GetInt( &cursor );
+	  subCondition->subResult        = 0.;
+	  subConditions[andOr]->push_back( subCondition );
+	}
+      }
+    }
+
+    int nConclusions = GetInt( &cursor );
+    for ( int j = 0; j < nConclusions and cursor.ok; j++ ) {
+      string variableName = GetString( &cursor );
+      string termName     = GetString( &cursor );
+      map< string, FuzzyOutputClass* >::iterator foi =
+	OutputVariables.find( variableName );
+      if ( foi == OutputVariables.end() or
+	   foi->second->OutputTerms.find( termName ) ==
+	   foi->second->OutputTerms.end() ) {
+	cursor.ok = false;
+	break;
+      }
+      Conclusion* lpConclusion = new Conclusion;
+      if ( not lpConclusion ) {
+	status = -1;
+	ErrMsg( "LoadModel() Failed to create Conclusion struct for",
+		frc->ruleName, status );
+	return status;
+      }
+      lpConclusion->outputVariable  = foi->second;
+      lpConclusion->outputDefuzzify =
+	foi->second->OutputTerms.find( termName )->second;
+      lpConclusion->weight          = GetDouble( &cursor );
+      lpConclusion->activationTerm.varName     = variableName;
+      lpConclusion->activationTerm.termName    = termName;
+      lpConclusion->activationTerm.termType    = -1;
+      lpConclusion->activationTerm.singleton.x = 0.;
+      lpConclusion->activationTerm.singleton.y = 0.;
+      frc->Conclusions.push_back( lpConclusion );
+    }
+  }
+
+  if ( not cursor.ok or cursor.position != cursor.end ) {
+    status = -1;
+    ErrMsg( "LoadModel() Invalid model data", FCLFileName, status );
+  }
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// WriteSnapshotFile
+//
+// Purpose: Write the parsed model to a binary snapshot file keyed
+//          by FCLHash. The snapshot is written to a temporary file
+//          and renamed into place, so processes reading the snapshot
+//          never see a partial file.
+//
+// Arguments: fileName : snapshot file name
+//            FCLHash  : hash of the FCL text the model was parsed from
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyControlClass::WriteSnapshotFile( string* fileName,
+					  uint64_t FCLHash ) {
+
+  int status = 0;
+
+  string model;
+  status = SaveModel( &model );
+  if ( status != 0 ) {
+    ErrMsg( "WriteSnapshotFile() Failed to serialize model",
+	    *fileName, status );
+    return status;
+  }
+
+  SnapshotHeader header;
+  memcpy( header.magic, SnapshotMagic, sizeof( header.magic ) );
+  header.version   = FCL_SNAPSHOT_VERSION;
+  header.byteOrder = FCL_SNAPSHOT_BYTE_ORDER;
+  header.FCLHash   = FCLHash;
+  header.modelSize = model.size();
+
+  char pid[32];
+  sprintf( pid, ".%d", (int) getpid() );
+  string tmpFileName = *fileName + pid;
+
+  ofstream snapshotStream( tmpFileName.c_str(), ios::out | ios::binary );
+  if ( not snapshotStream ) {
+    status = -1;
+    ErrMsg( "WriteSnapshotFile() Failed to open file", tmpFileName, status );
+    return status;
+  }
+  snapshotStream.write( (const char*) &header, sizeof( header ) );
+  snapshotStream.write( model.data(), model.size() );
+  snapshotStream.close();
+
+  if ( not snapshotStream or
+       rename( tmpFileName.c_str(), fileName->c_str() ) != 0 ) {
+    status = -1;
+    ErrMsg( "WriteSnapshotFile() Failed to write file", *fileName, status );
+    remove( tmpFileName.c_str() );
+    return status;
+  }
+
+  DebugMsg( "Wrote snapshot file", *fileName, status );
+  return status;
+}
+
+//--------------------------------------------------------------
+// ReadSnapshotFile
+//
+// Purpose: Memory map a snapshot file read-only and load the model
+//          from it. The mapping is shared, so processes loading the
+//          same snapshot share its pages in the page cache.
+//
+// Arguments: fileName : snapshot file name
+//            FCLHash  : hash of the current FCL text
+//
+// Return: status, 1 if the snapshot is missing, stale or from
+//         a different snapshot version, -1 on error
+//--------------------------------------------------------------
+int FuzzyControlClass::ReadSnapshotFile( string* fileName,
+					 uint64_t FCLHash ) {
+
+  int status = 0;
+
+  int fd = open( fileName->c_str(), O_RDONLY );
+  if ( fd < 0 ) {
+    return 1; // no snapshot yet
+  }
+
+  struct stat fileStat;
+  if ( fstat( fd, &fileStat ) != 0 or
+       fileStat.st_size < (off_t) sizeof( SnapshotHeader ) ) {
+    close( fd );
+    return 1;
+  }
+
+  size_t mapSize = fileStat.st_size;
+  void*  lpMap   = mmap( 0, mapSize, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+  if ( lpMap == MAP_FAILED ) {
+    ErrMsg( "ReadSnapshotFile() Failed to map file", *fileName, 1 );
+    return 1;
+  }
+
+  const char*     lpData = (const char*) lpMap;
+  SnapshotHeader  header;
+  memcpy( &header, lpData, sizeof( header ) );
+
+  if ( memcmp( header.magic, SnapshotMagic, sizeof( header.magic ) ) != 0 or
+       header.version   != FCL_SNAPSHOT_VERSION    or
+       header.byteOrder != FCL_SNAPSHOT_BYTE_ORDER or
+       header.FCLHash   != FCLHash or
+       header.modelSize != mapSize - sizeof( header ) ) {
+    DebugMsg( "Snapshot does not match FCL file", *fileName, 1 );
+    munmap( lpMap, mapSize );
+    return 1;
+  }
+
+  status = LoadModel( lpData + sizeof( header ), header.modelSize );
+  munmap( lpMap, mapSize );
+
+  if ( status != 0 ) {
+    ErrMsg( "ReadSnapshotFile() Failed to load model from",
+	    *fileName, status );
+    return -1;
+  }
+
+  DebugMsg( "Loaded snapshot file", *fileName, status );
+  return status;
+}
@@ -0,0 +1,276 @@
+#include "FuzzyControl.h"
+#include <pthread.h> // pthread_create, pthread_mutex, pthread_cond
+#include <unistd.h>  // sysconf
+
+//--------------------------------------------------------------
+// struct ParallelJob
+//
+// Purpose: A FCL_ParallelFor() call handed to the thread pool.
+//          nextItem is claimed chunkSize items at a time with an
+//          atomic add, so fast threads pick up more chunks.
+//          joined and active are protected by poolMutex.
+//--------------------------------------------------------------
+struct ParallelJob {
+  FCL_ParallelFunc func;
+  void*            arg;
+  int              nItems;
+  int              chunkSize;
+  volatile int     nextItem;
+  int              maxWorkers; // pool threads allowed to join
+  int              joined;     // pool threads that joined the job
+  int              active;     // pool threads still working on it
+};
+
+//--------------------------------------------------------------
+// Thread pool state. The pool threads are started on demand and
+// live for the rest of the process, waiting on poolWork between
+// jobs, so a FCL_ParallelFor() per timestep is cheap.
+// The pool runs one job at a time: a FCL_ParallelFor() called
+// while a job is running (from a work function, or from another
+// thread) runs its items in the calling thread.
+//--------------------------------------------------------------
+static pthread_mutex_t poolMutex      = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  poolWork       = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  poolDone       = PTHREAD_COND_INITIALIZER;
+static ParallelJob*    poolJob        = 0;
+static unsigned int    poolGeneration = 0;
+static int             poolThreads    = 0;
+static bool            poolBusy       = false;
+
+//--------------------------------------------------------------
+// RunParallelJob
+//
+// Purpose: Claim and process chunks of items until all are taken
+//
+// Arguments: lpJob       : the job
+//            threadIndex : passed to the work function
+//
+// Return:
+//--------------------------------------------------------------
+static void RunParallelJob( ParallelJob* lpJob, int threadIndex ) {
+
+  while ( true ) {
+    int begin = __sync_fetch_and_add( &lpJob->nextItem, lpJob->chunkSize );
+    if ( begin >= lpJob->nItems ) {
+      break;
+    }
+    int end = begin + lpJob->chunkSize;
+    if ( end > lpJob->nItems ) {
+      end = lpJob->nItems;
+    }
+    lpJob->func( lpJob->arg, threadIndex, begin, end );
+  }
+}
+
+//--------------------------------------------------------------
+// PoolWorker
+//
+// Purpose: Thread pool thread entry point, wait for a job that
+//          still accepts workers, join it, run it, repeat
+//
+// Arguments: unused
+//
+// Return: never returns
+//--------------------------------------------------------------
+static void* PoolWorker( void* ) {
+
+  unsigned int seenGeneration = 0;
+
+  pthread_mutex_lock( &poolMutex );
+  while ( true ) {
+    while ( not poolJob or poolGeneration == seenGeneration or
+	    poolJob->joined >= poolJob->maxWorkers ) {
+      pthread_cond_wait( &poolWork, &poolMutex );
+    }
+    seenGeneration    = poolGeneration;
+    ParallelJob* lpJob = poolJob;
+    int threadIndex    = ++lpJob->joined;
+    lpJob->active++;
+    pthread_mutex_unlock( &poolMutex );
+
+    RunParallelJob( lpJob, threadIndex );
+
+    pthread_mutex_lock( &poolMutex );
+    if ( --lpJob->active == 0 ) {
+      pthread_cond_signal( &poolDone );
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FCL_NumThreads
+//
+// Purpose: Number of worker threads to use by default.
+//          The environment variable FCL_THREADS overrides the
+//          number of online processors.
+//
+// Arguments:
+//
+// Return: number of threads, at least 1
+//--------------------------------------------------------------
+int FCL_NumThreads() {
+
+  int nThreads = 0;
+
+  char* envThreads = getenv( "FCL_THREADS" );
+  if ( envThreads ) {
+    nThreads = atoi( envThreads );
+  }
+  if ( nThreads < 1 ) {
+    nThreads = (int) sysconf( _SC_NPROCESSORS_ONLN );
+  }
+  if ( nThreads < 1 ) {
+    nThreads = 1;
+  }
+  return nThreads;
+}
+
+//--------------------------------------------------------------
+// FCL_ParallelFor
+//
+// Purpose: Call func( arg, threadIndex, begin, end ) over the
+//          items [0, nItems) in chunks of chunkSize, spread over
+//          nThreads threads. The calling thread is thread 0.
+//          Returns after all items are processed. Each item is
+//          processed exactly once, threadIndex is in [0, nThreads)
+//          so the caller can keep per-thread state.
+//
+// Arguments: nItems    : number of items
+//            chunkSize : number of items per call of func
+//            func      : work function
+//            arg       : passed to func
+//            nThreads  : number of threads, if < 1 FCL_NumThreads()
+//
+// Return: status
+//--------------------------------------------------------------
+int FCL_ParallelFor( int nItems, int chunkSize,
+		     FCL_ParallelFunc func, void* arg, int nThreads ) {
+
+  int status = 0;
+
+  if ( nItems < 1 ) {
+    return status;
+  }
+  if ( chunkSize < 1 ) {
+    chunkSize = 1;
+  }
+  if ( nThreads < 1 ) {
+    nThreads = FCL_NumThreads();
+  }
+  // no more threads than chunks
+  int nChunks = ( nItems + chunkSize - 1 ) / chunkSize;
+  if ( nThreads > nChunks ) {
+    nThreads = nChunks;
+  }
+
+  ParallelJob job;
+  job.func       = func;
+  job.arg        = arg;
+  job.nItems     = nItems;
+  job.chunkSize  = chunkSize;
+  job.nextItem   = 0;
+  job.maxWorkers = 0;
+  job.joined     = 0;
+  job.active     = 0;
+
+  bool usePool = false;
+
+  if ( nThreads > 1 ) {
+    pthread_mutex_lock( &poolMutex );
+    if ( not poolBusy ) {
+      poolBusy = true;
+      usePool  = true;
+
+      // Grow the pool to nThreads - 1 threads
+      while ( poolThreads < nThreads - 1 ) {
+	pthread_t thread;
+	if ( pthread_create( &thread, 0, PoolWorker, 0 ) != 0 ) {
+	  ErrMsg( "FCL_ParallelFor() Failed to create thread",
+		  poolThreads + 1, 1 );
+	  break;
+	}
+	pthread_detach( thread );
+	poolThreads++;
+      }
+      job.maxWorkers = min( poolThreads, nThreads - 1 );
+
+      poolJob = &job;
+      poolGeneration++;
+      pthread_cond_broadcast( &poolWork );
+    }
+    pthread_mutex_unlock( &poolMutex );
+  }
+
+  // The calling thread is thread 0, and does all the work if
+  // the pool is not used
+  RunParallelJob( &job, 0 );
+
+  if ( usePool ) {
+    // Close the job to late joiners, wait for the ones that joined
+    pthread_mutex_lock( &poolMutex );
+    poolJob = 0;
+    while ( job.active > 0 ) {
+      pthread_cond_wait( &poolDone, &poolMutex );
+    }
+    poolBusy = false;
+    pthread_mutex_unlock( &poolMutex );
+  }
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// FCL_CloneModels
+//
+// Purpose: Add clones of a parsed model to lpClones until it holds
+//          nClones, each from one SaveModel() image of lpFC, for
+//          the per-thread state of an FCL_ParallelFor() work
+//          function. The clones belong to the caller, the ones
+//          added before a failure are kept in lpClones.
+//
+// Arguments: lpFC     : the parsed model, not changed
+//            nClones  : number of clones
+//            lpClones : clones, may already hold some
+//
+// Return: status
+//--------------------------------------------------------------
+int FCL_CloneModels( FuzzyControlClass* lpFC, int nClones,
+		     vector< FuzzyControlClass* >* lpClones ) {
+
+  int status = 0;
+
+  if ( (int) lpClones->size() >= nClones ) {
+    return status;
+  }
+
+  string image;
+  status = lpFC->SaveModel( &image );
+  if ( status != 0 ) {
+    ErrMsg( "FCL_CloneModels() Failed to save model", lpFC->FCLFile(),
+	    status );
+    return status;
+  }
+
+  while ( (int) lpClones->size() < nClones ) {
+    FuzzyControlClass* lpClone = 0;
+    try {
+      lpClone = new FuzzyControlClass( lpFC->FCLFile(), "", "" );
+      lpClones->push_back( lpClone );
+    }
+    catch ( ... ) {
+      delete lpClone;
+      status = -1;
+      ErrMsg( "FCL_CloneModels() Failed to allocate model",
+	      lpFC->FCLFile(), status );
+      return status;
+    }
+    status = lpClone->LoadModel( image.data(), image.size() );
+    if ( status != 0 ) {
+      ErrMsg( "FCL_CloneModels() Failed to load model", lpFC->FCLFile(),
+	      status );
+      return status;
+    }
+  }
+  return status;
+}
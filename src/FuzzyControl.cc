@@ -359,6 +359,7 @@ int FuzzyControlClass::Accumulation() {
   vector<Conclusion*>             :: iterator conci;
   map <string, FuzzyOutputClass*> :: iterator foi;  // Output Variables
   map <string, FuzzyOutputTerm*>  :: iterator ati;  // Accumulation terms
+  map <string, FuzzyOutputTerm*>  :: iterator oti;  // FCL output terms
   vector<XY*>                     :: iterator xyi;
 
   // INFERENCE: ACCUMULATION
@@ -374,10 +375,7 @@ int FuzzyControlClass::Accumulation() {
 	  ati != lpFOC->AccumulationTerms.end(); ++ ati ) {
       lpFACCU = ati->second;
       lpFACCU->singleton.y = 0.;
-      for ( xyi = lpFACCU->xy.begin(); xyi != lpFACCU->xy.end();++xyi ) {
-	delete *xyi;
-      }
-      lpFACCU->xy.clear();
+      ReleaseTermXY( lpFACCU );
     }
   }
 
@@ -389,9 +387,14 @@ int FuzzyControlClass::Accumulation() {
     lpFOC = foi->second;
     DebugMsg("Accumulation:", lpFOC->varName, 0);
 
-    // Iterate through the accumulation terms for this variable
-    for ( ati = lpFOC->AccumulationTerms.begin(); 
-	  ati != lpFOC->AccumulationTerms.end(); ++ ati ) {
+    // Iterate through the accumulation terms for this variable.
+    // AccumulationTerms and OutputTerms have the same keys, so oti
+    // is the FCL defined term of ati, and a conclusion fires this
+    // term when its outputDefuzzify is oti, without a name compare.
+    for ( ati = lpFOC->AccumulationTerms.begin(), 
+	  oti = lpFOC->OutputTerms.begin();
+	  ati != lpFOC->AccumulationTerms.end() and 
+	  oti != lpFOC->OutputTerms.end(); ++ ati, ++ oti ) {
       lpFACCU = ati->second;
 
       // Iterate through rules to accumulate activation from each conclusion
@@ -405,7 +408,7 @@ int FuzzyControlClass::Accumulation() {
 	  if ( lpConc->outputVariable == lpFOC ) {
 	    // If the rule fires this activation term, accumulate it
 	    lpFACT = &(lpConc->activationTerm);
-	    if ( lpFACT->termName == lpFACCU->termName ) {
+	    if ( lpConc->outputDefuzzify == oti->second ) {
 	      DebugMsg("\tAccumulate RULE", lpFRC->ruleName + " > " + 
 		       lpFACCU->varName + " IS " + lpFACCU->termName, 0);
 	      status = Accumulate( lpFOC, lpFACT, lpFACCU );
@@ -475,7 +478,7 @@ int FuzzyControlClass::Accumulation() {
 	      break;
 	    }
 	    if ( lpFACCU->xy.at(2)->x == lpFACCU->xy.at(3)->x ) {
-	      delete lpFACCU->xy[3];
+	      ReleaseTermXY( lpFACCU, lpFACCU->xy[3] );
 	      lpFACCU->xy.pop_back();
 	      lpFACCU->termType = Triangle;
 	    }
@@ -537,7 +540,6 @@ int FuzzyControlClass::Accumulate( FuzzyOutputClass* lpFOC,
   int  i      = 0;
 
   XY*              lpXY;
-  FuzzyOutputTerm* lpFOT;  // access pointer to FCL defined term
 
   vector<XY*> :: iterator xyi;
       
@@ -558,7 +560,7 @@ int FuzzyControlClass::Accumulate( FuzzyOutputClass* lpFOC,
   // Just copy the activation term, since it's the 1st and maybe only one
   if ( lpFACCU->termType != Singleton and not lpFACCU->xy.size() ) {
     for ( xyi = lpFACT->xy.begin(); xyi != lpFACT->xy.end(); ++xyi ) {
-      XY* lpXY = new XY;
+      XY* lpXY = NewTermXY( lpFACCU );
       if ( not lpXY ) {
 	status = -1; ErrMsg("Accumulate() Failed to alloc XY", "", status);
 	return status;
@@ -571,16 +573,6 @@ int FuzzyControlClass::Accumulate( FuzzyOutputClass* lpFOC,
     return status;
   }
 
-  // Find the matching FCL defined output term
-  if ( lpFOC->OutputTerms.find(lpFACCU->termName) == 
-       lpFOC->OutputTerms.end() ) {
-    status = -1;
-    ErrMsg("Accumulate(): Failed to find FCL output term", 
-	   lpFACCU->termName, status);
-    return status;
-  }
-  lpFOT = lpFOC->OutputTerms[lpFACCU->termName];
-
   // The activationTerm will control the type of the accumulation term, since
   // activation may have converted an ouput triangle term into a trapezoid.
   switch ( lpFACT->termType ) {
@@ -591,7 +583,7 @@ int FuzzyControlClass::Accumulate( FuzzyOutputClass* lpFOC,
 
       if ( lpFACCU->xy.size() == 3 ) {
 	// It was a Triangle Output term that Activation changed to a Trapezoid
-	XY* lpXY = new XY;
+	XY* lpXY = NewTermXY( lpFACCU );
 	if ( not lpXY ) {
 	  status = -1; ErrMsg("Accumulate() Failed to alloc XY for Trapezoid", 
 			      "", status);
@@ -777,10 +769,7 @@ int FuzzyControlClass::Accumulate( FuzzyOutputClass* lpFOC,
       // set the term type
       lpFACCU->termType = Singleton;
       // Make sure there aren't any xy points
-      for ( xyi = lpFACT->xy.begin(); xyi != lpFACT->xy.end(); ++xyi ) {
-	delete *xyi;
-      }
-      lpFACT->xy.clear();
+      ReleaseTermXY( lpFACT );
 
       lpFACCU->singleton.x = lpFACT->singleton.x;
 
@@ -945,12 +934,14 @@ int FuzzyControlClass::Fuzzification(int inputDataIndex) {
 //           
 // Return:   
 //--------------------------------------------------------------
-int FuzzyControlClass::FuzzifyInput( string varName, double inputValue ) {
+int FuzzyControlClass::FuzzifyInput( const string& varName, 
+				     double inputValue ) {
 
   int status = 0;
 
   // Find the input variable in the InputVariables Map
-  if ( InputVariables.find(varName) != InputVariables.end() ) {
+  map<string, FuzzyInputClass*> :: iterator fii = InputVariables.find(varName);
+  if ( fii != InputVariables.end() ) {
     DebugMsg("Fuzzify variable", varName, 0);
     DebugAllMsg("\tVariable value", inputValue, 0);
   }
@@ -960,7 +951,24 @@ int FuzzyControlClass::FuzzifyInput( string varName, double inputValue ) {
 	   varName, status);
     return status;
   }
-  FuzzyInputClass* lpFIC = InputVariables[varName];
+  return FuzzifyVariable( fii->second, inputValue );
+}
+
+//--------------------------------------------------------------
+// FuzzifyVariable
+//
+// Purpose: Assign the membership function values to each term
+//          of a fuzzy input variable, for callers that resolved
+//          the FuzzyInputClass once and don't need the name lookup
+//
+// Arguments: lpFIC, inputValue 
+//           
+// Return: status
+//--------------------------------------------------------------
+int FuzzyControlClass::FuzzifyVariable( FuzzyInputClass* lpFIC, 
+					double inputValue ) {
+
+  int status = 0;
 
   // For each term in the InputTerms map, assign the membership value
   map<string, FuzzyInputTerm*> :: const_iterator fti;
@@ -995,6 +1003,27 @@ int FuzzyControlClass::FuzzifyInput( string varName, double inputValue ) {
   return status;
 }
 
+//--------------------------------------------------------------
+// FCL_VersionString
+//
+// Purpose: The library name and version, for a program to print.
+//          The library itself does not write to stdout.
+//
+// Arguments: 
+//           
+// Return: version text, one line each
+//--------------------------------------------------------------
+string FCL_VersionString() {
+
+  FCLL_Version FCLLVersion;
+  FCLLVersion.SetVersionNumber("1", "0", "1");
+  FCLLVersion.SetBuildDate("None");
+  FCLLVersion.SetReleaseDate("None");
+  FCLLVersion.SetVersionString();
+
+  return FCLLVersion.VersionString();
+}
+
 //--------------------------------------------------------------
 // FuzzyControlClass
 //
@@ -1011,18 +1040,12 @@ FuzzyControlClass::FuzzyControlClass( string fileName,
 				      string inputDelimeters,
 				      string inputDataLabel ) {
 
-  // Initialize version 
-  FCLL_Version* FCLLVersion = new FCLL_Version();
-  FCLLVersion->SetVersionNumber("1", "0", "1");
-  FCLLVersion->SetBuildDate("None");
-  FCLLVersion->SetReleaseDate("None");
-  FCLLVersion->SetVersionString();
-
   // Initialize FCL file name
   FCLFileName = fileName;
 
   // Initialize other members
   status = 0;
+  tangentIndexValid = false;
 
   if ( not inputDelimeters.length() ) {
     // Assume the input data file is .csv format
@@ -1258,3 +1281,754 @@ FuzzyControlClass::FuzzyControlClass( string fileName,
 
   status = 0;
 }
+
+//--------------------------------------------------------------
+// ~FuzzyControlClass
+//
+// Purpose: Destructor for FuzzyControlClass. Delete the model with
+//          ClearModel(), the input data vectors and the FCL
+//          keywords map.
+//
+// Arguments: 
+//           
+// Return:   
+//--------------------------------------------------------------
+FuzzyControlClass::~FuzzyControlClass() {
+
+  ClearModel();
+
+  map< string, vector< double >* >::iterator idi;
+  for ( idi = InputData.begin(); idi != InputData.end(); ++idi ) {
+    delete idi->second;
+  }
+  InputData.clear();
+
+  map< string, FCL_keyword* >::iterator ki;
+  for ( ki = keywords.begin(); ki != keywords.end(); ++ki ) {
+    delete ki->second;
+  }
+  keywords.clear();
+}
+
+//--------------------------------------------------------------
+// SetInputs
+//
+// Purpose: Fuzzify all input variables without name lookups
+//
+// Arguments: inputValues : one value per input variable, in 
+//                          declaration order (InputVariablesVector)
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::SetInputs( const double* inputValues ) {
+
+  int status = 0;
+
+  for ( unsigned int i = 0; i < InputVariableVector.size(); i++ ) {
+    status = FuzzifyVariable( InputVariableVector[i], inputValues[i] );
+    if ( status != 0 ) {
+      ErrMsg("SetInputs() Failed to fuzzify", 
+	     InputVariableVector[i]->varName, status);
+      return status;
+    }
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// Evaluate
+//
+// Purpose: Run Aggregation, Activation, Accumulation and 
+//          Defuzzification on the fuzzified inputs
+//
+// Arguments: 
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::Evaluate() {
+
+  int status = 0;
+
+  status = Aggregation();
+  if ( status != 0 ) {
+    ErrMsg("Aggregation Failed.", FCLFileName, status);
+    return status;
+  }
+  status = Activation();
+  if ( status != 0 ) {
+    ErrMsg("Activation Failed.", FCLFileName, status);
+    return status;
+  }
+  status = Accumulation();
+  if ( status != 0 ) {
+    ErrMsg("Accumulation Failed.", FCLFileName, status);
+    return status;
+  }
+  status = Defuzzification();
+  if ( status != 0 ) {
+    ErrMsg("Defuzzification Failed.", FCLFileName, status);
+    return status;
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// GetOutputs
+//
+// Purpose: Copy the defuzzified output values
+//
+// Arguments: outputValues : one value per output variable, in 
+//                           declaration order (OutputVariablesVector)
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::GetOutputs( double* outputValues ) {
+
+  for ( unsigned int i = 0; i < OutputVariableVector.size(); i++ ) {
+    outputValues[i] = OutputVariableVector[i]->defuzzOut;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// InputHandle
+//
+// Purpose: Find the handle of an input variable
+//
+// Arguments: varName : name of the VAR_INPUT variable
+//           
+// Return: handle, index in InputVariablesVector, -1 if not found
+//--------------------------------------------------------------
+int FuzzyControlClass::InputHandle( const string& varName ) const {
+
+  for ( unsigned int i = 0; i < InputVariableVector.size(); i++ ) {
+    if ( InputVariableVector[i]->varName == varName ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+//--------------------------------------------------------------
+// OutputHandle
+//
+// Purpose: Find the handle of an output variable
+//
+// Arguments: varName : name of the VAR_OUTPUT variable
+//           
+// Return: handle, index in OutputVariablesVector, -1 if not found
+//--------------------------------------------------------------
+int FuzzyControlClass::OutputHandle( const string& varName ) const {
+
+  for ( unsigned int i = 0; i < OutputVariableVector.size(); i++ ) {
+    if ( OutputVariableVector[i]->varName == varName ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+//--------------------------------------------------------------
+// SetInput
+//
+// Purpose: Fuzzify one input variable by handle
+//
+// Arguments: inputHandle : from InputHandle()
+//            inputValue
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::SetInput( int inputHandle, double inputValue ) {
+
+  int status = 0;
+
+  if ( inputHandle < 0 or 
+       inputHandle >= (int) InputVariableVector.size() ) {
+    status = -1;
+    ErrMsg("SetInput() Invalid input handle", inputHandle, status);
+    return status;
+  }
+  status = FuzzifyVariable( InputVariableVector[inputHandle], inputValue );
+  if ( status != 0 ) {
+    ErrMsg("SetInput() Failed to fuzzify", 
+	   InputVariableVector[inputHandle]->varName, status);
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// GetOutput
+//
+// Purpose: Copy the defuzzified value of one output variable
+//
+// Arguments: outputHandle : from OutputHandle()
+//            outputValue  : set to the defuzzified output
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::GetOutput( int outputHandle, 
+				  double* outputValue ) const {
+
+  int status = 0;
+
+  if ( outputHandle < 0 or 
+       outputHandle >= (int) OutputVariableVector.size() ) {
+    status = -1;
+    ErrMsg("GetOutput() Invalid output handle", outputHandle, status);
+    return status;
+  }
+  *outputValue = OutputVariableVector[outputHandle]->defuzzOut;
+  return status;
+}
+
+//--------------------------------------------------------------
+// NumInputTerms
+//
+// Purpose: Number of terms over all input variables, the size
+//          of the GetMemberships() buffer
+//
+// Arguments: 
+//           
+// Return: number of input terms
+//--------------------------------------------------------------
+int FuzzyControlClass::NumInputTerms() const {
+
+  int numTerms = 0;
+
+  for ( unsigned int i = 0; i < InputVariableVector.size(); i++ ) {
+    numTerms += InputVariableVector[i]->InputTerms.size();
+  }
+  return numTerms;
+}
+
+//--------------------------------------------------------------
+// GetMemberships
+//
+// Purpose: Copy the membership of each input term from the last
+//          fuzzification
+//
+// Arguments: memberships : NumInputTerms() values, the terms of
+//                          each input in declaration order
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::GetMemberships( double* memberships ) const {
+
+  map<string, FuzzyInputTerm*> :: const_iterator fti;
+  int n = 0;
+
+  for ( unsigned int i = 0; i < InputVariableVector.size(); i++ ) {
+    const FuzzyInputClass* lpFIC = InputVariableVector[i];
+    for ( fti = lpFIC->InputTerms.begin(); 
+	  fti != lpFIC->InputTerms.end(); ++fti ) {
+      memberships[n++] = fti->second->membership;
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// GetRuleStrengths
+//
+// Purpose: Copy the aggregated condition value of each rule from
+//          the last evaluation
+//
+// Arguments: strengths : NumRules() values in Rules map order
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::GetRuleStrengths( double* strengths ) const {
+
+  map<string, FuzzyRuleClass*> :: const_iterator fri;
+  int n = 0;
+
+  for ( fri = Rules.begin(); fri != Rules.end(); ++fri ) {
+    strengths[n++] = fri->second->conditionResult;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// DeleteRule
+//
+// Purpose: Delete a rule with its conditions and conclusions
+//
+// Arguments: lpFRC : rule, not in the Rules map
+//           
+// Return:   
+//--------------------------------------------------------------
+void DeleteRule( FuzzyRuleClass* lpFRC ) {
+
+  vector< XY* >::iterator xyi;
+
+  for ( vector<Condition*>::iterator ci = lpFRC->Conditions.begin();
+	ci != lpFRC->Conditions.end(); ++ci ) {
+    for ( vector<SubCondition*>::iterator sci = 
+	    (*ci)->AND_SubConditions.begin();
+	  sci != (*ci)->AND_SubConditions.end(); ++sci ) {
+      delete *sci;
+    }
+    for ( vector<SubCondition*>::iterator sci = 
+	    (*ci)->OR_SubConditions.begin();
+	  sci != (*ci)->OR_SubConditions.end(); ++sci ) {
+      delete *sci;
+    }
+    delete *ci;
+  }
+  for ( vector<Conclusion*>::iterator conci = lpFRC->Conclusions.begin();
+	conci != lpFRC->Conclusions.end(); ++conci ) {
+    ReleaseTermXY( &((*conci)->activationTerm) );
+    for ( xyi = (*conci)->activationTerm.xyFree.begin(); 
+	  xyi != (*conci)->activationTerm.xyFree.end(); ++xyi ) {
+      delete *xyi;
+    }
+    delete *conci;
+  }
+  delete lpFRC;
+}
+
+//--------------------------------------------------------------
+// ParseRuleEdit
+//
+// Purpose: Parse a RULE statement for AddRule() and ReplaceRule(),
+//          the rule must have conditions and conclusions on the
+//          variables of the model
+//
+// Arguments: lpRS  : RULE statement with its methods
+//            lpFRC : set to the new rule
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::ParseRuleEdit( RuleStatement*   lpRS,
+				      FuzzyRuleClass** lpFRC ) {
+
+  int status = ParseFCL_Rule( lpRS, lpFRC );
+  cerr << lpRS->errMsg;
+  if ( status != 0 ) {
+    ErrMsg("Failed to parse rule", lpRS->FCLFileLine, status);
+    return status;
+  }
+  if ( (*lpFRC)->Conditions.empty() or (*lpFRC)->Conclusions.empty() ) {
+    status = -1;
+    ErrMsg("Rule has no valid condition or conclusion", 
+	   lpRS->FCLFileLine, status);
+    DeleteRule( *lpFRC );
+    *lpFRC = 0;
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// AddRule
+//
+// Purpose: Parse a RULE statement and insert it into the Rules map
+//          of the loaded model. Only the new rule is parsed, the
+//          evaluation finds it through the Rules map and its
+//          conclusion pointers, there is no other rule index.
+//
+// Arguments: ruleText  : "RULE name : IF ... THEN ... ;"
+//            andMethod : AND method of the rule: MIN, PROD, BDIF
+//            orMethod  : OR method of the rule: MAX, ASUM, BSUM
+//            actMethod : ACT method of the rule: MIN, PROD
+//                        an empty method keeps the rule default
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::AddRule( const string& ruleText,
+				const string& andMethod,
+				const string& orMethod,
+				const string& actMethod ) {
+
+  int status = 0;
+
+  RuleStatement ruleStatement;
+  ruleStatement.FCLFileLine   = ruleText;
+  ruleStatement.ruleBlockName = "AddRule";
+  ruleStatement.andMethod     = 0;
+  ruleStatement.orMethod      = 0;
+  ruleStatement.actMethod     = 0;
+
+  if ( not andMethod.empty() ) {
+    ruleStatement.andMethod = FindFCLKeywordFromMap( andMethod, true );
+    if ( ruleStatement.andMethod != keyword_Min  and 
+	 ruleStatement.andMethod != keyword_Prod and
+	 ruleStatement.andMethod != keyword_Bdif ) {
+      status = -1;
+      ErrMsg("AddRule() Invalid AND method", andMethod, status);
+      return status;
+    }
+  }
+  if ( not orMethod.empty() ) {
+    ruleStatement.orMethod = FindFCLKeywordFromMap( orMethod, true );
+    if ( ruleStatement.orMethod != keyword_Max  and 
+	 ruleStatement.orMethod != keyword_Asum and
+	 ruleStatement.orMethod != keyword_Bsum ) {
+      status = -1;
+      ErrMsg("AddRule() Invalid OR method", orMethod, status);
+      return status;
+    }
+  }
+  if ( not actMethod.empty() ) {
+    ruleStatement.actMethod = FindFCLKeywordFromMap( actMethod, true );
+    if ( ruleStatement.actMethod != keyword_Min and 
+	 ruleStatement.actMethod != keyword_Prod ) {
+      status = -1;
+      ErrMsg("AddRule() Invalid ACT method", actMethod, status);
+      return status;
+    }
+  }
+
+  FuzzyRuleClass* lpFRC = 0;
+  status = ParseRuleEdit( &ruleStatement, &lpFRC );
+  if ( status != 0 ) {
+    return status;
+  }
+  if ( Rules.find( lpFRC->ruleName ) != Rules.end() ) {
+    status = -1;
+    ErrMsg("AddRule() Found redundant rule definition", 
+	   lpFRC->ruleName, status);
+    DeleteRule( lpFRC );
+    return status;
+  }
+  Rules[ lpFRC->ruleName ] = lpFRC;
+  tangentIndexValid = false;
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// ReplaceRule
+//
+// Purpose: Parse a RULE statement and replace the rule of the same
+//          name, keeping the AND/OR/ACT methods of the old rule
+//
+// Arguments: ruleText : "RULE name : IF ... THEN ... ;"
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::ReplaceRule( const string& ruleText ) {
+
+  int status = 0;
+
+  RuleStatement ruleStatement;
+  ruleStatement.FCLFileLine   = ruleText;
+  ruleStatement.ruleBlockName = "ReplaceRule";
+  ruleStatement.andMethod     = 0;
+  ruleStatement.orMethod      = 0;
+  ruleStatement.actMethod     = 0;
+
+  FuzzyRuleClass* lpFRC = 0;
+  status = ParseRuleEdit( &ruleStatement, &lpFRC );
+  if ( status != 0 ) {
+    return status;
+  }
+
+  map< string, FuzzyRuleClass* >::iterator fri = 
+    Rules.find( lpFRC->ruleName );
+  if ( fri == Rules.end() ) {
+    status = -1;
+    ErrMsg("ReplaceRule() Failed to find rule", lpFRC->ruleName, status);
+    DeleteRule( lpFRC );
+    return status;
+  }
+
+  lpFRC->andMethod = fri->second->andMethod;
+  lpFRC->orMethod  = fri->second->orMethod;
+  lpFRC->actMethod = fri->second->actMethod;
+
+  DeleteRule( fri->second );
+  fri->second = lpFRC;
+  tangentIndexValid = false;
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// RemoveRule
+//
+// Purpose: Delete a rule from the loaded model
+//
+// Arguments: ruleName
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::RemoveRule( const string& ruleName ) {
+
+  int status = 0;
+
+  map< string, FuzzyRuleClass* >::iterator fri = Rules.find( ruleName );
+  if ( fri == Rules.end() ) {
+    status = -1;
+    ErrMsg("RemoveRule() Failed to find rule", ruleName, status);
+    return status;
+  }
+  DeleteRule( fri->second );
+  Rules.erase( fri );
+  tangentIndexValid = false;
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// SetRuleWeight
+//
+// Purpose: Set the WITH weight of every conclusion of a rule
+//
+// Arguments: ruleName
+//            weight
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::SetRuleWeight( const string& ruleName, 
+				      double weight ) {
+
+  int status = 0;
+
+  map< string, FuzzyRuleClass* >::iterator fri = Rules.find( ruleName );
+  if ( fri == Rules.end() ) {
+    status = -1;
+    ErrMsg("SetRuleWeight() Failed to find rule", ruleName, status);
+    return status;
+  }
+  if ( weight < 0. or weight > 1. ) {
+    status = -1;
+    ErrMsg("SetRuleWeight() Weight is not in [0, 1]", weight, status);
+    return status;
+  }
+
+  vector<Conclusion*>& conclusions = fri->second->Conclusions;
+  for ( unsigned int i = 0; i < conclusions.size(); i++ ) {
+    conclusions[i]->weight = weight;
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// ClassifyTermPoints
+//
+// Purpose: Term type of a set of term points, as the FUZZIFY and
+//          DEFUZZIFY parsers classify them, after checking that x
+//          does not decrease and y is a membership in [0, 1]
+//
+// Arguments: x, y    : term points
+//            nPoints : number of points
+//           
+// Return: Singleton, Ramp, Triangle, Rectangle, Trapezoid, -1 if
+//         the points are invalid
+//--------------------------------------------------------------
+static int ClassifyTermPoints( const double* x, const double* y, 
+			       int nPoints ) {
+
+  for ( int i = 0; i < nPoints; i++ ) {
+    if ( y[i] < 0. or y[i] > 1. ) {
+      return -1;
+    }
+    if ( i > 0 and x[i] < x[i-1] ) {
+      return -1;
+    }
+  }
+
+  switch ( nPoints ) {
+  case 1:
+    return Singleton;
+  case 2:
+    return Ramp;
+  case 3:
+    return Triangle;
+  case 4:
+    if ( x[0] == x[1] and x[2] == x[3] ) {
+      return Rectangle;
+    }
+    if ( x[0] != x[1] and x[2] != x[3] ) {
+      return Trapezoid;
+    }
+    return -1;
+  default:
+    return -1;
+  };
+}
+
+//--------------------------------------------------------------
+// SetInputTermPoints
+//
+// Purpose: Move the breakpoints of an input term in place. The
+//          memberships are computed from the points by each
+//          SetInputs(), there is no derived data to update, the
+//          new points apply from the next fuzzification.
+//
+// Arguments: inputHandle : from InputHandle()
+//            termName    : TERM of the input variable
+//            x, y        : nPoints new points
+//            nPoints     : number of points of the term
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::SetInputTermPoints( int inputHandle, 
+					   const string& termName,
+					   const double* x, const double* y, 
+					   int nPoints ) {
+
+  int status = 0;
+
+  if ( inputHandle < 0 or 
+       inputHandle >= (int) InputVariableVector.size() ) {
+    status = -1;
+    ErrMsg("SetInputTermPoints() Invalid input handle", inputHandle, status);
+    return status;
+  }
+  FuzzyInputClass* lpFIC = InputVariableVector[inputHandle];
+
+  map<string, FuzzyInputTerm*> :: iterator fti = 
+    lpFIC->InputTerms.find( termName );
+  if ( fti == lpFIC->InputTerms.end() ) {
+    status = -1;
+    ErrMsg("SetInputTermPoints() Failed to find term", 
+	   lpFIC->varName + " IS " + termName, status);
+    return status;
+  }
+  FuzzyInputTerm* lpFIT = fti->second;
+
+  if ( nPoints != (int) lpFIT->xy.size() or
+       ClassifyTermPoints( x, y, nPoints ) != lpFIT->termType ) {
+    status = -1;
+    ErrMsg("SetInputTermPoints() Points change the shape of term", 
+	   lpFIC->varName + " IS " + termName, status);
+    return status;
+  }
+
+  for ( int i = 0; i < nPoints; i++ ) {
+    lpFIT->xy[i]->x = x[i];
+    lpFIT->xy[i]->y = y[i];
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// SetOutputTermPoints
+//
+// Purpose: Move the breakpoints of an output term in place. The
+//          activation and accumulation terms are rebuilt from the
+//          FCL defined term by each Evaluate(), so only the term
+//          itself changes.
+//
+// Arguments: outputHandle : from OutputHandle()
+//            termName     : TERM of the output variable
+//            x, y         : nPoints new points, a Singleton term
+//                           takes x[0]
+//            nPoints      : number of points of the term
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::SetOutputTermPoints( int outputHandle, 
+					    const string& termName,
+					    const double* x, const double* y, 
+					    int nPoints ) {
+
+  int status = 0;
+
+  if ( outputHandle < 0 or 
+       outputHandle >= (int) OutputVariableVector.size() ) {
+    status = -1;
+    ErrMsg("SetOutputTermPoints() Invalid output handle", 
+	   outputHandle, status);
+    return status;
+  }
+  FuzzyOutputClass* lpFOC = OutputVariableVector[outputHandle];
+
+  map<string, FuzzyOutputTerm*> :: iterator oti = 
+    lpFOC->OutputTerms.find( termName );
+  if ( oti == lpFOC->OutputTerms.end() ) {
+    status = -1;
+    ErrMsg("SetOutputTermPoints() Failed to find term", 
+	   lpFOC->varName + " IS " + termName, status);
+    return status;
+  }
+  FuzzyOutputTerm* lpFOT = oti->second;
+
+  int nTermPoints = lpFOT->termType == Singleton ? 1 : lpFOT->xy.size();
+  if ( nPoints != nTermPoints or
+       ClassifyTermPoints( x, y, nPoints ) != lpFOT->termType ) {
+    status = -1;
+    ErrMsg("SetOutputTermPoints() Points change the shape of term", 
+	   lpFOC->varName + " IS " + termName, status);
+    return status;
+  }
+
+  if ( lpFOT->termType == Singleton ) {
+    lpFOT->singleton.x = x[0];
+    return status;
+  }
+  for ( int i = 0; i < nPoints; i++ ) {
+    lpFOT->xy[i]->x = x[i];
+    lpFOT->xy[i]->y = y[i];
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// ClearModel
+//
+// Purpose: Delete the InputVariables, OutputVariables and Rules
+//          with their terms, conditions and conclusions, leaving
+//          an empty model that can be parsed or loaded again
+//
+// Arguments: 
+//           
+// Return: status  
+//--------------------------------------------------------------
+int FuzzyControlClass::ClearModel() {
+
+  int status = 0;
+
+  map< string, FuzzyInputClass*  >::iterator fii;
+  map< string, FuzzyOutputClass* >::iterator foi;
+  map< string, FuzzyRuleClass*   >::iterator fri;
+  map< string, FuzzyInputTerm*   >::iterator iti;
+  map< string, FuzzyOutputTerm*  >::iterator oti;
+  vector< XY* >::iterator xyi;
+
+  for ( fri = Rules.begin(); fri != Rules.end(); ++fri ) {
+    DeleteRule( fri->second );
+  }
+  Rules.clear();
+  tangentIndexValid = false;
+
+  for ( fii = InputVariables.begin(); fii != InputVariables.end(); ++fii ) {
+    for ( iti = fii->second->InputTerms.begin(); 
+	  iti != fii->second->InputTerms.end(); ++iti ) {
+      for ( xyi = iti->second->xy.begin(); 
+	    xyi != iti->second->xy.end(); ++xyi ) {
+	delete *xyi;
+      }
+      delete iti->second;
+    }
+    delete fii->second;
+  }
+  InputVariables.clear();
+  InputVariableVector.clear();
+
+  for ( foi = OutputVariables.begin(); foi != OutputVariables.end(); ++foi ){
+    for ( oti = foi->second->OutputTerms.begin(); 
+	  oti != foi->second->OutputTerms.end(); ++oti ) {
+      for ( xyi = oti->second->xy.begin(); 
+	    xyi != oti->second->xy.end(); ++xyi ) {
+	delete *xyi;
+      }
+      delete oti->second;
+    }
+    for ( oti = foi->second->AccumulationTerms.begin(); 
+	  oti != foi->second->AccumulationTerms.end(); ++oti ) {
+      ReleaseTermXY( oti->second );
+      for ( xyi = oti->second->xyFree.begin(); 
+	    xyi != oti->second->xyFree.end(); ++xyi ) {
+	delete *xyi;
+      }
+      delete oti->second;
+    }
+    delete foi->second;
+  }
+  OutputVariables.clear();
+  OutputVariableVector.clear();
+
+  return status;
+}
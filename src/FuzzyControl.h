@@ -10,6 +10,9 @@ using namespace std;
 #include <cmath>     // fabs
 #include <cstdlib>   // atof
 #include <algorithm> // find
+#include <stdint.h>  // uint32_t, uint64_t for the model snapshot
+
+#include "FuzzyGzip.h"
 
 #include "FCLL_Version.h"
 #include "FCL_Keyword.h"
@@ -33,6 +36,29 @@ enum term { Trapezoid,
 // Define direction of search for FindNoWhiteSpace()
 enum direction { back, forward };
 
+// Binary model snapshot format version, see FCL_Snapshot.cc
+// Increment when the SaveModel() layout changes
+#define FCL_SNAPSHOT_VERSION    2
+#define FCL_SNAPSHOT_BYTE_ORDER 0x01020304
+
+// Number of RULE statements parsed per thread pool work item
+#define RULE_PARSE_CHUNK 256
+
+//------------------------------------------------------------------
+// struct TangentSeed
+//
+// Purpose: The value OutputTangents() differentiates with respect
+//          to, one of input, inputTerm, outputTerm or conclusion is
+//          set, the others are 0
+//------------------------------------------------------------------
+struct TangentSeed {
+  FuzzyInputClass* input;      // input value
+  FuzzyInputTerm*  inputTerm;  // x of xy[point]
+  FuzzyOutputTerm* outputTerm; // x of xy[point], a Singleton's x is point 0
+  Conclusion*      conclusion; // WITH weight
+  int              point;
+};
+
 //------------------------------------------------------------------
 // class FuzzyControl
 //
@@ -45,14 +71,17 @@ class FuzzyControlClass {
 
   string inputFCL; // string to hold single line of FCL during read
   vector< string > FCLFileVector; // vector to hold all FCL file lines
+  string functionBlockName;       // name from FUNCTION_BLOCK, if any
 
   ifstream FCLFileStream;    // FCL file stream access object
   ofstream OutputDataStream; // Output data file stream access object
+  FuzzyGzipBufferClass OutputBuffer; // OutputDataStream of a .gz file
 
   string FCLFileName;      // FCL file name container
   string outputFileName;   // output data file name 
   string inputDelimeters;  // Line parsing delimeters for input data file
   string inputDataLabel;   // Column name to put labels in InputLabels
+  string snapshotFileName; // Binary model snapshot, if empty not used
 
   // The FCL keyword map, the key is a string which is the keyword, 
   // the values are pointer to FCL_keyword struct, one for each keyword
@@ -75,6 +104,11 @@ class FuzzyControlClass {
   // OutputTerms map has one entry for each defuzzification term.
   map < string, FuzzyOutputClass* > OutputVariables; 
 
+  // The input and output variables in VAR_INPUT/VAR_OUTPUT declaration
+  // order, the order of the values of SetInputs() and GetOutputs()
+  vector < FuzzyInputClass* >  InputVariableVector;
+  vector < FuzzyOutputClass* > OutputVariableVector;
+
   // FuzzyRulesClass Map: The rules map.
   // The key is a string which is the name of the rule, 
   // the values are a FuzzyRuleClass, one for each rule.
@@ -87,6 +121,27 @@ class FuzzyControlClass {
   // If there is a inputDataLabel input, this stack holds the labels
   vector < string > InputLabels;
 
+  // EvaluateTangents() state and OutputTangents() work space
+  vector < double > tangentInputs;    // evaluated input values
+  vector < int >    tangentAccuTypes; // accumulation term types
+  vector < double > tangentStrengths; // d rule strength / d seed
+  // conclusions of each output term, in Rules order, the ones of
+  // accumulation term n start at tangentTermStart[n]
+  vector < Conclusion* >     tangentConclusions;
+  vector < FuzzyRuleClass* > tangentConclusionRules;
+  vector < int >             tangentConclusionRuleIndex;
+  vector < int >             tangentTermStart;
+  // the conclusion index is built by EvaluateTangents(), cleared
+  // wherever the Rules map changes
+  bool tangentIndexValid;
+
+ private:
+  // Not copyable, the destructor frees the variables, terms and rules
+  // it owns. Declared and not defined, a model is copied by
+  // FCL_CloneModels() from its SaveModel() image.
+  FuzzyControlClass( const FuzzyControlClass& );
+  FuzzyControlClass& operator=( const FuzzyControlClass& );
+
  public:
   // Encapsulation methods for protected variables
   string  FCLFile()  const { return FCLFileName; }
@@ -101,24 +156,53 @@ class FuzzyControlClass {
   string  InputDataLabel()  const { return inputDataLabel; }
   string &InputDataLabel()        { return inputDataLabel; }
 
-  map<string, FCL_keyword*>  Keywords()  const { return keywords; }
+  string  SnapshotFile() const { return snapshotFileName; }
+  string &SnapshotFile()       { return snapshotFileName; }
+
+  vector< string >  FCLLines() const { return FCLFileVector; }
+  vector< string > &FCLLines()       { return FCLFileVector; }
+
+  string  FunctionBlockName() const { return functionBlockName; }
+  string &FunctionBlockName()       { return functionBlockName; }
+
+  // The const accessors of the containers return references, so a
+  // read only caller, such as a monitor, does not copy the model
+  const map<string, FCL_keyword*> &Keywords()  const { return keywords; }
   map<string, FCL_keyword*> &Keywords()        { return keywords; }
   
-  map <string, FuzzyInputClass*> InputVariablesMap() 
+  const map <string, FuzzyInputClass*> &InputVariablesMap() 
     const { return InputVariables; }
   map <string, FuzzyInputClass*> &InputVariablesMap() 
     { return InputVariables; }
 
-  map <string, FuzzyOutputClass*>  OutputVariablesMap() 
+  const map <string, FuzzyOutputClass*> &OutputVariablesMap() 
     const { return OutputVariables; }
   map <string, FuzzyOutputClass*> &OutputVariablesMap() 
     { return OutputVariables; }
 
-  map <string, FuzzyRuleClass*>  RulesMap() const { return Rules; }
+  const vector <FuzzyInputClass*> &InputVariablesVector() 
+    const { return InputVariableVector; }
+  vector <FuzzyInputClass*> &InputVariablesVector() 
+    { return InputVariableVector; }
+
+  const vector <FuzzyOutputClass*> &OutputVariablesVector() 
+    const { return OutputVariableVector; }
+  vector <FuzzyOutputClass*> &OutputVariablesVector() 
+    { return OutputVariableVector; }
+
+  int NumInputs()  const { return InputVariableVector.size(); }
+  int NumOutputs() const { return OutputVariableVector.size(); }
+  int NumRules()   const { return Rules.size(); }
+  int NumInputTerms() const;
+
+  const map <string, FuzzyRuleClass*> &RulesMap() const { return Rules; }
   map <string, FuzzyRuleClass*> &RulesMap()       { return Rules; }
 
-  map <string, vector<double>* > InputDataMap() const { return InputData; }
-  map <string, vector<double>* > InputDataMap()       { return InputData; }
+  const map <string, vector<double>* > &InputDataMap() const 
+    { return InputData; }
+  map <string, vector<double>* > &InputDataMap() { return InputData; }
+
+  const vector <string> &InputLabelsVector() const { return InputLabels; }
 
   // Access pointers into the keywords map for convenience
   // These are publically accessible, and probably shouldn't be,
@@ -170,9 +254,12 @@ class FuzzyControlClass {
   FuzzyControlClass( string FCLFileName, 
 		     string inputDelimeters,
 		     string inputDataLabel ); 
+  // Destructor
+  ~FuzzyControlClass();
 
   int Fuzzification( int inputDataIndex );
-  int FuzzifyInput ( string varName, double inputValue );
+  int FuzzifyInput ( const string& varName, double inputValue );
+  int FuzzifyVariable( FuzzyInputClass* lpFIC, double inputValue );
 
   int Aggregation();
 
@@ -184,15 +271,68 @@ class FuzzyControlClass {
 
   int Defuzzification();
 
+  int SetInputs ( const double* inputValues );
+  int Evaluate  ();
+  int GetOutputs( double* outputValues );
+
+  // Variable handles, the index of a variable in declaration order,
+  // resolved once so that SetInput() and GetOutput() need no name
+  int InputHandle ( const string& varName ) const;
+  int OutputHandle( const string& varName ) const;
+  int SetInput    ( int inputHandle, double inputValue );
+  int GetOutput   ( int outputHandle, double* outputValue ) const;
+
+  // Evaluation state sampling into caller buffers, without copies of
+  // the model. Memberships are NumInputTerms() values, the terms of
+  // each input in declaration order, in InputTerms map order within
+  // an input. Rule strengths are NumRules() aggregated condition
+  // values in Rules map order.
+  int GetMemberships  ( double* memberships ) const;
+  int GetRuleStrengths( double* strengths ) const;
+
+  // Rule edits on a loaded model, see FuzzyControl.cc. ruleText is a
+  // RULE statement as in a RULEBLOCK, an empty method is the default.
+  int AddRule      ( const string& ruleText,  const string& andMethod,
+		     const string& orMethod,  const string& actMethod );
+  int ReplaceRule  ( const string& ruleText );
+  int RemoveRule   ( const string& ruleName );
+  int SetRuleWeight( const string& ruleName, double weight );
+
+  // Term breakpoint edits, the new points must give the same term
+  // type. x, y are nPoints values, an output Singleton is one point.
+  int SetInputTermPoints ( int inputHandle,  const string& termName,
+			   const double* x, const double* y, int nPoints );
+  int SetOutputTermPoints( int outputHandle, const string& termName,
+			   const double* x, const double* y, int nPoints );
+
+  // Derivatives of the outputs, forward mode through the evaluation,
+  // see FuzzyJacobian.cc. OutputTangents() differentiates the last
+  // EvaluateTangents(), tangents is NumOutputs() values.
+  int Jacobian        ( const double* inputValues, double* jacobian );
+  int EvaluateTangents( const double* inputValues );
+  int OutputTangents  ( const TangentSeed* seed, double* tangents );
+
+  int ClearModel();
+
   // FCL File IO Methods
   int ReadFCLFile         ();
+  int WriteFCLFile        ( string *fileName );
   int ReadInputDataFile   ( string *fileName );
+  int ReadInputDataColumns( string *fileName, 
+			    const vector< string >* lpColumns );
   int OpenOutputFile      ( string *fileName );
   int CloseOutputFile     ();
   int WriteTimestepOutput ( int iteration );
   int WriteOutputHeader   ();
   int WriteOutput         ();
 
+  // Binary model snapshot methods in FCL_Snapshot.cc
+  int FCLTextHash       ( uint64_t* hash );
+  int SaveModel         ( string* buffer );
+  int LoadModel         ( const char* data, size_t size );
+  int WriteSnapshotFile ( string* fileName, uint64_t FCLHash );
+  int ReadSnapshotFile  ( string* fileName, uint64_t FCLHash );
+
   // FCL Parsing Methods
   int ParseFCLFile             ();
   int LoadFCLKeywords          ( map< string, FCL_keyword* >& keywords );
@@ -201,9 +341,11 @@ class FuzzyControlClass {
   int ParseFCL_Input_Fuzzify   ();
   int ParseFCL_Output_Defuzzify();
   int ParseFCL_Rules           ();
+  int ParseFCL_Rule            ( RuleStatement* lpRS, FuzzyRuleClass** lpFRC );
+  int ParseRuleEdit            ( RuleStatement* lpRS, FuzzyRuleClass** lpFRC );
 
-  int SplitLine( vector<string> *subCondTerms, 
-		 string *conditionString, string *delimeters );
+  static int SplitLine( vector<string> *subCondTerms, 
+			string *conditionString, string *delimeters );
 
   string::size_type FindNoWhiteSpace( string str, 
 				      string::size_type offset, int direction );
@@ -217,15 +359,78 @@ class FuzzyControlClass {
   int CheckFuzzyTermParen( string * FCLFileLine );
 };
 
+//------------------------------------------------------------------
+// struct RuleChunkArg
+//
+// Purpose: Shared argument to the ParseFCL_RuleChunk() workers
+//------------------------------------------------------------------
+struct RuleChunkArg {
+  FuzzyControlClass*        lpFC;
+  vector< RuleStatement >*  ruleStatements; // RULEs in file order
+  vector< FuzzyRuleClass* >* parsedRules;   // one slot per RULE
+  vector< int >*            ruleStatus;     // one status per RULE
+};
+
+void ParseFCL_RuleChunk( void* arg, int threadIndex, int begin, int end );
+
+// Delete a rule that is not in the Rules map, in FuzzyControl.cc
+void DeleteRule( FuzzyRuleClass* lpFRC );
+
+// Thread pool functions in FCL_Thread.cc
+// The work function is called with the items [begin, end)
+typedef void (*FCL_ParallelFunc)( void* arg, int threadIndex, 
+				  int begin, int end );
+
+int FCL_NumThreads ();
+int FCL_ParallelFor( int nItems, int chunkSize, 
+		     FCL_ParallelFunc func, void* arg, int nThreads );
+int FCL_CloneModels( FuzzyControlClass* lpFC, int nClones,
+		     vector< FuzzyControlClass* >* lpClones );
+
 // API functions in FuzzyControlAPI.cc
 int FuzzyControl_SingleInput ( FuzzyControlClass* lpFC );
 int FuzzyControl_SeriesInput ( FuzzyControlClass* lpFC, int numDataPoints );
 int FuzzyControl_Fuzzify     ( FuzzyControlClass* lpFC, 
-			       string varName, double inputValue );
+			       const string& varName, double inputValue );
 int FuzzyControl_Aggregation     ( FuzzyControlClass* lpFC );
 int FuzzyControl_Activation      ( FuzzyControlClass* lpFC );
 int FuzzyControl_Accumulation    ( FuzzyControlClass* lpFC );
 int FuzzyControl_Defuzzification ( FuzzyControlClass* lpFC );
+int FuzzyControl_EvaluateBatch   ( FuzzyControlClass* lpFC, int nPoints,
+				   const double* inputs, double* outputs );
+int FuzzyControl_InputHandle     ( FuzzyControlClass* lpFC, 
+				   const string& varName, int* handle );
+int FuzzyControl_OutputHandle    ( FuzzyControlClass* lpFC, 
+				   const string& varName, int* handle );
+int FuzzyControl_SetInput        ( FuzzyControlClass* lpFC, 
+				   int handle, double inputValue );
+int FuzzyControl_Evaluate        ( FuzzyControlClass* lpFC );
+int FuzzyControl_GetOutput       ( FuzzyControlClass* lpFC, 
+				   int handle, double* outputValue );
+int FuzzyControl_AddRule         ( FuzzyControlClass* lpFC, 
+				   const string& ruleText,
+				   const string& andMethod,
+				   const string& orMethod,
+				   const string& actMethod );
+int FuzzyControl_ReplaceRule     ( FuzzyControlClass* lpFC, 
+				   const string& ruleText );
+int FuzzyControl_RemoveRule      ( FuzzyControlClass* lpFC, 
+				   const string& ruleName );
+int FuzzyControl_SetRuleWeight   ( FuzzyControlClass* lpFC, 
+				   const string& ruleName, double weight );
+int FuzzyControl_SetInputTermPoints ( FuzzyControlClass* lpFC, 
+				      int handle, const string& termName,
+				      const double* x, const double* y, 
+				      int nPoints );
+int FuzzyControl_SetOutputTermPoints( FuzzyControlClass* lpFC, 
+				      int handle, const string& termName,
+				      const double* x, const double* y, 
+				      int nPoints );
+int FuzzyControl_Jacobian        ( FuzzyControlClass* lpFC, 
+				   const double* inputs, double* outputs,
+				   double* jacobian );
+
+string FCL_VersionString();
 
 int FuzzyControl_ReadFCL          ( FuzzyControlClass* lpFC );
 int FuzzyControl_IO_Files         ( FuzzyControlClass* lpFC, 
@@ -276,7 +481,8 @@ void DebugMsg   ( string      msg, string arg,      int status );
 void DebugMsg   ( string      msg, int arg,         int status );
 void DebugMsg   ( string      msg, double arg,      int status );
 #else
-#define DebugMsg
+// Arguments are not evaluated, no string is built per call
+#define DebugMsg(msg, arg, status)
 #endif
 #ifdef DEBUG_ALL
 void DebugAllMsg( const char *msg, const char *arg, int status );
@@ -288,7 +494,7 @@ void DebugAllMsg( string      msg, string arg,      int status );
 void DebugAllMsg( string      msg, int arg,         int status );
 void DebugAllMsg( string      msg, double arg,      int status );
 #else
-#define DebugAllMsg
+#define DebugAllMsg(msg, arg, status)
 #endif
 
 void PrintKeywordMap       ( map< string, FCL_keyword* >      *keywords );
@@ -1,5 +1,6 @@
 
 #include "FuzzyControl.h"
+#include "FuzzyGraph.h"
 
 //--------------------------------------------------------------
 // FuzzyControl_SingleInput
@@ -164,7 +165,7 @@ int FuzzyControl_SeriesInput(FuzzyControlClass* lpFC, int numDataPoints) {
 // Return: status, 0 = OK, , nonzero = ERR
 //--------------------------------------------------------------
 int FuzzyControl_Fuzzify( FuzzyControlClass* lpFC, 
-			  string varName, double inputValue ) {
+			  const string& varName, double inputValue ) {
 
   int status = 0;
   if (not lpFC) {
@@ -285,10 +286,340 @@ int FuzzyControl_Defuzzification(FuzzyControlClass* lpFC) {
   return status;
 }
 
+//--------------------------------------------------------------
+// FuzzyControl_EvaluateBatch
+//
+// Purpose: Run control on nPoints input points in order
+//
+// Arguments: pointer to FuzzyControlClass
+//            nPoints : number of points
+//            inputs  : nPoints rows of NumInputs() values
+//            outputs : nPoints rows of NumOutputs() values
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_EvaluateBatch(FuzzyControlClass* lpFC, int nPoints,
+			       const double* inputs, double* outputs) {
+
+  int status = 0;
+  if (not lpFC) {
+    status = -1;
+    ErrMsg("FuzzyControl_EvaluateBatch()", "Invalid FuzzyControlClass", 
+	   status);
+    return status;
+  }
+
+  int nInputs  = lpFC->NumInputs();
+  int nOutputs = lpFC->NumOutputs();
+
+  for ( int i = 0; i < nPoints; i++ ) {
+    status = lpFC->SetInputs( inputs + i * nInputs );
+    if ( status != 0 ) {
+      ErrMsg("FuzzyControl_EvaluateBatch() SetInputs Failed at point",
+	     i, status);
+      return status;
+    }
+    status = lpFC->Evaluate();
+    if ( status != 0 ) {
+      ErrMsg("FuzzyControl_EvaluateBatch() Evaluate Failed at point",
+	     i, status);
+      return status;
+    }
+    lpFC->GetOutputs( outputs + i * nOutputs );
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_InputHandle
+//
+// Purpose: Resolve an input variable name to a handle for
+//          FuzzyControl_SetInput()
+//
+// Arguments: pointer to FuzzyControlClass
+//            varName : name of the VAR_INPUT variable
+//            handle  : set to the handle
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_InputHandle(FuzzyControlClass* lpFC, 
+			     const string& varName, int* handle) {
+
+  int status = 0;
+  if (not lpFC) {
+    status = -1;
+    ErrMsg("FuzzyControl_InputHandle()", "Invalid FuzzyControlClass", 
+	   status);
+    return status;
+  }
+
+  *handle = lpFC->InputHandle( varName );
+  if ( *handle < 0 ) {
+    status = -1;
+    ErrMsg("FuzzyControl_InputHandle() No input variable", varName, status);
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_OutputHandle
+//
+// Purpose: Resolve an output variable name to a handle for
+//          FuzzyControl_GetOutput()
+//
+// Arguments: pointer to FuzzyControlClass
+//            varName : name of the VAR_OUTPUT variable
+//            handle  : set to the handle
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_OutputHandle(FuzzyControlClass* lpFC, 
+			      const string& varName, int* handle) {
+
+  int status = 0;
+  if (not lpFC) {
+    status = -1;
+    ErrMsg("FuzzyControl_OutputHandle()", "Invalid FuzzyControlClass", 
+	   status);
+    return status;
+  }
+
+  *handle = lpFC->OutputHandle( varName );
+  if ( *handle < 0 ) {
+    status = -1;
+    ErrMsg("FuzzyControl_OutputHandle() No output variable", varName, 
+	   status);
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_SetInput
+//
+// Purpose: FUZZIFICATION of one input variable by handle
+//
+// Arguments: pointer to FuzzyControlClass
+//            handle : from FuzzyControl_InputHandle()
+//            inputValue
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_SetInput(FuzzyControlClass* lpFC, 
+			  int handle, double inputValue) {
+
+  if (not lpFC) {
+    ErrMsg("FuzzyControl_SetInput()", "Invalid FuzzyControlClass", -1);
+    return -1;
+  }
+  return lpFC->SetInput( handle, inputValue );
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_Evaluate
+//
+// Purpose: INFERENCE and DEFUZZIFICATION on the fuzzified inputs
+//
+// Arguments: pointer to FuzzyControlClass
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_Evaluate(FuzzyControlClass* lpFC) {
+
+  if (not lpFC) {
+    ErrMsg("FuzzyControl_Evaluate()", "Invalid FuzzyControlClass", -1);
+    return -1;
+  }
+  return lpFC->Evaluate();
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_GetOutput
+//
+// Purpose: Defuzzified value of one output variable by handle
+//
+// Arguments: pointer to FuzzyControlClass
+//            handle      : from FuzzyControl_OutputHandle()
+//            outputValue : set to the output
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_GetOutput(FuzzyControlClass* lpFC, 
+			   int handle, double* outputValue) {
+
+  if (not lpFC or not outputValue) {
+    ErrMsg("FuzzyControl_GetOutput()", "Invalid argument", -1);
+    return -1;
+  }
+  return lpFC->GetOutput( handle, outputValue );
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_AddRule
+//
+// Purpose: Insert a RULE statement into the loaded model
+//
+// Arguments: pointer to FuzzyControlClass
+//            ruleText : "RULE name : IF ... THEN ... ;"
+//            andMethod, orMethod, actMethod : "" for the default
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_AddRule(FuzzyControlClass* lpFC, const string& ruleText,
+			 const string& andMethod, const string& orMethod,
+			 const string& actMethod) {
+
+  if (not lpFC) {
+    ErrMsg("FuzzyControl_AddRule()", "Invalid FuzzyControlClass", -1);
+    return -1;
+  }
+  return lpFC->AddRule( ruleText, andMethod, orMethod, actMethod );
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_ReplaceRule
+//
+// Purpose: Replace the rule named in a RULE statement
+//
+// Arguments: pointer to FuzzyControlClass
+//            ruleText : "RULE name : IF ... THEN ... ;"
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_ReplaceRule(FuzzyControlClass* lpFC, 
+			     const string& ruleText) {
+
+  if (not lpFC) {
+    ErrMsg("FuzzyControl_ReplaceRule()", "Invalid FuzzyControlClass", -1);
+    return -1;
+  }
+  return lpFC->ReplaceRule( ruleText );
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_RemoveRule
+//
+// Purpose: Delete a rule from the loaded model
+//
+// Arguments: pointer to FuzzyControlClass
+//            ruleName
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_RemoveRule(FuzzyControlClass* lpFC, 
+			    const string& ruleName) {
+
+  if (not lpFC) {
+    ErrMsg("FuzzyControl_RemoveRule()", "Invalid FuzzyControlClass", -1);
+    return -1;
+  }
+  return lpFC->RemoveRule( ruleName );
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_SetRuleWeight
+//
+// Purpose: Set the WITH weight of the conclusions of a rule
+//
+// Arguments: pointer to FuzzyControlClass
+//            ruleName
+//            weight : in [0, 1]
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_SetRuleWeight(FuzzyControlClass* lpFC, 
+			       const string& ruleName, double weight) {
+
+  if (not lpFC) {
+    ErrMsg("FuzzyControl_SetRuleWeight()", "Invalid FuzzyControlClass", -1);
+    return -1;
+  }
+  return lpFC->SetRuleWeight( ruleName, weight );
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_SetInputTermPoints
+//
+// Purpose: Move the breakpoints of an input term
+//
+// Arguments: pointer to FuzzyControlClass
+//            handle   : from FuzzyControl_InputHandle()
+//            termName : TERM of the input variable
+//            x, y     : nPoints new points
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_SetInputTermPoints(FuzzyControlClass* lpFC, int handle,
+				    const string& termName, 
+				    const double* x, const double* y,
+				    int nPoints) {
+
+  if (not lpFC or not x or not y) {
+    ErrMsg("FuzzyControl_SetInputTermPoints()", "Invalid argument", -1);
+    return -1;
+  }
+  return lpFC->SetInputTermPoints( handle, termName, x, y, nPoints );
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_SetOutputTermPoints
+//
+// Purpose: Move the breakpoints of an output term
+//
+// Arguments: pointer to FuzzyControlClass
+//            handle   : from FuzzyControl_OutputHandle()
+//            termName : TERM of the output variable
+//            x, y     : nPoints new points
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_SetOutputTermPoints(FuzzyControlClass* lpFC, int handle,
+				     const string& termName, 
+				     const double* x, const double* y,
+				     int nPoints) {
+
+  if (not lpFC or not x or not y) {
+    ErrMsg("FuzzyControl_SetOutputTermPoints()", "Invalid argument", -1);
+    return -1;
+  }
+  return lpFC->SetOutputTermPoints( handle, termName, x, y, nPoints );
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_Jacobian
+//
+// Purpose: Evaluate one input row and the derivatives of the 
+//          outputs with respect to the inputs
+//
+// Arguments: pointer to FuzzyControlClass
+//            inputs   : NumInputs() values in declaration order
+//            outputs  : NumOutputs() values, 0 if not needed
+//            jacobian : NumOutputs() rows of NumInputs() values
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_Jacobian(FuzzyControlClass* lpFC, const double* inputs,
+			  double* outputs, double* jacobian) {
+
+  int status = 0;
+  if (not lpFC or not inputs or not jacobian) {
+    status = -1;
+    ErrMsg("FuzzyControl_Jacobian()", "Invalid argument", status);
+    return status;
+  }
+  status = lpFC->Jacobian( inputs, jacobian );
+  if ( status == 0 and outputs ) {
+    status = lpFC->GetOutputs( outputs );
+  }
+  return status;
+}
+
 //--------------------------------------------------------------
 // FuzzyControlReadFCL
 //
 // Purpose: Read & Parse the FCL file, init all FuzzyControl maps
+//          If SnapshotFile() is set the model is loaded from the
+//          snapshot when it matches the FCL text, otherwise the
+//          FCL file is parsed and the snapshot (re)written.
 //
 // Arguments: pointer to FuzzyControlClass
 //           
@@ -302,6 +633,24 @@ int FuzzyControl_ReadFCL(FuzzyControlClass* lpFC) {
     ErrMsg("FuzzyControl_ReadFCL()", "Invalid FuzzyControlClass", status);
     return status;
   }
+
+  // If a snapshot file is set, and it was built from the current
+  // FCL text, load the model from it instead of parsing the FCL file
+  uint64_t FCLHash = 0;
+  string   snapshotFile = lpFC->SnapshotFile();
+  if ( not snapshotFile.empty() ) {
+    status = lpFC->FCLTextHash( &FCLHash );
+    if ( status != 0 ) {
+      ErrMsg( "Failed to read FCL file", lpFC->FCLFile(), status );
+      return status;
+    }
+    if ( lpFC->ReadSnapshotFile( &snapshotFile, FCLHash ) == 0 ) {
+      return status;
+    }
+    // missing, stale or unreadable: start over from the FCL file
+    lpFC->ClearModel();
+  }
+
   // Open the FCL file, buffer contents, close file
   status = lpFC->ReadFCLFile();
   if ( status != 0 ) {
@@ -315,6 +664,14 @@ int FuzzyControl_ReadFCL(FuzzyControlClass* lpFC) {
     ErrMsg( "Failed to parse FCL file", lpFC->FCLFile(), status );
     return status;
   }
+
+  // Save the parsed model for the next run, a failure to write the
+  // snapshot is not an error for this run
+  if ( not snapshotFile.empty() ) {
+    if ( lpFC->WriteSnapshotFile( &snapshotFile, FCLHash ) != 0 ) {
+      ConsoleMsg( "Failed to write snapshot file", snapshotFile, 1 );
+    }
+  }
   return status;
 }
 
@@ -494,6 +851,136 @@ int FuzzyControl_CloseOutputFile(FuzzyControlClass* lpFC) {
   return status;
 }
 
+//--------------------------------------------------------------
+// FuzzyControl_GraphReadFCL
+//
+// Purpose: Read & Parse the FUNCTION_BLOCKs of the FCL files,
+//          link them into a dataflow graph
+//
+// Arguments: pointer to FuzzyGraphClass, FCL file names
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_GraphReadFCL(FuzzyGraphClass* lpFG, 
+			      vector< string >* FCLFiles) {
+
+  int status = 0;
+  if (not lpFG) {
+    status = -1;
+    ErrMsg("FuzzyControl_GraphReadFCL()", "Invalid FuzzyGraphClass", status);
+    return status;
+  }
+
+  status = lpFG->ReadFCLFiles( FCLFiles );
+  if ( status != 0 ) {
+    ErrMsg( "Failed to read FCL files", FCLFiles->front(), status );
+    return status;
+  }
+
+  status = lpFG->Link();
+  if ( status != 0 ) {
+    ErrMsg( "Failed to link FUNCTION_BLOCKs", FCLFiles->front(), status );
+    return status;
+  }
+
+  DebugMsg( "FuzzyControl_GraphReadFCL() FUNCTION_BLOCKs", 
+	    lpFG->NumBlocks(), status );
+  return status;
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_GraphIO_Files
+//
+// Purpose: Open I/O files, buffer the graph input data
+//
+// Arguments: pointer to FuzzyGraphClass
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_GraphIO_Files(FuzzyGraphClass* lpFG, 
+			       string* inputDataFileName,
+			       string* outputDataFileName, 
+			       int *numPointsRead) {
+
+  int status = 0;
+  if (not lpFG) {
+    status = -1;
+    ErrMsg("FuzzyControl_GraphIO_Files()", "Invalid FuzzyGraphClass", status);
+    return status;
+  }
+
+  int numDataPoints = lpFG->ReadInputDataFile( inputDataFileName );
+  if ( numDataPoints < 0 ) {
+    status = -1;
+    ErrMsg( "Failed to read input data file", 
+	    *inputDataFileName, numDataPoints );
+    return status;
+  }
+  *numPointsRead = numDataPoints;
+
+  // Open the output data file if requested
+  if ( not outputDataFileName->empty() ) {
+    status = lpFG->OpenOutputFile( outputDataFileName );
+    if ( status != 0 ) {
+      return status;
+    }
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_GraphSeriesInput
+//
+// Purpose: Run the graph on the buffered input data
+//
+// Arguments: pointer to FuzzyGraphClass, number of data points
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_GraphSeriesInput(FuzzyGraphClass* lpFG, int numDataPoints) {
+
+  int status = 0;
+  if (not lpFG) {
+    status = -1;
+    ErrMsg("FuzzyControl_GraphSeriesInput()", 
+	   "Invalid FuzzyGraphClass", status);
+    return status;
+  }
+
+  status = lpFG->SeriesInput( numDataPoints );
+  if ( status != 0 ) {
+    ErrMsg("SeriesInput() Failed.", numDataPoints, status);
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_GraphCloseOutputFile
+//
+// Purpose: 
+//
+// Arguments: pointer to FuzzyGraphClass
+//           
+// Return: status, 0 = OK, nonzero = ERR
+//--------------------------------------------------------------
+int FuzzyControl_GraphCloseOutputFile(FuzzyGraphClass* lpFG) {
+
+  int status = 0;
+  if (not lpFG) {
+    status = -1;
+    ErrMsg("FuzzyControl_GraphCloseOutputFile()", 
+	   "Invalid FuzzyGraphClass", status);
+    return status;
+  }
+  if ( not lpFG->OutputFileName().empty() ) {
+    status = lpFG->CloseOutputFile();
+    if ( status != 0 ) {
+      ErrMsg("CloseOutputFile() Failed.", lpFG->OutputFileName(), status);
+    }
+  }
+  return status;
+}
+
 //--------------------------------------------------------------
 // FuzzyControl_PrintKeywordMap
 //
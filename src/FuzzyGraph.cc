@@ -0,0 +1,627 @@
+#include "FuzzyGraph.h"
+#include <set> // graph input names
+
+//--------------------------------------------------------------
+// struct GraphLevelArg
+//
+// Purpose: Shared argument to the EvaluateGraphLevel() workers
+//--------------------------------------------------------------
+struct GraphLevelArg {
+  FuzzyGraphClass* lpFG;
+  vector< int >*   level;      // node indices of the level
+  vector< int >*   nodeStatus; // one status per node of the level
+};
+
+//--------------------------------------------------------------
+// EvaluateGraphLevel
+//
+// Purpose: FCL_ParallelFor() worker for Evaluate(), evaluates the
+//          independent nodes [begin, end) of a dependency level
+//
+// Arguments: arg         : pointer to GraphLevelArg
+//            threadIndex : unused
+//            begin, end  : range of nodes in the level
+//
+// Return:
+//--------------------------------------------------------------
+static void EvaluateGraphLevel( void* arg, int threadIndex,
+				int begin, int end ) {
+
+  GraphLevelArg* lpGLA = (GraphLevelArg*) arg;
+
+  for ( int i = begin; i < end; i++ ) {
+    (*lpGLA->nodeStatus)[i] = lpGLA->lpFG->EvaluateNode( (*lpGLA->level)[i] );
+  }
+}
+
+//--------------------------------------------------------------
+// FuzzyGraphClass
+//
+// Purpose: Constructor for FuzzyGraphClass
+//
+// Arguments: inputDelimeters, inputDataLabel as FuzzyControlClass
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyGraphClass::FuzzyGraphClass( string delimeters, string dataLabel ) {
+
+  status = 0;
+
+  if ( not delimeters.length() ) {
+    // Assume the input data file is .csv format
+    InputDelimeters() = ",";
+  }
+  else {
+    InputDelimeters() = delimeters;
+  }
+  InputDataLabel() = dataLabel;
+}
+
+//--------------------------------------------------------------
+// ~FuzzyGraphClass
+//
+// Purpose: Destructor for FuzzyGraphClass, delete the blocks
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyGraphClass::~FuzzyGraphClass() {
+
+  for ( vector< FuzzyGraphNode* >::iterator ni = Nodes.begin();
+	ni != Nodes.end(); ++ni ) {
+    delete (*ni)->lpFC;
+    delete *ni;
+  }
+}
+
+//--------------------------------------------------------------
+// ReadFCLFiles
+//
+// Purpose: Read the FCL files, split each one into its
+//          FUNCTION_BLOCK ... END_FUNCTION_BLOCK sections and
+//          parse each section into its own FuzzyControlClass.
+//          A file without FUNCTION_BLOCK is a single block named
+//          after the file.
+//
+// Arguments: fileNames : FCL files
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGraphClass::ReadFCLFiles( vector< string >* fileNames ) {
+
+  status = 0;
+
+  for ( vector< string >::iterator fni = fileNames->begin();
+	fni != fileNames->end(); ++fni ) {
+
+    // Read and clean the FCL lines with a FuzzyControlClass
+    FuzzyControlClass reader( *fni, inputDelimeters, inputDataLabel );
+    status = reader.ReadFCLFile();
+    if ( status != 0 ) {
+      ErrMsg( "Failed to read FCL file", *fni, status );
+      return status;
+    }
+    vector< string > FCLLines = reader.FCLLines();
+
+    string beginKey = reader.keyword_FuncBlock->keyword;
+    string endKey   = reader.keyword_EndFuncBlock->keyword;
+
+    // Find the sections, [begin, end] line indices
+    vector< pair< int, int > > sections;
+    vector< string >           blockNames;
+    int begin = -1;
+
+    for ( int i = 0; i < (int) FCLLines.size(); i++ ) {
+      string::size_type position;
+      if ( FCLLines[i].find( endKey ) != string::npos ) {
+	if ( begin < 0 ) {
+	  status = -1;
+	  ErrMsg( "Found END_FUNCTION_BLOCK without FUNCTION_BLOCK in",
+		  *fni, status );
+	  return status;
+	}
+	sections.push_back( pair< int, int >( begin, i ) );
+	begin = -1;
+      }
+      else if ( ( position = FCLLines[i].find( beginKey ) ) != string::npos ) {
+	if ( begin >= 0 ) {
+	  status = -1;
+	  ErrMsg( "Found FUNCTION_BLOCK without END_FUNCTION_BLOCK in",
+		  *fni, status );
+	  return status;
+	}
+	begin = i;
+	vector< string > words;
+	string blockLine = FCLLines[i].substr( position + beginKey.length() );
+	string delimeters = " \t";
+	reader.SplitLine( &words, &blockLine, &delimeters );
+	blockNames.push_back( words.size() ? words[0] : *fni );
+      }
+    }
+    if ( begin >= 0 ) {
+      status = -1;
+      ErrMsg( "Missing END_FUNCTION_BLOCK in", *fni, status );
+      return status;
+    }
+    if ( sections.empty() ) {
+      sections.push_back( pair< int, int >( 0, FCLLines.size() - 1 ) );
+      blockNames.push_back( *fni );
+    }
+
+    // Parse each section as a FuzzyControlClass
+    for ( unsigned int s = 0; s < sections.size(); s++ ) {
+      for ( vector< FuzzyGraphNode* >::iterator ni = Nodes.begin();
+	    ni != Nodes.end(); ++ni ) {
+	if ( (*ni)->blockName == blockNames[s] ) {
+	  status = -1;
+	  ErrMsg( "Found redundant FUNCTION_BLOCK", blockNames[s], status );
+	  return status;
+	}
+      }
+
+      FuzzyGraphNode* lpNode = new FuzzyGraphNode;
+      if ( not lpNode ) {
+	status = -1;
+	ErrMsg( "Failed to create FuzzyGraphNode for", blockNames[s], status );
+	return status;
+      }
+      lpNode->blockName = blockNames[s];
+      lpNode->level     = -1;
+      lpNode->lpFC      = new FuzzyControlClass( *fni, inputDelimeters,
+						 inputDataLabel );
+      if ( not lpNode->lpFC ) {
+	status = -1;
+	ErrMsg( "Failed to create FuzzyControlClass for",
+		blockNames[s], status );
+	delete lpNode;
+	return status;
+      }
+      Nodes.push_back( lpNode );
+
+      lpNode->lpFC->FunctionBlockName() = blockNames[s];
+      lpNode->lpFC->FCLLines().assign( FCLLines.begin() + sections[s].first,
+				       FCLLines.begin() + sections[s].second
+				       + 1 );
+
+      status = lpNode->lpFC->ParseFCLFile();
+      if ( status != 0 ) {
+	ErrMsg( "Failed to parse FUNCTION_BLOCK",
+		blockNames[s] + " in " + *fni, status );
+	return status;
+      }
+      DebugMsg( "Parsed FUNCTION_BLOCK", blockNames[s], status );
+    }
+  }
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// Link
+//
+// Purpose: Connect block outputs to the block inputs of the same
+//          name, collect the graph inputs and outputs, and sort the
+//          blocks into dependency levels. Fails if an output name is
+//          produced by more than one block or the blocks form a cycle.
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGraphClass::Link() {
+
+  status = 0;
+
+  int nNodes = Nodes.size();
+
+  map< string, FuzzyOutputClass* >::iterator foi;
+  map< string, FuzzyInputClass*  >::iterator fii;
+
+  // The producing node and variable of each output name
+  map< string, pair< int, FuzzyOutputClass* > > producers;
+  map< string, pair< int, FuzzyOutputClass* > >::iterator pi;
+
+  for ( int n = 0; n < nNodes; n++ ) {
+    map< string, FuzzyOutputClass* > &outputs =
+      Nodes[n]->lpFC->OutputVariablesMap();
+    for ( foi = outputs.begin(); foi != outputs.end(); ++foi ) {
+      if ( producers.find( foi->first ) != producers.end() ) {
+	status = -1;
+	ErrMsg( "Output variable is produced by more than one block",
+		foi->first, status );
+	return status;
+      }
+      producers[ foi->first ] = pair< int, FuzzyOutputClass* >( n,
+								 foi->second );
+    }
+  }
+
+  // Link the inputs, collect the names of the graph inputs
+  set< string > graphInputs;
+
+  for ( int n = 0; n < nNodes; n++ ) {
+    FuzzyGraphNode* lpNode = Nodes[n];
+    map< string, FuzzyInputClass* > &inputs =
+      lpNode->lpFC->InputVariablesMap();
+
+    for ( fii = inputs.begin(); fii != inputs.end(); ++fii ) {
+      pi = producers.find( fii->first );
+      if ( pi == producers.end() ) {
+	graphInputs.insert( fii->first );
+	continue;
+      }
+      if ( pi->second.first == n ) {
+	status = -1;
+	ErrMsg( "Block output feeds its own input",
+		lpNode->blockName + " " + fii->first, status );
+	return status;
+      }
+      FuzzyGraphLink link;
+      link.source = pi->second.second;
+      link.target = fii->second;
+      lpNode->links.push_back( link );
+      if ( find( lpNode->producers.begin(), lpNode->producers.end(),
+		 pi->second.first ) == lpNode->producers.end() ) {
+	lpNode->producers.push_back( pi->second.first );
+      }
+      DebugMsg( "Linked " + fii->first + " to block",
+		lpNode->blockName, 0 );
+    }
+  }
+
+  InputNames.assign( graphInputs.begin(), graphInputs.end() );
+  inputValues.assign( InputNames.size(), 0. );
+
+  for ( int n = 0; n < nNodes; n++ ) {
+    FuzzyGraphNode* lpNode = Nodes[n];
+    map< string, FuzzyInputClass* > &inputs =
+      lpNode->lpFC->InputVariablesMap();
+    for ( fii = inputs.begin(); fii != inputs.end(); ++fii ) {
+      vector< string >::iterator ini =
+	find( InputNames.begin(), InputNames.end(), fii->first );
+      if ( ini != InputNames.end() ) {
+	FuzzyGraphInput input;
+	input.inputIndex = ini - InputNames.begin();
+	input.target     = fii->second;
+	lpNode->inputs.push_back( input );
+      }
+    }
+  }
+
+  // Outputs in name order
+  for ( pi = producers.begin(); pi != producers.end(); ++pi ) {
+    OutputNames.push_back( pi->first );
+    Outputs.push_back( pi->second.second );
+  }
+
+  // Assign levels, a node is one level above its deepest producer
+  int nAssigned = 0;
+  bool progress = true;
+  while ( progress ) {
+    progress = false;
+    for ( int n = 0; n < nNodes; n++ ) {
+      FuzzyGraphNode* lpNode = Nodes[n];
+      if ( lpNode->level >= 0 ) {
+	continue;
+      }
+      int  level = 0;
+      bool ready = true;
+      for ( vector< int >::iterator pni = lpNode->producers.begin();
+	    pni != lpNode->producers.end(); ++pni ) {
+	if ( Nodes[ *pni ]->level < 0 ) {
+	  ready = false;
+	  break;
+	}
+	level = max( level, Nodes[ *pni ]->level + 1 );
+      }
+      if ( ready ) {
+	lpNode->level = level;
+	if ( (int) Levels.size() <= level ) {
+	  Levels.resize( level + 1 );
+	}
+	Levels[ level ].push_back( n );
+	nAssigned++;
+	progress = true;
+      }
+    }
+  }
+  if ( nAssigned != nNodes ) {
+    status = -1;
+    for ( int n = 0; n < nNodes; n++ ) {
+      if ( Nodes[n]->level < 0 ) {
+	ErrMsg( "FUNCTION_BLOCK is part of a dependency cycle",
+		Nodes[n]->blockName, status );
+      }
+    }
+    return status;
+  }
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// SetInput
+//
+// Purpose: Set the value of a graph input for the next Evaluate()
+//
+// Arguments: inputIndex : index into InputVariableNames()
+//            inputValue
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGraphClass::SetInput( int inputIndex, double inputValue ) {
+
+  if ( inputIndex < 0 or inputIndex >= (int) inputValues.size() ) {
+    ErrMsg( "SetInput() Invalid graph input index", inputIndex, -1 );
+    return -1;
+  }
+  inputValues[ inputIndex ] = inputValue;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// EvaluateNode
+//
+// Purpose: Fuzzify the inputs of a block from the graph inputs and
+//          the outputs of its producers, then run the inference and
+//          defuzzification of the block
+//
+// Arguments: node : index into Nodes
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGraphClass::EvaluateNode( int node ) {
+
+  int status = 0;
+  FuzzyGraphNode*    lpNode = Nodes[ node ];
+  FuzzyControlClass* lpFC   = lpNode->lpFC;
+
+  for ( vector< FuzzyGraphInput >::iterator ii = lpNode->inputs.begin();
+	ii != lpNode->inputs.end(); ++ii ) {
+    status = lpFC->FuzzifyVariable( ii->target, inputValues[ ii->inputIndex ] );
+    if ( status != 0 ) {
+      ErrMsg( "Failed to fuzzify input variable", ii->target->varName, status );
+      return status;
+    }
+  }
+  for ( vector< FuzzyGraphLink >::iterator li = lpNode->links.begin();
+	li != lpNode->links.end(); ++li ) {
+    status = lpFC->FuzzifyVariable( li->target, li->source->defuzzOut );
+    if ( status != 0 ) {
+      ErrMsg( "Failed to fuzzify linked variable", li->target->varName,
+	      status );
+      return status;
+    }
+  }
+
+  status = lpFC->Aggregation();
+  if ( status != 0 ) {
+    ErrMsg("Aggregation Failed.", lpNode->blockName, status);
+    return status;
+  }
+  status = lpFC->Activation();
+  if ( status != 0 ) {
+    ErrMsg("Activation Failed.", lpNode->blockName, status);
+    return status;
+  }
+  status = lpFC->Accumulation();
+  if ( status != 0 ) {
+    ErrMsg("Accumulation Failed.", lpNode->blockName, status);
+    return status;
+  }
+  status = lpFC->Defuzzification();
+  if ( status != 0 ) {
+    ErrMsg("Defuzzification Failed.", lpNode->blockName, status);
+    return status;
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// Evaluate
+//
+// Purpose: Evaluate the blocks level by level, the blocks within
+//          a level are independent and run concurrently
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGraphClass::Evaluate() {
+
+  status = 0;
+
+  for ( vector< vector< int > >::iterator li = Levels.begin();
+	li != Levels.end(); ++li ) {
+
+    if ( li->size() == 1 ) {
+      status = EvaluateNode( li->front() );
+      if ( status != 0 ) {
+	return status;
+      }
+      continue;
+    }
+
+    vector< int > nodeStatus( li->size(), 0 );
+    GraphLevelArg graphLevelArg;
+    graphLevelArg.lpFG       = this;
+    graphLevelArg.level      = &(*li);
+    graphLevelArg.nodeStatus = &nodeStatus;
+
+    FCL_ParallelFor( li->size(), 1, EvaluateGraphLevel, &graphLevelArg, 0 );
+
+    for ( vector< int >::iterator si = nodeStatus.begin();
+	  si != nodeStatus.end(); ++si ) {
+      if ( *si != 0 ) {
+	status = *si;
+	return status;
+      }
+    }
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// ReadInputDataFile
+//
+// Purpose: Buffer the graph input data values, read with the
+//          FuzzyControlClass::ReadInputDataColumns() of a reader
+//          model, so a .gz file is read as well. Columns that are
+//          not graph inputs or the label are ignored, every graph
+//          input must have a column.
+//
+// Arguments: fileName
+//
+// Return: Number of points read, or error code
+//--------------------------------------------------------------
+int FuzzyGraphClass::ReadInputDataFile( string *fileName ) {
+
+  if ( Nodes.empty() ) {
+    ErrMsg( "ReadInputDataFile() No FUNCTION_BLOCK read", *fileName, -1 );
+    return -1;
+  }
+
+  FuzzyControlClass reader( "", InputDelimeters(), InputDataLabel() );
+
+  int numPointsRead = reader.ReadInputDataColumns( fileName, &InputNames );
+  if ( numPointsRead < 0 ) {
+    return numPointsRead;
+  }
+
+  // Take the column of each graph input from the reader
+  map< string, vector< double >* > &readerData = reader.InputDataMap();
+  InputData.assign( InputNames.size(), vector< double >() );
+
+  for ( int i = 0; i < (int) InputNames.size(); i++ ) {
+    map< string, vector< double >* >::iterator idi =
+      readerData.find( InputNames[i] );
+    if ( idi == readerData.end() ) {
+      ErrMsg( "Input data file has no column for graph input",
+	      InputNames[i], -1 );
+      return -1;
+    }
+    InputData[i].swap( *idi->second );
+  }
+  InputLabels = reader.InputLabelsVector();
+
+  return numPointsRead;
+}
+
+//--------------------------------------------------------------
+// OpenOutputFile
+//
+// Purpose:
+//
+// Arguments: fileName
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGraphClass::OpenOutputFile( string *fileName ) {
+
+  int status = 0;
+
+  OutputDataStream.open( fileName->c_str(), ios::out );
+  if ( not OutputDataStream ) {
+    status = -1;
+    ErrMsg( "Failed to open output data file:", *fileName, status );
+    return status;
+  }
+  outputFileName = *fileName;
+  return status;
+}
+
+//--------------------------------------------------------------
+// CloseOutputFile
+//
+// Purpose:
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGraphClass::CloseOutputFile() {
+
+  OutputDataStream.close();
+  return 0;
+}
+
+//--------------------------------------------------------------
+// WriteTimestepOutput
+//
+// Purpose: Write the graph inputs and all block outputs, in the
+//          format of FuzzyControlClass::WriteTimestepOutput()
+//
+// Arguments: index : data point index
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGraphClass::WriteTimestepOutput( int index ) {
+
+  int status = 0;
+  unsigned int i = 0;
+
+  // Write a header of graph inputs, outputs
+  if ( index == 0 ) {
+    OutputDataStream << "index, ";
+    if ( InputLabels.size() ) {
+      OutputDataStream << InputDataLabel() << ", ";
+    }
+    for ( i = 0; i < InputNames.size(); i++ ) {
+      OutputDataStream << InputNames[i] << ", ";
+    }
+    for ( i = 0; i < OutputNames.size(); i++ ) {
+      OutputDataStream << OutputNames[i] << ", ";
+    }
+    OutputDataStream << "\n";
+  }
+
+  // Write a line of data for this index
+  OutputDataStream << index << ", ";
+  if ( InputLabels.size() ) {
+    OutputDataStream << InputLabels[ index ] << ", ";
+  }
+  for ( i = 0; i < inputValues.size(); i++ ) {
+    OutputDataStream << inputValues[i] << ", ";
+  }
+  for ( i = 0; i < Outputs.size(); i++ ) {
+    OutputDataStream << Outputs[i]->defuzzOut << ", ";
+  }
+  OutputDataStream << "\n";
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// SeriesInput
+//
+// Purpose: Run the graph on the buffered input data, write the
+//          output data if an output file is open
+//
+// Arguments: numDataPoints : from ReadInputDataFile()
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGraphClass::SeriesInput( int numDataPoints ) {
+
+  status = 0;
+
+  for ( int i = 0; i < numDataPoints; i++ ) {
+    for ( unsigned int j = 0; j < InputData.size(); j++ ) {
+      inputValues[j] = InputData[j][i];
+    }
+    status = Evaluate();
+    if ( status != 0 ) {
+      ErrMsg( "Graph evaluation failed at index", i, status );
+      return status;
+    }
+    if ( not outputFileName.empty() ) {
+      status = WriteTimestepOutput( i );
+      if ( status != 0 ) {
+	ErrMsg( "WriteTimestepOutput() Failed.", outputFileName, status );
+	return status;
+      }
+    }
+  }
+  return status;
+}
@@ -0,0 +1,132 @@
+#ifndef Fuzzy_Graph_H
+#define Fuzzy_Graph_H
+
+#include "FuzzyControl.h"
+
+//---------------------------------------------------------------------
+// struct FuzzyGraphLink
+//
+// Purpose: Passes the defuzzOut of a VAR_OUTPUT in one function block
+//          to the VAR_INPUT of the same name in another block.
+//          Resolved once by Link(), evaluation uses the pointers only.
+//---------------------------------------------------------------------
+struct FuzzyGraphLink {
+  FuzzyOutputClass* source; // VAR_OUTPUT of the producing block
+  FuzzyInputClass*  target; // VAR_INPUT of the consuming block
+};
+
+//---------------------------------------------------------------------
+// struct FuzzyGraphInput
+//
+// Purpose: A VAR_INPUT of a block that no block produces, it is fed
+//          from the graph input values at index inputIndex
+//---------------------------------------------------------------------
+struct FuzzyGraphInput {
+  int              inputIndex; // index into FuzzyGraphClass::inputValues
+  FuzzyInputClass* target;     // VAR_INPUT of the block
+};
+
+//---------------------------------------------------------------------
+// struct FuzzyGraphNode
+//
+// Purpose: A FUNCTION_BLOCK in the dataflow graph
+//---------------------------------------------------------------------
+struct FuzzyGraphNode {
+  string             blockName; // name from FUNCTION_BLOCK
+  FuzzyControlClass* lpFC;      // the parsed block
+
+  vector< FuzzyGraphInput > inputs; // inputs fed from the graph inputs
+  vector< FuzzyGraphLink >  links;  // inputs fed from other blocks
+  vector< int >             producers; // nodes this node depends on
+
+  int level; // dependency level, 0 if fed only by graph inputs
+};
+
+//---------------------------------------------------------------------
+// class FuzzyGraphClass
+//
+// Purpose: Several FUNCTION_BLOCKs, from one or more FCL files,
+//          evaluated as a dependency DAG. A block VAR_INPUT with the
+//          name of another block's VAR_OUTPUT is fed from it, the
+//          remaining VAR_INPUTs are the graph inputs. The blocks of
+//          each dependency level are independent and are evaluated
+//          concurrently on the FCL_ParallelFor() thread pool.
+//---------------------------------------------------------------------
+class FuzzyGraphClass {
+
+ protected:
+  int status; // Error code variable
+
+  string inputDelimeters;  // Line parsing delimeters for input data file
+  string inputDataLabel;   // Column name to put labels in InputLabels
+  string outputFileName;   // output data file name
+
+  ofstream OutputDataStream; // Output data file stream access object
+
+  // The blocks in the order they appear in the FCL files
+  vector< FuzzyGraphNode* > Nodes;
+
+  // Node indices of each dependency level, Levels[0] first
+  vector< vector< int > > Levels;
+
+  // Graph input variable names, sorted, and their current values
+  vector< string > InputNames;
+  vector< double > inputValues;
+
+  // Graph output variables, every block VAR_OUTPUT, sorted by name
+  vector< string >            OutputNames;
+  vector< FuzzyOutputClass* > Outputs;
+
+  // Input Data container, one vector per InputNames entry
+  vector< vector< double > > InputData;
+
+  // If there is a inputDataLabel input, this stack holds the labels
+  vector< string > InputLabels;
+
+ public:
+  // Encapsulation methods for protected variables
+  string  InputDelimeters() const { return inputDelimeters; }
+  string &InputDelimeters()       { return inputDelimeters; }
+
+  string  InputDataLabel()  const { return inputDataLabel; }
+  string &InputDataLabel()        { return inputDataLabel; }
+
+  string  OutputFileName()  const { return outputFileName; }
+
+  vector< string > InputVariableNames()  const { return InputNames; }
+  vector< string > OutputVariableNames() const { return OutputNames; }
+
+  int NumBlocks() const { return Nodes.size(); }
+  int NumLevels() const { return Levels.size(); }
+
+  // FuzzyGraph Methods
+  FuzzyGraphClass( string inputDelimeters, string inputDataLabel );
+  ~FuzzyGraphClass();
+
+  int ReadFCLFiles( vector< string >* fileNames );
+  int Link();
+
+  int SetInput ( int inputIndex, double inputValue );
+  int Evaluate ();
+  int EvaluateNode( int node );
+  double Output( int outputIndex ) const
+    { return Outputs[ outputIndex ]->defuzzOut; }
+
+  int ReadInputDataFile   ( string *fileName );
+  int OpenOutputFile      ( string *fileName );
+  int CloseOutputFile     ();
+  int WriteTimestepOutput ( int index );
+  int SeriesInput         ( int numDataPoints );
+};
+
+// Graph API functions in FuzzyControlAPI.cc
+int FuzzyControl_GraphReadFCL        ( FuzzyGraphClass* lpFG,
+				       vector< string >* FCLFiles );
+int FuzzyControl_GraphIO_Files       ( FuzzyGraphClass* lpFG,
+				       string* inFile, string* outFile,
+				       int* numPointsRead );
+int FuzzyControl_GraphSeriesInput    ( FuzzyGraphClass* lpFG,
+				       int numDataPoints );
+int FuzzyControl_GraphCloseOutputFile( FuzzyGraphClass* lpFG );
+
+#endif
@@ -0,0 +1,249 @@
+#include "FuzzyGroup.h"
+
+//--------------------------------------------------------------
+// GroupItems
+//
+// Purpose: FCL_ParallelFor() worker for Run(), the items are the
+//          groups
+//
+// Arguments: arg         : pointer to the FuzzyGroupClass
+//            threadIndex : model clone of the thread
+//            begin, end  : range of groups
+//
+// Return:
+//--------------------------------------------------------------
+static void GroupItems( void* arg, int threadIndex, int begin, int end ) {
+
+  FuzzyGroupClass* lpGroup = (FuzzyGroupClass*) arg;
+
+  for ( int group = begin; group < end; group++ ) {
+    lpGroup->EvaluateGroup( threadIndex, group );
+  }
+}
+
+//--------------------------------------------------------------
+// FuzzyGroupClass
+//
+// Purpose: Constructor for FuzzyGroupClass
+//
+// Arguments: lpFC : the parsed model
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyGroupClass::FuzzyGroupClass( FuzzyControlClass* lpFC ) {
+
+  status     = 0;
+  this->lpFC = lpFC;
+  nRows      = 0;
+}
+
+//--------------------------------------------------------------
+// ~FuzzyGroupClass
+//
+// Purpose: Destructor for FuzzyGroupClass, delete the model
+//          clones
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyGroupClass::~FuzzyGroupClass() {
+
+  for ( int i = 0; i < (int) Workers.size(); i++ ) {
+    delete Workers[i];
+  }
+}
+
+//--------------------------------------------------------------
+// Partition
+//
+// Purpose: Split the InputData rows of the model into groups by
+//          their InputLabels value, copy the input data into rows
+//          in input handle order, and keep the model output state
+//
+// Arguments: numDataPoints : number of InputData rows
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGroupClass::Partition( int numDataPoints ) {
+
+  const vector< string >& labels = lpFC->InputLabelsVector();
+  int nInputs = lpFC->NumInputs();
+
+  if ( (int) labels.size() < numDataPoints ) {
+    status = -1;
+    ErrMsg( "Partition() No input label column for the rows of",
+	    lpFC->FCLFile(), status );
+    return status;
+  }
+
+  nRows = numDataPoints;
+  Inputs.assign( nRows * nInputs, 0. );
+  for ( int j = 0; j < nInputs; j++ ) {
+    const string& varName = lpFC->InputVariablesVector()[j]->varName;
+    map< string, vector< double >* >::const_iterator idi =
+      lpFC->InputDataMap().find( varName );
+    if ( idi == lpFC->InputDataMap().end() or
+	 (int) idi->second->size() < nRows ) {
+      status = -1;
+      ErrMsg( "Partition() No input data for", varName, status );
+      return status;
+    }
+    for ( int row = 0; row < nRows; row++ ) {
+      Inputs[ row * nInputs + j ] = (*idi->second)[ row ];
+    }
+  }
+
+  groupLabels.clear();
+  groupRows.clear();
+  map< string, int > groupIndex;
+  for ( int row = 0; row < nRows; row++ ) {
+    map< string, int >::iterator gi = groupIndex.find( labels[ row ] );
+    if ( gi == groupIndex.end() ) {
+      gi = groupIndex.insert( make_pair( labels[ row ],
+					 (int) groupLabels.size() ) ).first;
+      groupLabels.push_back( labels[ row ] );
+      groupRows.push_back( vector< int >() );
+    }
+    groupRows[ gi->second ].push_back( row );
+  }
+
+  initialOutputs.assign( lpFC->NumOutputs(), 0. );
+  lpFC->GetOutputs( initialOutputs.empty() ? 0 : &initialOutputs[0] );
+  return 0;
+}
+
+//--------------------------------------------------------------
+// EvaluateGroup
+//
+// Purpose: Evaluate the rows of a group in order on the model
+//          clone of the thread, from the initial output state
+//
+// Arguments: threadIndex : index into Workers
+//            group       : index into groupRows
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyGroupClass::EvaluateGroup( int threadIndex, int group ) {
+
+  FuzzyControlClass*           lpModel  = Workers[ threadIndex ];
+  vector< FuzzyOutputClass* > &outputs  = lpModel->OutputVariablesVector();
+  const vector< int >         &rows     = groupRows[ group ];
+  int                          nInputs  = lpModel->NumInputs();
+  int                          nOutputs = outputs.size();
+
+  for ( int k = 0; k < nOutputs; k++ ) {
+    outputs[k]->defuzzOut = initialOutputs[k];
+  }
+
+  int status = 0;
+  for ( unsigned int r = 0; r < rows.size(); r++ ) {
+    int row = rows[r];
+    status = lpModel->SetInputs( &Inputs[ row * nInputs ] );
+    if ( status == 0 ) {
+      status = lpModel->Evaluate();
+    }
+    if ( status != 0 ) {
+      ErrMsg( "EvaluateGroup() Failed at row", row, status );
+      break;
+    }
+    lpModel->GetOutputs( &Outputs[ row * nOutputs ] );
+  }
+  groupStatus[ group ] = status;
+}
+
+//--------------------------------------------------------------
+// Run
+//
+// Purpose: Evaluate the groups on the FCL_ParallelFor() thread
+//          pool
+//
+// Arguments:
+//
+// Return: status, of the first group that failed
+//--------------------------------------------------------------
+int FuzzyGroupClass::Run() {
+
+  int nThreads = FCL_NumThreads();
+
+  if ( nRows < 1 or lpFC->NumInputs() < 1 ) {
+    status = -1;
+    ErrMsg( "Run() No input data or inputs for", lpFC->FCLFile(), status );
+    return status;
+  }
+
+  // A model clone per thread, from one parsed model
+  status = FCL_CloneModels( lpFC, nThreads, &Workers );
+  if ( status != 0 ) {
+    ErrMsg( "Run() Failed to clone model", lpFC->FCLFile(), status );
+    return status;
+  }
+
+  Outputs.assign( nRows * lpFC->NumOutputs(), 0. );
+  groupStatus.assign( groupLabels.size(), 0 );
+
+  status = FCL_ParallelFor( groupLabels.size(), 1, GroupItems, this,
+			    Workers.size() );
+  if ( status != 0 ) {
+    ErrMsg( "Run() Failed to evaluate groups of", lpFC->FCLFile(), status );
+    return status;
+  }
+  for ( int g = 0; g < (int) groupLabels.size(); g++ ) {
+    if ( groupStatus[g] != 0 ) {
+      status = groupStatus[g];
+      ErrMsg( "Run() Failed to evaluate group", groupLabels[g], status );
+      return status;
+    }
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// WriteOutput
+//
+// Purpose: Write the rows to the model output file with
+//          WriteTimestepOutput(), the row index is the input data
+//          row. The header is written with row 0, the first row of
+//          the first group.
+//
+// Arguments: grouped : false for file order, true for the rows of
+//                      each group in turn
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGroupClass::WriteOutput( bool grouped ) {
+
+  vector< FuzzyOutputClass* > &outputs  = lpFC->OutputVariablesVector();
+  int                          nOutputs = outputs.size();
+
+  if ( lpFC->OutputFileName().empty() ) {
+    return 0;
+  }
+
+  vector< int > order;
+  order.reserve( nRows );
+  if ( grouped ) {
+    for ( unsigned int g = 0; g < groupRows.size(); g++ ) {
+      order.insert( order.end(), groupRows[g].begin(), groupRows[g].end() );
+    }
+  }
+  else {
+    for ( int row = 0; row < nRows; row++ ) {
+      order.push_back( row );
+    }
+  }
+
+  for ( unsigned int r = 0; r < order.size(); r++ ) {
+    int row = order[r];
+    for ( int k = 0; k < nOutputs; k++ ) {
+      outputs[k]->defuzzOut = Outputs[ row * nOutputs + k ];
+    }
+    status = lpFC->WriteTimestepOutput( row );
+    if ( status != 0 ) {
+      ErrMsg( "WriteOutput() WriteTimestepOutput() Failed.",
+	      lpFC->OutputFileName(), status );
+      return status;
+    }
+  }
+  return 0;
+}
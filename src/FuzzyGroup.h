@@ -0,0 +1,63 @@
+#ifndef Fuzzy_Group_H
+#define Fuzzy_Group_H
+
+#include "FuzzyControl.h"
+
+//---------------------------------------------------------------------
+// class FuzzyGroupClass
+//
+// Purpose: Process the InputData rows of a model as independent
+//          series, one per InputLabels value, such as the stations of
+//          an interleaved data file. Each group starts from the output
+//          state of the parsed model and keeps its own state, the
+//          value an NC output keeps when no rule fires, over its rows
+//          in file order. The groups are spread over the
+//          FCL_ParallelFor() thread pool, one model clone per thread,
+//          so the outputs do not depend on the number of threads.
+//
+//          WriteOutput() writes the rows with the model
+//          WriteTimestepOutput(), in file order or group by group in
+//          order of first appearance.
+//---------------------------------------------------------------------
+class FuzzyGroupClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC; // the parsed model with InputData
+
+  // Model clones, one per thread
+  vector< FuzzyControlClass* > Workers;
+
+  // Output state of the parsed model, the start of each group
+  vector< double > initialOutputs;
+
+  // Group labels in order of first appearance, and their rows
+  vector< string >        groupLabels;
+  vector< vector< int > > groupRows;
+
+  // Input data, nRows rows of NumInputs() values, and the outputs,
+  // nRows rows of NumOutputs() values
+  int              nRows;
+  vector< double > Inputs;
+  vector< double > Outputs;
+
+  // Evaluation status of each group
+  vector< int > groupStatus;
+
+ public:
+  // Encapsulation methods for protected variables
+  int NumGroups() const { return groupLabels.size(); }
+  int NumRows()   const { return nRows; }
+
+  // FuzzyGroup Methods
+  FuzzyGroupClass( FuzzyControlClass* lpFC );
+  ~FuzzyGroupClass();
+
+  int  Partition    ( int numDataPoints );
+  int  Run          ();
+  int  WriteOutput  ( bool grouped );
+  void EvaluateGroup( int threadIndex, int group );
+};
+
+#endif
@@ -0,0 +1,500 @@
+#include "FuzzyControl.h"
+#include <zlib.h>
+
+//--------------------------------------------------------------
+// GzipThread
+//
+// Purpose: pthread start routine of a FuzzyGzipBufferClass
+//
+// Arguments: arg : the FuzzyGzipBufferClass
+//
+// Return: 0
+//--------------------------------------------------------------
+static void* GzipThread( void* arg ) {
+
+  ( (FuzzyGzipBufferClass*) arg )->Run();
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FuzzyGzipBufferClass
+//
+// Purpose: Constructor for FuzzyGzipBufferClass
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyGzipBufferClass::FuzzyGzipBufferClass() {
+
+  status        = 0;
+  lpFile        = 0;
+  output        = false;
+  threadStarted = false;
+  finished      = false;
+  threadStatus  = 0;
+  lpBlock       = 0;
+
+  pthread_mutex_init( &mutex, 0 );
+  pthread_cond_init ( &cond,  0 );
+}
+
+//--------------------------------------------------------------
+// ~FuzzyGzipBufferClass
+//
+// Purpose: Destructor for FuzzyGzipBufferClass, close an open file
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyGzipBufferClass::~FuzzyGzipBufferClass() {
+
+  Close();
+  pthread_cond_destroy ( &cond  );
+  pthread_mutex_destroy( &mutex );
+}
+
+//--------------------------------------------------------------
+// Open
+//
+// Purpose: Open a gzip file and start its thread
+//
+// Arguments: fileName : the .gz file
+//            output   : true to write the file, false to read it
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGzipBufferClass::Open( const string& fileName, bool output ) {
+
+  if ( lpFile ) {
+    status = -1;
+    ErrMsg( "FuzzyGzipBuffer::Open() A file is already open",
+	    this->fileName, status );
+    return status;
+  }
+
+  gzFile file = gzopen( fileName.c_str(), output ? "wb" : "rb" );
+  if ( not file ) {
+    status = -1;
+    ErrMsg( "FuzzyGzipBuffer::Open() Failed to open gzip file",
+	    fileName, status );
+    return status;
+  }
+  gzbuffer( file, FCL_GZIP_BLOCK_SIZE );
+
+  this->fileName = fileName;
+  this->output   = output;
+  lpFile         = file;
+  status         = 0;
+  threadStatus   = 0;
+  finished       = false;
+
+  if ( output ) {
+    try {
+      lpBlock = new vector< char >( FCL_GZIP_BLOCK_SIZE );
+    }
+    catch ( ... ) {
+      lpBlock = 0;
+    }
+    if ( not lpBlock ) {
+      status = -1;
+      ErrMsg( "FuzzyGzipBuffer::Open() Failed to allocate block",
+	      fileName, status );
+      gzclose( file );
+      lpFile = 0;
+      return status;
+    }
+    setp( &(*lpBlock)[0], &(*lpBlock)[0] + lpBlock->size() );
+  }
+  else {
+    setg( 0, 0, 0 );
+  }
+
+  if ( pthread_create( &thread, 0, GzipThread, this ) != 0 ) {
+    status = -1;
+    ErrMsg( "FuzzyGzipBuffer::Open() Failed to start gzip thread",
+	    fileName, status );
+    delete lpBlock;
+    lpBlock = 0;
+    setp( 0, 0 );
+    gzclose( file );
+    lpFile = 0;
+    return status;
+  }
+  threadStarted = true;
+
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Run
+//
+// Purpose: Body of the gzip thread. A reading buffer decompresses
+//          blocks into Blocks until the end of the file, while
+//          fewer than FCL_GZIP_BLOCKS are waiting. A writing buffer
+//          compresses the Blocks until Close(). Errors are kept in
+//          threadStatus and reported by the stream thread.
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyGzipBufferClass::Run() {
+
+  gzFile file = (gzFile) lpFile;
+
+  if ( output ) {
+    pthread_mutex_lock( &mutex );
+    while ( true ) {
+      while ( Blocks.empty() and not finished ) {
+	pthread_cond_wait( &cond, &mutex );
+      }
+      if ( Blocks.empty() ) {
+	break;
+      }
+      vector< char >* lpWrite = Blocks.front();
+      Blocks.pop_front();
+      pthread_cond_broadcast( &cond );
+      pthread_mutex_unlock( &mutex );
+
+      int written = 0;
+      if ( threadStatus == 0 ) {
+	written = gzwrite( file, &(*lpWrite)[0], lpWrite->size() );
+      }
+      delete lpWrite;
+
+      pthread_mutex_lock( &mutex );
+      if ( threadStatus == 0 and written <= 0 ) {
+	threadStatus = -1;
+      }
+    }
+    pthread_mutex_unlock( &mutex );
+    return;
+  }
+
+  while ( true ) {
+    vector< char >* lpRead = 0;
+    try {
+      lpRead = new vector< char >( FCL_GZIP_BLOCK_SIZE );
+    }
+    catch ( ... ) {
+      lpRead = 0;
+    }
+    int nRead = lpRead ? gzread( file, &(*lpRead)[0], lpRead->size() ) : -1;
+    if ( nRead == 0 ) {
+      // A truncated file ends without an error from gzread()
+      int errnum = Z_OK;
+      gzerror( file, &errnum );
+      if ( errnum != Z_OK ) {
+	nRead = -1;
+      }
+    }
+
+    pthread_mutex_lock( &mutex );
+    if ( nRead <= 0 ) {
+      delete lpRead;
+      if ( nRead < 0 ) {
+	threadStatus = -1;
+      }
+      break;
+    }
+    lpRead->resize( nRead );
+    while ( Blocks.size() >= FCL_GZIP_BLOCKS and not finished ) {
+      pthread_cond_wait( &cond, &mutex );
+    }
+    if ( finished ) {
+      // Close() before the end of the file
+      delete lpRead;
+      break;
+    }
+    Blocks.push_back( lpRead );
+    pthread_cond_broadcast( &cond );
+    pthread_mutex_unlock( &mutex );
+  }
+  finished = true;
+  pthread_cond_broadcast( &cond );
+  pthread_mutex_unlock( &mutex );
+}
+
+//--------------------------------------------------------------
+// underflow
+//
+// Purpose: streambuf get area refill, the next block decompressed
+//          by the thread
+//
+// Arguments:
+//
+// Return: the next character, eof at the end of the file or on
+//         error
+//--------------------------------------------------------------
+FuzzyGzipBufferClass::int_type FuzzyGzipBufferClass::underflow() {
+
+  if ( gptr() < egptr() ) {
+    return traits_type::to_int_type( *gptr() );
+  }
+  if ( not lpFile or output ) {
+    return traits_type::eof();
+  }
+
+  delete lpBlock;
+  lpBlock = 0;
+  setg( 0, 0, 0 );
+
+  pthread_mutex_lock( &mutex );
+  while ( Blocks.empty() and not finished ) {
+    pthread_cond_wait( &cond, &mutex );
+  }
+  if ( not Blocks.empty() ) {
+    lpBlock = Blocks.front();
+    Blocks.pop_front();
+    pthread_cond_broadcast( &cond );
+  }
+  int readStatus = threadStatus;
+  pthread_mutex_unlock( &mutex );
+
+  if ( not lpBlock ) {
+    if ( readStatus != 0 and status == 0 ) {
+      status = readStatus;
+      ErrMsg( "FuzzyGzipBuffer::underflow() Failed to read gzip file",
+	      fileName, status );
+    }
+    return traits_type::eof();
+  }
+  char* lpBegin = &(*lpBlock)[0];
+  setg( lpBegin, lpBegin, lpBegin + lpBlock->size() );
+  return traits_type::to_int_type( *gptr() );
+}
+
+//--------------------------------------------------------------
+// PushBlock
+//
+// Purpose: Pass the put area to the compression thread, waiting
+//          while FCL_GZIP_BLOCKS are queued, start a new block
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGzipBufferClass::PushBlock() {
+
+  if ( not lpBlock ) {
+    return -1;
+  }
+  if ( pptr() == pbase() ) {
+    return status;
+  }
+  lpBlock->resize( pptr() - pbase() );
+
+  pthread_mutex_lock( &mutex );
+  while ( Blocks.size() >= FCL_GZIP_BLOCKS and threadStatus == 0 ) {
+    pthread_cond_wait( &cond, &mutex );
+  }
+  Blocks.push_back( lpBlock );
+  pthread_cond_broadcast( &cond );
+  int writeStatus = threadStatus;
+  pthread_mutex_unlock( &mutex );
+
+  try {
+    lpBlock = new vector< char >( FCL_GZIP_BLOCK_SIZE );
+  }
+  catch ( ... ) {
+    lpBlock = 0;
+  }
+  if ( not lpBlock ) {
+    setp( 0, 0 );
+    status = -1;
+    ErrMsg( "FuzzyGzipBuffer::PushBlock() Failed to allocate block",
+	    fileName, status );
+    return status;
+  }
+  setp( &(*lpBlock)[0], &(*lpBlock)[0] + lpBlock->size() );
+
+  if ( writeStatus != 0 and status == 0 ) {
+    status = writeStatus;
+    ErrMsg( "FuzzyGzipBuffer::PushBlock() Failed to write gzip file",
+	    fileName, status );
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// overflow
+//
+// Purpose: streambuf put area full, pass it to the compression
+//          thread and store c in a new block
+//
+// Arguments: c : the character that did not fit, or eof
+//
+// Return: c, eof on error
+//--------------------------------------------------------------
+FuzzyGzipBufferClass::int_type FuzzyGzipBufferClass::overflow( int_type c ) {
+
+  if ( not lpFile or not output or PushBlock() != 0 ) {
+    return traits_type::eof();
+  }
+  if ( traits_type::eq_int_type( c, traits_type::eof() ) ) {
+    return traits_type::not_eof( c );
+  }
+  *pptr() = traits_type::to_char_type( c );
+  pbump( 1 );
+  return c;
+}
+
+//--------------------------------------------------------------
+// Close
+//
+// Purpose: Compress the remaining output, stop the thread, close
+//          the file
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyGzipBufferClass::Close() {
+
+  if ( not lpFile ) {
+    return 0;
+  }
+  if ( output ) {
+    PushBlock();
+  }
+
+  pthread_mutex_lock( &mutex );
+  finished = true;
+  pthread_cond_broadcast( &cond );
+  pthread_mutex_unlock( &mutex );
+
+  if ( threadStarted ) {
+    pthread_join( thread, 0 );
+    threadStarted = false;
+  }
+  for ( unsigned int i = 0; i < Blocks.size(); i++ ) {
+    delete Blocks[i];
+  }
+  Blocks.clear();
+  delete lpBlock;
+  lpBlock = 0;
+  setg( 0, 0, 0 );
+  setp( 0, 0 );
+
+  if ( output and threadStatus != 0 and status == 0 ) {
+    status = threadStatus;
+    ErrMsg( "FuzzyGzipBuffer::Close() Failed to write gzip file",
+	    fileName, status );
+  }
+  if ( gzclose( (gzFile) lpFile ) != Z_OK and output and status == 0 ) {
+    status = -1;
+    ErrMsg( "FuzzyGzipBuffer::Close() Failed to close gzip file",
+	    fileName, status );
+  }
+  lpFile = 0;
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// FCL_IsGzipFile
+//
+// Purpose: Whether a data file is gzip compressed, by its .gz
+//          extension
+//
+// Arguments: fileName
+//
+// Return: true if gzip
+//--------------------------------------------------------------
+bool FCL_IsGzipFile( const string& fileName ) {
+
+  return fileName.size() > 3 and
+         fileName.compare( fileName.size() - 3, 3, ".gz" ) == 0;
+}
+
+//--------------------------------------------------------------
+// FCL_OpenInputStream
+//
+// Purpose: Open a data file for reading, a .gz file through
+//          lpBuffer, any other file as the stream's own file
+//
+// Arguments: lpStream : closed stream
+//            fileName : data file
+//            lpBuffer : closed buffer, open while the stream is
+//
+// Return: status
+//--------------------------------------------------------------
+int FCL_OpenInputStream( ifstream* lpStream, const string& fileName,
+			 FuzzyGzipBufferClass* lpBuffer ) {
+
+  if ( not FCL_IsGzipFile( fileName ) ) {
+    lpStream->open( fileName.c_str(), ios::in );
+    return *lpStream ? 0 : -1;
+  }
+  if ( lpBuffer->Open( fileName, false ) != 0 ) {
+    lpStream->setstate( ios::failbit );
+    return -1;
+  }
+  static_cast< ios& >( *lpStream ).rdbuf( lpBuffer );
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FCL_OpenOutputStream
+//
+// Purpose: Open a data file for writing, compressed through
+//          lpBuffer if it is a .gz file
+//
+// Arguments: lpStream : closed stream
+//            fileName : data file
+//            mode     : ofstream open mode
+//            lpBuffer : closed buffer, open while the stream is
+//
+// Return: status
+//--------------------------------------------------------------
+int FCL_OpenOutputStream( ofstream* lpStream, const string& fileName,
+			  ios::openmode mode,
+			  FuzzyGzipBufferClass* lpBuffer ) {
+
+  if ( not FCL_IsGzipFile( fileName ) ) {
+    lpStream->open( fileName.c_str(), mode );
+    return *lpStream ? 0 : -1;
+  }
+  if ( lpBuffer->Open( fileName, true ) != 0 ) {
+    lpStream->setstate( ios::failbit );
+    return -1;
+  }
+  static_cast< ios& >( *lpStream ).rdbuf( lpBuffer );
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FCL_CloseStream
+//
+// Purpose: Close a stream opened by FCL_OpenInputStream() or
+//          FCL_OpenOutputStream(), return it to its own file
+//
+// Arguments: lpStream : the stream
+//            lpBuffer : its buffer
+//
+// Return: status
+//--------------------------------------------------------------
+int FCL_CloseStream( ifstream* lpStream, FuzzyGzipBufferClass* lpBuffer ) {
+
+  if ( not lpBuffer->IsOpen() ) {
+    lpStream->close();
+    return 0;
+  }
+  static_cast< ios& >( *lpStream ).rdbuf( lpStream->rdbuf() );
+  return lpBuffer->Close();
+}
+
+int FCL_CloseStream( ofstream* lpStream, FuzzyGzipBufferClass* lpBuffer ) {
+
+  if ( not lpBuffer->IsOpen() ) {
+    int status = lpStream->good() ? 0 : -1;
+    lpStream->close();
+    return status;
+  }
+  int status = lpStream->good() ? 0 : -1;
+  static_cast< ios& >( *lpStream ).rdbuf( lpStream->rdbuf() );
+  int closeStatus = lpBuffer->Close();
+  return status != 0 ? status : closeStatus;
+}
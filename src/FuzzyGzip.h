@@ -0,0 +1,78 @@
+#ifndef Fuzzy_Gzip_H
+#define Fuzzy_Gzip_H
+
+#include <streambuf> // streambuf
+#include <deque>     // blocks between the threads
+#include <pthread.h> // compression thread
+
+// Bytes per block passed between a stream and its gzip thread
+#define FCL_GZIP_BLOCK_SIZE 262144
+
+// Blocks queued between a stream and its gzip thread
+#define FCL_GZIP_BLOCKS 4
+
+//---------------------------------------------------------------------
+// class FuzzyGzipBufferClass
+//
+// Purpose: A stream buffer of a gzip file, with the decompression or
+//          compression on its own thread. A reading buffer's thread
+//          decompresses blocks ahead of the stream, a writing buffer's
+//          thread compresses the blocks written by the stream, up to
+//          FCL_GZIP_BLOCKS blocks apart. Written data is complete in
+//          the file after Close().
+//
+//          FCL_OpenInputStream() and FCL_OpenOutputStream() attach a
+//          buffer to a stream when the file name ends in .gz, and open
+//          the stream on the file otherwise.
+//---------------------------------------------------------------------
+class FuzzyGzipBufferClass : public streambuf {
+
+ protected:
+  int status; // Error code variable
+
+  string fileName;
+  void*  lpFile;  // gzFile
+  bool   output;
+
+  pthread_t       thread;
+  bool            threadStarted;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+
+  // Full blocks from the reading thread, or to the writing thread
+  deque< vector< char >* > Blocks;
+  bool                     finished;     // no more blocks will be added
+  int                      threadStatus;
+
+  vector< char >* lpBlock; // block of the get or put area
+
+  int PushBlock();
+
+  virtual int_type underflow();
+  virtual int_type overflow ( int_type c );
+
+ public:
+  // Encapsulation methods for protected variables
+  bool IsOpen() const { return lpFile != 0; }
+
+  // FuzzyGzipBuffer Methods
+  FuzzyGzipBufferClass();
+  ~FuzzyGzipBufferClass();
+
+  int  Open ( const string& fileName, bool output );
+  int  Close();
+  void Run  ();
+};
+
+bool FCL_IsGzipFile      ( const string& fileName );
+int  FCL_OpenInputStream ( ifstream* lpStream, const string& fileName,
+			   FuzzyGzipBufferClass* lpBuffer );
+int  FCL_OpenOutputStream( ofstream* lpStream, const string& fileName,
+			   ios::openmode mode,
+			   FuzzyGzipBufferClass* lpBuffer );
+int  FCL_CloseStream     ( ifstream* lpStream,
+			   FuzzyGzipBufferClass* lpBuffer );
+int  FCL_CloseStream     ( ofstream* lpStream,
+			   FuzzyGzipBufferClass* lpBuffer );
+
+#endif
@@ -33,7 +33,7 @@ int FuzzyInputClass::FuzzifyTriangle(FuzzyInputTerm* fit, double inputValue) {
   // (x0, y0), (x1, y1), (x2, y2)
 
   // Each point is an XY struct in the vector xy
-  vector<XY*> lpXY = fit->xy;
+  vector<XY*>& lpXY = fit->xy;
 
   // Perform a linear interpolation of the form: y = y0 + mx
   // where y0 is the reference datum, m the slope, and x the argument
@@ -104,7 +104,7 @@ int FuzzyInputClass::FuzzifyRamp(FuzzyInputTerm* fit, double inputValue) {
   // (x0, y0), (x1, y1)
 
   // Each point is an XY struct in the vector xy
-  vector<XY*> lpXY = fit->xy;
+  vector<XY*>& lpXY = fit->xy;
 
   // Perform a linear interpolation of the form: y = y0 + mx
   // where y0 is the reference datum, m the slope, and x the argument
@@ -173,7 +173,7 @@ int FuzzyInputClass::FuzzifyTrapezoid(FuzzyInputTerm* fit, double inputValue) {
   // the ordinates of the 1st & 2nd, and 3rd & 4th points are not the same
 
   // Each point is an XY struct in the vector xy
-  vector<XY*> lpXY = fit->xy;
+  vector<XY*>& lpXY = fit->xy;
 
   // Perform a linear interpolation of the form: y = y0 + mx
   // where y0 is the reference datum, m the slope, and x the argument
@@ -249,7 +249,7 @@ int FuzzyInputClass::FuzzifyRectangle(FuzzyInputTerm* fit, double inputValue) {
   // the ordinates of the 1st & 2nd, and 3rd & 4th points are the same
 
   // Each point is an XY struct in the vector xy
-  vector<XY*> lpXY = fit->xy;
+  vector<XY*>& lpXY = fit->xy;
 
   if ( inputValue < lpXY[0]->x ) {
     // if the inputValue is below the range of the rectangle, return low
@@ -291,7 +291,7 @@ int FuzzyInputClass::FuzzifySingleton(FuzzyInputTerm* fit, double inputValue) {
   int status = 0;
 
   // The point is an XY struct in the vector xy
-  vector<XY*> lpXY = fit->xy;
+  vector<XY*>& lpXY = fit->xy;
 
   // Only one point in term, use it if the oridnate matches
   if ( inputValue == lpXY[0]->x ) {
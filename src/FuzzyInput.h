@@ -26,6 +26,7 @@ struct FuzzyInputTerm {
   int    termType;   // Trapezoid, Triangle, Ramp, Rectangle, Singleton
   vector<XY*> xy;    // container for xy 'points' of term
   double membership; // fuzzification value for input 
+  double dMembership; // d membership / d seed, set by OutputTangents()
 };
 
 //------------------------------------------------------------
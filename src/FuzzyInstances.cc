@@ -0,0 +1,193 @@
+#include "FuzzyInstances.h"
+#include <climits> // INT_MAX
+
+//--------------------------------------------------------------
+// InstanceChunks
+//
+// Purpose: FCL_ParallelFor() worker for Evaluate(), the items are
+//          chunks of FCL_INSTANCES_CHUNK instances
+//
+// Arguments: arg         : pointer to the FuzzyInstancesClass
+//            threadIndex : model clone of the thread
+//            begin, end  : range of chunks
+//
+// Return:
+//--------------------------------------------------------------
+static void InstanceChunks( void* arg, int threadIndex, int begin, int end ) {
+
+  FuzzyInstancesClass* lpInstances = (FuzzyInstancesClass*) arg;
+
+  for ( int chunk = begin; chunk < end; chunk++ ) {
+    lpInstances->EvaluateChunk( threadIndex, chunk );
+  }
+}
+
+//--------------------------------------------------------------
+// FuzzyInstancesClass
+//
+// Purpose: Constructor for FuzzyInstancesClass
+//
+// Arguments: lpFC : the parsed model
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyInstancesClass::FuzzyInstancesClass( FuzzyControlClass* lpFC ) {
+
+  status     = 0;
+  this->lpFC = lpFC;
+  nInstances = 0;
+  lpInputs   = 0;
+  lpOutputs  = 0;
+  nFailed    = 0;
+}
+
+//--------------------------------------------------------------
+// ~FuzzyInstancesClass
+//
+// Purpose: Destructor for FuzzyInstancesClass, delete the model
+//          clones
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyInstancesClass::~FuzzyInstancesClass() {
+
+  for ( int i = 0; i < (int) Workers.size(); i++ ) {
+    delete Workers[i];
+  }
+}
+
+//--------------------------------------------------------------
+// EvaluateChunk
+//
+// Purpose: Evaluate the instances of a chunk on the model clone of
+//          the thread. The outputs of the clone are set to the
+//          previous outputs of the instance before the evaluation,
+//          so that NC outputs keep the value of their instance.
+//
+// Arguments: threadIndex : index into Workers
+//            chunk       : chunk of FCL_INSTANCES_CHUNK instances
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyInstancesClass::EvaluateChunk( int threadIndex, int chunk ) {
+
+  FuzzyControlClass*           lpModel = Workers[ threadIndex ];
+  vector< FuzzyOutputClass* > &outputs = lpModel->OutputVariablesVector();
+  vector< double >            &inputs  = WorkerInputs[ threadIndex ];
+
+  int  nInputs  = inputs.size();
+  int  nOutputs = outputs.size();
+  long begin    = (long) chunk * FCL_INSTANCES_CHUNK;
+  long end      = begin + FCL_INSTANCES_CHUNK;
+  if ( end > nInstances ) end = nInstances;
+
+  long failed = 0;
+  for ( long cell = begin; cell < end; cell++ ) {
+    for ( int j = 0; j < nInputs; j++ ) {
+      inputs[j] = lpInputs[j][cell];
+    }
+    for ( int k = 0; k < nOutputs; k++ ) {
+      outputs[k]->defuzzOut = lpOutputs[k][cell];
+    }
+
+    if ( lpModel->SetInputs( &inputs[0] ) != 0 or
+	 lpModel->Evaluate() != 0 ) {
+      failed++;
+      continue;
+    }
+
+    for ( int k = 0; k < nOutputs; k++ ) {
+      lpOutputs[k][cell] = outputs[k]->defuzzOut;
+    }
+  }
+  chunkFailed[ chunk ] = failed;
+}
+
+//--------------------------------------------------------------
+// Evaluate
+//
+// Purpose: Evaluate the model for each instance on the
+//          FCL_ParallelFor() thread pool
+//
+// Arguments: nInstances : number of instances
+//            inputs     : NumInputs() arrays of nInstances inputs
+//            outputs    : NumOutputs() arrays of nInstances outputs,
+//                         the previous outputs, replaced
+//
+// Return: status, nonzero if an instance failed
+//--------------------------------------------------------------
+int FuzzyInstancesClass::Evaluate( long nInstances,
+				   const double* const* inputs,
+				   double* const* outputs ) {
+
+  int nThreads = FCL_NumThreads();
+
+  if ( nInstances < 0 or not inputs or not outputs or
+       lpFC->NumInputs() < 1 ) {
+    status = -1;
+    ErrMsg( "Evaluate() Invalid instance arrays for", lpFC->FCLFile(),
+	    status );
+    return status;
+  }
+  for ( int j = 0; j < lpFC->NumInputs(); j++ ) {
+    if ( not inputs[j] and nInstances ) {
+      status = -1;
+      ErrMsg( "Evaluate() No instance array for input",
+	      lpFC->InputVariablesVector()[j]->varName, status );
+      return status;
+    }
+  }
+  for ( int k = 0; k < lpFC->NumOutputs(); k++ ) {
+    if ( not outputs[k] and nInstances ) {
+      status = -1;
+      ErrMsg( "Evaluate() No instance array for output",
+	      lpFC->OutputVariablesVector()[k]->varName, status );
+      return status;
+    }
+  }
+
+  // A model clone per thread, from one parsed model
+  status = FCL_CloneModels( lpFC, nThreads, &Workers );
+  if ( status != 0 ) {
+    ErrMsg( "Evaluate() Failed to clone model", lpFC->FCLFile(), status );
+    return status;
+  }
+  WorkerInputs.resize( Workers.size(),
+		       vector< double >( lpFC->NumInputs(), 0. ) );
+
+  long nChunks = ( nInstances + FCL_INSTANCES_CHUNK - 1 ) /
+                 FCL_INSTANCES_CHUNK;
+  if ( nChunks > INT_MAX ) {
+    status = -1;
+    ErrMsg( "Evaluate() Too many instances", (double) nInstances, status );
+    return status;
+  }
+
+  this->nInstances = nInstances;
+  lpInputs         = inputs;
+  lpOutputs        = outputs;
+  chunkFailed.assign( nChunks, 0 );
+
+  status = FCL_ParallelFor( nChunks, 1, InstanceChunks, this,
+			    Workers.size() );
+
+  lpInputs  = 0;
+  lpOutputs = 0;
+  nFailed   = 0;
+  for ( long c = 0; c < nChunks; c++ ) {
+    nFailed += chunkFailed[c];
+  }
+
+  if ( status != 0 ) {
+    ErrMsg( "Evaluate() Failed to evaluate instances of", lpFC->FCLFile(),
+	    status );
+    return status;
+  }
+  if ( nFailed ) {
+    status = -1;
+    ErrMsg( "Evaluate() Instances failed", (double) nFailed, status );
+  }
+  return status;
+}
@@ -0,0 +1,59 @@
+#ifndef Fuzzy_Instances_H
+#define Fuzzy_Instances_H
+
+#include "FuzzyControl.h"
+
+// Instances per thread pool work item
+#define FCL_INSTANCES_CHUNK 4096
+
+//---------------------------------------------------------------------
+// class FuzzyInstancesClass
+//
+// Purpose: Evaluate one model for many independent instances, such as
+//          the cells of a spatial grid. The instance states are held by
+//          the caller as arrays, one per variable: inputs[j][cell] for
+//          input handle j, and outputs[k][cell] for output handle k.
+//          An instance is only its outputs, which hold the previous
+//          defuzzOut, the value an NC output keeps when no rule
+//          fires, and are replaced by the new outputs.
+//
+//          The instances are evaluated in chunks on the
+//          FCL_ParallelFor() thread pool, one model clone per thread,
+//          so the memory does not grow with the number of instances.
+//          An instance that fails keeps its previous outputs and is
+//          counted in NumFailed().
+//---------------------------------------------------------------------
+class FuzzyInstancesClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC; // the parsed model, not changed
+
+  // Model clones and an input row, one per thread
+  vector< FuzzyControlClass* > Workers;
+  vector< vector< double > >   WorkerInputs;
+
+  // Instance arrays of the current Evaluate(), owned by the caller
+  long                 nInstances;
+  const double* const* lpInputs;
+  double* const*       lpOutputs;
+
+  // Failed instances of each chunk
+  vector< long > chunkFailed;
+  long           nFailed;
+
+ public:
+  // Encapsulation methods for protected variables
+  long NumFailed() const { return nFailed; }
+
+  // FuzzyInstances Methods
+  FuzzyInstancesClass( FuzzyControlClass* lpFC );
+  ~FuzzyInstancesClass();
+
+  int  Evaluate     ( long nInstances, const double* const* inputs,
+		      double* const* outputs );
+  void EvaluateChunk( int threadIndex, int chunk );
+};
+
+#endif
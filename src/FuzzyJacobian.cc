@@ -0,0 +1,917 @@
+#include "FuzzyControl.h"
+
+// The output derivatives are found in forward mode: each value of
+// Aggregation(), Activation(), Accumulation() and Defuzzification() is
+// replayed as a Dual, a value and its derivative with respect to one
+// TangentSeed, an input or a model parameter, taking the same branches
+// as the evaluation. The MIN/MAX selections follow std::min() and
+// std::max(), so a tie takes the same argument as the evaluation does. At a breakpoint the derivative is
+// the one of the branch the evaluation took.
+
+//------------------------------------------------------------
+// struct Dual
+//
+// Purpose: A value and its derivative with respect to one seed
+//------------------------------------------------------------
+struct Dual {
+  double v; // value
+  double d; // derivative
+
+  Dual( double value = 0., double derivative = 0. ) :
+    v( value ), d( derivative ) {}
+};
+
+static inline Dual operator+( const Dual& a, const Dual& b ) {
+  return Dual( a.v + b.v, a.d + b.d );
+}
+static inline Dual operator-( const Dual& a, const Dual& b ) {
+  return Dual( a.v - b.v, a.d - b.d );
+}
+static inline Dual operator*( const Dual& a, const Dual& b ) {
+  return Dual( a.v * b.v, a.d * b.v + a.v * b.d );
+}
+static inline Dual operator/( const Dual& a, const Dual& b ) {
+  return Dual( a.v / b.v, (a.d * b.v - a.v * b.d) / (b.v * b.v) );
+}
+// std::min(a, b), std::max(a, b)
+static inline Dual DualMin( const Dual& a, const Dual& b ) {
+  return ( b.v < a.v ) ? b : a;
+}
+static inline Dual DualMax( const Dual& a, const Dual& b ) {
+  return ( a.v < b.v ) ? b : a;
+}
+
+//------------------------------------------------------------
+// struct DualTerm
+//
+// Purpose: An activation or accumulation term as Duals
+//------------------------------------------------------------
+struct DualTerm {
+  int  termType; // Trapezoid, Triangle, Ramp, Rectangle, Singleton
+  int  nXY;      // number of xy points
+  Dual x[4];
+  Dual y[4];
+  Dual singletonX;
+  Dual singletonY;
+};
+
+//--------------------------------------------------------------
+// DualMembership
+//
+// Purpose: Replay the Fuzzify functions in FuzzyInput.cc as Duals
+//
+// Arguments: fit        : input term, fuzzified at inputValue.v
+//            inputValue : input, with its derivative
+//            seedPoint  : index of the point whose x is the seed,
+//                         -1 if none
+//
+// Return: membership
+//--------------------------------------------------------------
+static Dual DualMembership( FuzzyInputTerm* fit, Dual inputValue,
+			    int seedPoint ) {
+
+  vector<XY*>& lpXY = fit->xy;
+  Dual         x[4];
+  double       y[4];
+  Dual         in = inputValue;
+
+  // A membership set to 0 below ZERO_TOLERANCE is constant
+  if ( fit->membership < ZERO_TOLERANCE or lpXY.size() > 4 ) {
+    return fit->membership;
+  }
+  for ( unsigned int i = 0; i < lpXY.size(); i++ ) {
+    x[i] = Dual( lpXY[i]->x, (int) i == seedPoint ? 1. : 0. );
+    y[i] = lpXY[i]->y;
+  }
+
+  switch ( fit->termType ) {
+    case Triangle:
+      if ( in.v <= x[0].v ) return y[0];
+      if ( in.v >= x[2].v ) return y[2];
+      if ( in.v <= x[1].v ) {
+	return y[0] + ( (y[1] - y[0]) / (x[1] - x[0]) ) * (in - x[0]);
+      }
+      return y[1] - ( (y[1] - y[2]) / (x[2] - x[1]) ) * (in - x[1]);
+
+    case Ramp:
+      if ( in.v <= x[0].v ) return y[0];
+      if ( in.v >= x[1].v ) return y[1];
+      if ( y[0] < y[1] ) {
+	return y[0] + ( (y[1] - y[0]) / (x[1] - x[0]) ) * (in - x[0]);
+      }
+      return y[0] - ( (y[0] - y[1]) / (x[1] - x[0]) ) * (in - x[0]);
+
+    case Trapezoid:
+      if ( in.v <= x[0].v ) return y[0];
+      if ( in.v >= x[3].v ) return y[3];
+      if ( in.v <= x[1].v ) {
+	return y[0] + ( (y[1] - y[0]) / (x[1] - x[0]) ) * (in - x[0]);
+      }
+      if ( in.v <= x[2].v ) return y[1];
+      return y[2] - ( (y[2] - y[3]) / (x[3] - x[2]) ) * (in - x[2]);
+
+    default:
+      // Rectangle and Singleton are flat
+      return fit->membership;
+  };
+}
+
+//--------------------------------------------------------------
+// DualSubConditions
+//
+// Purpose: Replay AND_SubConditions() or OR_SubConditions() of a
+//          rule as Duals
+//
+// Arguments: lpFRC  : rule, aggregated by Aggregation(), with the
+//                     dMembership of its input terms set
+//            AND    : true for the AND_SubConditions
+//            result : condition result, unchanged if the rule has
+//                     no such subconditions
+//
+// Return: status
+//--------------------------------------------------------------
+static int DualSubConditions( FuzzyRuleClass* lpFRC, bool AND, 
+			      Dual* result ) {
+
+  vector<Condition*>    :: iterator condi;
+  vector<SubCondition*> :: iterator subCondi;
+
+  Condition*    lpCond;
+  SubCondition* lpSubCond = 0;
+
+  for ( condi =  lpFRC->Conditions.begin();
+	condi != lpFRC->Conditions.end(); ++condi ) {
+    lpCond = *condi;
+    vector<SubCondition*>& subConditions =
+      AND ? lpCond->AND_SubConditions : lpCond->OR_SubConditions;
+
+    if ( not subConditions.size() ) {
+      continue;
+    }
+
+    Dual lastTermMembership = AND ? 1. : 0.;
+    Dual thisTermMembership = 0.;
+    Dual subResult          = AND ? 1. : 0.;
+
+    for ( subCondi =  subConditions.begin();
+	  subCondi != subConditions.end(); ++subCondi ) {
+      lpSubCond = *subCondi;
+      FuzzyInputTerm* lpFIT = lpSubCond->inputFuzzifyTerm;
+
+      Dual membership( lpFIT->membership, lpFIT->dMembership );
+
+      if ( lpSubCond->notTerm ) {
+	thisTermMembership = 1. - membership;
+      }
+      else {
+	thisTermMembership = membership;
+      }
+
+      if ( subConditions.size() == 1 ) {
+	subResult = membership;
+	continue;
+      }
+
+      if ( AND and lpFRC->andMethod == lpFRC->kwd_Min ) {
+	subResult = DualMin( lastTermMembership, thisTermMembership );
+      }
+      else if ( AND and lpFRC->andMethod == lpFRC->kwd_Prod ) {
+	subResult = subResult * thisTermMembership;
+      }
+      else if ( AND and lpFRC->andMethod == lpFRC->kwd_Bdif ) {
+	subResult = DualMax( 0., lastTermMembership + thisTermMembership - 1.);
+      }
+      else if ( not AND and lpFRC->orMethod == lpFRC->kwd_Max ) {
+	subResult = DualMax( lastTermMembership, thisTermMembership );
+      }
+      else if ( not AND and lpFRC->orMethod == lpFRC->kwd_Asum ) {
+	subResult = lastTermMembership + thisTermMembership -
+	            lastTermMembership * thisTermMembership;
+      }
+      else if ( not AND and lpFRC->orMethod == lpFRC->kwd_Bsum ) {
+	subResult = DualMin( 1., lastTermMembership + thisTermMembership );
+      }
+      else {
+	return -1;
+      }
+      lastTermMembership = thisTermMembership;
+    }
+
+    if ( lpSubCond->notCondition ) {
+      subResult = 1. - subResult;
+    }
+    *result = subResult;
+  }
+
+  return 0;
+}
+
+//--------------------------------------------------------------
+// DualActivate
+//
+// Purpose: Replay FuzzyRuleClass::Activate() of one conclusion
+//          as Duals
+//
+// Arguments: lpFRC  : rule of the conclusion
+//            lpConc : conclusion
+//            c      : rule condition result
+//            seed   : term point or weight of the derivative
+//            lpAct  : activation term
+//
+// Return: status
+//--------------------------------------------------------------
+static int DualActivate( FuzzyRuleClass* lpFRC, Conclusion* lpConc,
+			 Dual c, const TangentSeed* seed, DualTerm* lpAct ) {
+
+  FuzzyOutputTerm* lpFOT  = lpConc->outputDefuzzify;
+  vector<XY*>&     lpXY   = lpFOT->xy;
+  bool             prod   = ( lpFRC->actMethod == lpFRC->kwd_Prod );
+  bool             least  = ( lpFRC->actMethod == lpFRC->kwd_Min  );
+  bool             seeded = ( seed->outputTerm == lpFOT );
+  Dual             X[4];   // term points, the seed x has derivative 1
+  double           Y[4];
+  Dual             w( lpConc->weight, seed->conclusion == lpConc ? 1. : 0. );
+  int              i;
+
+  if ( not prod and not least ) {
+    return -1;
+  }
+  for ( i = 0; i < (int) lpXY.size() and i < 4; i++ ) {
+    X[i] = Dual( lpXY[i]->x, seeded and seed->point == i ? 1. : 0. );
+    Y[i] = lpXY[i]->y;
+  }
+
+  switch ( lpFOT->termType ) {
+
+    case Trapezoid:
+      lpAct->termType = Trapezoid;
+      lpAct->nXY      = 4;
+      if ( prod or c.v >= Y[1] ) {
+	for ( i = 0; i <= 3; i++ ) {
+	  lpAct->x[i] = X[i];
+	  lpAct->y[i] = prod ? c * Y[i] * w : Y[i] * w;
+	}
+      }
+      else {
+	if ( c.v < Y[0] ) {
+	  return -1;
+	}
+	lpAct->x[0] = X[0];
+	lpAct->y[0] = Y[0] * w;
+	lpAct->x[3] = X[3];
+	lpAct->y[3] = Y[3] * w;
+	lpAct->y[1] = c * w;
+	lpAct->y[2] = c * w;
+	if ( c.v > Y[0] and c.v > Y[2] and
+	     Y[1] > Y[0] and X[1].v > X[0].v and
+	     Y[3] > Y[2] and X[3].v > X[2].v ) {
+	  lpAct->x[1] = (c - Y[0]) /
+	                ( (Y[1] - Y[0]) /
+			  (X[1] - X[0]) );
+	  lpAct->x[2] = X[2] + (c - Y[2]) /
+	                ( (Y[3] - Y[2]) /
+			  (X[3] - X[2]) );
+	}
+	else {
+	  lpAct->x[1] = X[1];
+	  lpAct->x[2] = X[2];
+	}
+      }
+      break;
+
+    case Triangle:
+      if ( prod or c.v >= Y[1] ) {
+	lpAct->termType = Triangle;
+	lpAct->nXY      = 3;
+	for ( i = 0; i <= 2; i++ ) {
+	  lpAct->x[i] = X[i];
+	  lpAct->y[i] = prod ? c * Y[i] * w : Y[i] * w;
+	}
+      }
+      else {
+	if ( c.v < Y[0] ) {
+	  return -1;
+	}
+	// Activate() converts the triangle to a trapezoid
+	lpAct->termType = Trapezoid;
+	lpAct->nXY      = 4;
+	lpAct->x[0] = X[0];
+	lpAct->y[0] = Y[0] * w;
+	lpAct->x[3] = X[2];
+	lpAct->y[3] = Y[2] * w;
+	lpAct->y[1] = c * w;
+	lpAct->y[2] = c * w;
+	if ( c.v >= Y[0] and Y[1] > Y[0] and
+	     X[1].v > X[0].v ) {
+	  lpAct->x[1] = X[0] + (c - Y[0]) /
+	                ( (Y[1] - Y[0]) /
+			  (X[1] - X[0]) );
+	  lpAct->x[2] = X[1] + (c - Y[1]) /
+	                ( (Y[2] - Y[1]) /
+			  (X[2] - X[1]) );
+	}
+	else {
+	  lpAct->x[1] = X[0] + (X[1] - X[0])/2.;
+	  lpAct->x[2] = X[1] + (X[2] - X[1])/2.;
+	}
+	if ( lpAct->x[0].v == lpAct->x[1].v ) {
+	  lpAct->x[1] = X[0] + (X[1] - X[0])/2.;
+	}
+	if ( lpAct->x[2].v == lpAct->x[3].v ) {
+	  lpAct->x[2] = X[1] + (X[2] - X[1])/2.;
+	}
+      }
+      break;
+
+    case Ramp: {
+      bool rampUp   = ( Y[1] > Y[0] );
+      bool rampDown = ( Y[0] > Y[1] );
+      bool aggregationAbove = false;
+      bool aggregationBelow = false;
+      if ( rampUp ) {
+	if ( c.v >= Y[1] ) aggregationAbove = true;
+	if ( c.v <  Y[0] ) aggregationBelow = true;
+      }
+      if ( rampDown ) {
+	if ( c.v >= Y[0] ) aggregationAbove = true;
+	if ( c.v <  Y[1] ) aggregationBelow = true;
+      }
+
+      lpAct->termType = Ramp;
+      lpAct->nXY      = 2;
+      if ( prod or aggregationAbove ) {
+	for ( i = 0; i <= 1; i++ ) {
+	  lpAct->x[i] = X[i];
+	  lpAct->y[i] = prod ? c * Y[i] * w : Y[i] * w;
+	}
+      }
+      else if ( aggregationBelow ) {
+	return -1;
+      }
+      else if ( rampUp ) {
+	lpAct->x[0] = X[0];
+	lpAct->y[0] = Y[0] * w;
+	lpAct->x[1] = X[1];
+	if ( c.v > Y[0] and Y[1] > Y[0] and
+	     X[1].v > X[0].v ) {
+	  Dual x1 = (c - Y[0]) /
+	            ( (Y[1] - Y[0]) /
+		      (X[1] - X[0]) );
+	  if ( not ( x1.v < X[0].v ) ) {
+	    lpAct->x[1] = x1;
+	  }
+	}
+	lpAct->y[1] = c * w;
+      }
+      else if ( rampDown ) {
+	// Activate() moves the first point only for a rising ramp
+	lpAct->x[0] = X[0];
+	lpAct->y[0] = c * w;
+	lpAct->x[1] = X[1];
+	lpAct->y[1] = Y[1] * w;
+      }
+      else {
+	lpAct->nXY = 0;
+      }
+      break;
+    }
+
+    case Rectangle:
+      if ( least and c.v < Y[0] ) {
+	return -1;
+      }
+      lpAct->termType = Rectangle;
+      lpAct->nXY      = lpXY.size() < 4 ? lpXY.size() : 4;
+      for ( i = 0; i < lpAct->nXY; i++ ) {
+	lpAct->x[i] = X[i];
+	if ( least ) {
+	  lpAct->y[i] = DualMin( c, Y[i] ) * w;
+	}
+	else {
+	  lpAct->y[i] = c * Y[i] * w;
+	}
+      }
+      // Activate() does not apply ZERO_TOLERANCE to a Rectangle
+      return 0;
+
+    case Singleton:
+      lpAct->termType   = Singleton;
+      lpAct->nXY        = 0;
+      lpAct->singletonX = Dual( lpFOT->singleton.x,
+				seeded and seed->point == 0 ? 1. : 0. );
+      lpAct->singletonY = c * w;
+      return 0;
+
+    default:
+      return -1;
+  };
+
+  for ( i = 0; i < lpAct->nXY; i++ ) {
+    if ( lpAct->y[i].v < ZERO_TOLERANCE ) lpAct->y[i] = 0.;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// DualAccu
+//
+// Purpose: MAX, BSUM or NSUM of an accumulation and an activation
+//          ordinate, as in Accumulate()
+//
+// Arguments: lpFC         : keyword pointers
+//            accumulation : ACCU method of the output variable
+//            acc, act     : ordinates
+//
+// Return: accumulated ordinate
+//--------------------------------------------------------------
+static Dual DualAccu( FuzzyControlClass* lpFC, FCL_keyword* accumulation,
+		      const Dual& acc, const Dual& act ) {
+
+  if ( accumulation == lpFC->keyword_Max ) {
+    return DualMax( acc, act );
+  }
+  if ( accumulation == lpFC->keyword_Bsum ) {
+    return DualMin( 1., acc + act );
+  }
+  // NSUM
+  return (acc + act) / DualMax( 1., acc + act );
+}
+
+//--------------------------------------------------------------
+// DualAccumulate
+//
+// Purpose: Replay FuzzyControlClass::Accumulate() as Duals
+//
+// Arguments: lpFC  : keyword pointers
+//            lpFOC : output variable
+//            lpAct : activation term
+//            lpAcc : accumulation term
+//
+// Return: status
+//--------------------------------------------------------------
+static int DualAccumulate( FuzzyControlClass* lpFC, FuzzyOutputClass* lpFOC,
+			   DualTerm* lpAct, DualTerm* lpAcc ) {
+
+  FCL_keyword* accumulation = lpFOC->accumulation;
+  int          nPoints      = 0;
+  int          i;
+
+  if ( accumulation != lpFC->keyword_Max  and
+       accumulation != lpFC->keyword_Bsum and
+       accumulation != lpFC->keyword_Nsum ) {
+    return -1;
+  }
+
+  // The first activation is copied, the term type is unchanged
+  if ( lpAcc->termType != Singleton and not lpAcc->nXY ) {
+    lpAcc->nXY = lpAct->nXY;
+    for ( i = 0; i < lpAct->nXY; i++ ) {
+      lpAcc->x[i] = lpAct->x[i];
+      lpAcc->y[i] = lpAct->y[i];
+    }
+    return 0;
+  }
+
+  switch ( lpAct->termType ) {
+    case Trapezoid:
+      lpAcc->termType = Trapezoid;
+      if ( lpAcc->nXY == 3 ) {
+	lpAcc->x[3] = lpAct->x[3];
+	lpAcc->y[3] = lpAct->y[3];
+	lpAcc->nXY  = 4;
+      }
+      if ( lpAcc->nXY != 4 ) {
+	return -1;
+      }
+      lpAcc->x[0] = lpAct->x[0];
+      lpAcc->x[3] = lpAct->x[3];
+      nPoints = 4;
+      break;
+
+    case Triangle:
+      lpAcc->termType = Triangle;
+      if ( lpAcc->nXY < 3 ) {
+	return -1;
+      }
+      for ( i = 0; i <= 2; i++ ) {
+	lpAcc->x[i] = lpAct->x[i];
+      }
+      nPoints = 3;
+      break;
+
+    case Ramp:
+      lpAcc->termType = Ramp;
+      if ( lpAcc->nXY != 2 ) {
+	return -1;
+      }
+      nPoints = 2;
+      break;
+
+    case Rectangle:
+      lpAcc->termType = Rectangle;
+      if ( lpAcc->nXY != 4 ) {
+	return -1;
+      }
+      for ( i = 0; i <= 3; i++ ) {
+	lpAcc->x[i] = lpAct->x[i];
+      }
+      nPoints = 4;
+      break;
+
+    case Singleton:
+      lpAcc->termType   = Singleton;
+      lpAcc->singletonX = lpAct->singletonX;
+      break;
+
+    default:
+      return -1;
+  };
+
+  // MAX, BSUM or NSUM of the ordinates
+  if ( lpAct->termType == Singleton ) {
+    lpAcc->singletonY = DualAccu( lpFC, accumulation, 
+				  lpAcc->singletonY, lpAct->singletonY );
+  }
+  for ( i = 0; i < nPoints; i++ ) {
+    lpAcc->y[i] = DualAccu( lpFC, accumulation, lpAcc->y[i], lpAct->y[i] );
+  }
+
+  // Abcissa that depend on the accumulated ordinates
+  if ( lpAct->termType == Trapezoid ) {
+    if ( not ( lpAcc->y[1].v > lpAct->y[1].v ) ) {
+      lpAcc->x[1] = lpAct->x[1];
+      lpAcc->x[2] = lpAct->x[2];
+    }
+  }
+  else if ( lpAct->termType == Ramp ) {
+    if ( lpAct->y[1].v > lpAct->y[0].v ) {
+      lpAcc->x[0] = lpAct->x[0];
+      if ( not ( lpAcc->y[1].v > lpAct->y[1].v ) ) {
+	lpAcc->x[1] = lpAct->x[1];
+      }
+    }
+    else {
+      lpAcc->x[1] = lpAct->x[1];
+      if ( not ( lpAcc->y[0].v > lpAct->y[0].v ) ) {
+	lpAcc->x[0] = lpAct->x[0];
+      }
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// DualRising, DualFalling
+//
+// Purpose: Defuzzification() first moment of a rising or falling
+//          linear section from (x0, y0) to (x1, y1)
+//
+// Arguments: section end points
+//
+// Return: first moment
+//--------------------------------------------------------------
+static Dual DualRising( const Dual& x0, const Dual& y0,
+			const Dual& x1, const Dual& y1 ) {
+
+  Dual alpha = (y1 - y0) / (x1 - x0);
+
+  return (y0 - alpha * x0) * (x1 * x1 - x0 * x0)/2. +
+         alpha * ( (x1 * x1 * x1 - x0 * x0 * x0)/3. );
+}
+
+static Dual DualFalling( const Dual& x0, const Dual& y0,
+			 const Dual& x1, const Dual& y1 ) {
+
+  Dual alpha = (y0 - y1) / (x1 - x0);
+
+  return (y0 + alpha * x0) * (x1 * x1 - x0 * x0)/2. -
+         alpha * ( (x1 * x1 * x1 - x0 * x0 * x0)/3. );
+}
+
+//--------------------------------------------------------------
+// DualDefuzzify
+//
+// Purpose: Replay the Defuzzification() integrals of one
+//          accumulation term as Duals
+//
+// Arguments: lpFOC  : output variable
+//            lpAcc  : accumulation term
+//            uSum   : integral of the membership
+//            U_uSum : integral of output * membership
+//
+// Return:
+//--------------------------------------------------------------
+static void DualDefuzzify( FuzzyOutputClass* lpFOC, DualTerm* lpAcc,
+			   Dual* uSum, Dual* U_uSum ) {
+
+  Dual* x = lpAcc->x;
+  Dual* y = lpAcc->y;
+
+  switch ( lpAcc->termType ) {
+    case Trapezoid:
+      if ( lpAcc->nXY != 4 or x[1].v <= x[0].v or x[3].v <= x[2].v ) {
+	return;
+      }
+      *uSum   = *uSum + y[1]/2. * (x[1] - x[0]) + y[2]/2. * (x[3] - x[2]) +
+	        y[2] * (x[2] - x[1]);
+      *U_uSum = *U_uSum + y[1] / 2. * (x[2] * x[2] - x[1] * x[1]) +
+	        DualRising ( x[0], y[0], x[1], y[1] ) +
+	        DualFalling( x[2], y[2], x[3], y[3] );
+      return;
+
+    case Triangle:
+      if ( lpAcc->nXY < 3 or x[1].v <= x[0].v or x[2].v <= x[1].v ) {
+	return;
+      }
+      *uSum   = *uSum + y[1] * (x[2] - x[0])/2.;
+      *U_uSum = *U_uSum + DualRising ( x[0], y[0], x[1], y[1] ) +
+	                  DualFalling( x[1], y[1], x[2], y[2] );
+      return;
+
+    case Ramp:
+      if ( lpAcc->nXY != 2 or x[1].v <= x[0].v ) {
+	return;
+      }
+      if ( y[1].v > y[0].v ) {
+	*uSum   = *uSum + y[1] * (lpFOC->maxOut - x[1]) +
+	          y[1]/2. * (x[1] - x[0]);
+	*U_uSum = *U_uSum + y[1] / 2. *
+	          (lpFOC->maxOut * lpFOC->maxOut - x[1] * x[1]) +
+	          DualRising( x[0], y[0], x[1], y[1] );
+      }
+      else {
+	*uSum   = *uSum + y[0] * (x[0] - lpFOC->minOut) +
+	          y[0]/2. * (x[1] - x[0]);
+	*U_uSum = *U_uSum + y[0] / 2. *
+	          (x[1] * x[1] - lpFOC->minOut * lpFOC->minOut) +
+	          DualFalling( x[0], y[0], x[1], y[1] );
+      }
+      return;
+
+    case Rectangle:
+      if ( lpAcc->nXY != 4 ) {
+	return;
+      }
+      *uSum   = *uSum + y[1] * (x[2] - x[1]);
+      *U_uSum = *U_uSum + y[1] * (x[2] * x[2] - x[1] * x[1])/2.;
+      return;
+
+    case Singleton:
+      *uSum   = *uSum + lpAcc->singletonY;
+      *U_uSum = *U_uSum + lpAcc->singletonX * lpAcc->singletonY;
+      return;
+  };
+}
+
+//--------------------------------------------------------------
+// EvaluateTangents
+//
+// Purpose: Evaluate the inputs for OutputTangents()
+//
+// Arguments: inputValues : NumInputs() values, as SetInputs()
+//
+// Return: status, the outputs are then read with GetOutputs()
+//--------------------------------------------------------------
+int FuzzyControlClass::EvaluateTangents( const double* inputValues ) {
+
+  int status = 0;
+  int nInputs  = InputVariableVector.size();
+  int nOutputs = OutputVariableVector.size();
+  int n, r, k;
+
+  map <string, FuzzyOutputTerm*> :: iterator ati; // AccumulationTerms
+  map <string, FuzzyOutputTerm*> :: iterator oti; // OutputTerms
+  map <string, FuzzyRuleClass*>  :: iterator fri;
+  vector<Conclusion*>            :: iterator conci;
+
+  // Accumulate() copies the first activation into a non Singleton
+  // accumulation term without setting its type, the replay needs
+  // the types before Evaluate()
+  n = 0;
+  for ( k = 0; k < nOutputs; k++ ) {
+    n += OutputVariableVector[k]->AccumulationTerms.size();
+  }
+  tangentAccuTypes.resize( n );
+  n = 0;
+  for ( k = 0; k < nOutputs; k++ ) {
+    FuzzyOutputClass* lpFOC = OutputVariableVector[k];
+    for ( ati = lpFOC->AccumulationTerms.begin();
+	  ati != lpFOC->AccumulationTerms.end(); ++ati ) {
+      tangentAccuTypes[n++] = ati->second->termType;
+    }
+  }
+  tangentInputs.assign( inputValues, inputValues + nInputs );
+
+  // The conclusions of each output term, so OutputTangents() does
+  // not search the rules for every seed. Built once, until the
+  // Rules map changes.
+  if ( not tangentIndexValid ) {
+    tangentConclusions.clear();
+    tangentConclusionRules.clear();
+    tangentConclusionRuleIndex.clear();
+    tangentTermStart.clear();
+    for ( k = 0; k < nOutputs; k++ ) {
+      FuzzyOutputClass* lpFOC = OutputVariableVector[k];
+      for ( ati = lpFOC->AccumulationTerms.begin(),
+	    oti = lpFOC->OutputTerms.begin();
+	    ati != lpFOC->AccumulationTerms.end() and
+	    oti != lpFOC->OutputTerms.end(); ++ati, ++oti ) {
+	tangentTermStart.push_back( tangentConclusions.size() );
+	for ( fri = Rules.begin(), r = 0; fri != Rules.end(); ++fri, ++r ) {
+	  for ( conci =  fri->second->Conclusions.begin();
+		conci != fri->second->Conclusions.end(); ++conci ) {
+	    if ( (*conci)->outputVariable  == lpFOC and
+		 (*conci)->outputDefuzzify == oti->second ) {
+	      tangentConclusions.push_back( *conci );
+	      tangentConclusionRules.push_back( fri->second );
+	      tangentConclusionRuleIndex.push_back( r );
+	    }
+	  }
+	}
+      }
+    }
+    tangentTermStart.push_back( tangentConclusions.size() );
+    tangentIndexValid = true;
+  }
+
+  status = SetInputs( inputValues );
+  if ( status != 0 ) {
+    ErrMsg("EvaluateTangents() Failed to set inputs", FCLFileName, status);
+    return status;
+  }
+  status = Evaluate();
+  if ( status != 0 ) {
+    ErrMsg("EvaluateTangents() Failed to evaluate", FCLFileName, status);
+    return status;
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// OutputTangents
+//
+// Purpose: Derivative of each output of the last EvaluateTangents()
+//          with respect to the seed. An output clamped to its RANGE,
+//          or set by DEFAULT because no rule fired, has zero
+//          derivatives.
+//
+// Arguments: seed     : input, term point or weight
+//            tangents : NumOutputs() values, d output[k] / d seed
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyControlClass::OutputTangents( const TangentSeed* seed,
+				       double* tangents ) {
+
+  int status = 0;
+  int nInputs  = InputVariableVector.size();
+  int nOutputs = OutputVariableVector.size();
+  int i, n, r, t, j, k;
+  bool strengthSeeded = false; // a rule strength has a derivative
+
+  map <string, FuzzyInputTerm*>  :: iterator fti;
+  map <string, FuzzyRuleClass*>  :: iterator fri;
+
+  if ( (int) tangentInputs.size() != nInputs ) {
+    status = -1;
+    ErrMsg("OutputTangents() No EvaluateTangents()", FCLFileName, status);
+    return status;
+  }
+
+  // Fuzzification
+  for ( j = 0; j < nInputs; j++ ) {
+    FuzzyInputClass* lpFIC = InputVariableVector[j];
+    Dual in( tangentInputs[j], seed->input == lpFIC ? 1. : 0. );
+    for ( fti = lpFIC->InputTerms.begin();
+	  fti != lpFIC->InputTerms.end(); ++fti ) {
+      FuzzyInputTerm* fit = fti->second;
+      int seedPoint = ( seed->inputTerm == fit ) ? seed->point : -1;
+      fit->dMembership = DualMembership( fit, in, seedPoint ).d;
+    }
+  }
+
+  // Aggregation
+  tangentStrengths.resize( Rules.size() );
+  for ( fri = Rules.begin(), r = 0; fri != Rules.end(); ++fri, ++r ) {
+    FuzzyRuleClass* lpFRC = fri->second;
+    Dual result( lpFRC->conditionResult, 0. );
+
+    if ( DualSubConditions( lpFRC, true,  &result ) != 0 or
+	 DualSubConditions( lpFRC, false, &result ) != 0 ) {
+      status = -1;
+      ErrMsg("OutputTangents() Invalid AND/OR method in rule",
+	     lpFRC->ruleName, status);
+      return status;
+    }
+    tangentStrengths[r] = result.d;
+    if ( result.d != 0. ) {
+      strengthSeeded = true;
+    }
+  }
+
+  // Activation, Accumulation and Defuzzification of each output
+  n = 0;
+  for ( k = 0; k < nOutputs; k++ ) {
+    FuzzyOutputClass* lpFOC = OutputVariableVector[k];
+    Dual uSum   = 0.;
+    Dual U_uSum = 0.;
+
+    // Without a rule strength derivative, an output term or weight
+    // seed changes only its own output variable
+    tangents[k] = 0.;
+    if ( not strengthSeeded and 
+	 not ( seed->conclusion and
+	       seed->conclusion->outputVariable == lpFOC ) and
+	 not ( seed->outputTerm and
+	       seed->outputTerm->varName == lpFOC->varName ) ) {
+      n += lpFOC->AccumulationTerms.size();
+      continue;
+    }
+
+    for ( t = 0; t < (int) lpFOC->AccumulationTerms.size(); t++, n++ ) {
+      DualTerm acc;
+      acc.termType   = tangentAccuTypes[n];
+      acc.nXY        = 0;
+      acc.singletonY = 0.;
+
+      for ( i = tangentTermStart[n]; i < tangentTermStart[n+1]; i++ ) {
+	FuzzyRuleClass* lpFRC  = tangentConclusionRules[i];
+	Conclusion*     lpConc = tangentConclusions[i];
+	Dual c( lpFRC->conditionResult,
+		tangentStrengths[ tangentConclusionRuleIndex[i] ] );
+	DualTerm act;
+	if ( DualActivate( lpFRC, lpConc, c, seed, &act ) != 0 or
+	     DualAccumulate( this, lpFOC, &act, &acc ) != 0 ) {
+	  status = -1;
+	  ErrMsg("OutputTangents() Failed to replay rule",
+		 lpFRC->ruleName, status);
+	  return status;
+	}
+      }
+
+      // Accumulation() reduces a Trapezoid with coincident third
+      // and fourth points to a Triangle
+      if ( lpFOC->ruleActive and acc.termType == Trapezoid and
+	   acc.nXY == 4 and fabs( acc.y[1].v ) > ZERO_TOLERANCE and
+	   acc.x[2].v == acc.x[3].v ) {
+	acc.nXY      = 3;
+	acc.termType = Triangle;
+      }
+
+      DualDefuzzify( lpFOC, &acc, &uSum, &U_uSum );
+    }
+
+    double derivative = 0.;
+    if ( lpFOC->ruleActive and fabs( uSum.v ) > 1.E-9 ) {
+      Dual defuzz = U_uSum / uSum;
+      if ( defuzz.v >= lpFOC->minOut and defuzz.v <= lpFOC->maxOut ) {
+	derivative = defuzz.d;
+      }
+    }
+    tangents[k] = derivative;
+  }
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// Jacobian
+//
+// Purpose: Evaluate the inputs and find the derivative of each
+//          output with respect to each input
+//
+// Arguments: inputValues : NumInputs() values, as SetInputs()
+//            jacobian    : NumOutputs() rows of NumInputs() values,
+//                          d output[k] / d input[j] at [k][j]
+//
+// Return: status, the outputs are then read with GetOutputs()
+//--------------------------------------------------------------
+int FuzzyControlClass::Jacobian( const double* inputValues,
+				 double* jacobian ) {
+
+  int status = 0;
+  int nInputs  = InputVariableVector.size();
+  int nOutputs = OutputVariableVector.size();
+  int j, k;
+  TangentSeed    seed = { 0, 0, 0, 0, 0 };
+  vector<double> tangents( nOutputs );
+
+  status = EvaluateTangents( inputValues );
+  if ( status != 0 ) {
+    return status;
+  }
+
+  // One forward pass per input
+  for ( j = 0; j < nInputs; j++ ) {
+    seed.input = InputVariableVector[j];
+    status = OutputTangents( &seed, nOutputs ? &tangents[0] : 0 );
+    if ( status != 0 ) {
+      return status;
+    }
+    for ( k = 0; k < nOutputs; k++ ) {
+      jacobian[ k * nInputs + j ] = tangents[k];
+    }
+  }
+
+  return status;
+}
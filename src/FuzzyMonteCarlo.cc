@@ -0,0 +1,523 @@
+#include "FuzzyMonteCarlo.h"
+#include <sstream> // noise file words
+
+//--------------------------------------------------------------
+// MonteCarloRows
+//
+// Purpose: FCL_ParallelFor() worker for Run(), the items are the
+//          input rows
+//
+// Arguments: arg         : pointer to the FuzzyMonteCarloClass
+//            threadIndex : model clone of the thread
+//            begin, end  : range of rows
+//
+// Return:
+//--------------------------------------------------------------
+static void MonteCarloRows( void* arg, int threadIndex, int begin, int end ) {
+
+  FuzzyMonteCarloClass* lpMC = (FuzzyMonteCarloClass*) arg;
+
+  for ( int row = begin; row < end; row++ ) {
+    lpMC->EvaluateRow( threadIndex, row );
+  }
+}
+
+//--------------------------------------------------------------
+// RandomUniform
+//
+// Purpose: Next number of a splitmix64 sequence, so each row has
+//          its own generator without shared state
+//
+// Arguments: state : generator state, advanced
+//
+// Return: uniform random number in [0, 1)
+//--------------------------------------------------------------
+static double RandomUniform( uint64_t* state ) {
+
+  uint64_t z = ( *state += 0x9E3779B97F4A7C15ULL );
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  z =   z ^ ( z >> 31 );
+
+  return ( z >> 11 ) * ( 1. / 9007199254740992. ); // 2^53
+}
+
+//--------------------------------------------------------------
+// RandomNormal
+//
+// Purpose: Standard normal random number, Box-Muller
+//
+// Arguments: state : generator state, advanced
+//
+// Return: normal random number, mean 0, standard deviation 1
+//--------------------------------------------------------------
+static double RandomNormal( uint64_t* state ) {
+
+  double u1 = 1. - RandomUniform( state ); // (0, 1]
+  double u2 = RandomUniform( state );
+
+  return sqrt( -2. * log( u1 ) ) * cos( 2. * M_PI * u2 );
+}
+
+//--------------------------------------------------------------
+// FuzzyMonteCarloClass
+//
+// Purpose: Constructor for FuzzyMonteCarloClass, the default
+//          quantiles are 0.05, 0.5 and 0.95
+//
+// Arguments: lpFC : parsed model
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyMonteCarloClass::FuzzyMonteCarloClass( FuzzyControlClass* lpFC ) {
+
+  status     = 0;
+  this->lpFC = lpFC;
+  nSamples   = FCL_MC_SAMPLES;
+  seed       = FCL_MC_SEED;
+  nRows      = 0;
+
+  quantiles.push_back( 0.05 );
+  quantiles.push_back( 0.5 );
+  quantiles.push_back( 0.95 );
+}
+
+//--------------------------------------------------------------
+// ~FuzzyMonteCarloClass
+//
+// Purpose: Destructor for FuzzyMonteCarloClass, delete the model
+//          clones
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyMonteCarloClass::~FuzzyMonteCarloClass() {
+
+  for ( int i = 0; i < (int) Workers.size(); i++ ) {
+    delete Workers[i];
+  }
+}
+
+//--------------------------------------------------------------
+// ReadEmpirical
+//
+// Purpose: Read a column of a delimited data file with the column
+//          names on the first line, for EMPIRICAL noise. A .gz
+//          file is decompressed on its own thread as it is read.
+//
+// Arguments: fileName : data file
+//            column   : column name
+//            values   : set to the column values
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyMonteCarloClass::ReadEmpirical( const string& fileName,
+					 const string& column,
+					 vector< double >* values ) {
+
+  FuzzyGzipBufferClass DataBuffer; // DataStream of a .gz file
+  ifstream DataStream;
+  string   inputLine;
+  vector< string > words;
+  int index = -1;
+
+  if ( FCL_OpenInputStream( &DataStream, fileName, &DataBuffer ) ) {
+    ErrMsg( "Failed to open EMPIRICAL noise file:", fileName, -1 );
+    return -1;
+  }
+
+  values->clear();
+  while ( getline( DataStream, inputLine ) ) {
+    string::size_type CR = inputLine.find( '\r' );
+    if ( CR != string::npos ) {
+      inputLine.erase( CR );
+    }
+    if ( inputLine.find_first_not_of( " \t" ) == string::npos ) {
+      continue;
+    }
+    words.clear();
+    if ( lpFC->SplitLine( &words, &inputLine,
+			  &lpFC->InputDelimeters() ) != 0 ) {
+      ErrMsg( "Failed to split EMPIRICAL noise file line", fileName, -1 );
+      return -1;
+    }
+    if ( index < 0 ) {
+      for ( int i = 0; i < (int) words.size(); i++ ) {
+	if ( words[i] == column ) index = i;
+      }
+      if ( index < 0 ) {
+	ErrMsg( "EMPIRICAL noise file " + fileName + " has no column",
+		column, -1 );
+	return -1;
+      }
+      continue;
+    }
+    if ( index >= (int) words.size() ) {
+      ErrMsg( "EMPIRICAL noise file " + fileName + " has a short line",
+	      inputLine, -1 );
+      return -1;
+    }
+    values->push_back( atof( words[ index ].c_str() ) );
+  }
+  if ( FCL_CloseStream( &DataStream, &DataBuffer ) != 0 ) {
+    ErrMsg( "Failed to read EMPIRICAL noise file:", fileName, -1 );
+    return -1;
+  }
+
+  if ( values->empty() ) {
+    ErrMsg( "EMPIRICAL noise file " + fileName + " has no values for",
+	    column, -1 );
+    return -1;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// ReadNoiseFile
+//
+// Purpose: Read the input noise, see FuzzyNoise for the format.
+//          Statements end with ';', blank and comment lines are
+//          skipped.
+//
+// Arguments: fileName : noise file
+//
+// Return: Number of noise statements, or error code
+//--------------------------------------------------------------
+int FuzzyMonteCarloClass::ReadNoiseFile( string* fileName ) {
+
+  ifstream NoiseStream;
+  string   inputLine;
+  string   statement;
+  vector< string > statements;
+
+  NoiseStream.open( fileName->c_str(), ios::in );
+  if ( not NoiseStream ) {
+    ErrMsg( "Failed to open noise file:", *fileName, -1 );
+    return -1;
+  }
+  while ( getline( NoiseStream, inputLine ) ) {
+    if ( inputLine.find_first_not_of( " \t\r" ) == string::npos or
+	 lpFC->CommentLine( &inputLine ) ) {
+      continue;
+    }
+    statement += " " + inputLine;
+    string::size_type semicolon;
+    while ( ( semicolon = statement.find( ';' ) ) != string::npos ) {
+      statements.push_back( statement.substr( 0, semicolon ) );
+      statement.erase( 0, semicolon + 1 );
+    }
+  }
+  NoiseStream.close();
+  if ( statement.find_first_not_of( " \t\r" ) != string::npos ) {
+    ErrMsg( "Noise file statement has no ';'", statement, -1 );
+    return -1;
+  }
+
+  Noise.clear();
+  for ( int s = 0; s < (int) statements.size(); s++ ) {
+    FuzzyNoise noise;
+    string     varName, kind, word;
+    vector< string > words;
+
+    string::size_type assign = statements[s].find( ":=" );
+    if ( assign == string::npos ) {
+      ErrMsg( "Noise statement has no ':='", statements[s], -1 );
+      return -1;
+    }
+    istringstream left( statements[s].substr( 0, assign ) );
+    istringstream right( statements[s].substr( assign + 2 ) );
+    left >> varName;
+    right >> kind;
+    while ( right >> word ) {
+      words.push_back( word );
+    }
+
+    noise.handle = lpFC->InputHandle( varName );
+    noise.a = noise.b = 0.;
+    if ( noise.handle < 0 ) {
+      ErrMsg( "Noise statement has an unknown input", varName, -1 );
+      return -1;
+    }
+
+    if ( kind == "NORMAL" and words.size() == 1 ) {
+      noise.kind = NoiseNormal;
+      noise.a    = atof( words[0].c_str() );
+    }
+    else if ( kind == "UNIFORM" and words.size() == 2 ) {
+      noise.kind = NoiseUniform;
+      noise.a    = atof( words[0].c_str() );
+      noise.b    = atof( words[1].c_str() );
+    }
+    else if ( kind == "EMPIRICAL" and words.size() == 2 ) {
+      noise.kind = NoiseEmpirical;
+      status = ReadEmpirical( words[0], words[1], &noise.values );
+      if ( status != 0 ) return status;
+    }
+    else {
+      ErrMsg( "Noise statement has an invalid distribution for",
+	      varName, -1 );
+      return -1;
+    }
+    Noise.push_back( noise );
+  }
+
+  if ( Noise.empty() ) {
+    ErrMsg( "Noise file has no noise", *fileName, -1 );
+    return -1;
+  }
+  return Noise.size();
+}
+
+//--------------------------------------------------------------
+// ReadInputDataFile
+//
+// Purpose: Read the input data with the ReadInputDataFile() of
+//          the model
+//
+// Arguments: fileName : input data file
+//
+// Return: Number of rows read, or error code
+//--------------------------------------------------------------
+int FuzzyMonteCarloClass::ReadInputDataFile( string* fileName ) {
+
+  int nInputs = lpFC->NumInputs();
+
+  nRows = lpFC->ReadInputDataFile( fileName );
+  if ( nRows < 1 ) {
+    ErrMsg( "Monte Carlo input data file has no data", *fileName, -1 );
+    return -1;
+  }
+
+  Inputs.assign( nRows * nInputs, 0. );
+  for ( int j = 0; j < nInputs; j++ ) {
+    const string& varName = lpFC->InputVariablesVector()[j]->varName;
+    map< string, vector< double >* >::const_iterator idi =
+      lpFC->InputDataMap().find( varName );
+    if ( idi == lpFC->InputDataMap().end() or
+	 (int) idi->second->size() < nRows ) {
+      ErrMsg( "Monte Carlo input data file has no column for input",
+	      varName, -1 );
+      return -1;
+    }
+    for ( int r = 0; r < nRows; r++ ) {
+      Inputs[ r * nInputs + j ] = (*idi->second)[r];
+    }
+  }
+  return nRows;
+}
+
+//--------------------------------------------------------------
+// EvaluateRow
+//
+// Purpose: Evaluate the perturbed samples of an input row on the
+//          model clone of a thread, keep the mean, standard
+//          deviation and quantiles of each output. Each sample starts
+//          from the outputs of the parsed model, the failed ones are
+//          left out.
+//
+// Arguments: threadIndex : index into Workers
+//            row         : input row
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyMonteCarloClass::EvaluateRow( int threadIndex, int row ) {
+
+  FuzzyControlClass* lpModel = Workers[ threadIndex ];
+  vector< FuzzyOutputClass* > &outputVariables =
+    lpModel->OutputVariablesVector();
+  int nInputs    = lpModel->NumInputs();
+  int nOutputs   = lpModel->NumOutputs();
+  int nQuantiles = quantiles.size();
+  int nResults   = 2 + nQuantiles;
+
+  vector< double > inputs ( nSamples * nInputs );
+  vector< double > outputs( nSamples * nOutputs );
+  vector< bool >   good   ( nSamples, true );
+
+  // Generator of the row, from the seed and the row
+  uint64_t state = (uint64_t) seed * 0x9E3779B97F4A7C15ULL + (uint64_t) row;
+  RandomUniform( &state );
+
+  for ( int i = 0; i < nSamples; i++ ) {
+    double* lpInputs = &inputs[ i * nInputs ];
+    for ( int j = 0; j < nInputs; j++ ) {
+      lpInputs[j] = Inputs[ row * nInputs + j ];
+    }
+    for ( int n = 0; n < (int) Noise.size(); n++ ) {
+      const FuzzyNoise& noise = Noise[n];
+      double value = 0.;
+      switch ( noise.kind ) {
+        case NoiseNormal:
+	  value = noise.a * RandomNormal( &state );
+	  break;
+        case NoiseUniform:
+	  value = noise.a + ( noise.b - noise.a ) * RandomUniform( &state );
+	  break;
+        case NoiseEmpirical: {
+	  int k = (int) ( RandomUniform( &state ) * noise.values.size() );
+	  value = noise.values[ min( k, (int) noise.values.size() - 1 ) ];
+	  break;
+	}
+      };
+      lpInputs[ noise.handle ] += value;
+    }
+  }
+
+  // The samples are independent draws, not a series
+  Failed[ row ] = 0;
+  for ( int i = 0; i < nSamples; i++ ) {
+    for ( int k = 0; k < nOutputs; k++ ) {
+      outputVariables[k]->defuzzOut = initialOutputs[k];
+    }
+    if ( lpModel->SetInputs( &inputs[ i * nInputs ] ) != 0 or
+	 lpModel->Evaluate() != 0 ) {
+      good[i] = false;
+      Failed[ row ]++;
+      continue;
+    }
+    lpModel->GetOutputs( &outputs[ i * nOutputs ] );
+  }
+
+  vector< double > values;
+  values.reserve( nSamples );
+
+  for ( int k = 0; k < nOutputs; k++ ) {
+    double* lpResults = &Results[ ( row * nOutputs + k ) * nResults ];
+
+    values.clear();
+    double sum = 0.;
+    for ( int i = 0; i < nSamples; i++ ) {
+      if ( good[i] ) {
+	values.push_back( outputs[ i * nOutputs + k ] );
+	sum += values.back();
+      }
+    }
+    int n = values.size();
+    if ( n == 0 ) {
+      for ( int r = 0; r < nResults; r++ ) lpResults[r] = 0.;
+      continue;
+    }
+
+    double mean = sum / n;
+    double sumSq = 0.;
+    for ( int i = 0; i < n; i++ ) {
+      sumSq += ( values[i] - mean ) * ( values[i] - mean );
+    }
+    lpResults[0] = mean;
+    lpResults[1] = n > 1 ? sqrt( sumSq / ( n - 1 ) ) : 0.;
+
+    // Quantiles, linear between the sorted samples
+    sort( values.begin(), values.end() );
+    for ( int q = 0; q < nQuantiles; q++ ) {
+      double position = quantiles[q] * ( n - 1 );
+      int    lower    = (int) floor( position );
+      int    upper    = min( lower + 1, n - 1 );
+      double fraction = position - lower;
+      lpResults[ 2 + q ] = values[ lower ] +
+	                   fraction * ( values[ upper ] - values[ lower ] );
+    }
+  }
+}
+
+//--------------------------------------------------------------
+// Run
+//
+// Purpose: Evaluate the samples of every input row on the
+//          FCL_ParallelFor() thread pool
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyMonteCarloClass::Run() {
+
+  int nThreads = FCL_NumThreads();
+
+  if ( Noise.empty() or nRows < 1 or nSamples < 1 ) {
+    status = -1;
+    ErrMsg( "Run() No noise, input data or samples for",
+	    lpFC->FCLFile(), status );
+    return status;
+  }
+  for ( int q = 0; q < (int) quantiles.size(); q++ ) {
+    if ( quantiles[q] < 0. or quantiles[q] > 1. ) {
+      status = -1;
+      ErrMsg( "Run() Quantile is not in [0, 1]", quantiles[q], status );
+      return status;
+    }
+  }
+
+  // A model clone per thread, from one parsed model
+  status = FCL_CloneModels( lpFC, nThreads, &Workers );
+  if ( status != 0 ) {
+    ErrMsg( "Run() Failed to clone model", lpFC->FCLFile(), status );
+    return status;
+  }
+  initialOutputs.assign( lpFC->NumOutputs(), 0. );
+  lpFC->GetOutputs( &initialOutputs[0] );
+
+  Results.assign( nRows * lpFC->NumOutputs() * ( 2 + quantiles.size() ),
+		  0. );
+  Failed.assign( nRows, 0 );
+
+  status = FCL_ParallelFor( nRows, 1, MonteCarloRows, this,
+			    Workers.size() );
+  if ( status != 0 ) {
+    ErrMsg( "Run() Failed to evaluate samples of", lpFC->FCLFile(), status );
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// WriteOutput
+//
+// Purpose: Write a row per input row: the index, the inputs, the
+//          mean, standard deviation and quantiles of each output,
+//          and the number of samples that failed
+//
+// Arguments: fileName : output file
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyMonteCarloClass::WriteOutput( string* fileName ) {
+
+  ofstream OutputStream;
+  int nInputs    = lpFC->NumInputs();
+  int nOutputs   = lpFC->NumOutputs();
+  int nQuantiles = quantiles.size();
+  int nResults   = 2 + nQuantiles;
+
+  OutputStream.open( fileName->c_str(), ios::out );
+  if ( not OutputStream ) {
+    ErrMsg( "Failed to open Monte Carlo output file:", *fileName, -1 );
+    return -1;
+  }
+
+  OutputStream << "index";
+  for ( int j = 0; j < nInputs; j++ ) {
+    OutputStream << ", " << lpFC->InputVariablesVector()[j]->varName;
+  }
+  for ( int k = 0; k < nOutputs; k++ ) {
+    const string& varName = lpFC->OutputVariablesVector()[k]->varName;
+    OutputStream << ", " << varName << "_mean, " << varName << "_std";
+    for ( int q = 0; q < nQuantiles; q++ ) {
+      OutputStream << ", " << varName << "_q" << quantiles[q];
+    }
+  }
+  OutputStream << ", failed" << endl;
+
+  for ( int row = 0; row < nRows; row++ ) {
+    OutputStream << row;
+    for ( int j = 0; j < nInputs; j++ ) {
+      OutputStream << ", " << Inputs[ row * nInputs + j ];
+    }
+    for ( int r = 0; r < nOutputs * nResults; r++ ) {
+      OutputStream << ", " << Results[ row * nOutputs * nResults + r ];
+    }
+    OutputStream << ", " << Failed[ row ] << endl;
+  }
+
+  OutputStream.close();
+  return 0;
+}
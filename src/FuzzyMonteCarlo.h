@@ -0,0 +1,103 @@
+#ifndef Fuzzy_MonteCarlo_H
+#define Fuzzy_MonteCarlo_H
+
+#include "FuzzyControl.h"
+
+// Default number of perturbed evaluations of each input row
+#define FCL_MC_SAMPLES 1000
+
+// Default random seed
+#define FCL_MC_SEED 1
+
+// Input noise distributions of a noise file line
+enum noiseKind { NoiseNormal,
+		 NoiseUniform,
+		 NoiseEmpirical };
+
+//---------------------------------------------------------------------
+// struct FuzzyNoise
+//
+// Purpose: A line of the noise file, noise added to an input. The
+//          noises of an input listed more than once are summed.
+//
+//          var := NORMAL sd ;                normal, mean 0
+//          var := UNIFORM lower upper ;      uniform
+//          var := EMPIRICAL file column ;    drawn from a column of
+//                                            a delimited data file
+//---------------------------------------------------------------------
+struct FuzzyNoise {
+  int    kind;   // noiseKind
+  int    handle; // input handle
+  double a;      // NORMAL sd, UNIFORM lower
+  double b;      // UNIFORM upper
+
+  vector< double > values; // EMPIRICAL
+};
+
+//---------------------------------------------------------------------
+// class FuzzyMonteCarloClass
+//
+// Purpose: Propagate input uncertainty through a model. Each input
+//          row is evaluated Samples() times with noise added to the
+//          inputs, each sample from the output state of the parsed
+//          model, as they are independent draws. The mean, standard deviation
+//          and Quantiles() of each output are kept for each row. The
+//          rows are spread over the FCL_ParallelFor() thread pool,
+//          one model clone per thread. The random numbers of a row
+//          depend only on Seed() and the row, so the results do not
+//          depend on the number of threads.
+//---------------------------------------------------------------------
+class FuzzyMonteCarloClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC; // the parsed model, not changed
+
+  // Model clones, one per thread
+  vector< FuzzyControlClass* > Workers;
+
+  // Output state of the parsed model, the start of each sample
+  vector< double > initialOutputs;
+
+  vector< FuzzyNoise > Noise;
+
+  int              nSamples;
+  unsigned long    seed;
+  vector< double > quantiles;
+
+  // Input data, nRows rows of NumInputs() values
+  int              nRows;
+  vector< double > Inputs;
+
+  // Results of each row, for each output: mean, standard deviation
+  // and the quantiles, and the number of samples that failed
+  vector< double > Results;
+  vector< int >    Failed;
+
+  int ReadEmpirical( const string& fileName, const string& column,
+		     vector< double >* values );
+
+ public:
+  // Encapsulation methods for protected variables
+  int               Samples()   const { return nSamples; }
+  int              &Samples()         { return nSamples; }
+  unsigned long     Seed()      const { return seed; }
+  unsigned long    &Seed()            { return seed; }
+  vector< double >  Quantiles() const { return quantiles; }
+  vector< double > &Quantiles()       { return quantiles; }
+
+  int NumRows() const { return nRows; }
+
+  // FuzzyMonteCarlo Methods
+  FuzzyMonteCarloClass( FuzzyControlClass* lpFC );
+  ~FuzzyMonteCarloClass();
+
+  int ReadNoiseFile    ( string* fileName );
+  int ReadInputDataFile( string* fileName );
+  int Run              ();
+  int WriteOutput      ( string* fileName );
+  void EvaluateRow     ( int threadIndex, int row );
+};
+
+#endif
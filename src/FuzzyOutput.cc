@@ -22,3 +22,64 @@ FuzzyOutputClass::FuzzyOutputClass(FCL_keyword* ACCU_Method,
   defuzzOut    = 0.;
 
 }
+
+//--------------------------------------------------------------
+// NewTermXY
+//
+// Purpose: Get an XY point for an activation or accumulation term,
+//          from the points the term released in a previous
+//          evaluation, so that evaluation does not allocate once
+//          every term has been used.
+//
+// Arguments: lpFOT : term the point will be pushed onto
+//           
+// Return: pointer to the XY point, 0 on failure
+//--------------------------------------------------------------
+XY* NewTermXY( FuzzyOutputTerm* lpFOT ) {
+
+  XY* lpXY = 0;
+
+  if ( lpFOT->xyFree.size() ) {
+    lpXY = lpFOT->xyFree.back();
+    lpFOT->xyFree.pop_back();
+    return lpXY;
+  }
+
+  lpXY = new XY;
+  if ( lpXY ) {
+    // the free list can then hold all the points of the term
+    lpFOT->xyFree.reserve( lpFOT->xy.size() + 4 );
+  }
+  return lpXY;
+}
+
+//--------------------------------------------------------------
+// ReleaseTermXY
+//
+// Purpose: Move all the xy points of a term to its free list
+//
+// Arguments: lpFOT : activation or accumulation term
+//           
+// Return:   
+//--------------------------------------------------------------
+void ReleaseTermXY( FuzzyOutputTerm* lpFOT ) {
+
+  lpFOT->xyFree.insert( lpFOT->xyFree.end(), 
+			lpFOT->xy.begin(), lpFOT->xy.end() );
+  lpFOT->xy.clear();
+}
+
+//--------------------------------------------------------------
+// ReleaseTermXY
+//
+// Purpose: Move one xy point, removed from a term, to its free list
+//
+// Arguments: lpFOT : activation or accumulation term
+//            lpXY  : the point
+//           
+// Return:   
+//--------------------------------------------------------------
+void ReleaseTermXY( FuzzyOutputTerm* lpFOT, XY* lpXY ) {
+
+  lpFOT->xyFree.push_back( lpXY );
+}
@@ -17,8 +17,14 @@ struct FuzzyOutputTerm {
   int    termType;     // Trapezoid, Triangle, Ramp, Rectangle, Singleton
   vector<XY*> xy;      // container for term xy points if not Singleton
   XY     singleton;    // output x,y value for Singleton
+  vector<XY*> xyFree;  // released xy points, reused by NewTermXY()
 };
 
+// Activation and accumulation term points, reused between evaluations
+XY*  NewTermXY    ( FuzzyOutputTerm* lpFOT );
+void ReleaseTermXY( FuzzyOutputTerm* lpFOT );
+void ReleaseTermXY( FuzzyOutputTerm* lpFOT, XY* lpXY );
+
 //---------------------------------------------------------------------
 // class FuzzyOutput
 //
@@ -0,0 +1,404 @@
+#include "FuzzyRaster.h"
+#include <cstring>    // memcpy, memcmp
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <fcntl.h>    // open
+#include <unistd.h>   // ftruncate, close
+
+//--------------------------------------------------------------
+// RasterTiles
+//
+// Purpose: FCL_ParallelFor() worker for Evaluate(), the items are
+//          the tiles, row by row
+//
+// Arguments: arg         : pointer to the FuzzyRasterClass
+//            threadIndex : model clone of the thread
+//            begin, end  : range of tiles
+//
+// Return:
+//--------------------------------------------------------------
+static void RasterTiles( void* arg, int threadIndex, int begin, int end ) {
+
+  FuzzyRasterClass* lpRaster = (FuzzyRasterClass*) arg;
+
+  for ( int tile = begin; tile < end; tile++ ) {
+    lpRaster->EvaluateTile( threadIndex, tile );
+  }
+}
+
+//--------------------------------------------------------------
+// FuzzyRasterClass
+//
+// Purpose: Constructor for FuzzyRasterClass
+//
+// Arguments: lpFC : the parsed model
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyRasterClass::FuzzyRasterClass( FuzzyControlClass* lpFC ) {
+
+  status     = 0;
+  this->lpFC = lpFC;
+  nx         = 0;
+  ny         = 0;
+  tileSize   = FCL_RASTER_TILE;
+  nTilesX    = 0;
+  nNoData    = 0;
+  nFailed    = 0;
+
+  FuzzyRasterMap unmapped;
+  unmapped.lpMap   = 0;
+  unmapped.mapSize = 0;
+  unmapped.lpData  = 0;
+  unmapped.nodata  = 0.;
+  InputRasters.assign ( lpFC->NumInputs(),  unmapped );
+  OutputRasters.assign( lpFC->NumOutputs(), unmapped );
+}
+
+//--------------------------------------------------------------
+// ~FuzzyRasterClass
+//
+// Purpose: Destructor for FuzzyRasterClass, unmap the rasters and
+//          delete the model clones
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyRasterClass::~FuzzyRasterClass() {
+
+  Close();
+  for ( int i = 0; i < (int) Workers.size(); i++ ) {
+    delete Workers[i];
+  }
+}
+
+//--------------------------------------------------------------
+// MapRaster
+//
+// Purpose: Map a raster file read only, check its header and size
+//
+// Arguments: fileName : raster file
+//            lpRaster : set to the mapping
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRasterClass::MapRaster( const string& fileName,
+				 FuzzyRasterMap* lpRaster ) {
+
+  int fd = open( fileName.c_str(), O_RDONLY );
+  if ( fd < 0 ) {
+    ErrMsg( "MapRaster() Failed to open raster file", fileName, -1 );
+    return -1;
+  }
+  struct stat fileStat;
+  if ( fstat( fd, &fileStat ) != 0 or
+       fileStat.st_size < (off_t) sizeof( FuzzyRasterHeader ) ) {
+    ErrMsg( "MapRaster() Raster file has no header", fileName, -1 );
+    close( fd );
+    return -1;
+  }
+  size_t size  = fileStat.st_size;
+  void*  lpMap = mmap( 0, size, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+  if ( lpMap == MAP_FAILED ) {
+    ErrMsg( "MapRaster() Failed to map raster file", fileName, -1 );
+    return -1;
+  }
+
+  const FuzzyRasterHeader* lpHeader = (const FuzzyRasterHeader*) lpMap;
+  if ( memcmp( lpHeader->magic, FCL_RASTER_MAGIC, 8 ) != 0 or
+       size != sizeof( FuzzyRasterHeader ) +
+	       (size_t) lpHeader->nx * lpHeader->ny * sizeof( double ) ) {
+    ErrMsg( "MapRaster() Invalid raster header or size", fileName, -1 );
+    munmap( lpMap, size );
+    return -1;
+  }
+
+  lpRaster->fileName = fileName;
+  lpRaster->lpMap    = lpMap;
+  lpRaster->mapSize  = size;
+  lpRaster->lpData   = (double*) ( (char*) lpMap +
+				   sizeof( FuzzyRasterHeader ) );
+  lpRaster->nodata   = lpHeader->nodata;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// CreateRaster
+//
+// Purpose: Create an nx by ny raster file, replacing an existing
+//          one, and map it read write
+//
+// Arguments: fileName : raster file
+//            nodata   : nodata value of the header
+//            lpRaster : set to the mapping
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRasterClass::CreateRaster( const string& fileName, double nodata,
+				    FuzzyRasterMap* lpRaster ) {
+
+  size_t size = sizeof( FuzzyRasterHeader ) +
+                (size_t) nx * ny * sizeof( double );
+
+  int fd = open( fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if ( fd < 0 ) {
+    ErrMsg( "CreateRaster() Failed to create raster file", fileName, -1 );
+    return -1;
+  }
+  if ( ftruncate( fd, size ) != 0 ) {
+    ErrMsg( "CreateRaster() Failed to size raster file", fileName, -1 );
+    close( fd );
+    return -1;
+  }
+  void* lpMap = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close( fd );
+  if ( lpMap == MAP_FAILED ) {
+    ErrMsg( "CreateRaster() Failed to map raster file", fileName, -1 );
+    return -1;
+  }
+
+  FuzzyRasterHeader* lpHeader = (FuzzyRasterHeader*) lpMap;
+  memcpy( lpHeader->magic, FCL_RASTER_MAGIC, 8 );
+  lpHeader->nx     = nx;
+  lpHeader->ny     = ny;
+  lpHeader->nodata = nodata;
+
+  lpRaster->fileName = fileName;
+  lpRaster->lpMap    = lpMap;
+  lpRaster->mapSize  = size;
+  lpRaster->lpData   = (double*) ( (char*) lpMap +
+				   sizeof( FuzzyRasterHeader ) );
+  lpRaster->nodata   = nodata;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// UnmapRaster
+//
+// Purpose: Unmap a raster file, the written cells of an output
+//          raster are kept in the file
+//
+// Arguments: lpRaster : the mapping, cleared
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyRasterClass::UnmapRaster( FuzzyRasterMap* lpRaster ) {
+
+  if ( lpRaster->lpMap ) {
+    munmap( lpRaster->lpMap, lpRaster->mapSize );
+  }
+  lpRaster->lpMap   = 0;
+  lpRaster->mapSize = 0;
+  lpRaster->lpData  = 0;
+}
+
+//--------------------------------------------------------------
+// SetInput
+//
+// Purpose: Map the raster file of an input variable, all of the
+//          input rasters are the same shape
+//
+// Arguments: varName  : VAR_INPUT variable
+//            fileName : raster file
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRasterClass::SetInput( const string& varName,
+				const string& fileName ) {
+
+  int handle = lpFC->InputHandle( varName );
+  if ( handle < 0 ) {
+    status = -1;
+    ErrMsg( "SetInput() No input variable", varName, status );
+    return status;
+  }
+  UnmapRaster( &InputRasters[ handle ] );
+
+  status = MapRaster( fileName, &InputRasters[ handle ] );
+  if ( status != 0 ) {
+    return status;
+  }
+
+  const FuzzyRasterHeader* lpHeader =
+    (const FuzzyRasterHeader*) InputRasters[ handle ].lpMap;
+  bool first = true;
+  for ( int j = 0; j < (int) InputRasters.size(); j++ ) {
+    if ( j != handle and InputRasters[j].lpMap ) first = false;
+  }
+  if ( first ) {
+    nx = lpHeader->nx;
+    ny = lpHeader->ny;
+  }
+  else if ( lpHeader->nx != nx or lpHeader->ny != ny ) {
+    status = -1;
+    ErrMsg( "SetInput() Raster is not the shape of the other inputs",
+	    fileName, status );
+    UnmapRaster( &InputRasters[ handle ] );
+    return status;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// EvaluateTile
+//
+// Purpose: Evaluate the cells of a tile on the model clone of the
+//          thread, write the outputs of each cell
+//
+// Arguments: threadIndex : index into Workers
+//            tile        : tile index, row by row
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyRasterClass::EvaluateTile( int threadIndex, int tile ) {
+
+  FuzzyControlClass*           lpModel  = Workers[ threadIndex ];
+  vector< FuzzyOutputClass* > &outputs  = lpModel->OutputVariablesVector();
+  vector< double >            &inputs   = WorkerInputs[ threadIndex ];
+  int                          nInputs  = inputs.size();
+  int                          nOutputs = outputs.size();
+  double                       nodata   = InputRasters[0].nodata;
+
+  uint32_t x0 = ( tile % nTilesX ) * tileSize;
+  uint32_t y0 = ( tile / nTilesX ) * tileSize;
+  uint32_t x1 = x0 + tileSize < nx ? x0 + tileSize : nx;
+  uint32_t y1 = y0 + tileSize < ny ? y0 + tileSize : ny;
+
+  long noData = 0;
+  long failed = 0;
+  for ( uint32_t y = y0; y < y1; y++ ) {
+    size_t rowStart = (size_t) y * nx;
+    for ( uint32_t x = x0; x < x1; x++ ) {
+      size_t cell  = rowStart + x;
+      bool   valid = true;
+      for ( int j = 0; j < nInputs and valid; j++ ) {
+	double value = InputRasters[j].lpData[ cell ];
+	valid = not ( value == InputRasters[j].nodata or value != value );
+	inputs[j] = value;
+      }
+
+      if ( valid ) {
+	for ( int k = 0; k < nOutputs; k++ ) {
+	  outputs[k]->defuzzOut = initialOutputs[k];
+	}
+	if ( lpModel->SetInputs( &inputs[0] ) != 0 or
+	     lpModel->Evaluate() != 0 ) {
+	  failed++;
+	  valid = false;
+	}
+      }
+      else {
+	noData++;
+      }
+
+      for ( int k = 0; k < nOutputs; k++ ) {
+	OutputRasters[k].lpData[ cell ] =
+	  valid ? outputs[k]->defuzzOut : nodata;
+      }
+    }
+  }
+  tileNoData[ tile ] = noData;
+  tileFailed[ tile ] = failed;
+}
+
+//--------------------------------------------------------------
+// Evaluate
+//
+// Purpose: Create the output rasters, baseName.output.raster, and
+//          evaluate the tiles on the FCL_ParallelFor() thread pool
+//
+// Arguments: baseName : output raster file name base
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRasterClass::Evaluate( const string& baseName ) {
+
+  int nThreads = FCL_NumThreads();
+
+  for ( int j = 0; j < (int) InputRasters.size(); j++ ) {
+    if ( not InputRasters[j].lpMap ) {
+      status = -1;
+      ErrMsg( "Evaluate() No raster for input",
+	      lpFC->InputVariablesVector()[j]->varName, status );
+      return status;
+    }
+  }
+  if ( InputRasters.empty() or OutputRasters.empty() or tileSize < 1 ) {
+    status = -1;
+    ErrMsg( "Evaluate() No inputs, outputs or tile size for",
+	    lpFC->FCLFile(), status );
+    return status;
+  }
+
+  long nTiles = 0;
+  nTilesX = ( nx + tileSize - 1 ) / tileSize;
+  nTiles  = (long) nTilesX * ( ( ny + tileSize - 1 ) / tileSize );
+  if ( nTiles > 0x7FFFFFFF ) {
+    status = -1;
+    ErrMsg( "Evaluate() Too many tiles, increase the tile size",
+	    tileSize, status );
+    return status;
+  }
+
+  // A model clone per thread, from one parsed model
+  status = FCL_CloneModels( lpFC, nThreads, &Workers );
+  if ( status != 0 ) {
+    ErrMsg( "Evaluate() Failed to clone model", lpFC->FCLFile(), status );
+    return status;
+  }
+  WorkerInputs.resize( Workers.size(),
+		       vector< double >( lpFC->NumInputs(), 0. ) );
+  initialOutputs.assign( lpFC->NumOutputs(), 0. );
+  lpFC->GetOutputs( &initialOutputs[0] );
+
+  for ( int k = 0; k < (int) OutputRasters.size(); k++ ) {
+    UnmapRaster( &OutputRasters[k] );
+    string fileName = baseName + "." +
+      lpFC->OutputVariablesVector()[k]->varName + ".raster";
+    status = CreateRaster( fileName, InputRasters[0].nodata,
+			   &OutputRasters[k] );
+    if ( status != 0 ) {
+      return status;
+    }
+  }
+
+  tileNoData.assign( nTiles, 0 );
+  tileFailed.assign( nTiles, 0 );
+
+  status = FCL_ParallelFor( nTiles, 1, RasterTiles, this, Workers.size() );
+  if ( status != 0 ) {
+    ErrMsg( "Evaluate() Failed to evaluate tiles of", lpFC->FCLFile(),
+	    status );
+    return status;
+  }
+
+  nNoData = 0;
+  nFailed = 0;
+  for ( long t = 0; t < nTiles; t++ ) {
+    nNoData += tileNoData[t];
+    nFailed += tileFailed[t];
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Close
+//
+// Purpose: Unmap the input and output rasters
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRasterClass::Close() {
+
+  for ( int j = 0; j < (int) InputRasters.size(); j++ ) {
+    UnmapRaster( &InputRasters[j] );
+  }
+  for ( int k = 0; k < (int) OutputRasters.size(); k++ ) {
+    UnmapRaster( &OutputRasters[k] );
+  }
+  return 0;
+}
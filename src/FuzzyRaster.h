@@ -0,0 +1,105 @@
+#ifndef Fuzzy_Raster_H
+#define Fuzzy_Raster_H
+
+#include "FuzzyControl.h"
+
+// Default tile edge, in cells, of the raster evaluation
+#define FCL_RASTER_TILE 64
+
+// Raster file magic
+#define FCL_RASTER_MAGIC "FCLRAST1"
+
+//---------------------------------------------------------------------
+// struct FuzzyRasterHeader
+//
+// Purpose: Header of a raster file, followed by ny rows of nx
+//          doubles, native byte order. A cell of value nodata, or
+//          NaN, has no data.
+//---------------------------------------------------------------------
+struct FuzzyRasterHeader {
+  char     magic[8]; // FCL_RASTER_MAGIC, without the terminating 0
+  uint32_t nx;       // columns
+  uint32_t ny;       // rows
+  double   nodata;
+};
+
+//---------------------------------------------------------------------
+// struct FuzzyRasterMap
+//
+// Purpose: A raster file mapped into memory
+//---------------------------------------------------------------------
+struct FuzzyRasterMap {
+  string  fileName;
+  void*   lpMap;
+  size_t  mapSize;
+  double* lpData; // ny rows of nx values after the header
+  double  nodata;
+};
+
+//---------------------------------------------------------------------
+// class FuzzyRasterClass
+//
+// Purpose: Evaluate a model on each cell of gridded inputs, a raster
+//          file per input variable, and write a raster file of the
+//          same shape per output variable. The rasters are mapped
+//          into memory, not read. The grid is evaluated in square
+//          tiles of TileSize() cells on the FCL_ParallelFor() thread
+//          pool, one model clone per thread, so that the cells of a
+//          tile stay in cache. Each cell starts from the output state
+//          of the parsed model. A cell where an input has no data, or
+//          that fails to evaluate, is set to the nodata value of the
+//          first input raster in the output rasters.
+//---------------------------------------------------------------------
+class FuzzyRasterClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC; // the parsed model, not changed
+
+  // Model clones and an input row, one per thread
+  vector< FuzzyControlClass* > Workers;
+  vector< vector< double > >   WorkerInputs;
+
+  // Output state of the parsed model, the start of each cell
+  vector< double > initialOutputs;
+
+  // Raster of each input handle, each output handle
+  vector< FuzzyRasterMap > InputRasters;
+  vector< FuzzyRasterMap > OutputRasters;
+
+  uint32_t nx;
+  uint32_t ny;
+  int      tileSize;
+  int      nTilesX;
+
+  // Cells without data and failed cells of each tile
+  vector< long > tileNoData;
+  vector< long > tileFailed;
+  long           nNoData;
+  long           nFailed;
+
+  int  MapRaster   ( const string& fileName, FuzzyRasterMap* lpRaster );
+  int  CreateRaster( const string& fileName, double nodata,
+		     FuzzyRasterMap* lpRaster );
+  void UnmapRaster ( FuzzyRasterMap* lpRaster );
+
+ public:
+  // Encapsulation methods for protected variables
+  int  TileSize() const { return tileSize; }
+  int &TileSize()       { return tileSize; }
+  long NumCells()  const { return (long) nx * ny; }
+  long NumNoData() const { return nNoData; }
+  long NumFailed() const { return nFailed; }
+
+  // FuzzyRaster Methods
+  FuzzyRasterClass( FuzzyControlClass* lpFC );
+  ~FuzzyRasterClass();
+
+  int  SetInput    ( const string& varName, const string& fileName );
+  int  Evaluate    ( const string& baseName );
+  int  Close       ();
+  void EvaluateTile( int threadIndex, int tile );
+};
+
+#endif
@@ -0,0 +1,449 @@
+#include "FuzzyReload.h"
+#include <sys/stat.h> // stat
+#include <unistd.h>   // usleep
+
+//--------------------------------------------------------------
+// FuzzyReloadPollThread
+//
+// Purpose: pthread entry point of StartPolling()
+//
+// Arguments: pointer to FuzzyReloadClass
+//
+// Return:
+//--------------------------------------------------------------
+static void* FuzzyReloadPollThread( void* arg ) {
+
+  ((FuzzyReloadClass*) arg)->PollLoop();
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FuzzyReloadClass
+//
+// Purpose: Constructor for FuzzyReloadClass. The model is loaded
+//          by the first Reload().
+//
+// Arguments: as FuzzyControlClass
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyReloadClass::FuzzyReloadClass( string FCLFile,
+				    string delimeters,
+				    string dataLabel ) {
+
+  status          = 0;
+  FCLFileName     = FCLFile;
+  inputDelimeters = delimeters;
+  inputDataLabel  = dataLabel;
+  FCLHash         = 0;
+  modTime         = 0;
+  modTimeNs       = 0;
+  fileSize        = 0;
+  generation      = 0;
+  polling         = false;
+  pollInterval    = 0;
+
+  pthread_mutex_init( &writerMutex, 0 );
+
+  for ( int i = 0; i < FCL_RELOAD_MAX_READERS; i++ ) {
+    Readers[i].used    = false;
+    Readers[i].model   = 0;
+    Readers[i].pending = 0;
+  }
+}
+
+//--------------------------------------------------------------
+// ~FuzzyReloadClass
+//
+// Purpose: Stop polling, delete the reader models. The readers
+//          must have stopped evaluating.
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyReloadClass::~FuzzyReloadClass() {
+
+  StopPolling();
+
+  for ( int i = 0; i < FCL_RELOAD_MAX_READERS; i++ ) {
+    DeleteModel( Readers[i].model );
+    DeleteModel( Readers[i].pending );
+  }
+  pthread_mutex_destroy( &writerMutex );
+}
+
+//--------------------------------------------------------------
+// NewModel
+//
+// Purpose: Create a reader model from a SaveModel() image.
+//          Called with writerMutex held.
+//
+// Arguments: modelImage : the published image, or the one
+//                         Reload() is about to publish
+//
+// Return: pointer to FuzzyControlClass, 0 on error
+//--------------------------------------------------------------
+FuzzyControlClass* FuzzyReloadClass::NewModel( const string& modelImage ) {
+
+  FuzzyControlClass* lpFC = new FuzzyControlClass( FCLFileName,
+						   inputDelimeters,
+						   inputDataLabel );
+  if ( not lpFC ) {
+    ErrMsg( "Failed to create FuzzyControlClass for", FCLFileName, -1 );
+    return 0;
+  }
+  if ( lpFC->LoadModel( modelImage.data(), modelImage.size() ) != 0 ) {
+    ErrMsg( "Failed to load reader model of", FCLFileName, -1 );
+    DeleteModel( lpFC );
+    return 0;
+  }
+  return lpFC;
+}
+
+//--------------------------------------------------------------
+// DeleteModel
+//
+// Purpose: Free a model, ~FuzzyControlClass() frees its FCL
+//          objects and keywords
+//
+// Arguments: pointer to FuzzyControlClass, may be 0
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyReloadClass::DeleteModel( FuzzyControlClass* lpFC ) {
+
+  delete lpFC;
+}
+
+//--------------------------------------------------------------
+// Reload
+//
+// Purpose: Parse the FCL file and publish it to the readers if
+//          the text changed. A file that fails to parse, has no
+//          inputs, outputs or rules, or a rule without a condition
+//          or conclusion, is rejected and the readers keep the
+//          current model. The model is published only when the
+//          copy of every reader is built, otherwise the published
+//          hash is kept and the next CheckReload() tries again.
+//
+// Arguments:
+//
+// Return: 0 = published, 1 = unchanged, < 0 = error
+//--------------------------------------------------------------
+int FuzzyReloadClass::Reload() {
+
+  pthread_mutex_lock( &writerMutex );
+
+  FuzzyControlClass parser( FCLFileName, inputDelimeters, inputDataLabel );
+
+  uint64_t hash = 0;
+  status = parser.FCLTextHash( &hash );
+  if ( status != 0 ) {
+    ErrMsg( "Reload() Failed to read FCL file", FCLFileName, status );
+    pthread_mutex_unlock( &writerMutex );
+    return status;
+  }
+  if ( generation and hash == FCLHash ) {
+    pthread_mutex_unlock( &writerMutex );
+    return 1;
+  }
+
+  status = parser.ReadFCLFile();
+  if ( status == 0 ) {
+    status = parser.ParseFCLFile();
+  }
+  if ( status == 0 and ( parser.InputVariablesMap().empty()  or
+			 parser.OutputVariablesMap().empty() or
+			 parser.RulesMap().empty() ) ) {
+    status = -1;
+    ErrMsg( "Reload() FCL file has no inputs, outputs or rules",
+	    FCLFileName, status );
+  }
+  if ( status == 0 ) {
+    map< string, FuzzyRuleClass* > &rules = parser.RulesMap();
+    for ( map< string, FuzzyRuleClass* >::iterator ri = rules.begin();
+	  ri != rules.end(); ++ri ) {
+      if ( ri->second->Conditions.empty() or 
+	   ri->second->Conclusions.empty() ) {
+	status = -1;
+	ErrMsg( "Reload() Rule has no valid condition or conclusion",
+		ri->first, status );
+      }
+    }
+  }
+
+  string newImage;
+  if ( status == 0 ) {
+    status = parser.SaveModel( &newImage );
+  }
+
+  if ( status != 0 ) {
+    ErrMsg( "Reload() Rejected FCL file, keeping the current model",
+	    FCLFileName, status );
+    pthread_mutex_unlock( &writerMutex );
+    return status;
+  }
+
+  // Build the copy of every reader before anything is published
+  FuzzyControlClass* copies[ FCL_RELOAD_MAX_READERS ];
+  for ( int i = 0; i < FCL_RELOAD_MAX_READERS; i++ ) {
+    copies[i] = 0;
+    if ( status == 0 and Readers[i].used ) {
+      copies[i] = NewModel( newImage );
+      if ( not copies[i] ) {
+	status = -1;
+      }
+    }
+  }
+  if ( status != 0 ) {
+    for ( int i = 0; i < FCL_RELOAD_MAX_READERS; i++ ) {
+      DeleteModel( copies[i] );
+    }
+    ErrMsg( "Reload() Failed to copy the model for the readers, retrying",
+	    FCLFileName, status );
+    // Not unchanged at the next CheckReload()
+    fileSize = -1;
+    pthread_mutex_unlock( &writerMutex );
+    return status;
+  }
+
+  image   = newImage;
+  FCLHash = hash;
+  generation++;
+
+  // Hand each reader its copy. The copy is complete before the
+  // exchange publishes it. A copy the reader never took is
+  // replaced, and deleted here since no reader has seen it.
+  __sync_synchronize();
+  for ( int i = 0; i < FCL_RELOAD_MAX_READERS; i++ ) {
+    if ( copies[i] ) {
+      DeleteModel( __sync_lock_test_and_set( &Readers[i].pending,
+					     copies[i] ) );
+    }
+  }
+
+  ConsoleMsg( "Reload() Published FCL model", FCLFileName, generation );
+  pthread_mutex_unlock( &writerMutex );
+  return status;
+}
+
+//--------------------------------------------------------------
+// CheckReload
+//
+// Purpose: Reload() if the FCL file modification time or size
+//          changed since the last check
+//
+// Arguments:
+//
+// Return: as Reload()
+//--------------------------------------------------------------
+int FuzzyReloadClass::CheckReload() {
+
+  struct stat fileStat;
+
+  if ( stat( FCLFileName.c_str(), &fileStat ) != 0 ) {
+    ErrMsg( "CheckReload() Failed to stat FCL file", FCLFileName, -1 );
+    return -1;
+  }
+  pthread_mutex_lock( &writerMutex );
+  bool unchanged = generation and fileStat.st_mtime == modTime and
+		   fileStat.st_mtim.tv_nsec == modTimeNs and
+		   fileStat.st_size == fileSize;
+  modTime   = fileStat.st_mtime;
+  modTimeNs = fileStat.st_mtim.tv_nsec;
+  fileSize  = fileStat.st_size;
+  pthread_mutex_unlock( &writerMutex );
+
+  if ( unchanged ) {
+    return 1;
+  }
+  return Reload();
+}
+
+//--------------------------------------------------------------
+// PollLoop
+//
+// Purpose: CheckReload() every pollInterval until StopPolling()
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyReloadClass::PollLoop() {
+
+  while ( polling ) {
+    usleep( pollInterval * 1000 );
+    if ( polling ) {
+      CheckReload();
+    }
+  }
+}
+
+//--------------------------------------------------------------
+// StartPolling
+//
+// Purpose: Start a thread that checks the FCL file for changes
+//
+// Arguments: intervalMS : milliseconds between checks
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyReloadClass::StartPolling( int intervalMS ) {
+
+  if ( polling ) {
+    return 0;
+  }
+  pollInterval = intervalMS > 0 ? intervalMS : 1000;
+  polling      = true;
+
+  if ( pthread_create( &pollThread, 0, FuzzyReloadPollThread, this ) != 0 ) {
+    polling = false;
+    ErrMsg( "StartPolling() Failed to create thread", FCLFileName, -1 );
+    return -1;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// StopPolling
+//
+// Purpose: Stop the polling thread, wait for it to finish
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyReloadClass::StopPolling() {
+
+  if ( not polling ) {
+    return 0;
+  }
+  polling = false;
+  pthread_join( pollThread, 0 );
+  return 0;
+}
+
+//--------------------------------------------------------------
+// RegisterReader
+//
+// Purpose: Allocate a reader slot with its own copy of the
+//          published model. The first call loads the FCL file.
+//
+// Arguments:
+//
+// Return: slot index for Acquire(), < 0 = error
+//--------------------------------------------------------------
+int FuzzyReloadClass::RegisterReader() {
+
+  if ( not generation ) {
+    int reloadStatus = CheckReload();
+    if ( reloadStatus < 0 ) {
+      return reloadStatus;
+    }
+  }
+
+  pthread_mutex_lock( &writerMutex );
+
+  int slot = -1;
+  for ( int i = 0; i < FCL_RELOAD_MAX_READERS; i++ ) {
+    if ( not Readers[i].used ) {
+      slot = i;
+      break;
+    }
+  }
+  if ( slot < 0 ) {
+    ErrMsg( "RegisterReader() No free reader slot, maximum",
+	    FCL_RELOAD_MAX_READERS, -1 );
+    pthread_mutex_unlock( &writerMutex );
+    return -1;
+  }
+
+  Readers[ slot ].model = NewModel( image );
+  if ( not Readers[ slot ].model ) {
+    pthread_mutex_unlock( &writerMutex );
+    return -1;
+  }
+  Readers[ slot ].pending = 0;
+  Readers[ slot ].used    = true;
+
+  pthread_mutex_unlock( &writerMutex );
+  return slot;
+}
+
+//--------------------------------------------------------------
+// UnregisterReader
+//
+// Purpose: Free a reader slot and its models. The reader must not
+//          use the model returned by Acquire() afterwards.
+//
+// Arguments: slot : from RegisterReader()
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyReloadClass::UnregisterReader( int slot ) {
+
+  if ( slot < 0 or slot >= FCL_RELOAD_MAX_READERS ) {
+    ErrMsg( "UnregisterReader() Invalid reader slot", slot, -1 );
+    return -1;
+  }
+
+  pthread_mutex_lock( &writerMutex );
+  Readers[ slot ].used = false;
+  DeleteModel( Readers[ slot ].model );
+  DeleteModel( __sync_lock_test_and_set( &Readers[ slot ].pending,
+					 (FuzzyControlClass*) 0 ) );
+  Readers[ slot ].model = 0;
+  pthread_mutex_unlock( &writerMutex );
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Acquire
+//
+// Purpose: Reader side, called before each evaluation. Switches
+//          to a newly published model if there is one, carrying
+//          the previous defuzzOut of NC outputs over by name, and
+//          deletes the old model. Lock free.
+//
+// Arguments: slot : from RegisterReader()
+//
+// Return: model to evaluate until the next Acquire(), 0 on error
+//--------------------------------------------------------------
+FuzzyControlClass* FuzzyReloadClass::Acquire( int slot ) {
+
+  if ( slot < 0 or slot >= FCL_RELOAD_MAX_READERS ) {
+    ErrMsg( "Acquire() Invalid reader slot", slot, -1 );
+    return 0;
+  }
+  FuzzyReaderSlot* lpSlot = &Readers[ slot ];
+
+  if ( lpSlot->pending ) {
+    FuzzyControlClass* lpNew =
+      __sync_lock_test_and_set( &lpSlot->pending, (FuzzyControlClass*) 0 );
+
+    if ( lpNew ) {
+      FuzzyControlClass* lpOld = lpSlot->model;
+
+      map< string, FuzzyOutputClass* > &oldOutputs =
+	lpOld->OutputVariablesMap();
+      map< string, FuzzyOutputClass* > &newOutputs =
+	lpNew->OutputVariablesMap();
+      map< string, FuzzyOutputClass* >::iterator noi, ooi;
+
+      for ( noi = newOutputs.begin(); noi != newOutputs.end(); ++noi ) {
+	if ( not noi->second->defaultNC ) {
+	  continue;
+	}
+	ooi = oldOutputs.find( noi->first );
+	if ( ooi != oldOutputs.end() ) {
+	  noi->second->defuzzOut = ooi->second->defuzzOut;
+	}
+      }
+
+      lpSlot->model = lpNew;
+      DeleteModel( lpOld );
+    }
+  }
+  return lpSlot->model;
+}
@@ -0,0 +1,95 @@
+#ifndef Fuzzy_Reload_H
+#define Fuzzy_Reload_H
+
+#include "FuzzyControl.h"
+#include <pthread.h> // pthread_mutex_t, pthread_t
+#include <time.h>    // time_t
+
+// Maximum number of concurrent readers of a FuzzyReloadClass
+#define FCL_RELOAD_MAX_READERS 64
+
+//---------------------------------------------------------------------
+// struct FuzzyReaderSlot
+//
+// Purpose: The models of one reader (evaluation thread).
+//          model is used only by the reader. pending is written by
+//          Reload() and taken by the reader in Acquire(), both with
+//          an atomic exchange, so each model has exactly one owner.
+//---------------------------------------------------------------------
+struct FuzzyReaderSlot {
+  bool                        used;    // slot is registered
+  FuzzyControlClass*          model;   // model the reader evaluates
+  FuzzyControlClass* volatile pending; // newer model not yet taken
+};
+
+//---------------------------------------------------------------------
+// class FuzzyReloadClass
+//
+// Purpose: Keeps a FCL model current with its FCL file for a long
+//          running service. Reload() parses and validates the file
+//          off the evaluation path and publishes the new model to
+//          every reader. A reader picks it up in Acquire(), between
+//          evaluations, with one atomic exchange and no lock, so an
+//          evaluation in progress finishes on the old model and the
+//          old model is deleted when the reader has moved past it.
+//          NC outputs keep their last value when the output name
+//          exists in the new model.
+//
+//          The engine keeps evaluation state in the model objects,
+//          so each reader evaluates its own copy of the model, built
+//          from the SaveModel() image of the published model.
+//---------------------------------------------------------------------
+class FuzzyReloadClass {
+
+ protected:
+  int status; // Error code variable
+
+  string FCLFileName;      // FCL file to watch
+  string inputDelimeters;  // passed to the model FuzzyControlClass
+  string inputDataLabel;   // passed to the model FuzzyControlClass
+
+  // Serializes Reload(), RegisterReader() and UnregisterReader()
+  pthread_mutex_t writerMutex;
+
+  string       image;      // SaveModel() image of the published model
+  uint64_t     FCLHash;    // FCLTextHash() of the published model
+  time_t       modTime;    // FCL file modification time at last check
+  long         modTimeNs;  // nanoseconds of modTime
+  off_t        fileSize;   // FCL file size at last check
+  unsigned int generation; // incremented by each published model
+
+  FuzzyReaderSlot Readers[ FCL_RELOAD_MAX_READERS ];
+
+  // Background polling of the FCL file
+  pthread_t     pollThread;
+  volatile bool polling;
+  int           pollInterval; // milliseconds
+
+  FuzzyControlClass* NewModel( const string& modelImage );
+  void DeleteModel( FuzzyControlClass* lpFC );
+
+ public:
+  // Encapsulation methods for protected variables
+  string       FCLFile()    const { return FCLFileName; }
+  unsigned int Generation() const { return generation; }
+  int          PollInterval() const { return pollInterval; }
+
+  // FuzzyReload Methods
+  FuzzyReloadClass( string FCLFileName,
+		    string inputDelimeters,
+		    string inputDataLabel );
+  ~FuzzyReloadClass();
+
+  int Reload();
+  int CheckReload();
+  int StartPolling( int intervalMS );
+  int StopPolling();
+
+  int RegisterReader();
+  int UnregisterReader( int slot );
+  FuzzyControlClass* Acquire( int slot );
+
+  void PollLoop(); // body of pollThread
+};
+
+#endif
@@ -0,0 +1,547 @@
+#include "FuzzyRing.h"
+#include <cstring>    // memset, memcpy, memcmp
+#include <sys/mman.h> // shm_open, mmap
+#include <sys/stat.h> // fstat
+#include <fcntl.h>    // O_CREAT
+#include <unistd.h>   // ftruncate, close, sysconf
+#include <sched.h>    // sched_yield
+#include <time.h>     // clock_gettime
+
+//--------------------------------------------------------------
+// Shared memory layout:
+//
+//   FuzzyRingHeader
+//   input records  : capacity * nInputs doubles
+//   output records : capacity * ( FuzzyRingOutput + nOutputs doubles )
+//
+// A record is written before the index that publishes it, and
+// read before the index that releases it, with a full barrier
+// between the record and the index.
+//--------------------------------------------------------------
+static const char RingMagic[8] = { 'F','C','L','R','I','N','G','\0' };
+
+//--------------------------------------------------------------
+// CPURelax
+//
+// Purpose: Spin wait hint to the processor
+//--------------------------------------------------------------
+static inline void CPURelax() {
+#if defined(__i386__) or defined(__x86_64__)
+  __asm__ __volatile__( "pause" ::: "memory" );
+#else
+  __sync_synchronize();
+#endif
+}
+
+//--------------------------------------------------------------
+// ControllerThread
+//
+// Purpose: pthread entry point of Start()
+//
+// Arguments: pointer to FuzzyRingClass
+//
+// Return:
+//--------------------------------------------------------------
+static void* ControllerThread( void* arg ) {
+
+  ((FuzzyRingClass*) arg)->ControllerLoop();
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FuzzyRingClass
+//
+// Purpose: Constructor for FuzzyRingClass
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyRingClass::FuzzyRingClass() {
+
+  status           = 0;
+  owner            = false;
+  mapSize          = 0;
+  lpHeader         = 0;
+  inputRecords     = 0;
+  outputRecords    = 0;
+  inputRecordSize  = 0;
+  outputRecordSize = 0;
+  mask             = 0;
+  lpFC             = 0;
+  started          = false;
+  running          = false;
+}
+
+//--------------------------------------------------------------
+// ~FuzzyRingClass
+//
+// Purpose: Destructor for FuzzyRingClass
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyRingClass::~FuzzyRingClass() {
+
+  Close();
+}
+
+//--------------------------------------------------------------
+// Map
+//
+// Purpose: Map the shared memory segment, set the record pointers
+//          from the header
+//
+// Arguments: fd   : shm_open() descriptor
+//            size : segment size
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRingClass::Map( int fd, size_t size ) {
+
+  void* lpMap = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  if ( lpMap == MAP_FAILED ) {
+    ErrMsg( "Failed to map shared memory ring", ringName, -1 );
+    return -1;
+  }
+  mapSize  = size;
+  lpHeader = (FuzzyRingHeader*) lpMap;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Create
+//
+// Purpose: Controller side, create and initialize the shared
+//          memory rings. An existing ring of the same name is
+//          replaced.
+//
+// Arguments: name     : shm_open() name, "/name"
+//            nInputs  : doubles per input record
+//            nOutputs : doubles per output record
+//            capacity : records per ring, rounded up to a power of 2
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRingClass::Create( string name, int nInputs, int nOutputs,
+			    int capacity ) {
+
+  status = 0;
+
+  if ( lpHeader ) {
+    status = -1;
+    ErrMsg( "Create() Ring is already open", ringName, status );
+    return status;
+  }
+  if ( nInputs < 1 or nOutputs < 1 ) {
+    status = -1;
+    ErrMsg( "Create() Ring needs inputs and outputs", name, status );
+    return status;
+  }
+  uint32_t ringCapacity = 1;
+  while ( (int) ringCapacity < capacity ) {
+    ringCapacity <<= 1;
+  }
+
+  ringName         = name;
+  inputRecordSize  = nInputs * sizeof( double );
+  outputRecordSize = sizeof( FuzzyRingOutput ) + nOutputs * sizeof( double );
+  size_t size      = sizeof( FuzzyRingHeader ) +
+                     ringCapacity * ( inputRecordSize + outputRecordSize );
+
+  shm_unlink( ringName.c_str() );
+  int fd = shm_open( ringName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600 );
+  if ( fd < 0 ) {
+    status = -1;
+    ErrMsg( "Create() Failed to create shared memory ring", ringName, status );
+    return status;
+  }
+  if ( ftruncate( fd, size ) != 0 ) {
+    status = -1;
+    ErrMsg( "Create() Failed to size shared memory ring", ringName, status );
+    close( fd );
+    shm_unlink( ringName.c_str() );
+    return status;
+  }
+  status = Map( fd, size );
+  close( fd );
+  if ( status != 0 ) {
+    shm_unlink( ringName.c_str() );
+    return status;
+  }
+  owner = true;
+
+  memset( lpHeader, 0, sizeof( FuzzyRingHeader ) );
+  lpHeader->version  = FCL_RING_VERSION;
+  lpHeader->nInputs  = nInputs;
+  lpHeader->nOutputs = nOutputs;
+  lpHeader->capacity = ringCapacity;
+
+  pthread_mutexattr_t mutexAttr;
+  pthread_mutexattr_init( &mutexAttr );
+  pthread_mutexattr_setpshared( &mutexAttr, PTHREAD_PROCESS_SHARED );
+  pthread_mutex_init( &lpHeader->parkMutex, &mutexAttr );
+  pthread_mutexattr_destroy( &mutexAttr );
+
+  pthread_condattr_t condAttr;
+  pthread_condattr_init( &condAttr );
+  pthread_condattr_setpshared( &condAttr, PTHREAD_PROCESS_SHARED );
+  pthread_condattr_setclock( &condAttr, CLOCK_MONOTONIC );
+  pthread_cond_init( &lpHeader->parkCond, &condAttr );
+  pthread_condattr_destroy( &condAttr );
+
+  mask          = ringCapacity - 1;
+  inputRecords  = (char*) lpHeader + sizeof( FuzzyRingHeader );
+  outputRecords = inputRecords + ringCapacity * inputRecordSize;
+
+  // The magic is written last, a client never sees a partial header
+  __sync_synchronize();
+  memcpy( lpHeader->magic, RingMagic, sizeof( RingMagic ) );
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// Open
+//
+// Purpose: Client side, map the rings created by a controller
+//
+// Arguments: name : shm_open() name
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRingClass::Open( string name ) {
+
+  status = 0;
+
+  if ( lpHeader ) {
+    status = -1;
+    ErrMsg( "Open() Ring is already open", ringName, status );
+    return status;
+  }
+  ringName = name;
+
+  int fd = shm_open( ringName.c_str(), O_RDWR, 0 );
+  if ( fd < 0 ) {
+    status = -1;
+    ErrMsg( "Open() Failed to open shared memory ring", ringName, status );
+    return status;
+  }
+  struct stat ringStat;
+  if ( fstat( fd, &ringStat ) != 0 or
+       ringStat.st_size < (off_t) sizeof( FuzzyRingHeader ) ) {
+    status = -1;
+    ErrMsg( "Open() Invalid shared memory ring", ringName, status );
+    close( fd );
+    return status;
+  }
+  status = Map( fd, ringStat.st_size );
+  close( fd );
+  if ( status != 0 ) {
+    return status;
+  }
+  __sync_synchronize();
+
+  if ( memcmp( lpHeader->magic, RingMagic, sizeof( RingMagic ) ) != 0 or
+       lpHeader->version != FCL_RING_VERSION ) {
+    status = -1;
+    ErrMsg( "Open() Shared memory ring has a different format",
+	    ringName, status );
+    Close();
+    return status;
+  }
+
+  uint32_t capacity = lpHeader->capacity;
+  inputRecordSize   = lpHeader->nInputs * sizeof( double );
+  outputRecordSize  = sizeof( FuzzyRingOutput ) +
+                      lpHeader->nOutputs * sizeof( double );
+  if ( sizeof( FuzzyRingHeader ) +
+       capacity * ( inputRecordSize + outputRecordSize ) > mapSize ) {
+    status = -1;
+    ErrMsg( "Open() Shared memory ring is truncated", ringName, status );
+    Close();
+    return status;
+  }
+  mask          = capacity - 1;
+  inputRecords  = (char*) lpHeader + sizeof( FuzzyRingHeader );
+  outputRecords = inputRecords + capacity * inputRecordSize;
+
+  return status;
+}
+
+//--------------------------------------------------------------
+// Close
+//
+// Purpose: Stop the controller, unmap the rings. The controller
+//          side also removes the shared memory name.
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRingClass::Close() {
+
+  Stop();
+
+  if ( lpHeader ) {
+    munmap( lpHeader, mapSize );
+    lpHeader = 0;
+  }
+  if ( owner ) {
+    shm_unlink( ringName.c_str() );
+    owner = false;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// PushInput
+//
+// Purpose: Client side, queue an input record for the controller
+//
+// Arguments: inputs : NumInputs() values, in VAR_INPUT declaration
+//                     order of the controller model
+//
+// Return: 0 = queued, 1 = ring full
+//--------------------------------------------------------------
+int FuzzyRingClass::PushInput( const double* inputs ) {
+
+  uint64_t head = lpHeader->inHead;
+  if ( head - lpHeader->inTail > mask ) {
+    return 1;
+  }
+  memcpy( inputRecords + ( head & mask ) * inputRecordSize,
+	  inputs, inputRecordSize );
+  __sync_synchronize();
+  lpHeader->inHead = head + 1;
+
+  // A parked controller sets parked, then rechecks inHead
+  __sync_synchronize();
+  if ( lpHeader->parked ) {
+    Wake();
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// PopOutput
+//
+// Purpose: Client side, take the next output record
+//
+// Arguments: outputs        : NumOutputs() values, in VAR_OUTPUT
+//                             declaration order
+//            evaluateStatus : status of the evaluation
+//
+// Return: 0 = taken, 1 = ring empty
+//--------------------------------------------------------------
+int FuzzyRingClass::PopOutput( double* outputs, int* evaluateStatus ) {
+
+  uint64_t tail = lpHeader->outTail;
+  if ( tail == lpHeader->outHead ) {
+    return 1;
+  }
+  __sync_synchronize();
+  FuzzyRingOutput* lpOutput =
+    (FuzzyRingOutput*) ( outputRecords + ( tail & mask ) * outputRecordSize );
+  if ( evaluateStatus ) {
+    *evaluateStatus = lpOutput->status;
+  }
+  memcpy( outputs, lpOutput + 1, outputRecordSize - sizeof( FuzzyRingOutput ) );
+  __sync_synchronize();
+  lpHeader->outTail = tail + 1;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Wake
+//
+// Purpose: Signal a parked controller
+//--------------------------------------------------------------
+void FuzzyRingClass::Wake() {
+
+  pthread_mutex_lock( &lpHeader->parkMutex );
+  pthread_cond_signal( &lpHeader->parkCond );
+  pthread_mutex_unlock( &lpHeader->parkMutex );
+}
+
+//--------------------------------------------------------------
+// Park
+//
+// Purpose: Controller side, wait until the client pushes an input
+//          record, or FCL_RING_PARK_MS passes
+//--------------------------------------------------------------
+void FuzzyRingClass::Park() {
+
+  struct timespec wakeTime;
+  clock_gettime( CLOCK_MONOTONIC, &wakeTime );
+  wakeTime.tv_nsec += FCL_RING_PARK_MS * 1000000L;
+  if ( wakeTime.tv_nsec >= 1000000000L ) {
+    wakeTime.tv_sec  += 1;
+    wakeTime.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock( &lpHeader->parkMutex );
+  lpHeader->parked = 1;
+  __sync_synchronize();
+  if ( running and lpHeader->inHead == lpHeader->inTail ) {
+    pthread_cond_timedwait( &lpHeader->parkCond, &lpHeader->parkMutex,
+			    &wakeTime );
+  }
+  lpHeader->parked = 0;
+  pthread_mutex_unlock( &lpHeader->parkMutex );
+}
+
+//--------------------------------------------------------------
+// ControllerLoop
+//
+// Purpose: Evaluate input records until Stop(). Polls the input
+//          ring, parks after FCL_RING_SPIN empty polls, or at once
+//          on a single processor. Waits for the client to drain a
+//          full output ring.
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyRingClass::ControllerLoop() {
+
+  int nOutputs = lpHeader->nOutputs;
+  int spins    = 0;
+
+  // Spinning only helps if the client runs on another processor
+  int maxSpins = sysconf( _SC_NPROCESSORS_ONLN ) > 1 ? FCL_RING_SPIN : 0;
+
+  while ( running ) {
+
+    uint64_t tail = lpHeader->inTail;
+    if ( tail == lpHeader->inHead ) {
+      if ( ++spins < maxSpins ) {
+	CPURelax();
+      }
+      else {
+	Park();
+	spins = 0;
+      }
+      continue;
+    }
+    spins = 0;
+    __sync_synchronize();
+
+    uint64_t head = lpHeader->outHead;
+    while ( head - lpHeader->outTail > mask ) {
+      if ( not running ) {
+	return;
+      }
+      sched_yield();
+    }
+
+    const double* inputs =
+      (const double*) ( inputRecords + ( tail & mask ) * inputRecordSize );
+    FuzzyRingOutput* lpOutput =
+      (FuzzyRingOutput*) ( outputRecords + ( head & mask ) * outputRecordSize );
+
+    int evaluateStatus = lpFC->SetInputs( inputs );
+    if ( evaluateStatus == 0 ) {
+      evaluateStatus = lpFC->Evaluate();
+    }
+    if ( evaluateStatus == 0 ) {
+      lpFC->GetOutputs( (double*) ( lpOutput + 1 ) );
+    }
+    else {
+      memset( lpOutput + 1, 0, nOutputs * sizeof( double ) );
+    }
+    lpOutput->status = evaluateStatus;
+
+    __sync_synchronize();
+    lpHeader->inTail  = tail + 1;
+    lpHeader->outHead = head + 1;
+  }
+}
+
+//--------------------------------------------------------------
+// Serve
+//
+// Purpose: Controller side, run the controller loop in the
+//          calling thread until Stop() from another thread
+//
+// Arguments: lpFC : model, NumInputs() and NumOutputs() must match
+//                   the ring
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRingClass::Serve( FuzzyControlClass* lpModel ) {
+
+  status = 0;
+
+  if ( not lpHeader or not lpModel or
+       lpModel->NumInputs()  != (int) lpHeader->nInputs or
+       lpModel->NumOutputs() != (int) lpHeader->nOutputs ) {
+    status = -1;
+    ErrMsg( "Serve() Model does not match the ring", ringName, status );
+    return status;
+  }
+  lpFC    = lpModel;
+  running = true;
+  ControllerLoop();
+  return status;
+}
+
+//--------------------------------------------------------------
+// Start
+//
+// Purpose: Controller side, run the controller loop on a new
+//          thread
+//
+// Arguments: lpFC : model, as Serve()
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRingClass::Start( FuzzyControlClass* lpModel ) {
+
+  status = 0;
+
+  if ( not lpHeader or not lpModel or
+       lpModel->NumInputs()  != (int) lpHeader->nInputs or
+       lpModel->NumOutputs() != (int) lpHeader->nOutputs ) {
+    status = -1;
+    ErrMsg( "Start() Model does not match the ring", ringName, status );
+    return status;
+  }
+  if ( running ) {
+    return status;
+  }
+  lpFC    = lpModel;
+  running = true;
+  if ( pthread_create( &controller, 0, ControllerThread, this ) != 0 ) {
+    running = false;
+    status  = -1;
+    ErrMsg( "Start() Failed to create controller thread", ringName, status );
+    return status;
+  }
+  started = true;
+  return status;
+}
+
+//--------------------------------------------------------------
+// Stop
+//
+// Purpose: Stop the controller loop, wait for the thread
+//          started by Start()
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRingClass::Stop() {
+
+  running = false;
+  if ( lpHeader ) {
+    Wake();
+  }
+  if ( started ) {
+    pthread_join( controller, 0 );
+    started = false;
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+#ifndef Fuzzy_Ring_H
+#define Fuzzy_Ring_H
+
+#include "FuzzyControl.h"
+#include <pthread.h> // process shared mutex and condition
+
+// Shared memory ring format version, see FuzzyRing.cc
+#define FCL_RING_VERSION 1
+
+// Default number of records in each ring, a power of 2
+#define FCL_RING_CAPACITY 1024
+
+// Empty polls of the input ring before the controller parks
+#define FCL_RING_SPIN 20000
+
+// Controller park timeout, milliseconds, bounds the Stop() latency
+#define FCL_RING_PARK_MS 100
+
+//---------------------------------------------------------------------
+// struct FuzzyRingHeader
+//
+// Purpose: Start of the shared memory segment. The ring indices
+//          increase without wrapping, the record slot of index i is
+//          i & (capacity - 1). Each index is written by one side only
+//          and has its own cache line.
+//
+//          input ring  : client writes inHead,  controller writes inTail
+//          output ring : controller writes outHead, client writes outTail
+//---------------------------------------------------------------------
+struct FuzzyRingHeader {
+  char     magic[8];  // "FCLRING"
+  uint32_t version;   // FCL_RING_VERSION
+  uint32_t nInputs;   // doubles per input record
+  uint32_t nOutputs;  // doubles per output record, after the status
+  uint32_t capacity;  // records per ring, a power of 2
+
+  pthread_mutex_t parkMutex; // process shared, guards parked
+  pthread_cond_t  parkCond;  // signaled when a parked controller has work
+  volatile uint32_t parked;  // controller is waiting on parkCond
+
+  char pad0[64];
+  volatile uint64_t inHead;  char pad1[56];
+  volatile uint64_t inTail;  char pad2[56];
+  volatile uint64_t outHead; char pad3[56];
+  volatile uint64_t outTail; char pad4[56];
+};
+
+//---------------------------------------------------------------------
+// struct FuzzyRingOutput
+//
+// Purpose: Start of an output record, nOutputs doubles follow
+//---------------------------------------------------------------------
+struct FuzzyRingOutput {
+  int32_t  status; // status of the evaluation, 0 = OK
+  uint32_t pad;
+};
+
+//---------------------------------------------------------------------
+// class FuzzyRingClass
+//
+// Purpose: Shared memory transport for control loops on the same
+//          host. A single producer/single consumer ring of input
+//          records feeds a controller thread, which evaluates each
+//          record with SetInputs(), Evaluate() and GetOutputs() and
+//          writes a record to the output ring. The controller polls
+//          the input ring FCL_RING_SPIN times before it parks on a
+//          process shared condition, a client wakes it only when it
+//          is parked, so a busy loop costs no system calls.
+//
+//          The controller process Create()s the ring and runs
+//          Serve() or Start(). A client process Open()s it and uses
+//          PushInput() and PopOutput(). One client per ring.
+//---------------------------------------------------------------------
+class FuzzyRingClass {
+
+ protected:
+  int status; // Error code variable
+
+  string ringName;  // shm_open() name
+  bool   owner;     // created the segment, unlinks it on Close()
+  size_t mapSize;   // bytes mapped
+
+  FuzzyRingHeader* lpHeader;
+  char*            inputRecords;
+  char*            outputRecords;
+  size_t           inputRecordSize;
+  size_t           outputRecordSize;
+  uint64_t         mask; // capacity - 1
+
+  // Controller thread
+  FuzzyControlClass* lpFC;
+  pthread_t          controller;
+  bool               started; // controller runs on its own thread
+  volatile bool      running;
+
+  int  Map( int fd, size_t size );
+  void Park();
+  void Wake();
+
+ public:
+  // Encapsulation methods for protected variables
+  string RingName() const { return ringName; }
+  int    NumInputs()  const { return lpHeader ? lpHeader->nInputs  : 0; }
+  int    NumOutputs() const { return lpHeader ? lpHeader->nOutputs : 0; }
+
+  // FuzzyRing Methods
+  FuzzyRingClass();
+  ~FuzzyRingClass();
+
+  int Create( string name, int nInputs, int nOutputs, int capacity );
+  int Open  ( string name );
+  int Close ();
+
+  // client side
+  int PushInput( const double* inputs );
+  int PopOutput( double* outputs, int* evaluateStatus );
+
+  // controller side
+  int  Serve( FuzzyControlClass* lpFC );
+  int  Start( FuzzyControlClass* lpFC );
+  int  Stop ();
+  void ControllerLoop();
+};
+
+#endif
@@ -0,0 +1,676 @@
+#include "FuzzyRuleGen.h"
+#include <sstream> // partition file words
+#include <cstring> // strchr
+
+//--------------------------------------------------------------
+// RangeChunks, RuleChunks
+//
+// Purpose: FCL_ParallelFor() workers for Generate(), the items are
+//          the chunks of FCL_RULEGEN_CHUNK data rows
+//
+// Arguments: arg         : pointer to the FuzzyRuleGenClass
+//            threadIndex : not used, the chunks have their own work
+//                          space
+//            begin, end  : range of chunks
+//
+// Return:
+//--------------------------------------------------------------
+static void RangeChunks( void* arg, int threadIndex, int begin, int end ) {
+
+  FuzzyRuleGenClass* lpRG = (FuzzyRuleGenClass*) arg;
+
+  for ( int chunk = begin; chunk < end; chunk++ ) {
+    lpRG->RangeChunk( chunk );
+  }
+}
+
+static void RuleChunks( void* arg, int threadIndex, int begin, int end ) {
+
+  FuzzyRuleGenClass* lpRG = (FuzzyRuleGenClass*) arg;
+
+  for ( int chunk = begin; chunk < end; chunk++ ) {
+    lpRG->RuleChunk( chunk );
+  }
+}
+
+//--------------------------------------------------------------
+// TermNames
+//
+// Purpose: Names of the terms of a partition, low to high
+//
+// Arguments: nTerms : number of terms
+//            names  : set to the names
+//
+// Return:
+//--------------------------------------------------------------
+static void TermNames( int nTerms, vector< string >* names ) {
+
+  static const char* three[] = { "low", "medium", "high" };
+  static const char* five[]  = { "very_low", "low", "medium", "high",
+				 "very_high" };
+  static const char* seven[] = { "very_low", "low", "medium_low",
+				 "medium", "medium_high", "high",
+				 "very_high" };
+  names->clear();
+  for ( int k = 0; k < nTerms; k++ ) {
+    if      ( nTerms == 3 ) names->push_back( three[k] );
+    else if ( nTerms == 5 ) names->push_back( five[k] );
+    else if ( nTerms == 7 ) names->push_back( seven[k] );
+    else {
+      ostringstream name;
+      name << "term" << k + 1;
+      names->push_back( name.str() );
+    }
+  }
+}
+
+//--------------------------------------------------------------
+// FuzzyRuleGenClass
+//
+// Purpose: Constructor for FuzzyRuleGenClass
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyRuleGenClass::FuzzyRuleGenClass() {
+
+  status = 0;
+  nRows  = 0;
+}
+
+//--------------------------------------------------------------
+// ReadPartitionFile
+//
+// Purpose: Read the variables and their terms, see FuzzyPartition
+//          for the format. Statements end with ';', text after //
+//          is a comment.
+//
+// Arguments: fileName : partition file
+//
+// Return: Number of variables, or error code
+//--------------------------------------------------------------
+int FuzzyRuleGenClass::ReadPartitionFile( string* fileName ) {
+
+  ifstream PartitionStream;
+  string   inputLine;
+  string   statement;
+  vector< string > statements;
+
+  PartitionStream.open( fileName->c_str(), ios::in );
+  if ( not PartitionStream ) {
+    ErrMsg( "Failed to open partition file:", *fileName, -1 );
+    return -1;
+  }
+  while ( getline( PartitionStream, inputLine ) ) {
+    string::size_type comment = inputLine.find( "//" );
+    if ( comment != string::npos ) {
+      inputLine.erase( comment );
+    }
+    statement += " " + inputLine;
+    string::size_type semicolon;
+    while ( ( semicolon = statement.find( ';' ) ) != string::npos ) {
+      statements.push_back( statement.substr( 0, semicolon ) );
+      statement.erase( 0, semicolon + 1 );
+    }
+  }
+  PartitionStream.close();
+  if ( statement.find_first_not_of( " \t\r" ) != string::npos ) {
+    ErrMsg( "Partition file statement has no ';'", statement, -1 );
+    return -1;
+  }
+
+  Partitions.clear();
+  inputPartition.clear();
+  outputPartition.clear();
+
+  for ( int s = 0; s < (int) statements.size(); s++ ) {
+    FuzzyPartition partition;
+    string kind, extra;
+
+    string::size_type assign = statements[s].find( ":=" );
+    if ( assign == string::npos ) {
+      ErrMsg( "Partition statement has no ':='", statements[s], -1 );
+      return -1;
+    }
+    istringstream left( statements[s].substr( 0, assign ) );
+    istringstream right( statements[s].substr( assign + 2 ) );
+    left >> kind >> partition.varName;
+
+    if ( kind != "INPUT" and kind != "OUTPUT" ) {
+      ErrMsg( "Partition statement is not INPUT or OUTPUT", kind, -1 );
+      return -1;
+    }
+    partition.isOutput = ( kind == "OUTPUT" );
+    partition.nTerms   = 0;
+    partition.hasRange = false;
+    partition.lower    = 0.;
+    partition.upper    = 0.;
+    partition.column   = -1;
+
+    right >> partition.nTerms;
+    if ( right >> partition.lower ) {
+      if ( not ( right >> partition.upper ) or
+	   not ( partition.lower < partition.upper ) ) {
+	ErrMsg( "Partition statement has an invalid range for",
+		partition.varName, -1 );
+	return -1;
+      }
+      partition.hasRange = true;
+    }
+    right.clear();
+    if ( right >> extra or partition.nTerms < 2 ) {
+      ErrMsg( "Partition statement needs 2 or more terms for",
+	      partition.varName, -1 );
+      return -1;
+    }
+    for ( int p = 0; p < (int) Partitions.size(); p++ ) {
+      if ( Partitions[p].varName == partition.varName ) {
+	ErrMsg( "Partition file has a variable twice", partition.varName, -1 );
+	return -1;
+      }
+    }
+    TermNames( partition.nTerms, &partition.termNames );
+
+    if ( partition.isOutput ) {
+      outputPartition.push_back( Partitions.size() );
+    }
+    else {
+      inputPartition.push_back( Partitions.size() );
+    }
+    Partitions.push_back( partition );
+  }
+
+  if ( inputPartition.empty() or outputPartition.empty() ) {
+    ErrMsg( "Partition file needs an INPUT and an OUTPUT", *fileName, -1 );
+    return -1;
+  }
+
+  // The antecedents are numbered in 64 bits
+  double nAntecedents = 1.;
+  for ( int i = 0; i < (int) inputPartition.size(); i++ ) {
+    nAntecedents *= Partitions[ inputPartition[i] ].nTerms;
+  }
+  if ( nAntecedents > 4.E18 ) {
+    ErrMsg( "Partition file has too many input term combinations",
+	    *fileName, -1 );
+    return -1;
+  }
+  return Partitions.size();
+}
+
+//--------------------------------------------------------------
+// ReadDataFile
+//
+// Purpose: Read the data columns of the partition variables, in
+//          the layout of FuzzyControlClass::ReadInputDataFile():
+//          the column names on the first line, a row of values on
+//          each line after. Other columns are skipped. A .gz file
+//          is decompressed on its own thread as it is read.
+//
+// Arguments: fileName   : data file
+//            delimeters : column delimeters
+//
+// Return: Number of rows read, or error code
+//--------------------------------------------------------------
+int FuzzyRuleGenClass::ReadDataFile( string* fileName,
+				     string* delimeters ) {
+
+  FuzzyGzipBufferClass DataBuffer; // DataStream of a .gz file
+  ifstream DataStream;
+  string   inputLine;
+  int      nPartitions = Partitions.size();
+  int      lineNumber  = 1;
+
+  // Partition of each data file column, or -1
+  vector< int > columnPartition;
+
+  if ( FCL_OpenInputStream( &DataStream, *fileName, &DataBuffer ) ) {
+    ErrMsg( "Failed to open rule data file:", *fileName, -1 );
+    return -1;
+  }
+
+  // Column names on the first line
+  getline( DataStream, inputLine );
+  string::size_type begin = 0;
+  while ( begin <= inputLine.length() ) {
+    string::size_type end = inputLine.find_first_of( *delimeters, begin );
+    if ( end == string::npos ) end = inputLine.length();
+    string word = inputLine.substr( begin, end - begin );
+    string::size_type first = word.find_first_not_of( " \t\r" );
+    word = first == string::npos ? string() :
+           word.substr( first, word.find_last_not_of( " \t\r" ) - first + 1 );
+
+    columnPartition.push_back( -1 );
+    for ( int p = 0; p < nPartitions; p++ ) {
+      if ( Partitions[p].varName == word ) {
+	Partitions[p].column = columnPartition.size() - 1;
+	columnPartition.back() = p;
+      }
+    }
+    begin = end + 1;
+  }
+  for ( int p = 0; p < nPartitions; p++ ) {
+    if ( Partitions[p].column < 0 ) {
+      ErrMsg( "Rule data file has no column for", Partitions[p].varName, -1 );
+      return -1;
+    }
+  }
+
+  // Values, only the partition columns are converted
+  Data.clear();
+  nRows = 0;
+  vector< double > row( nPartitions );
+
+  while ( getline( DataStream, inputLine ) ) {
+    lineNumber++;
+    if ( inputLine.find_first_not_of( " \t\r" ) == string::npos ) {
+      continue;
+    }
+    const char* lpText = inputLine.c_str();
+    int column = 0;
+    int found  = 0;
+    while ( true ) {
+      int p = column < (int) columnPartition.size() ?
+	      columnPartition[ column ] : -1;
+      if ( p >= 0 ) {
+	char* lpEnd = 0;
+	row[p] = strtod( lpText, &lpEnd );
+	while ( *lpEnd == ' ' or *lpEnd == '\t' or *lpEnd == '\r' ) lpEnd++;
+	if ( lpEnd == lpText or
+	     ( *lpEnd and not strchr( delimeters->c_str(), *lpEnd ) ) ) {
+	  ErrMsg( "Rule data file has an invalid value for " +
+		  Partitions[p].varName + " on line", lineNumber, -1 );
+	  return -1;
+	}
+	lpText = lpEnd;
+	found++;
+      }
+      while ( *lpText and not strchr( delimeters->c_str(), *lpText ) ) {
+	lpText++;
+      }
+      if ( not *lpText ) break;
+      lpText++;
+      column++;
+    }
+    if ( found != nPartitions ) {
+      ErrMsg( "Rule data file has a short line", lineNumber, -1 );
+      return -1;
+    }
+    Data.insert( Data.end(), row.begin(), row.end() );
+    nRows++;
+  }
+  if ( FCL_CloseStream( &DataStream, &DataBuffer ) != 0 ) {
+    ErrMsg( "Failed to read rule data file:", *fileName, -1 );
+    return -1;
+  }
+
+  if ( nRows < 1 ) {
+    ErrMsg( "Rule data file has no data", *fileName, -1 );
+    return -1;
+  }
+  return nRows;
+}
+
+//--------------------------------------------------------------
+// Term
+//
+// Purpose: The term of highest membership of a value, values
+//          outside the range are in the end terms
+//
+// Arguments: partition  : the variable
+//            value      : data value
+//            membership : set to the membership of the term
+//
+// Return: term index
+//--------------------------------------------------------------
+int FuzzyRuleGenClass::Term( const FuzzyPartition& partition, double value,
+			     double* membership ) const {
+
+  double step     = ( partition.upper - partition.lower ) /
+                    ( partition.nTerms - 1 );
+  double position = ( value - partition.lower ) / step;
+
+  if ( position <= 0. ) {
+    *membership = 1.;
+    return 0;
+  }
+  if ( position >= partition.nTerms - 1 ) {
+    *membership = 1.;
+    return partition.nTerms - 1;
+  }
+  int term = (int) floor( position + 0.5 );
+  *membership = 1. - fabs( position - term );
+  return term;
+}
+
+//--------------------------------------------------------------
+// RangeChunk
+//
+// Purpose: The smallest and largest value of each partition in a
+//          chunk of the data
+//
+// Arguments: chunk : chunk of FCL_RULEGEN_CHUNK rows
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyRuleGenClass::RangeChunk( int chunk ) {
+
+  int nPartitions = Partitions.size();
+  int begin = chunk * FCL_RULEGEN_CHUNK;
+  int end   = min( nRows, begin + FCL_RULEGEN_CHUNK );
+
+  vector< double >& lower = chunkLower[ chunk ];
+  vector< double >& upper = chunkUpper[ chunk ];
+  lower.assign( nPartitions,  HUGE_VAL );
+  upper.assign( nPartitions, -HUGE_VAL );
+
+  for ( int r = begin; r < end; r++ ) {
+    const double* lpRow = &Data[ r * nPartitions ];
+    for ( int p = 0; p < nPartitions; p++ ) {
+      lower[p] = min( lower[p], lpRow[p] );
+      upper[p] = max( upper[p], lpRow[p] );
+    }
+  }
+}
+
+//--------------------------------------------------------------
+// RuleChunk
+//
+// Purpose: The rules of a chunk of the data, the one of highest
+//          degree of each antecedent and output
+//
+// Arguments: chunk : chunk of FCL_RULEGEN_CHUNK rows
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyRuleGenClass::RuleChunk( int chunk ) {
+
+  int nPartitions = Partitions.size();
+  int nInputs     = inputPartition.size();
+  int nOutputs    = outputPartition.size();
+  int begin = chunk * FCL_RULEGEN_CHUNK;
+  int end   = min( nRows, begin + FCL_RULEGEN_CHUNK );
+
+  map< uint64_t, FuzzyRuleCandidate >& rules = chunkRules[ chunk ];
+  map< uint64_t, FuzzyRuleCandidate >::iterator rci;
+  vector< int > antecedent( nInputs );
+  rules.clear();
+
+  for ( int r = begin; r < end; r++ ) {
+    const double* lpRow = &Data[ r * nPartitions ];
+    uint64_t key      = 0;
+    double   strength = 1.;
+    double   membership;
+
+    for ( int i = 0; i < nInputs; i++ ) {
+      const FuzzyPartition& partition = Partitions[ inputPartition[i] ];
+      antecedent[i] = Term( partition, lpRow[ inputPartition[i] ],
+			    &membership );
+      key       = key * partition.nTerms + antecedent[i];
+      strength *= membership;
+    }
+
+    rci = rules.find( key );
+    if ( rci == rules.end() ) {
+      FuzzyRuleCandidate candidate;
+      candidate.antecedent = antecedent;
+      candidate.consequent.assign( nOutputs, 0 );
+      candidate.degree.assign( nOutputs, -1. );
+      candidate.row.assign( nOutputs, 0 );
+      candidate.support = 0;
+      rci = rules.insert( make_pair( key, candidate ) ).first;
+    }
+    FuzzyRuleCandidate& candidate = rci->second;
+    candidate.support++;
+
+    for ( int k = 0; k < nOutputs; k++ ) {
+      const FuzzyPartition& partition = Partitions[ outputPartition[k] ];
+      int term = Term( partition, lpRow[ outputPartition[k] ], &membership );
+      double degree = strength * membership;
+      // rows are in order, so a tie keeps the earlier row
+      if ( degree > candidate.degree[k] ) {
+	candidate.consequent[k] = term;
+	candidate.degree[k]     = degree;
+	candidate.row[k]        = r;
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------
+// Merge
+//
+// Purpose: Merge the rules of a later chunk into the rules
+//
+// Arguments: rules : rules of the earlier chunks
+//            chunk : rules of the chunk
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRuleGenClass::Merge( map< uint64_t, FuzzyRuleCandidate >* rules,
+			      const map< uint64_t, FuzzyRuleCandidate >& chunk ) {
+
+  map< uint64_t, FuzzyRuleCandidate >::const_iterator cci;
+  map< uint64_t, FuzzyRuleCandidate >::iterator       rci;
+
+  for ( cci = chunk.begin(); cci != chunk.end(); ++cci ) {
+    rci = rules->find( cci->first );
+    if ( rci == rules->end() ) {
+      rules->insert( *cci );
+      continue;
+    }
+    FuzzyRuleCandidate&       rule      = rci->second;
+    const FuzzyRuleCandidate& candidate = cci->second;
+    rule.support += candidate.support;
+    for ( int k = 0; k < (int) rule.degree.size(); k++ ) {
+      if ( candidate.degree[k] > rule.degree[k] ) {
+	rule.consequent[k] = candidate.consequent[k];
+	rule.degree[k]     = candidate.degree[k];
+	rule.row[k]        = candidate.row[k];
+      }
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Generate
+//
+// Purpose: Take the ranges not in the partition file from the data,
+//          then generate the rules
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRuleGenClass::Generate() {
+
+  if ( Partitions.empty() or nRows < 1 ) {
+    status = -1;
+    ErrMsg( "Generate() No partitions or data", "", status );
+    return status;
+  }
+
+  int nPartitions = Partitions.size();
+  int nChunks = ( nRows + FCL_RULEGEN_CHUNK - 1 ) / FCL_RULEGEN_CHUNK;
+
+  // Data ranges
+  bool needRange = false;
+  for ( int p = 0; p < nPartitions; p++ ) {
+    if ( not Partitions[p].hasRange ) needRange = true;
+  }
+  if ( needRange ) {
+    chunkLower.assign( nChunks, vector< double >() );
+    chunkUpper.assign( nChunks, vector< double >() );
+    status = FCL_ParallelFor( nChunks, 1, RangeChunks, this, 0 );
+    if ( status != 0 ) {
+      ErrMsg( "Generate() Failed to find the data ranges", "", status );
+      return status;
+    }
+    for ( int p = 0; p < nPartitions; p++ ) {
+      FuzzyPartition& partition = Partitions[p];
+      if ( partition.hasRange ) continue;
+      partition.lower =  HUGE_VAL;
+      partition.upper = -HUGE_VAL;
+      for ( int c = 0; c < nChunks; c++ ) {
+	partition.lower = min( partition.lower, chunkLower[c][p] );
+	partition.upper = max( partition.upper, chunkUpper[c][p] );
+      }
+      if ( not ( partition.lower < partition.upper ) ) {
+	status = -1;
+	ErrMsg( "Generate() Data has a single value for",
+		partition.varName, status );
+	return status;
+      }
+      partition.hasRange = true;
+    }
+    chunkLower.clear();
+    chunkUpper.clear();
+  }
+
+  // Rules of each chunk, merged in chunk order
+  chunkRules.assign( nChunks, map< uint64_t, FuzzyRuleCandidate >() );
+  status = FCL_ParallelFor( nChunks, 1, RuleChunks, this, 0 );
+  if ( status != 0 ) {
+    ErrMsg( "Generate() Failed to generate rules", "", status );
+    return status;
+  }
+  Rules.clear();
+  for ( int c = 0; c < nChunks; c++ ) {
+    Merge( &Rules, chunkRules[c] );
+    chunkRules[c].clear();
+  }
+  chunkRules.clear();
+
+  return 0;
+}
+
+//--------------------------------------------------------------
+// WriteFCLFile
+//
+// Purpose: Write the variables, terms and rules as a FUNCTION_BLOCK.
+//          The rules are in antecedent order, each after a comment
+//          of its degrees and the number of data rows behind it.
+//          An output that no rule sets is at the middle of its
+//          range.
+//
+// Arguments: fileName  : FCL file
+//            blockName : FUNCTION_BLOCK name
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyRuleGenClass::WriteFCLFile( string* fileName,
+				     const string& blockName ) {
+
+  ofstream FCLStream;
+  map< uint64_t, FuzzyRuleCandidate >::const_iterator rci;
+
+  if ( Rules.empty() ) {
+    ErrMsg( "WriteFCLFile() No rules for", *fileName, -1 );
+    return -1;
+  }
+
+  FCLStream.open( fileName->c_str(), ios::out );
+  if ( not FCLStream ) {
+    ErrMsg( "Failed to open FCL file:", *fileName, -1 );
+    return -1;
+  }
+  FCLStream.precision( 10 );
+
+  FCLStream << "// Rule base generated from " << nRows
+	    << " data rows by the Wang-Mendel method" << endl;
+  FCLStream << "FUNCTION_BLOCK " << blockName << endl;
+
+  for ( int io = 0; io < 2; io++ ) {
+    const vector< int >& partitions = io ? outputPartition : inputPartition;
+    FCLStream << ( io ? "VAR_OUTPUT" : "VAR_INPUT" ) << endl;
+    for ( int i = 0; i < (int) partitions.size(); i++ ) {
+      FCLStream << "\t" << Partitions[ partitions[i] ].varName
+		<< " : REAL;" << endl;
+    }
+    FCLStream << "END_VAR" << endl;
+  }
+
+  // Triangles, with ramps at the ends
+  for ( int i = 0; i < (int) inputPartition.size(); i++ ) {
+    const FuzzyPartition& partition = Partitions[ inputPartition[i] ];
+    double step = ( partition.upper - partition.lower ) /
+                  ( partition.nTerms - 1 );
+    FCLStream << "FUZZIFY " << partition.varName << endl;
+    for ( int k = 0; k < partition.nTerms; k++ ) {
+      double peak = partition.lower + k * step;
+      FCLStream << "\tTERM " << partition.termNames[k] << " := ";
+      if ( k == 0 ) {
+	FCLStream << "(" << peak << ", 1) (" << peak + step << ", 0);";
+      }
+      else if ( k == partition.nTerms - 1 ) {
+	FCLStream << "(" << peak - step << ", 0) (" << peak << ", 1);";
+      }
+      else {
+	FCLStream << "(" << peak - step << ", 0) (" << peak << ", 1) ("
+		  << peak + step << ", 0);";
+      }
+      FCLStream << endl;
+    }
+    FCLStream << "END_FUZZIFY" << endl;
+  }
+
+  // Singletons at the peaks
+  for ( int k = 0; k < (int) outputPartition.size(); k++ ) {
+    const FuzzyPartition& partition = Partitions[ outputPartition[k] ];
+    double step = ( partition.upper - partition.lower ) /
+                  ( partition.nTerms - 1 );
+    FCLStream << "DEFUZZIFY " << partition.varName << endl;
+    for ( int t = 0; t < partition.nTerms; t++ ) {
+      FCLStream << "\tTERM " << partition.termNames[t] << " := "
+		<< partition.lower + t * step << ";" << endl;
+    }
+    FCLStream << "\tACCU : MAX;" << endl;
+    FCLStream << "\tMETHOD : COGS;" << endl;
+    FCLStream << "\tDEFAULT := "
+	      << 0.5 * ( partition.lower + partition.upper ) << ";" << endl;
+    FCLStream << "\tRANGE := (" << partition.lower << ", "
+	      << partition.upper << ");" << endl;
+    FCLStream << "END_DEFUZZIFY" << endl;
+  }
+
+  FCLStream << "RULEBLOCK No1" << endl;
+  FCLStream << "\tAND : MIN;" << endl;
+  FCLStream << "\tACT : MIN;" << endl;
+
+  int ruleNumber = 1;
+  for ( rci = Rules.begin(); rci != Rules.end(); ++rci, ++ruleNumber ) {
+    const FuzzyRuleCandidate& rule = rci->second;
+
+    FCLStream << "\t// degree";
+    for ( int k = 0; k < (int) outputPartition.size(); k++ ) {
+      FCLStream << " " << rule.degree[k];
+    }
+    FCLStream << ", " << rule.support << " rows" << endl;
+
+    FCLStream << "\tRULE " << ruleNumber << ": IF ";
+    for ( int i = 0; i < (int) inputPartition.size(); i++ ) {
+      const FuzzyPartition& partition = Partitions[ inputPartition[i] ];
+      FCLStream << ( i ? " AND " : "" ) << partition.varName << " IS "
+		<< partition.termNames[ rule.antecedent[i] ];
+    }
+    FCLStream << " THEN ";
+    for ( int k = 0; k < (int) outputPartition.size(); k++ ) {
+      const FuzzyPartition& partition = Partitions[ outputPartition[k] ];
+      FCLStream << ( k ? ", " : "" ) << partition.varName << " IS "
+		<< partition.termNames[ rule.consequent[k] ];
+    }
+    FCLStream << ";" << endl;
+  }
+
+  FCLStream << "END_RULEBLOCK" << endl;
+  FCLStream << "END_FUNCTION_BLOCK" << endl;
+
+  FCLStream.close();
+  if ( FCLStream.fail() ) {
+    ErrMsg( "Failed to write FCL file:", *fileName, -1 );
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+#ifndef Fuzzy_RuleGen_H
+#define Fuzzy_RuleGen_H
+
+#include "FuzzyControl.h"
+
+// Data rows per thread pool work item
+#define FCL_RULEGEN_CHUNK 65536
+
+//---------------------------------------------------------------------
+// struct FuzzyPartition
+//
+// Purpose: A line of the partition file, a data column and the
+//          terms of its variable. The terms are evenly spaced over
+//          [lower, upper]: triangles, with ramps at the ends. Output
+//          terms are singletons at the triangle peaks. Without a
+//          range the data range is used.
+//
+//          INPUT  var := nTerms [lower upper] ;
+//          OUTPUT var := nTerms [lower upper] ;
+//---------------------------------------------------------------------
+struct FuzzyPartition {
+  string varName;
+  bool   isOutput;
+  int    nTerms;
+  bool   hasRange;
+  double lower;
+  double upper;
+  int    column; // data file column
+
+  vector< string > termNames;
+};
+
+//---------------------------------------------------------------------
+// struct FuzzyRuleCandidate
+//
+// Purpose: The rule of an antecedent, the input terms. For each
+//          output the term and degree of the data row with the
+//          highest degree, the earliest row wins a tie.
+//---------------------------------------------------------------------
+struct FuzzyRuleCandidate {
+  vector< int >    antecedent; // term of each input
+  vector< int >    consequent; // term of each output
+  vector< double > degree;
+  vector< int >    row;
+  int              support;    // number of data rows
+};
+
+//---------------------------------------------------------------------
+// class FuzzyRuleGenClass
+//
+// Purpose: Generate a rule base from input and output data by the
+//          method of Wang and Mendel. Each data row gives a rule of
+//          the terms of highest membership of its values, with the
+//          product of the memberships as its degree. Of the rules
+//          with the same antecedent the one of highest degree is
+//          kept, for each output. The data is read once, the passes
+//          over it run in chunks on the FCL_ParallelFor() thread
+//          pool and are merged in chunk order, so the rule base
+//          does not depend on the number of threads.
+//---------------------------------------------------------------------
+class FuzzyRuleGenClass {
+
+ protected:
+  int status; // Error code variable
+
+  vector< FuzzyPartition > Partitions;
+  vector< int >            inputPartition;  // Partitions index
+  vector< int >            outputPartition;
+
+  // Data, nRows rows of a value per partition
+  int              nRows;
+  vector< double > Data;
+
+  // Work space of each chunk
+  vector< vector< double > > chunkLower;
+  vector< vector< double > > chunkUpper;
+  vector< map< uint64_t, FuzzyRuleCandidate > > chunkRules;
+
+  // Generated rules, by antecedent
+  map< uint64_t, FuzzyRuleCandidate > Rules;
+
+  int Term( const FuzzyPartition& partition, double value,
+	    double* membership ) const;
+  int Merge( map< uint64_t, FuzzyRuleCandidate >* rules,
+	     const map< uint64_t, FuzzyRuleCandidate >& chunk );
+
+ public:
+  // Encapsulation methods for protected variables
+  int NumRows()  const { return nRows; }
+  int NumRules() const { return Rules.size(); }
+
+  // FuzzyRuleGen Methods
+  FuzzyRuleGenClass();
+
+  int ReadPartitionFile( string* fileName );
+  int ReadDataFile     ( string* fileName, string* delimeters );
+  int Generate         ();
+  int WriteFCLFile     ( string* fileName, const string& blockName );
+  void RangeChunk      ( int chunk );
+  void RuleChunk       ( int chunk );
+};
+
+#endif
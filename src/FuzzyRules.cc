@@ -57,11 +57,8 @@ int FuzzyRuleClass::Activate() {
 	     lpFOT->termName, status);
     DebugMsg("\tAggregation value", conditionResult, status);
 
-    // Clear out any pre-existing xy components in this term
-    for ( xyi = lpFAT->xy.begin(); xyi != lpFAT->xy.end(); ++xyi ) {
-      delete *xyi;
-    }
-    lpFAT->xy.clear();
+    // Release any pre-existing xy components in this term for reuse
+    ReleaseTermXY( lpFAT );
 
     switch ( lpFOT->termType ) {
 
@@ -75,7 +72,7 @@ int FuzzyRuleClass::Activate() {
 	    // trapezoids have 4 points, vector stack is filo
 	    lpXY = lpFOT->xy[i]; 
 	    // create a new XY struct to hold the Activation term points
-	    lpActXY = new XY;
+	    lpActXY = NewTermXY( lpFAT );
 	    if ( not lpActXY ) {
 	      status = -1;
 	      ErrMsg("Activate() Trapezoid Failed to create new XY", 
@@ -109,10 +106,10 @@ int FuzzyRuleClass::Activate() {
 	  }
 
 	  // allocate containers for new Act trapezoid
-	  lpActXY_0 = new XY; 
-	  lpActXY_1 = new XY; 
-	  lpActXY_2 = new XY; 
-	  lpActXY_3 = new XY;
+	  lpActXY_0 = NewTermXY( lpFAT ); 
+	  lpActXY_1 = NewTermXY( lpFAT ); 
+	  lpActXY_2 = NewTermXY( lpFAT ); 
+	  lpActXY_3 = NewTermXY( lpFAT );
 	  if ( not lpActXY_0 or not lpActXY_1 or 
 	       not lpActXY_2 or not lpActXY_3 ) {
 	    status = -1;
@@ -189,7 +186,7 @@ int FuzzyRuleClass::Activate() {
 	    // vector stack is filo
 	    lpXY = lpFOT->xy[i];
 	    // create a new XY struct to hold the Activation term points
-	    lpActXY = new XY;
+	    lpActXY = NewTermXY( lpFAT );
 	    if ( not lpActXY ) {
 	      status = -1;
 	      ErrMsg("Activate() Triangle Failed to create new XY", 
@@ -231,10 +228,10 @@ int FuzzyRuleClass::Activate() {
 		   lpFOC->varName + " IS " + lpFAT->termName, status);
 
 	  // allocate containers for new Act trapezoid
-	  lpActXY_0 = new XY; 
-	  lpActXY_1 = new XY; 
-	  lpActXY_2 = new XY; 
-	  lpActXY_3 = new XY;
+	  lpActXY_0 = NewTermXY( lpFAT ); 
+	  lpActXY_1 = NewTermXY( lpFAT ); 
+	  lpActXY_2 = NewTermXY( lpFAT ); 
+	  lpActXY_3 = NewTermXY( lpFAT );
 	  if ( not lpActXY_0 or not lpActXY_1 or 
 	       not lpActXY_2 or not lpActXY_3 ) {
 	    status = -1;
@@ -346,7 +343,7 @@ int FuzzyRuleClass::Activate() {
 	    // ramps have 2 points, vector stack is filo
 	    lpXY = lpFOT->xy[i];
 	    // create a new XY struct to hold the Activation term points
-	    lpActXY = new XY;
+	    lpActXY = NewTermXY( lpFAT );
 	    if ( not lpActXY ) {
 	      status = -1;
 	      ErrMsg("Activate() Ramp Failed to create new XY", 
@@ -380,7 +377,7 @@ int FuzzyRuleClass::Activate() {
 	  else if ( rampUp ) {
 	    // Aggregation is between ramp low/high
 	    // Find new ordinate, abcissa values
-	    lpActXY_0 = new XY; lpActXY_1 = new XY;
+	    lpActXY_0 = NewTermXY( lpFAT ); lpActXY_1 = NewTermXY( lpFAT );
 	    if ( not lpActXY_0 or not lpActXY_1 ) {
 	      status = -1;
 	      ErrMsg("Activate() Ramp Failed to create new XY", 
@@ -420,7 +417,7 @@ int FuzzyRuleClass::Activate() {
 	  else if ( rampDown ) {
 	    // Aggregation is between ramp low/high
 	    // Find new ordinate, abcissa values
-	    lpActXY_0 = new XY; lpActXY_1 = new XY;
+	    lpActXY_0 = NewTermXY( lpFAT ); lpActXY_1 = NewTermXY( lpFAT );
 	    if ( not lpActXY_0 or not lpActXY_1 ) {
 	      status = -1;
 	      ErrMsg("Activate() Ramp Failed to create new XY", 
@@ -481,7 +478,7 @@ int FuzzyRuleClass::Activate() {
 	for ( xyi = lpFOT->xy.begin(); xyi != lpFOT->xy.end(); ++xyi ) {
 	  // create a new XY struct to hold the Activation term points
 	  lpXY = *xyi;
-	  lpActXY = new XY;
+	  lpActXY = NewTermXY( lpFAT );
 	  if ( not lpActXY ) {
 	    ErrMsg("Activate() Rectangle Failed to create new XY", 
 		   lpFOT->termName, status);
@@ -787,4 +784,5 @@ FuzzyRuleClass::FuzzyRuleClass(FCL_keyword* kwdMin,  FCL_keyword* kwdMax,
 
   nSubConclusions = 0;
   nSubConditions  = 0;
+  conditionResult = 0.;
 }
@@ -49,6 +49,24 @@ struct Conclusion {
 
 };
 
+//---------------------------------------------------------------------
+// struct RuleStatement
+//
+// Purpose: A RULE statement collected from a RULEBLOCK, with the
+//          AND/OR/ACT methods of that block, for ParseFCL_Rule()
+//---------------------------------------------------------------------
+struct RuleStatement {
+
+  string FCLFileLine;   // complete RULE, joined by GetLine()
+  string ruleBlockName; // RULEBLOCK the RULE was found in
+
+  FCL_keyword* andMethod; // AND method: MIN, PROD, BDIF, 0 if not set
+  FCL_keyword* orMethod;  // OR method:  MAX, ASUM, BSUM, 0 if not set
+  FCL_keyword* actMethod; // ACT method: PROD, MIN, 0 if not set
+
+  string errMsg; // ErrMsg() lines of ParseFCL_Rule(), for its caller
+};
+
 //---------------------------------------------------------------------
 // class FuzzyRule
 //---------------------------------------------------------------------
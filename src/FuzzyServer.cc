@@ -0,0 +1,612 @@
+#include "FuzzyServer.h"
+#include <sys/socket.h> // socket, bind, listen, accept, send, recv,
+                        // shutdown
+#include <sys/un.h>     // sockaddr_un
+#include <unistd.h>     // close, unlink
+#include <cstring>      // memset, strncpy
+#include <cerrno>       // errno, EINTR
+#include <sstream>      // ostringstream
+
+//--------------------------------------------------------------
+// ReadAll, WriteAll
+//
+// Purpose: Read or write exactly size bytes on a socket
+//
+// Arguments: fd, buffer, size
+//
+// Return: 0 = OK, -1 = error or connection closed
+//--------------------------------------------------------------
+static int ReadAll( int fd, void* buffer, size_t size ) {
+
+  char* lpBuffer = (char*) buffer;
+  while ( size > 0 ) {
+    ssize_t n = recv( fd, lpBuffer, size, 0 );
+    if ( n < 0 and errno == EINTR ) {
+      continue;
+    }
+    if ( n <= 0 ) {
+      return -1;
+    }
+    lpBuffer += n;
+    size     -= n;
+  }
+  return 0;
+}
+
+static int WriteAll( int fd, const void* buffer, size_t size ) {
+
+  const char* lpBuffer = (const char*) buffer;
+  while ( size > 0 ) {
+    ssize_t n = send( fd, lpBuffer, size, MSG_NOSIGNAL );
+    if ( n < 0 and errno == EINTR ) {
+      continue;
+    }
+    if ( n <= 0 ) {
+      return -1;
+    }
+    lpBuffer += n;
+    size     -= n;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// ConnectionThread, WriterThread, EngineThread
+//
+// Purpose: pthread entry points
+//
+// Arguments: ConnectionThreadArg*, FuzzyServeModel*
+//
+// Return:
+//--------------------------------------------------------------
+struct ConnectionThreadArg {
+  FuzzyServerClass*     lpServer;
+  FuzzyServeConnection* lpConn;
+};
+
+static void* ConnectionThread( void* arg ) {
+
+  ConnectionThreadArg* lpArg = (ConnectionThreadArg*) arg;
+  lpArg->lpServer->ConnectionLoop( lpArg->lpConn );
+  delete lpArg;
+  return 0;
+}
+
+static void* WriterThread( void* arg ) {
+
+  ConnectionThreadArg* lpArg = (ConnectionThreadArg*) arg;
+  lpArg->lpServer->WriterLoop( lpArg->lpConn );
+  delete lpArg;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// EndReading
+//
+// Purpose: Mark the reader of a connection done, the writer
+//          thread ends once the queued requests are answered
+//
+// Arguments: lpConn
+//
+// Return:
+//--------------------------------------------------------------
+static void EndReading( FuzzyServeConnection* lpConn ) {
+
+  pthread_mutex_lock( &lpConn->mutex );
+  lpConn->closing = true;
+  pthread_cond_broadcast( &lpConn->cond );
+  pthread_mutex_unlock( &lpConn->mutex );
+}
+
+static void* EngineThread( void* arg ) {
+
+  FuzzyServeModel* lpModel = (FuzzyServeModel*) arg;
+  lpModel->lpServer->EngineLoop( lpModel );
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FuzzyServerClass
+//
+// Purpose: Constructor for FuzzyServerClass
+//
+// Arguments: path         : Unix domain socket path
+//            pollInterval : FCL file change check, milliseconds
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyServerClass::FuzzyServerClass( string path, int interval ) {
+
+  status       = 0;
+  socketPath   = path;
+  listenFd     = -1;
+  pollInterval = interval;
+}
+
+//--------------------------------------------------------------
+// ~FuzzyServerClass
+//
+// Purpose: Close the listening socket. Serve() does not return
+//          while the engine threads run, so the models are only
+//          freed if they were never started.
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyServerClass::~FuzzyServerClass() {
+
+  if ( listenFd >= 0 ) {
+    close( listenFd );
+    unlink( socketPath.c_str() );
+  }
+}
+
+//--------------------------------------------------------------
+// AddModel
+//
+// Purpose: Load a FCL file to serve, the model index is the
+//          order of the AddModel() calls
+//
+// Arguments: FCLFileName
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyServerClass::AddModel( string FCLFileName ) {
+
+  status = 0;
+
+  FuzzyServeModel* lpModel = new FuzzyServeModel;
+  if ( not lpModel ) {
+    status = -1;
+    ErrMsg( "AddModel() Failed to create FuzzyServeModel",
+	    FCLFileName, status );
+    return status;
+  }
+  lpModel->lpServer = this;
+  lpModel->lpFR     = new FuzzyReloadClass( FCLFileName, "", "" );
+  lpModel->reader   = lpModel->lpFR->RegisterReader();
+  if ( lpModel->reader < 0 ) {
+    status = -1;
+    ErrMsg( "AddModel() Failed to load FCL file", FCLFileName, status );
+    delete lpModel->lpFR;
+    delete lpModel;
+    return status;
+  }
+  if ( pollInterval > 0 ) {
+    lpModel->lpFR->StartPolling( pollInterval );
+  }
+  pthread_mutex_init( &lpModel->queueMutex, 0 );
+  pthread_cond_init ( &lpModel->queueCond, 0 );
+
+  Models.push_back( lpModel );
+  return status;
+}
+
+//--------------------------------------------------------------
+// Serve
+//
+// Purpose: Start the engine threads, listen on the socket and
+//          start a reader and a writer thread for each connection.
+//          Runs until the process is stopped.
+//
+// Arguments:
+//
+// Return: status, only returns on error
+//--------------------------------------------------------------
+int FuzzyServerClass::Serve() {
+
+  status = 0;
+
+  if ( Models.empty() ) {
+    status = -1;
+    ErrMsg( "Serve() No FCL models to serve", socketPath, status );
+    return status;
+  }
+
+  struct sockaddr_un address;
+  memset( &address, 0, sizeof( address ) );
+  address.sun_family = AF_UNIX;
+  if ( socketPath.size() >= sizeof( address.sun_path ) ) {
+    status = -1;
+    ErrMsg( "Serve() Socket path is too long", socketPath, status );
+    return status;
+  }
+  strncpy( address.sun_path, socketPath.c_str(),
+	   sizeof( address.sun_path ) - 1 );
+
+  listenFd = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if ( listenFd < 0 ) {
+    status = -1;
+    ErrMsg( "Serve() Failed to create socket", socketPath, status );
+    return status;
+  }
+  unlink( socketPath.c_str() );
+  if ( bind( listenFd, (struct sockaddr*) &address, sizeof( address ) ) != 0
+       or listen( listenFd, 64 ) != 0 ) {
+    status = -1;
+    ErrMsg( "Serve() Failed to listen on socket", socketPath, status );
+    return status;
+  }
+
+  for ( vector< FuzzyServeModel* >::iterator mi = Models.begin();
+	mi != Models.end(); ++mi ) {
+    if ( pthread_create( &(*mi)->engine, 0, EngineThread, *mi ) != 0 ) {
+      status = -1;
+      ErrMsg( "Serve() Failed to create engine thread",
+	      (*mi)->lpFR->FCLFile(), status );
+      return status;
+    }
+  }
+
+  ConsoleMsg( "Serving FCL models on", socketPath, Models.size() );
+
+  while ( true ) {
+    int fd = accept( listenFd, 0, 0 );
+    if ( fd < 0 ) {
+      if ( errno == EINTR ) {
+	continue;
+      }
+      status = -1;
+      ErrMsg( "Serve() Failed to accept connection", socketPath, status );
+      return status;
+    }
+
+    FuzzyServeConnection* lpConn = new FuzzyServeConnection;
+    lpConn->fd       = fd;
+    lpConn->nOutput  = 0;
+    lpConn->pending  = 0;
+    lpConn->closing  = false;
+    lpConn->broken   = false;
+    lpConn->refCount = 2; // the connection and writer threads
+    pthread_mutex_init( &lpConn->mutex, 0 );
+    pthread_cond_init ( &lpConn->cond, 0 );
+
+    ConnectionThreadArg* lpWriterArg = new ConnectionThreadArg;
+    lpWriterArg->lpServer = this;
+    lpWriterArg->lpConn   = lpConn;
+
+    pthread_t thread;
+    if ( pthread_create( &thread, 0, WriterThread, lpWriterArg ) != 0 ) {
+      ErrMsg( "Serve() Failed to create writer thread", fd, 1 );
+      delete lpWriterArg;
+      Release( lpConn );
+      Release( lpConn );
+      continue;
+    }
+    pthread_detach( thread );
+
+    ConnectionThreadArg* lpArg = new ConnectionThreadArg;
+    lpArg->lpServer = this;
+    lpArg->lpConn   = lpConn;
+
+    if ( pthread_create( &thread, 0, ConnectionThread, lpArg ) != 0 ) {
+      ErrMsg( "Serve() Failed to create connection thread", fd, 1 );
+      delete lpArg;
+      EndReading( lpConn );
+      Release( lpConn );
+      continue;
+    }
+    pthread_detach( thread );
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// ConnectionLoop
+//
+// Purpose: Read requests from a connection and queue them on
+//          their model until the client closes the connection. While
+//          FCL_SERVE_MAX_PENDING requests wait for their response
+//          the connection is not read, the client blocks in send.
+//
+// Arguments: lpConn
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyServerClass::ConnectionLoop( FuzzyServeConnection* lpConn ) {
+
+  FuzzyServeRequestHeader header;
+
+  while ( true ) {
+
+    pthread_mutex_lock( &lpConn->mutex );
+    while ( lpConn->pending >= FCL_SERVE_MAX_PENDING and
+	    not lpConn->broken ) {
+      pthread_cond_wait( &lpConn->cond, &lpConn->mutex );
+    }
+    bool broken = lpConn->broken;
+    pthread_mutex_unlock( &lpConn->mutex );
+
+    if ( broken or
+	 ReadAll( lpConn->fd, &header, sizeof( header ) ) != 0 ) {
+      break;
+    }
+
+    // Every request read gets a response, or the connection ends
+    pthread_mutex_lock( &lpConn->mutex );
+    lpConn->pending++;
+    pthread_mutex_unlock( &lpConn->mutex );
+
+    if ( header.count > FCL_SERVE_MAX_VALUES ) {
+      // The stream can not be resynchronized
+      Respond( lpConn, header.type, header.requestId, -1, 0, 0, 0 );
+      break;
+    }
+
+    FuzzyServeRequest* lpRequest = new FuzzyServeRequest;
+    lpRequest->lpConn    = lpConn;
+    lpRequest->type      = header.type;
+    lpRequest->requestId = header.requestId;
+    lpRequest->inputs.resize( header.count );
+
+    if ( header.count and
+	 ReadAll( lpConn->fd, &lpRequest->inputs[0],
+		  header.count * sizeof( double ) ) != 0 ) {
+      delete lpRequest;
+      pthread_mutex_lock( &lpConn->mutex );
+      lpConn->pending--;
+      pthread_mutex_unlock( &lpConn->mutex );
+      break;
+    }
+
+    if ( header.model >= Models.size() or
+	 ( header.type != FCL_SERVE_EVALUATE and
+	   header.type != FCL_SERVE_DESCRIBE ) ) {
+      Respond( lpConn, header.type, header.requestId, -1, 0, 0, 0 );
+      delete lpRequest;
+      continue;
+    }
+
+    FuzzyServeModel* lpModel = Models[ header.model ];
+    __sync_fetch_and_add( &lpConn->refCount, 1 );
+
+    pthread_mutex_lock( &lpModel->queueMutex );
+    lpModel->queue.push_back( lpRequest );
+    if ( lpModel->queue.size() == 1 ) {
+      pthread_cond_signal( &lpModel->queueCond );
+    }
+    pthread_mutex_unlock( &lpModel->queueMutex );
+  }
+
+  EndReading( lpConn );
+  Release( lpConn );
+}
+
+//--------------------------------------------------------------
+// WriterLoop
+//
+// Purpose: Send the responses queued on a connection until the
+//          reader is done and every request is answered. A failed
+//          send shuts the socket down, which ends the reader, and
+//          the responses still to come are dropped.
+//
+// Arguments: lpConn
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyServerClass::WriterLoop( FuzzyServeConnection* lpConn ) {
+
+  string buffer;
+
+  pthread_mutex_lock( &lpConn->mutex );
+  while ( true ) {
+    while ( lpConn->output.empty() and not lpConn->broken and
+	    not ( lpConn->closing and lpConn->pending == 0 ) ) {
+      pthread_cond_wait( &lpConn->cond, &lpConn->mutex );
+    }
+    if ( lpConn->output.empty() or lpConn->broken ) {
+      break;
+    }
+    buffer.swap( lpConn->output );
+    int nSent = lpConn->nOutput;
+    lpConn->nOutput = 0;
+    pthread_mutex_unlock( &lpConn->mutex );
+
+    int writeStatus = WriteAll( lpConn->fd, buffer.data(), buffer.size() );
+    buffer.clear();
+
+    pthread_mutex_lock( &lpConn->mutex );
+    if ( writeStatus != 0 ) {
+      lpConn->broken = true;
+      shutdown( lpConn->fd, SHUT_RDWR );
+    }
+    lpConn->pending -= nSent;
+    pthread_cond_broadcast( &lpConn->cond );
+  }
+  pthread_mutex_unlock( &lpConn->mutex );
+
+  Release( lpConn );
+}
+
+//--------------------------------------------------------------
+// EngineLoop
+//
+// Purpose: Wait for queued requests of a model, take all of them
+//          (up to FCL_SERVE_MAX_BATCH), evaluate each request and
+//          queue the responses, each with the status of its own
+//          evaluation. Requests that arrive while a batch is
+//          evaluated form the next batch. The outputs are reset to
+//          those of the loaded model before each request, so an NC
+//          output does not carry the value of another request.
+//
+// Arguments: lpModel
+//
+// Return: never returns
+//--------------------------------------------------------------
+void FuzzyServerClass::EngineLoop( FuzzyServeModel* lpModel ) {
+
+  vector< FuzzyServeRequest* > batch;
+  vector< FuzzyServeRequest* > evaluate;
+  vector< double > inputs;
+  vector< double > outputs;
+  vector< int >    evaluateStatus;
+  vector< double > initialOutputs; // outputs of the loaded model
+
+  FuzzyControlClass* lpLoaded = 0;
+
+  while ( true ) {
+
+    pthread_mutex_lock( &lpModel->queueMutex );
+    while ( lpModel->queue.empty() ) {
+      pthread_cond_wait( &lpModel->queueCond, &lpModel->queueMutex );
+    }
+    if ( lpModel->queue.size() <= FCL_SERVE_MAX_BATCH ) {
+      batch.swap( lpModel->queue );
+    }
+    else {
+      batch.assign( lpModel->queue.begin(),
+		    lpModel->queue.begin() + FCL_SERVE_MAX_BATCH );
+      lpModel->queue.erase( lpModel->queue.begin(),
+			    lpModel->queue.begin() + FCL_SERVE_MAX_BATCH );
+    }
+    pthread_mutex_unlock( &lpModel->queueMutex );
+
+    // Pick up a reloaded model between batches
+    FuzzyControlClass* lpFC = lpModel->lpFR->Acquire( lpModel->reader );
+    int nInputs  = lpFC->NumInputs();
+    int nOutputs = lpFC->NumOutputs();
+    const vector< FuzzyOutputClass* >& outputVariables =
+      lpFC->OutputVariablesVector();
+    if ( lpFC != lpLoaded ) {
+      lpLoaded = lpFC;
+      initialOutputs.assign( nOutputs, 0. );
+      for ( int k = 0; k < nOutputs; k++ ) {
+	initialOutputs[k] = outputVariables[k]->defuzzOut;
+      }
+    }
+
+    // Gather the evaluations into one input block
+    evaluate.clear();
+    inputs.clear();
+    for ( vector< FuzzyServeRequest* >::iterator ri = batch.begin();
+	  ri != batch.end(); ++ri ) {
+      FuzzyServeRequest* lpRequest = *ri;
+      if ( lpRequest->type == FCL_SERVE_EVALUATE and
+	   (int) lpRequest->inputs.size() == nInputs ) {
+	evaluate.push_back( lpRequest );
+	inputs.insert( inputs.end(), lpRequest->inputs.begin(),
+		       lpRequest->inputs.end() );
+      }
+    }
+    outputs.assign( evaluate.size() * nOutputs, 0. );
+    evaluateStatus.assign( evaluate.size(), 0 );
+
+    // Each request on its own, a failed one does not fail the others
+    for ( unsigned int e = 0; e < evaluate.size(); e++ ) {
+      for ( int k = 0; k < nOutputs; k++ ) {
+	outputVariables[k]->defuzzOut = initialOutputs[k];
+      }
+      evaluateStatus[e] =
+	FuzzyControl_EvaluateBatch( lpFC, 1, &inputs[ e * nInputs ],
+				    &outputs[ e * nOutputs ] );
+    }
+
+    // Respond in request order
+    unsigned int e = 0;
+    for ( vector< FuzzyServeRequest* >::iterator ri = batch.begin();
+	  ri != batch.end(); ++ri ) {
+      FuzzyServeRequest* lpRequest = *ri;
+
+      if ( e < evaluate.size() and evaluate[e] == lpRequest ) {
+	if ( evaluateStatus[e] == 0 ) {
+	  Respond( lpRequest->lpConn, lpRequest->type, lpRequest->requestId,
+		   0, &outputs[ e * nOutputs ], nOutputs, sizeof( double ) );
+	}
+	else {
+	  Respond( lpRequest->lpConn, lpRequest->type, lpRequest->requestId,
+		   evaluateStatus[e], 0, 0, 0 );
+	}
+	e++;
+      }
+      else if ( lpRequest->type == FCL_SERVE_DESCRIBE ) {
+	ostringstream description;
+	description << lpFC->FCLFile() << "\n";
+	for ( int i = 0; i < nInputs; i++ ) {
+	  description << "input "
+		      << lpFC->InputVariablesVector()[i]->varName << "\n";
+	}
+	for ( int i = 0; i < nOutputs; i++ ) {
+	  description << "output "
+		      << lpFC->OutputVariablesVector()[i]->varName << "\n";
+	}
+	string text = description.str();
+	Respond( lpRequest->lpConn, lpRequest->type, lpRequest->requestId,
+		 0, text.data(), text.size(), 1 );
+      }
+      else {
+	// wrong number of input values
+	Respond( lpRequest->lpConn, lpRequest->type, lpRequest->requestId,
+		 -1, 0, 0, 0 );
+      }
+
+      Release( lpRequest->lpConn );
+      delete lpRequest;
+    }
+    batch.clear();
+  }
+}
+
+//--------------------------------------------------------------
+// Respond
+//
+// Purpose: Queue a response header and data for the writer thread
+//          of a connection, does not wait for the socket. The
+//          response is dropped if the connection is broken.
+//
+// Arguments: lpConn, type, requestId, status
+//            data  : response values
+//            count : number of values
+//            size  : bytes per value
+//
+// Return: status, -1 if the connection is broken
+//--------------------------------------------------------------
+int FuzzyServerClass::Respond( FuzzyServeConnection* lpConn, uint32_t type,
+			       uint32_t requestId, int responseStatus,
+			       const void* data, uint32_t count,
+			       size_t size ) {
+
+  FuzzyServeResponseHeader header;
+  header.type      = type;
+  header.requestId = requestId;
+  header.status    = responseStatus;
+  header.count     = count;
+
+  pthread_mutex_lock( &lpConn->mutex );
+  int writeStatus = 0;
+  if ( lpConn->broken ) {
+    lpConn->pending--;
+    writeStatus = -1;
+  }
+  else {
+    lpConn->output.append( (const char*) &header, sizeof( header ) );
+    if ( count ) {
+      lpConn->output.append( (const char*) data, count * size );
+    }
+    lpConn->nOutput++;
+  }
+  pthread_cond_broadcast( &lpConn->cond );
+  pthread_mutex_unlock( &lpConn->mutex );
+
+  return writeStatus;
+}
+
+//--------------------------------------------------------------
+// Release
+//
+// Purpose: Drop a reference to a connection, the last reference
+//          closes the socket and frees the connection
+//
+// Arguments: lpConn
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyServerClass::Release( FuzzyServeConnection* lpConn ) {
+
+  if ( __sync_sub_and_fetch( &lpConn->refCount, 1 ) == 0 ) {
+    close( lpConn->fd );
+    pthread_mutex_destroy( &lpConn->mutex );
+    pthread_cond_destroy ( &lpConn->cond );
+    delete lpConn;
+  }
+}
@@ -0,0 +1,154 @@
+#ifndef Fuzzy_Server_H
+#define Fuzzy_Server_H
+
+#include "FuzzyReload.h"
+
+//---------------------------------------------------------------------
+// RunFCL --serve wire protocol, over a Unix domain stream socket.
+// All values are in host byte order, the socket is local.
+//
+// Request:  FuzzyServeRequestHeader, then count doubles
+// Response: FuzzyServeResponseHeader, then count doubles (EVALUATE)
+//           or count characters (DESCRIBE)
+//
+// FCL_SERVE_EVALUATE : count input values of the model, in VAR_INPUT
+//                      declaration order. The response has the
+//                      output values in VAR_OUTPUT declaration order.
+// FCL_SERVE_DESCRIBE : count is 0. The response text has one line
+//                      "FCL file" then a line per input
+//                      "input name" and per output "output name".
+//
+// A client may send several requests before reading the responses,
+// responses for one model come back in request order. requestId is
+// returned unchanged. At most FCL_SERVE_MAX_PENDING requests of a
+// connection are read ahead of their responses being sent, beyond
+// that the server stops reading the connection until the client
+// reads its responses. A nonzero response status is an error, with
+// count 0.
+//---------------------------------------------------------------------
+#define FCL_SERVE_EVALUATE 1
+#define FCL_SERVE_DESCRIBE 2
+
+// Limits on one request, on the requests evaluated per batch, and
+// on the requests of a connection waiting for their response
+#define FCL_SERVE_MAX_VALUES  4096
+#define FCL_SERVE_MAX_BATCH   1024
+#define FCL_SERVE_MAX_PENDING 256
+
+struct FuzzyServeRequestHeader {
+  uint32_t type;      // FCL_SERVE_EVALUATE or FCL_SERVE_DESCRIBE
+  uint32_t requestId; // returned in the response
+  uint32_t model;     // index of the FCL file on the command line
+  uint32_t count;     // number of doubles that follow
+};
+
+struct FuzzyServeResponseHeader {
+  uint32_t type;      // type of the request
+  uint32_t requestId; // requestId of the request
+  int32_t  status;    // 0 = OK
+  uint32_t count;     // number of doubles, or characters, that follow
+};
+
+//---------------------------------------------------------------------
+// struct FuzzyServeConnection
+//
+// Purpose: A client connection. The engine threads append responses
+//          to output, the writer thread of the connection sends
+//          them, so a client that does not read its responses only
+//          blocks its own writer. pending counts the requests read
+//          and not yet sent a response, the reader thread waits on
+//          cond while it is FCL_SERVE_MAX_PENDING. refCount counts
+//          the reader and writer threads and the queued requests,
+//          the last one closes fd.
+//---------------------------------------------------------------------
+struct FuzzyServeConnection {
+  int             fd;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;      // output to send, or pending went down
+  string          output;    // responses not yet sent
+  int             nOutput;   // number of responses in output
+  int             pending;
+  bool            closing;   // the reader thread is done
+  bool            broken;    // a send failed, responses are dropped
+  volatile int    refCount;
+};
+
+//---------------------------------------------------------------------
+// struct FuzzyServeRequest
+//
+// Purpose: A request queued for a model engine thread
+//---------------------------------------------------------------------
+struct FuzzyServeRequest {
+  FuzzyServeConnection* lpConn;
+  uint32_t              type;
+  uint32_t              requestId;
+  vector< double >      inputs;
+};
+
+class FuzzyServerClass;
+
+//---------------------------------------------------------------------
+// struct FuzzyServeModel
+//
+// Purpose: A served FCL model with its request queue and the engine
+//          thread that evaluates the queued requests in batches
+//---------------------------------------------------------------------
+struct FuzzyServeModel {
+  FuzzyServerClass* lpServer;
+  FuzzyReloadClass* lpFR;   // model, reloaded when the FCL file changes
+  int               reader; // reader slot of the engine thread
+
+  pthread_t         engine;
+  pthread_mutex_t   queueMutex;
+  pthread_cond_t    queueCond;
+  vector< FuzzyServeRequest* > queue;
+};
+
+//---------------------------------------------------------------------
+// class FuzzyServerClass
+//
+// Purpose: RunFCL --serve, a long running process that loads FCL
+//          models once and evaluates requests from local clients.
+//          A thread per connection reads requests and queues them
+//          on their model. The engine thread of a model takes all
+//          queued requests at once, so concurrent clients share
+//          one wakeup and model switch, and evaluates each request
+//          on its own: a request that fails does not fail the
+//          others. The clients of a model share one model instance,
+//          its outputs are reset to the loaded values before each
+//          request, so an NC output with no rule fired returns its
+//          initial value, not the output of a previous request.
+//---------------------------------------------------------------------
+class FuzzyServerClass {
+
+ protected:
+  int status; // Error code variable
+
+  string socketPath;   // Unix domain socket path
+  int    listenFd;     // listening socket
+  int    pollInterval; // FCL file change check, milliseconds
+
+  vector< FuzzyServeModel* > Models;
+
+ public:
+  // Encapsulation methods for protected variables
+  string SocketPath() const { return socketPath; }
+  int    NumModels()  const { return Models.size(); }
+
+  // FuzzyServer Methods
+  FuzzyServerClass( string socketPath, int pollInterval );
+  ~FuzzyServerClass();
+
+  int AddModel( string FCLFileName );
+  int Serve();
+
+  void ConnectionLoop( FuzzyServeConnection* lpConn );
+  void WriterLoop    ( FuzzyServeConnection* lpConn );
+  void EngineLoop    ( FuzzyServeModel* lpModel );
+  int  Respond       ( FuzzyServeConnection* lpConn, uint32_t type,
+		       uint32_t requestId, int status,
+		       const void* data, uint32_t count, size_t size );
+  void Release       ( FuzzyServeConnection* lpConn );
+};
+
+#endif
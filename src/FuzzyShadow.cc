@@ -0,0 +1,398 @@
+#include "FuzzyShadow.h"
+#include <sstream> // statistics messages
+#include <limits>  // quiet_NaN
+
+//--------------------------------------------------------------
+// SameTerm
+//
+// Purpose: Whether two input terms give the same membership for
+//          every input value: the same type and points
+//
+// Arguments: lpA, lpB : input terms
+//
+// Return: true if the same
+//--------------------------------------------------------------
+static bool SameTerm( const FuzzyInputTerm* lpA, const FuzzyInputTerm* lpB ) {
+
+  if ( lpA->termType != lpB->termType or
+       lpA->xy.size() != lpB->xy.size() ) {
+    return false;
+  }
+  for ( unsigned int i = 0; i < lpA->xy.size(); i++ ) {
+    if ( lpA->xy[i]->x != lpB->xy[i]->x or
+	 lpA->xy[i]->y != lpB->xy[i]->y ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------
+// FuzzyShadowClass
+//
+// Purpose: Constructor for FuzzyShadowClass
+//
+// Arguments: lpProduction : parsed production model, only read
+//            lpCandidate  : parsed candidate model
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyShadowClass::FuzzyShadowClass( const FuzzyControlClass* lpProduction,
+				    FuzzyControlClass* lpCandidate ) {
+
+  status             = 0;
+  this->lpProduction = lpProduction;
+  this->lpCandidate  = lpCandidate;
+  nEvaluated         = 0;
+  nFailed            = 0;
+}
+
+//--------------------------------------------------------------
+// NumSharedTerms
+//
+// Purpose: Number of candidate input terms that take the
+//          production membership
+//
+// Arguments:
+//
+// Return: number of terms
+//--------------------------------------------------------------
+int FuzzyShadowClass::NumSharedTerms() const {
+
+  int nShared = 0;
+  for ( unsigned int t = 0; t < Terms.size(); t++ ) {
+    if ( Terms[t].production ) nShared++;
+  }
+  return nShared;
+}
+
+//--------------------------------------------------------------
+// Link
+//
+// Purpose: Match the candidate inputs, input terms and outputs to
+//          the production ones by name. Every candidate input must
+//          be a production input. A candidate term with the same
+//          definition as the production term takes its membership.
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyShadowClass::Link() {
+
+  const vector< FuzzyInputClass* >& candidateInputs =
+    lpCandidate->InputVariablesVector();
+  const vector< FuzzyInputClass* >& productionInputs =
+    lpProduction->InputVariablesVector();
+  map< string, FuzzyInputTerm* >::iterator fiti;
+  map< string, FuzzyInputTerm* >::const_iterator pfiti;
+
+  Terms.clear();
+  for ( unsigned int i = 0; i < candidateInputs.size(); i++ ) {
+    FuzzyInputClass* lpFIC = candidateInputs[i];
+    int handle = lpProduction->InputHandle( lpFIC->varName );
+    if ( handle < 0 ) {
+      status = -1;
+      ErrMsg( "Link() Candidate input is not a production input",
+	      lpFIC->varName, status );
+      return status;
+    }
+    const FuzzyInputClass* lpProductionFIC = productionInputs[ handle ];
+
+    for ( fiti = lpFIC->InputTerms.begin();
+	  fiti != lpFIC->InputTerms.end(); ++fiti ) {
+      ShadowTerm term;
+      term.lpFIC           = lpFIC;
+      term.candidate       = fiti->second;
+      term.production      = 0;
+      term.productionInput = handle;
+
+      pfiti = lpProductionFIC->InputTerms.find( fiti->first );
+      if ( pfiti != lpProductionFIC->InputTerms.end() and
+	   SameTerm( fiti->second, pfiti->second ) ) {
+	term.production = pfiti->second;
+      }
+      Terms.push_back( term );
+    }
+  }
+
+  int nOutputs = lpCandidate->NumOutputs();
+  productionOutput.assign( nOutputs, -1 );
+  for ( int k = 0; k < nOutputs; k++ ) {
+    productionOutput[k] = lpProduction->OutputHandle(
+      lpCandidate->OutputVariablesVector()[k]->varName );
+  }
+
+  candidateOutputs.assign( nOutputs, 0. );
+  sumAbsDiff.assign( nOutputs, 0. );
+  maxAbsDiff.assign( nOutputs, 0. );
+  maxAbsDiffRow.assign( nOutputs, -1 );
+  nEvaluated = 0;
+  nFailed    = 0;
+  inputColumn.clear();
+
+  ostringstream shared;
+  shared << NumSharedTerms() << " of " << Terms.size();
+  ConsoleMsg( "Shadow input terms shared with production", shared.str(), 0 );
+  return 0;
+}
+
+//--------------------------------------------------------------
+// OpenOutputFile
+//
+// Purpose: Open the candidate output file and write its header,
+//          the row index and the candidate outputs
+//
+// Arguments: fileName : candidate output file
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyShadowClass::OpenOutputFile( string* fileName ) {
+
+  ShadowStream.open( fileName->c_str(), ios::out );
+  if ( not ShadowStream ) {
+    ErrMsg( "Failed to open shadow output file:", *fileName, -1 );
+    return -1;
+  }
+  shadowFileName = *fileName;
+
+  ShadowStream << "index, ";
+  for ( int k = 0; k < lpCandidate->NumOutputs(); k++ ) {
+    ShadowStream << lpCandidate->OutputVariablesVector()[k]->varName << ", ";
+  }
+  ShadowStream << "\n";
+  return 0;
+}
+
+//--------------------------------------------------------------
+// CloseOutputFile
+//
+// Purpose: Close the candidate output file
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyShadowClass::CloseOutputFile() {
+
+  if ( ShadowStream.is_open() ) {
+    ShadowStream.close();
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Evaluate
+//
+// Purpose: Evaluate the candidate after the production model has
+//          evaluated the same input row. The shared terms take the
+//          production memberships, the others are fuzzified from
+//          the production input values. Update the divergence and
+//          write the candidate outputs.
+//
+// Arguments: productionInputs : the production input row, in
+//                               production declaration order
+//            row              : row index for the output file
+//
+// Return: status of the candidate
+//--------------------------------------------------------------
+int FuzzyShadowClass::Evaluate( const double* productionInputs,
+				long row ) {
+
+  int nOutputs = lpCandidate->NumOutputs();
+  int status   = 0;
+
+  for ( unsigned int t = 0; t < Terms.size() and status == 0; t++ ) {
+    const ShadowTerm& term = Terms[t];
+    if ( term.production ) {
+      term.candidate->membership = term.production->membership;
+      continue;
+    }
+    double value = productionInputs[ term.productionInput ];
+    switch ( term.candidate->termType ) {
+    case Trapezoid:
+      status = term.lpFIC->FuzzifyTrapezoid( term.candidate, value );
+      break;
+    case Triangle:
+      status = term.lpFIC->FuzzifyTriangle( term.candidate, value );
+      break;
+    case Ramp:
+      status = term.lpFIC->FuzzifyRamp( term.candidate, value );
+      break;
+    case Rectangle:
+      status = term.lpFIC->FuzzifyRectangle( term.candidate, value );
+      break;
+    case Singleton:
+      status = term.lpFIC->FuzzifySingleton( term.candidate, value );
+      break;
+    default:
+      status = -1;
+    };
+  }
+  if ( status == 0 ) {
+    status = lpCandidate->Evaluate();
+  }
+
+  nEvaluated++;
+  if ( status != 0 ) {
+    nFailed++;
+    candidateOutputs.assign( nOutputs, numeric_limits< double >::quiet_NaN() );
+  }
+  else {
+    lpCandidate->GetOutputs( &candidateOutputs[0] );
+    for ( int k = 0; k < nOutputs; k++ ) {
+      if ( productionOutput[k] < 0 ) continue;
+      double difference = fabs( candidateOutputs[k] -
+	lpProduction->OutputVariablesVector()[ productionOutput[k] ]->
+	defuzzOut );
+      sumAbsDiff[k] += difference;
+      if ( difference > maxAbsDiff[k] or maxAbsDiffRow[k] < 0 ) {
+	maxAbsDiff[k]    = difference;
+	maxAbsDiffRow[k] = row;
+      }
+    }
+  }
+
+  if ( ShadowStream.is_open() ) {
+    ShadowStream << row << ", ";
+    for ( int k = 0; k < nOutputs; k++ ) {
+      ShadowStream << candidateOutputs[k] << ", ";
+    }
+    ShadowStream << "\n";
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// EvaluateDataPoint
+//
+// Purpose: Evaluate() on a row of the production InputData, after
+//          the production Fuzzification() of the row
+//
+// Arguments: inputDataIndex : index in the InputData vectors
+//
+// Return: status of the candidate
+//--------------------------------------------------------------
+int FuzzyShadowClass::EvaluateDataPoint( int inputDataIndex ) {
+
+  int nInputs = lpProduction->NumInputs();
+
+  // The production data columns, once
+  if ( (int) inputColumn.size() != nInputs ) {
+    inputColumn.assign( nInputs, (const vector< double >*) 0 );
+    inputRow.assign( nInputs, 0. );
+    for ( int j = 0; j < nInputs; j++ ) {
+      map< string, vector< double >* >::const_iterator idi =
+	lpProduction->InputDataMap().find(
+	  lpProduction->InputVariablesVector()[j]->varName );
+      if ( idi != lpProduction->InputDataMap().end() ) {
+	inputColumn[j] = idi->second;
+      }
+    }
+  }
+
+  for ( int j = 0; j < nInputs; j++ ) {
+    if ( inputColumn[j] and
+	 inputDataIndex < (int) inputColumn[j]->size() ) {
+      inputRow[j] = (*inputColumn[j])[ inputDataIndex ];
+    }
+  }
+  return Evaluate( nInputs ? &inputRow[0] : 0, inputDataIndex );
+}
+
+//--------------------------------------------------------------
+// GetOutputs
+//
+// Purpose: Copy the candidate outputs of the last Evaluate()
+//
+// Arguments: outputValues : one value per candidate output
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyShadowClass::GetOutputs( double* outputValues ) const {
+
+  for ( unsigned int k = 0; k < candidateOutputs.size(); k++ ) {
+    outputValues[k] = candidateOutputs[k];
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// WriteStatistics
+//
+// Purpose: Report the divergence of each candidate output from the
+//          production output, and the failed candidate rows
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyShadowClass::WriteStatistics() {
+
+  for ( int k = 0; k < lpCandidate->NumOutputs(); k++ ) {
+    const string& varName = lpCandidate->OutputVariablesVector()[k]->varName;
+    if ( productionOutput[k] < 0 ) {
+      ConsoleMsg( "Shadow output is not a production output", varName, 0 );
+      continue;
+    }
+    long nCompared = nEvaluated - nFailed;
+    ostringstream statistics;
+    statistics << varName << " max " << maxAbsDiff[k]
+	       << " at row " << maxAbsDiffRow[k] << " mean "
+	       << ( nCompared ? sumAbsDiff[k] / nCompared : 0. );
+    ConsoleMsg( "Shadow absolute difference", statistics.str(), 0 );
+  }
+  if ( nFailed ) {
+    ConsoleMsg( "Shadow rows failed", lpCandidate->FCLFile(), nFailed );
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_ShadowSeriesInput
+//
+// Purpose: FuzzyControl_SeriesInput() with a shadow candidate
+//          evaluated after each production row. A candidate error
+//          does not stop the production run.
+//
+// Arguments: lpFC          : production model
+//            lpShadow      : shadow of the candidate
+//            numDataPoints : number of InputData rows
+//
+// Return: status of the production run
+//--------------------------------------------------------------
+int FuzzyControl_ShadowSeriesInput( FuzzyControlClass* lpFC,
+				    FuzzyShadowClass* lpShadow,
+				    int numDataPoints ) {
+
+  int status = 0;
+  if ( not lpFC or not lpShadow ) {
+    status = -1;
+    ErrMsg( "FuzzyControl_ShadowSeriesInput()",
+	    "Invalid FuzzyControlClass or FuzzyShadowClass", status );
+    return status;
+  }
+
+  for ( int i = 0; i < numDataPoints; i++ ) {
+    status = lpFC->Fuzzification( i );
+    if ( status != 0 ) {
+      ErrMsg( "Fuzzification Failed.", "", status );
+      break;
+    }
+    status = lpFC->Evaluate();
+    if ( status != 0 ) {
+      break;
+    }
+    if ( not lpFC->OutputFileName().empty() ) {
+      status = lpFC->WriteTimestepOutput( i );
+      if ( status != 0 ) {
+	ErrMsg( "WriteTimestepOutput() Failed.", lpFC->OutputFileName(),
+		status );
+	break;
+      }
+    }
+
+    lpShadow->EvaluateDataPoint( i );
+  }
+  return status;
+}
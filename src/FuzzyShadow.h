@@ -0,0 +1,87 @@
+#ifndef Fuzzy_Shadow_H
+#define Fuzzy_Shadow_H
+
+#include "FuzzyControl.h"
+
+//---------------------------------------------------------------------
+// struct ShadowTerm
+//
+// Purpose: A candidate input term and where its membership comes
+//          from: the production term of the same definition, or
+//          fuzzification of the production input value
+//---------------------------------------------------------------------
+struct ShadowTerm {
+  FuzzyInputClass*      lpFIC;           // candidate input
+  FuzzyInputTerm*       candidate;
+  const FuzzyInputTerm* production;      // 0 if fuzzified
+  int                   productionInput; // production input handle
+};
+
+//---------------------------------------------------------------------
+// class FuzzyShadowClass
+//
+// Purpose: Evaluate a candidate model on the inputs of a production
+//          model, after the production model, to compare a change
+//          at full traffic. The candidate uses the production input
+//          row, and the production memberships of the input terms
+//          it defines the same way. The candidate outputs go to their
+//          own output file, with the largest and mean absolute
+//          difference from the production output of the same name.
+//
+//          The production model is only read: a candidate error is
+//          counted and reported, and does not change the production
+//          outputs or status.
+//---------------------------------------------------------------------
+class FuzzyShadowClass {
+
+ protected:
+  int status; // Error code variable
+
+  const FuzzyControlClass* lpProduction;
+  FuzzyControlClass*       lpCandidate;
+
+  vector< ShadowTerm > Terms;
+
+  // Production output handle of each candidate output, or -1
+  vector< int > productionOutput;
+
+  // Production InputData column of each production input
+  vector< const vector< double >* > inputColumn;
+  vector< double >                  inputRow;
+
+  vector< double > candidateOutputs;
+
+  // Divergence of each candidate output
+  long             nEvaluated;
+  long             nFailed;
+  vector< double > sumAbsDiff;
+  vector< double > maxAbsDiff;
+  vector< long >   maxAbsDiffRow;
+
+  ofstream ShadowStream;
+  string   shadowFileName;
+
+ public:
+  // Encapsulation methods for protected variables
+  int  NumSharedTerms() const;
+  long NumEvaluated()   const { return nEvaluated; }
+  long NumFailed()      const { return nFailed; }
+
+  // FuzzyShadow Methods
+  FuzzyShadowClass( const FuzzyControlClass* lpProduction,
+		    FuzzyControlClass* lpCandidate );
+
+  int Link             ();
+  int OpenOutputFile   ( string* fileName );
+  int CloseOutputFile  ();
+  int Evaluate         ( const double* productionInputs, long row );
+  int EvaluateDataPoint( int inputDataIndex );
+  int GetOutputs       ( double* outputValues ) const;
+  int WriteStatistics  ();
+};
+
+int FuzzyControl_ShadowSeriesInput( FuzzyControlClass* lpFC,
+				    FuzzyShadowClass* lpShadow,
+				    int numDataPoints );
+
+#endif
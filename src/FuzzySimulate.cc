@@ -0,0 +1,625 @@
+#include "FuzzySimulate.h"
+#include <limits> // quiet_NaN
+
+//--------------------------------------------------------------
+// SimulateScenarios
+//
+// Purpose: FCL_ParallelFor() worker for Simulate(), the items are
+//          the scenarios
+//
+// Arguments: arg         : pointer to the FuzzySimulateClass
+//            threadIndex : model clone of the thread
+//            begin, end  : range of scenarios
+//
+// Return:
+//--------------------------------------------------------------
+static void SimulateScenarios( void* arg, int threadIndex,
+			       int begin, int end ) {
+
+  FuzzySimulateClass* lpFS = (FuzzySimulateClass*) arg;
+
+  for ( int s = begin; s < end; s++ ) {
+    lpFS->SimulateScenario( threadIndex, s );
+  }
+}
+
+//--------------------------------------------------------------
+// FuzzySimulateClass
+//
+// Purpose: Constructor for FuzzySimulateClass
+//
+// Arguments: lpFC  : parsed controller
+//            plant : plant model
+//
+// Return:
+//--------------------------------------------------------------
+FuzzySimulateClass::FuzzySimulateClass( FuzzyControlClass* lpFC,
+					const FuzzyPlant& plant ) {
+
+  status        = 0;
+  this->lpFC    = lpFC;
+  this->plant   = plant;
+  integrator    = SimRK4;
+  endTime       = FCL_SIM_END_TIME;
+  timeStep      = FCL_SIM_TIME_STEP;
+  controlPeriod = FCL_SIM_CONTROL_PERIOD;
+}
+
+//--------------------------------------------------------------
+// ~FuzzySimulateClass
+//
+// Purpose: Destructor for FuzzySimulateClass, delete the model
+//          clones
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzySimulateClass::~FuzzySimulateClass() {
+
+  for ( int i = 0; i < (int) Workers.size(); i++ ) {
+    delete Workers[i];
+  }
+}
+
+//--------------------------------------------------------------
+// Link
+//
+// Purpose: Match the plant measurements to controller inputs and
+//          the plant actuators to controller outputs by name. Every
+//          controller input must be measured.
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySimulateClass::Link() {
+
+  measurementInput.assign( plant.measurementNames.size(), -1 );
+  actuatorOutput.assign( plant.actuatorNames.size(), -1 );
+
+  vector< bool > measured( lpFC->NumInputs(), false );
+
+  for ( int i = 0; i < (int) plant.measurementNames.size(); i++ ) {
+    measurementInput[i] = lpFC->InputHandle( plant.measurementNames[i] );
+    if ( measurementInput[i] >= 0 ) {
+      measured[ measurementInput[i] ] = true;
+    }
+  }
+  for ( int j = 0; j < lpFC->NumInputs(); j++ ) {
+    if ( not measured[j] ) {
+      ErrMsg( "Link() Plant " + plant.name + " does not measure input",
+	      lpFC->InputVariablesVector()[j]->varName, -1 );
+      return -1;
+    }
+  }
+  for ( int a = 0; a < (int) plant.actuatorNames.size(); a++ ) {
+    actuatorOutput[a] = lpFC->OutputHandle( plant.actuatorNames[a] );
+    if ( actuatorOutput[a] < 0 ) {
+      ErrMsg( "Link() Controller has no output for actuator",
+	      plant.actuatorNames[a], -1 );
+      return -1;
+    }
+  }
+  if ( plant.errorMeasurement < 0 or
+       plant.errorMeasurement >= (int) plant.measurementNames.size() ) {
+    ErrMsg( "Link() Plant has no error measurement", plant.name, -1 );
+    return -1;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// ReadScenarioFile
+//
+// Purpose: Read the scenarios, a row each. A state name column is
+//          the initial value of the state, a d_ state name column
+//          its disturbance. A state without a column starts at 0.
+//          A .gz file is decompressed on its own thread as it is
+//          read.
+//
+// Arguments: fileName : scenario file
+//
+// Return: Number of scenarios read, or error code
+//--------------------------------------------------------------
+int FuzzySimulateClass::ReadScenarioFile( string* fileName ) {
+
+  FuzzyGzipBufferClass ScenarioBuffer; // ScenarioStream of a .gz file
+  ifstream ScenarioStream;
+  string   inputLine;
+  vector< string > words;
+  int nStates = plant.stateNames.size();
+
+  // Scenario column of each initial value and disturbance, or -1
+  vector< int > initialColumn;
+  vector< int > disturbanceColumn;
+  int nColumns = 0;
+
+  if ( FCL_OpenInputStream( &ScenarioStream, *fileName, &ScenarioBuffer ) ) {
+    ErrMsg( "Failed to open scenario file:", *fileName, -1 );
+    return -1;
+  }
+
+  Scenarios.clear();
+  while ( getline( ScenarioStream, inputLine ) ) {
+    string::size_type CR = inputLine.find( '\r' );
+    if ( CR != string::npos ) {
+      inputLine.erase( CR );
+    }
+    if ( inputLine.find_first_not_of( " \t" ) == string::npos ) {
+      continue;
+    }
+    words.clear();
+    if ( lpFC->SplitLine( &words, &inputLine,
+			  &lpFC->InputDelimeters() ) != 0 ) {
+      ErrMsg( "Failed to split scenario file line", *fileName, -1 );
+      return -1;
+    }
+
+    // Column names
+    if ( nColumns == 0 ) {
+      nColumns = words.size();
+      initialColumn.assign( nStates, -1 );
+      disturbanceColumn.assign( nStates, -1 );
+      for ( int c = 0; c < nColumns; c++ ) {
+	for ( int i = 0; i < nStates; i++ ) {
+	  if ( words[c] == plant.stateNames[i] ) {
+	    initialColumn[i] = c;
+	  }
+	  else if ( words[c] == "d_" + plant.stateNames[i] ) {
+	    disturbanceColumn[i] = c;
+	  }
+	}
+      }
+      continue;
+    }
+
+    if ( (int) words.size() < nColumns ) {
+      ErrMsg( "Scenario file " + *fileName + " has a short line",
+	      inputLine, -1 );
+      return -1;
+    }
+    FuzzyScenario scenario;
+    scenario.initial.assign( nStates, 0. );
+    scenario.disturbance.assign( nStates, 0. );
+    for ( int i = 0; i < nStates; i++ ) {
+      if ( initialColumn[i] >= 0 ) {
+	scenario.initial[i] = atof( words[ initialColumn[i] ].c_str() );
+      }
+      if ( disturbanceColumn[i] >= 0 ) {
+	scenario.disturbance[i] =
+	  atof( words[ disturbanceColumn[i] ].c_str() );
+      }
+    }
+    Scenarios.push_back( scenario );
+  }
+  if ( FCL_CloseStream( &ScenarioStream, &ScenarioBuffer ) != 0 ) {
+    ErrMsg( "Failed to read scenario file:", *fileName, -1 );
+    return -1;
+  }
+
+  if ( Scenarios.empty() ) {
+    ErrMsg( "Scenario file has no scenarios", *fileName, -1 );
+    return -1;
+  }
+  return Scenarios.size();
+}
+
+//--------------------------------------------------------------
+// Step
+//
+// Purpose: Advance the plant state over an integration step with
+//          the actuators held
+//
+// Arguments: t           : time at the start of the step
+//            h           : step
+//            state       : plant state, advanced
+//            actuators   : held actuator values
+//            disturbance : added to the derivatives
+//            work        : 5 * nStates values
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySimulateClass::Step( double t, double h, double* state,
+			      const double* actuators,
+			      const double* disturbance, double* work ) {
+
+  int n = plant.stateNames.size();
+  double* k1 = work;
+  double* k2 = work + n;
+  double* k3 = work + 2 * n;
+  double* k4 = work + 3 * n;
+  double* y  = work + 4 * n;
+
+  int status = plant.derivatives( plant.arg, t, state, actuators, k1 );
+  if ( status != 0 ) return status;
+  for ( int i = 0; i < n; i++ ) k1[i] += disturbance[i];
+
+  if ( integrator == SimEuler ) {
+    for ( int i = 0; i < n; i++ ) state[i] += h * k1[i];
+    return 0;
+  }
+
+  if ( integrator == SimHeun ) {
+    for ( int i = 0; i < n; i++ ) y[i] = state[i] + h * k1[i];
+    status = plant.derivatives( plant.arg, t + h, y, actuators, k2 );
+    if ( status != 0 ) return status;
+    for ( int i = 0; i < n; i++ ) {
+      state[i] += 0.5 * h * ( k1[i] + k2[i] + disturbance[i] );
+    }
+    return 0;
+  }
+
+  // Classic fourth order Runge-Kutta
+  for ( int i = 0; i < n; i++ ) y[i] = state[i] + 0.5 * h * k1[i];
+  status = plant.derivatives( plant.arg, t + 0.5 * h, y, actuators, k2 );
+  if ( status != 0 ) return status;
+  for ( int i = 0; i < n; i++ ) k2[i] += disturbance[i];
+
+  for ( int i = 0; i < n; i++ ) y[i] = state[i] + 0.5 * h * k2[i];
+  status = plant.derivatives( plant.arg, t + 0.5 * h, y, actuators, k3 );
+  if ( status != 0 ) return status;
+  for ( int i = 0; i < n; i++ ) k3[i] += disturbance[i];
+
+  for ( int i = 0; i < n; i++ ) y[i] = state[i] + h * k3[i];
+  status = plant.derivatives( plant.arg, t + h, y, actuators, k4 );
+  if ( status != 0 ) return status;
+  for ( int i = 0; i < n; i++ ) k4[i] += disturbance[i];
+
+  for ( int i = 0; i < n; i++ ) {
+    state[i] += h / 6. * ( k1[i] + 2. * k2[i] + 2. * k3[i] + k4[i] );
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// SimulateScenario
+//
+// Purpose: Run the closed loop of a scenario on the model clone of
+//          a thread, from the outputs of the parsed controller, keep
+//          its results. The error is sampled every controller period
+//          and at the end time.
+//
+// Arguments: threadIndex : index into Workers
+//            scenario    : index into Scenarios
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzySimulateClass::SimulateScenario( int threadIndex, int scenario ) {
+
+  FuzzyControlClass* lpModel = Workers[ threadIndex ];
+  const FuzzyScenario& S = Scenarios[ scenario ];
+  double* lpResults = &Results[ scenario * SimNumResults ];
+
+  int nStates       = plant.stateNames.size();
+  int nMeasurements = plant.measurementNames.size();
+  int nActuators    = plant.actuatorNames.size();
+
+  vector< double > state( S.initial );
+  vector< double > measurements( nMeasurements );
+  vector< double > inputs ( lpModel->NumInputs() );
+  vector< double > outputs( lpModel->NumOutputs() );
+  vector< double > actuators( nActuators, 0. );
+  vector< double > work( 5 * nStates );
+
+  int    nSteps   = max( 1, (int) floor( controlPeriod / timeStep + 0.5 ) );
+  double h        = controlPeriod / nSteps;
+  int    nPeriods = (int) ceil( endTime / controlPeriod - 1.E-9 );
+
+  double t = 0., error = 0., initialError = 0.;
+  double overshoot = 0., effort = 0., settlingTime = 0.;
+  int    status = 0;
+
+  // Not from the scenario the worker ran before
+  vector< FuzzyOutputClass* > &outputVariables =
+    lpModel->OutputVariablesVector();
+  for ( int k = 0; k < (int) outputVariables.size(); k++ ) {
+    outputVariables[k]->defuzzOut = initialOutputs[k];
+  }
+
+  for ( int p = 0; p <= nPeriods; p++ ) {
+    t = p * controlPeriod;
+    status = plant.measure( plant.arg, t, &state[0], &measurements[0] );
+    if ( status != 0 ) break;
+
+    error = measurements[ plant.errorMeasurement ];
+    if ( not ( fabs( error ) < HUGE_VAL ) ) {
+      status = -1;
+      break;
+    }
+    if ( p == 0 ) {
+      initialError = error;
+    }
+    if ( fabs( error ) > plant.settleBand ) {
+      settlingTime = t + controlPeriod;
+    }
+    if ( initialError > 0. ) {
+      overshoot = max( overshoot, -error );
+    }
+    else if ( initialError < 0. ) {
+      overshoot = max( overshoot, error );
+    }
+    if ( p == nPeriods ) break;
+
+    // Controller, its outputs held over the period
+    for ( int i = 0; i < nMeasurements; i++ ) {
+      if ( measurementInput[i] >= 0 ) {
+	inputs[ measurementInput[i] ] = measurements[i];
+      }
+    }
+    status = lpModel->SetInputs( &inputs[0] );
+    if ( status == 0 ) {
+      status = lpModel->Evaluate();
+    }
+    if ( status != 0 ) break;
+    lpModel->GetOutputs( &outputs[0] );
+
+    double effortRate = 0.;
+    for ( int a = 0; a < nActuators; a++ ) {
+      actuators[a] = outputs[ actuatorOutput[a] ];
+      effortRate  += fabs( actuators[a] );
+    }
+
+    for ( int k = 0; k < nSteps and status == 0; k++ ) {
+      status = Step( t + k * h, h, &state[0], &actuators[0],
+		     &S.disturbance[0], &work[0] );
+    }
+    if ( status != 0 ) break;
+    effort += effortRate * controlPeriod;
+  }
+
+  Failed[ scenario ] = status;
+  if ( status != 0 ) {
+    for ( int r = 0; r < SimNumResults; r++ ) {
+      lpResults[r] = numeric_limits< double >::quiet_NaN();
+    }
+    return;
+  }
+  lpResults[ SimSettled ]      = fabs( error ) <= plant.settleBand ? 1. : 0.;
+  lpResults[ SimSettlingTime ] = lpResults[ SimSettled ] ? settlingTime :
+				 numeric_limits< double >::quiet_NaN();
+  lpResults[ SimOvershoot ]    = overshoot;
+  lpResults[ SimEffort ]       = effort;
+  lpResults[ SimFinalError ]   = error;
+}
+
+//--------------------------------------------------------------
+// Simulate
+//
+// Purpose: Run every scenario on the FCL_ParallelFor() thread pool
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySimulateClass::Simulate() {
+
+  int nThreads = FCL_NumThreads();
+
+  if ( Scenarios.empty() ) {
+    status = -1;
+    ErrMsg( "Simulate() No scenarios for", lpFC->FCLFile(), status );
+    return status;
+  }
+  if ( not ( timeStep > 0. and controlPeriod > 0. and endTime > 0. ) ) {
+    status = -1;
+    ErrMsg( "Simulate() Invalid time step, control period or end time",
+	    lpFC->FCLFile(), status );
+    return status;
+  }
+  status = Link();
+  if ( status != 0 ) return status;
+
+  // A model clone per thread, from one parsed model
+  status = FCL_CloneModels( lpFC, nThreads, &Workers );
+  if ( status != 0 ) {
+    ErrMsg( "Simulate() Failed to clone model", lpFC->FCLFile(), status );
+    return status;
+  }
+  initialOutputs.assign( lpFC->NumOutputs(), 0. );
+  lpFC->GetOutputs( &initialOutputs[0] );
+
+  Results.assign( Scenarios.size() * SimNumResults, 0. );
+  Failed.assign( Scenarios.size(), 0 );
+
+  status = FCL_ParallelFor( Scenarios.size(), 1, SimulateScenarios, this,
+			    Workers.size() );
+  if ( status != 0 ) {
+    ErrMsg( "Simulate() Failed to run scenarios of",
+	    lpFC->FCLFile(), status );
+    return status;
+  }
+
+  int nFailed = 0;
+  for ( int s = 0; s < (int) Scenarios.size(); s++ ) {
+    if ( Failed[s] ) nFailed++;
+  }
+  if ( nFailed ) {
+    ConsoleMsg( "Simulate() Scenarios failed in", lpFC->FCLFile(), nFailed );
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// WriteResults
+//
+// Purpose: Write a row per scenario: the index, the initial state,
+//          the disturbances, the results and the status
+//
+// Arguments: fileName : output file
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySimulateClass::WriteResults( string* fileName ) {
+
+  ofstream ResultStream;
+  int nStates = plant.stateNames.size();
+
+  ResultStream.open( fileName->c_str(), ios::out );
+  if ( not ResultStream ) {
+    ErrMsg( "Failed to open simulation output file:", *fileName, -1 );
+    return -1;
+  }
+
+  ResultStream << "scenario";
+  for ( int i = 0; i < nStates; i++ ) {
+    ResultStream << ", " << plant.stateNames[i];
+  }
+  for ( int i = 0; i < nStates; i++ ) {
+    ResultStream << ", d_" << plant.stateNames[i];
+  }
+  ResultStream << ", settled, settling_time, overshoot, effort, "
+	       << "final_error, status" << endl;
+
+  for ( int s = 0; s < (int) Scenarios.size(); s++ ) {
+    ResultStream << s;
+    for ( int i = 0; i < nStates; i++ ) {
+      ResultStream << ", " << Scenarios[s].initial[i];
+    }
+    for ( int i = 0; i < nStates; i++ ) {
+      ResultStream << ", " << Scenarios[s].disturbance[i];
+    }
+    for ( int r = 0; r < SimNumResults; r++ ) {
+      ResultStream << ", " << Results[ s * SimNumResults + r ];
+    }
+    ResultStream << ", " << Failed[s] << endl;
+  }
+
+  ResultStream.close();
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Built-in plants
+//--------------------------------------------------------------
+
+//--------------------------------------------------------------
+// struct CraneParameters
+//
+// Purpose: Container crane: a cart on a rail driven by a force,
+//          the container hanging from it on a rope
+//--------------------------------------------------------------
+struct CraneParameters {
+  double cartMass;   // kg
+  double loadMass;   // kg
+  double ropeLength; // m
+  double friction;   // cart friction, N / (m/s)
+  double forceScale; // N per unit of controller output
+};
+
+static CraneParameters craneParameters = {
+  2000., 10000., 10., 4000., 1000. };
+
+static const double craneGravity = 9.81;
+
+//--------------------------------------------------------------
+// CraneDerivatives
+//
+// Purpose: Equations of motion of the crane. The state is the cart
+//          position (m, the target at 0), its velocity, the rope
+//          angle (degrees, positive toward +position) and its rate.
+//
+// Arguments: see FCL_PlantDerivatives
+//
+// Return: status
+//--------------------------------------------------------------
+static int CraneDerivatives( void* arg, double t, const double* state,
+			     const double* actuators, double* derivatives ) {
+
+  const CraneParameters* lpCP = (const CraneParameters*) arg;
+
+  double toRadians = M_PI / 180.;
+  double velocity  = state[1];
+  double theta     = state[2] * toRadians;
+  double omega     = state[3] * toRadians;
+  double sinTheta  = sin( theta );
+  double cosTheta  = cos( theta );
+  double force     = actuators[0] * lpCP->forceScale -
+                     lpCP->friction * velocity;
+
+  double acceleration =
+    ( force + lpCP->loadMass * sinTheta *
+      ( craneGravity * cosTheta + lpCP->ropeLength * omega * omega ) ) /
+    ( lpCP->cartMass + lpCP->loadMass * sinTheta * sinTheta );
+
+  double angularAcceleration =
+    -( acceleration * cosTheta + craneGravity * sinTheta ) /
+    lpCP->ropeLength;
+
+  derivatives[0] = velocity;
+  derivatives[1] = acceleration;
+  derivatives[2] = state[3];
+  derivatives[3] = angularAcceleration / toRadians;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// CraneMeasure
+//
+// Purpose: Measurements of the crane for data/crane.fcl: the
+//          distance to the target and the rope angle in degrees
+//
+// Arguments: see FCL_PlantMeasure
+//
+// Return: status
+//--------------------------------------------------------------
+static int CraneMeasure( void* arg, double t, const double* state,
+			 double* measurements ) {
+
+  measurements[0] = -state[0];
+  measurements[1] =  state[2];
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FCL_CranePlant
+//
+// Purpose: The container crane plant of data/crane.fcl
+//
+// Arguments: plant : set to the crane
+//
+// Return: status
+//--------------------------------------------------------------
+int FCL_CranePlant( FuzzyPlant* plant ) {
+
+  plant->name = "crane";
+
+  plant->stateNames.clear();
+  plant->stateNames.push_back( "position" );
+  plant->stateNames.push_back( "velocity" );
+  plant->stateNames.push_back( "angle" );
+  plant->stateNames.push_back( "angular_velocity" );
+
+  plant->measurementNames.clear();
+  plant->measurementNames.push_back( "distance" );
+  plant->measurementNames.push_back( "angle" );
+
+  plant->actuatorNames.clear();
+  plant->actuatorNames.push_back( "power" );
+
+  plant->derivatives      = CraneDerivatives;
+  plant->measure          = CraneMeasure;
+  plant->arg              = &craneParameters;
+  plant->errorMeasurement = 0;
+  plant->settleBand       = 0.5;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FCL_FindPlant
+//
+// Purpose: A built-in plant by name
+//
+// Arguments: name  : plant name
+//            plant : set to the plant
+//
+// Return: status
+//--------------------------------------------------------------
+int FCL_FindPlant( const string& name, FuzzyPlant* plant ) {
+
+  if ( name == "crane" ) {
+    return FCL_CranePlant( plant );
+  }
+  ErrMsg( "FCL_FindPlant() Unknown plant", name, -1 );
+  return -1;
+}
@@ -0,0 +1,148 @@
+#ifndef Fuzzy_Simulate_H
+#define Fuzzy_Simulate_H
+
+#include "FuzzyControl.h"
+
+// Default simulated time, integration step and controller period
+#define FCL_SIM_END_TIME       60.
+#define FCL_SIM_TIME_STEP      0.01
+#define FCL_SIM_CONTROL_PERIOD 0.1
+
+// ODE integrators
+enum simIntegrator { SimEuler,
+		     SimHeun,
+		     SimRK4 };
+
+// Plant callbacks, called concurrently from the simulation threads,
+// so arg must not be changed. Return status, nonzero stops the
+// scenario.
+//
+//   derivatives : d state / dt of nStates values, from the state and
+//                 the held actuator values
+//   measure     : measurements of the state, the controller inputs
+typedef int (*FCL_PlantDerivatives)( void* arg, double t,
+				     const double* state,
+				     const double* actuators,
+				     double* derivatives );
+typedef int (*FCL_PlantMeasure)( void* arg, double t,
+				 const double* state,
+				 double* measurements );
+
+//---------------------------------------------------------------------
+// struct FuzzyPlant
+//
+// Purpose: A plant model for the closed loop. Measurements are
+//          matched by name to controller inputs, actuators to
+//          controller outputs. The error measurement is driven to 0,
+//          settling time and overshoot are taken from it.
+//---------------------------------------------------------------------
+struct FuzzyPlant {
+  string name;
+
+  vector< string > stateNames;
+  vector< string > measurementNames;
+  vector< string > actuatorNames;
+
+  FCL_PlantDerivatives derivatives;
+  FCL_PlantMeasure     measure;
+  void*                arg;
+
+  int    errorMeasurement; // index into measurementNames
+  double settleBand;       // |error| band of a settled loop
+};
+
+//---------------------------------------------------------------------
+// struct FuzzyScenario
+//
+// Purpose: A closed loop run: the initial state, and a constant
+//          disturbance added to each state derivative
+//---------------------------------------------------------------------
+struct FuzzyScenario {
+  vector< double > initial;
+  vector< double > disturbance;
+};
+
+// Results of a scenario, in FuzzySimulateClass::Results
+enum simResult { SimSettled,      // 1 if the loop ends in the band
+		 SimSettlingTime, // time of the last exit from the band,
+		                  // NaN if the loop does not settle
+		 SimOvershoot,    // largest error past 0, from the side
+		                  // opposite the initial error
+		 SimEffort,       // integral of the sum of |actuators|
+		 SimFinalError,
+		 SimNumResults };
+
+//---------------------------------------------------------------------
+// class FuzzySimulateClass
+//
+// Purpose: Run a controller in closed loop with a plant for many
+//          scenarios. The controller is evaluated every
+//          ControlPeriod() on the measurements, its outputs are held
+//          over the integration steps of TimeStep() in between. The
+//          scenarios are spread over the FCL_ParallelFor() thread
+//          pool, one model clone per thread.
+//
+//          Scenario files are delimited, with the column names on
+//          the first line: a state name is its initial value, d_ and
+//          a state name its disturbance, others are ignored.
+//---------------------------------------------------------------------
+class FuzzySimulateClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC; // the parsed controller, not changed
+
+  // Model clones, one per thread
+  vector< FuzzyControlClass* > Workers;
+
+  // Output state of the parsed controller, the start of each scenario
+  vector< double > initialOutputs;
+
+  FuzzyPlant    plant;
+  vector< int > measurementInput; // controller input handle, or -1
+  vector< int > actuatorOutput;   // controller output handle
+
+  int    integrator;
+  double endTime;
+  double timeStep;
+  double controlPeriod;
+
+  vector< FuzzyScenario > Scenarios;
+
+  // SimNumResults values of each scenario, status of each scenario
+  vector< double > Results;
+  vector< int >    Failed;
+
+  int Step( double t, double h, double* state, const double* actuators,
+	    const double* disturbance, double* work );
+
+ public:
+  // Encapsulation methods for protected variables
+  int     Integrator()    const { return integrator; }
+  int    &Integrator()          { return integrator; }
+  double  EndTime()       const { return endTime; }
+  double &EndTime()             { return endTime; }
+  double  TimeStep()      const { return timeStep; }
+  double &TimeStep()            { return timeStep; }
+  double  ControlPeriod() const { return controlPeriod; }
+  double &ControlPeriod()       { return controlPeriod; }
+
+  int NumScenarios() const { return Scenarios.size(); }
+
+  // FuzzySimulate Methods
+  FuzzySimulateClass( FuzzyControlClass* lpFC, const FuzzyPlant& plant );
+  ~FuzzySimulateClass();
+
+  int Link            ();
+  int ReadScenarioFile( string* fileName );
+  int Simulate        ();
+  int WriteResults    ( string* fileName );
+  void SimulateScenario( int threadIndex, int scenario );
+};
+
+// Built-in plants, by name: crane
+int FCL_FindPlant ( const string& name, FuzzyPlant* plant );
+int FCL_CranePlant( FuzzyPlant* plant );
+
+#endif
@@ -0,0 +1,436 @@
+#include "FuzzySummary.h"
+
+//--------------------------------------------------------------
+// SummaryChunks
+//
+// Purpose: FCL_ParallelFor() worker for Run(), the items are the
+//          chunks of input rows
+//
+// Arguments: arg         : pointer to the FuzzySummaryClass
+//            threadIndex : model clone of the thread
+//            begin, end  : range of chunks
+//
+// Return:
+//--------------------------------------------------------------
+static void SummaryChunks( void* arg, int threadIndex, int begin, int end ) {
+
+  FuzzySummaryClass* lpSummary = (FuzzySummaryClass*) arg;
+
+  for ( int chunk = begin; chunk < end; chunk++ ) {
+    lpSummary->EvaluateChunk( threadIndex, chunk );
+  }
+}
+
+//--------------------------------------------------------------
+// FuzzySummaryClass
+//
+// Purpose: Constructor for FuzzySummaryClass, the histogram range
+//          of each output
+//
+// Arguments: lpFC : the parsed model
+//
+// Return:
+//--------------------------------------------------------------
+FuzzySummaryClass::FuzzySummaryClass( FuzzyControlClass* lpFC ) {
+
+  status     = 0;
+  this->lpFC = lpFC;
+  nBins      = FCL_SUMMARY_BINS;
+  nRows      = 0;
+  chunkSize  = FCL_SUMMARY_CHUNK;
+
+  map< string, FuzzyOutputTerm* >::const_iterator oti;
+  for ( int k = 0; k < lpFC->NumOutputs(); k++ ) {
+    const FuzzyOutputClass* lpFOC = lpFC->OutputVariablesVector()[k];
+    double lower = lpFOC->minOut;
+    double upper = lpFOC->maxOut;
+
+    // Without a RANGE the span of the term points
+    if ( lower <= -1.E12 or upper >= 1.E12 ) {
+      bool first = true;
+      for ( oti = lpFOC->OutputTerms.begin();
+	    oti != lpFOC->OutputTerms.end(); ++oti ) {
+	const FuzzyOutputTerm* lpFOT = oti->second;
+	vector< double > x;
+	if ( lpFOT->termType == Singleton ) {
+	  x.push_back( lpFOT->singleton.x );
+	}
+	for ( unsigned int i = 0; i < lpFOT->xy.size(); i++ ) {
+	  x.push_back( lpFOT->xy[i]->x );
+	}
+	for ( unsigned int i = 0; i < x.size(); i++ ) {
+	  if ( first or x[i] < lower ) lower = x[i];
+	  if ( first or x[i] > upper ) upper = x[i];
+	  first = false;
+	}
+      }
+    }
+    binLower.push_back( lower );
+    binUpper.push_back( upper );
+  }
+
+  map< string, FuzzyRuleClass* >::const_iterator fri;
+  for ( fri = lpFC->RulesMap().begin(); fri != lpFC->RulesMap().end();
+	++fri ) {
+    ruleNames.push_back( fri->first );
+  }
+}
+
+//--------------------------------------------------------------
+// ~FuzzySummaryClass
+//
+// Purpose: Destructor for FuzzySummaryClass, delete the model
+//          clones
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzySummaryClass::~FuzzySummaryClass() {
+
+  for ( int i = 0; i < (int) Workers.size(); i++ ) {
+    delete Workers[i];
+  }
+}
+
+//--------------------------------------------------------------
+// Clear
+//
+// Purpose: Empty an accumulator, sized for the model
+//
+// Arguments: lpAccumulator
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzySummaryClass::Clear( FuzzySummaryAccumulator* lpAccumulator ) {
+
+  int nOutputs = lpFC->NumOutputs();
+
+  lpAccumulator->nRows   = 0;
+  lpAccumulator->nFailed = 0;
+  lpAccumulator->mean.assign     ( nOutputs, 0. );
+  lpAccumulator->m2.assign       ( nOutputs, 0. );
+  lpAccumulator->minimum.assign  ( nOutputs, 0. );
+  lpAccumulator->maximum.assign  ( nOutputs, 0. );
+  lpAccumulator->histogram.assign( nOutputs * nBins, 0 );
+  lpAccumulator->exceeded.assign ( Exceedances.size(), 0 );
+  lpAccumulator->fired.assign    ( ruleNames.size(), 0 );
+}
+
+//--------------------------------------------------------------
+// Merge
+//
+// Purpose: Add the statistics of a chunk to a total, the mean and
+//          squared deviations are combined by the pairwise update
+//          of Chan et al.
+//
+// Arguments: lpTotal : accumulator, updated
+//            chunk   : accumulator of the following rows
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzySummaryClass::Merge( FuzzySummaryAccumulator* lpTotal,
+			       const FuzzySummaryAccumulator& chunk ) {
+
+  double nA = lpTotal->nRows - lpTotal->nFailed;
+  double nB = chunk.nRows    - chunk.nFailed;
+
+  if ( nB > 0 ) {
+    for ( unsigned int k = 0; k < lpTotal->mean.size(); k++ ) {
+      if ( nA == 0 ) {
+	lpTotal->mean[k]    = chunk.mean[k];
+	lpTotal->m2[k]      = chunk.m2[k];
+	lpTotal->minimum[k] = chunk.minimum[k];
+	lpTotal->maximum[k] = chunk.maximum[k];
+	continue;
+      }
+      double delta = chunk.mean[k] - lpTotal->mean[k];
+      lpTotal->mean[k] += delta * nB / ( nA + nB );
+      lpTotal->m2[k]   += chunk.m2[k] + delta * delta * nA * nB / ( nA + nB );
+      if ( chunk.minimum[k] < lpTotal->minimum[k] ) {
+	lpTotal->minimum[k] = chunk.minimum[k];
+      }
+      if ( chunk.maximum[k] > lpTotal->maximum[k] ) {
+	lpTotal->maximum[k] = chunk.maximum[k];
+      }
+    }
+  }
+  lpTotal->nRows   += chunk.nRows;
+  lpTotal->nFailed += chunk.nFailed;
+
+  for ( unsigned int i = 0; i < lpTotal->histogram.size(); i++ ) {
+    lpTotal->histogram[i] += chunk.histogram[i];
+  }
+  for ( unsigned int i = 0; i < lpTotal->exceeded.size(); i++ ) {
+    lpTotal->exceeded[i] += chunk.exceeded[i];
+  }
+  for ( unsigned int i = 0; i < lpTotal->fired.size(); i++ ) {
+    lpTotal->fired[i] += chunk.fired[i];
+  }
+}
+
+//--------------------------------------------------------------
+// AddExceedance
+//
+// Purpose: Count the rows where an output is above a threshold
+//
+// Arguments: varName   : VAR_OUTPUT variable
+//            threshold
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySummaryClass::AddExceedance( const string& varName,
+				      double threshold ) {
+
+  FuzzyExceedance exceedance;
+  exceedance.output    = lpFC->OutputHandle( varName );
+  exceedance.threshold = threshold;
+  if ( exceedance.output < 0 ) {
+    status = -1;
+    ErrMsg( "AddExceedance() No output variable", varName, status );
+    return status;
+  }
+  Exceedances.push_back( exceedance );
+  return 0;
+}
+
+//--------------------------------------------------------------
+// ReadInputDataFile
+//
+// Purpose: Read the input data with the ReadInputDataFile() of
+//          the model
+//
+// Arguments: fileName : input data file
+//
+// Return: Number of rows read, or error code
+//--------------------------------------------------------------
+int FuzzySummaryClass::ReadInputDataFile( string* fileName ) {
+
+  int nInputs = lpFC->NumInputs();
+
+  nRows = lpFC->ReadInputDataFile( fileName );
+  if ( nRows < 1 ) {
+    ErrMsg( "Summary input data file has no data", *fileName, -1 );
+    return -1;
+  }
+
+  Inputs.assign( nRows * nInputs, 0. );
+  for ( int j = 0; j < nInputs; j++ ) {
+    const string& varName = lpFC->InputVariablesVector()[j]->varName;
+    map< string, vector< double >* >::const_iterator idi =
+      lpFC->InputDataMap().find( varName );
+    if ( idi == lpFC->InputDataMap().end() or
+	 (int) idi->second->size() < nRows ) {
+      ErrMsg( "Summary input data file has no column for input",
+	      varName, -1 );
+      return -1;
+    }
+    for ( int r = 0; r < nRows; r++ ) {
+      Inputs[ r * nInputs + j ] = (*idi->second)[r];
+    }
+  }
+  return nRows;
+}
+
+//--------------------------------------------------------------
+// EvaluateChunk
+//
+// Purpose: Evaluate the rows of a chunk in order on the model
+//          clone of the thread, from the initial output state, into
+//          the accumulator of the chunk
+//
+// Arguments: threadIndex : index into Workers
+//            chunk       : chunk of chunkSize rows
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzySummaryClass::EvaluateChunk( int threadIndex, int chunk ) {
+
+  FuzzyControlClass*           lpModel   = Workers[ threadIndex ];
+  vector< FuzzyOutputClass* > &outputs   = lpModel->OutputVariablesVector();
+  vector< double >            &strengths = WorkerStrengths[ threadIndex ];
+  FuzzySummaryAccumulator     &total     = chunkAccumulators[ chunk ];
+  int                          nInputs   = lpModel->NumInputs();
+  int                          nOutputs  = outputs.size();
+
+  Clear( &total );
+  for ( int k = 0; k < nOutputs; k++ ) {
+    outputs[k]->defuzzOut = initialOutputs[k];
+  }
+
+  int begin = chunk * chunkSize;
+  int end   = begin + chunkSize < nRows ? begin + chunkSize : nRows;
+  for ( int row = begin; row < end; row++ ) {
+    total.nRows++;
+    if ( lpModel->SetInputs( &Inputs[ row * nInputs ] ) != 0 or
+	 lpModel->Evaluate() != 0 ) {
+      total.nFailed++;
+      continue;
+    }
+
+    double n = total.nRows - total.nFailed;
+    for ( int k = 0; k < nOutputs; k++ ) {
+      double value = outputs[k]->defuzzOut;
+      double delta = value - total.mean[k];
+      total.mean[k] += delta / n;
+      total.m2[k]   += delta * ( value - total.mean[k] );
+      if ( n == 1 or value < total.minimum[k] ) total.minimum[k] = value;
+      if ( n == 1 or value > total.maximum[k] ) total.maximum[k] = value;
+
+      double span = binUpper[k] - binLower[k];
+      int    bin  = span > 0. ?
+	(int) ( ( value - binLower[k] ) / span * nBins ) : 0;
+      if ( bin < 0 )      bin = 0;
+      if ( bin >= nBins ) bin = nBins - 1;
+      total.histogram[ k * nBins + bin ]++;
+    }
+    for ( unsigned int e = 0; e < Exceedances.size(); e++ ) {
+      if ( outputs[ Exceedances[e].output ]->defuzzOut >
+	   Exceedances[e].threshold ) {
+	total.exceeded[e]++;
+      }
+    }
+    if ( not strengths.empty() ) {
+      lpModel->GetRuleStrengths( &strengths[0] );
+      for ( unsigned int r = 0; r < strengths.size(); r++ ) {
+	if ( strengths[r] > 0. ) total.fired[r]++;
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------
+// Run
+//
+// Purpose: Evaluate the chunks of input rows on the
+//          FCL_ParallelFor() thread pool, merge the accumulators
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySummaryClass::Run() {
+
+  int nThreads = FCL_NumThreads();
+
+  if ( nRows < 1 or nBins < 1 ) {
+    status = -1;
+    ErrMsg( "Run() No input data or histogram bins for", lpFC->FCLFile(),
+	    status );
+    return status;
+  }
+
+  // A model clone per thread, from one parsed model
+  status = FCL_CloneModels( lpFC, nThreads, &Workers );
+  if ( status != 0 ) {
+    ErrMsg( "Run() Failed to clone model", lpFC->FCLFile(), status );
+    return status;
+  }
+  WorkerStrengths.resize( Workers.size(),
+			  vector< double >( ruleNames.size(), 0. ) );
+  initialOutputs.assign( lpFC->NumOutputs(), 0. );
+  lpFC->GetOutputs( &initialOutputs[0] );
+
+  // The rows of a model with an NC output are a series
+  chunkSize = FCL_SUMMARY_CHUNK;
+  for ( int k = 0; k < lpFC->NumOutputs(); k++ ) {
+    if ( lpFC->OutputVariablesVector()[k]->defaultNC ) {
+      chunkSize = nRows;
+    }
+  }
+  int nChunks = ( nRows + chunkSize - 1 ) / chunkSize;
+  chunkAccumulators.assign( nChunks, FuzzySummaryAccumulator() );
+
+  status = FCL_ParallelFor( nChunks, 1, SummaryChunks, this,
+			    Workers.size() );
+  if ( status != 0 ) {
+    ErrMsg( "Run() Failed to evaluate rows of", lpFC->FCLFile(), status );
+    return status;
+  }
+
+  Clear( &Total );
+  for ( int c = 0; c < nChunks; c++ ) {
+    Merge( &Total, chunkAccumulators[c] );
+  }
+  chunkAccumulators.clear();
+  return 0;
+}
+
+//--------------------------------------------------------------
+// WriteSummary
+//
+// Purpose: Write the summary, sections of comma separated rows
+//          after a # line: the statistics of each output, the
+//          histograms, the exceedances and the most fired rules
+//
+// Arguments: fileName : summary file
+//            topRules : number of most fired rules, all if < 0
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySummaryClass::WriteSummary( string* fileName, int topRules ) {
+
+  ofstream SummaryStream;
+  int  nOutputs  = lpFC->NumOutputs();
+  long nSummary  = Total.nRows - Total.nFailed;
+
+  SummaryStream.open( fileName->c_str(), ios::out );
+  if ( not SummaryStream ) {
+    ErrMsg( "Failed to open summary file:", *fileName, -1 );
+    return -1;
+  }
+
+  SummaryStream << "# outputs, rows " << Total.nRows << ", failed "
+		<< Total.nFailed << endl;
+  SummaryStream << "output, mean, std, min, max" << endl;
+  for ( int k = 0; k < nOutputs; k++ ) {
+    SummaryStream << lpFC->OutputVariablesVector()[k]->varName << ", "
+		  << Total.mean[k] << ", "
+		  << ( nSummary > 1 ? sqrt( Total.m2[k] / ( nSummary - 1 ) )
+		                    : 0. ) << ", "
+		  << Total.minimum[k] << ", " << Total.maximum[k] << endl;
+  }
+
+  SummaryStream << "# histogram" << endl;
+  SummaryStream << "output, lower, upper, count" << endl;
+  for ( int k = 0; k < nOutputs; k++ ) {
+    double width = ( binUpper[k] - binLower[k] ) / nBins;
+    for ( int b = 0; b < nBins; b++ ) {
+      SummaryStream << lpFC->OutputVariablesVector()[k]->varName << ", "
+		    << binLower[k] + b * width << ", "
+		    << binLower[k] + ( b + 1 ) * width << ", "
+		    << Total.histogram[ k * nBins + b ] << endl;
+    }
+  }
+
+  SummaryStream << "# exceedance" << endl;
+  SummaryStream << "output, threshold, count, fraction" << endl;
+  for ( unsigned int e = 0; e < Exceedances.size(); e++ ) {
+    SummaryStream
+      << lpFC->OutputVariablesVector()[ Exceedances[e].output ]->varName
+      << ", " << Exceedances[e].threshold << ", " << Total.exceeded[e]
+      << ", " << ( nSummary ? (double) Total.exceeded[e] / nSummary : 0. )
+      << endl;
+  }
+
+  // Rules by fired rows, the earlier rule first on a tie
+  vector< pair< long, int > > order;
+  for ( unsigned int r = 0; r < ruleNames.size(); r++ ) {
+    order.push_back( make_pair( -Total.fired[r], (int) r ) );
+  }
+  sort( order.begin(), order.end() );
+  if ( topRules >= 0 and topRules < (int) order.size() ) {
+    order.resize( topRules );
+  }
+
+  SummaryStream << "# rules" << endl;
+  SummaryStream << "rule, fired, fraction" << endl;
+  for ( unsigned int i = 0; i < order.size(); i++ ) {
+    long fired = -order[i].first;
+    SummaryStream << ruleNames[ order[i].second ] << ", " << fired << ", "
+		  << ( nSummary ? (double) fired / nSummary : 0. ) << endl;
+  }
+
+  SummaryStream.close();
+  return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef Fuzzy_Summary_H
+#define Fuzzy_Summary_H
+
+#include "FuzzyControl.h"
+
+// Input rows per thread pool work item
+#define FCL_SUMMARY_CHUNK 65536
+
+// Default number of histogram bins of an output
+#define FCL_SUMMARY_BINS 20
+
+// Default number of rules in the most fired list
+#define FCL_SUMMARY_TOP_RULES 10
+
+//---------------------------------------------------------------------
+// struct FuzzyExceedance
+//
+// Purpose: Count the rows where an output is above a threshold
+//---------------------------------------------------------------------
+struct FuzzyExceedance {
+  int    output; // output handle
+  double threshold;
+};
+
+//---------------------------------------------------------------------
+// struct FuzzySummaryAccumulator
+//
+// Purpose: Running statistics of a range of rows, mergeable. For each
+//          output the mean and sum of squared deviations (Welford),
+//          minimum, maximum and histogram; the count of each
+//          exceedance; the rows where each rule fired, a rule
+//          strength above 0.
+//---------------------------------------------------------------------
+struct FuzzySummaryAccumulator {
+  long nRows;   // rows evaluated
+  long nFailed; // rows that failed, not in the statistics
+
+  vector< double > mean;
+  vector< double > m2;
+  vector< double > minimum;
+  vector< double > maximum;
+  vector< long >   histogram; // nBins per output
+  vector< long >   exceeded;  // per Exceedances
+  vector< long >   fired;     // per rule, Rules map order
+};
+
+//---------------------------------------------------------------------
+// class FuzzySummaryClass
+//
+// Purpose: Evaluate the input rows of a model and keep only summary
+//          statistics of the outputs, without an output row per input
+//          row. The rows are evaluated in chunks on the
+//          FCL_ParallelFor() thread pool, one model clone per thread,
+//          each chunk into its own accumulator, and the accumulators
+//          are merged in chunk order, so the summary does not depend
+//          on the number of threads. A model with an NC output is
+//          evaluated as one chunk, since its rows are a series.
+//
+//          The histogram of an output spans its RANGE, or the points
+//          of its terms without a RANGE.
+//---------------------------------------------------------------------
+class FuzzySummaryClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC; // the parsed model, not changed
+
+  // Model clones and rule strengths, one per thread
+  vector< FuzzyControlClass* > Workers;
+  vector< vector< double > >   WorkerStrengths;
+
+  // Output state of the parsed model, the start of each chunk
+  vector< double > initialOutputs;
+
+  int                       nBins;
+  vector< double >          binLower;  // histogram range per output
+  vector< double >          binUpper;
+  vector< FuzzyExceedance > Exceedances;
+  vector< string >          ruleNames; // Rules map order
+
+  // Input data, nRows rows of NumInputs() values
+  int              nRows;
+  vector< double > Inputs;
+  int              chunkSize;
+
+  vector< FuzzySummaryAccumulator > chunkAccumulators;
+  FuzzySummaryAccumulator           Total;
+
+  void Clear( FuzzySummaryAccumulator* lpAccumulator );
+  void Merge( FuzzySummaryAccumulator* lpTotal,
+	      const FuzzySummaryAccumulator& chunk );
+
+ public:
+  // Encapsulation methods for protected variables
+  int  Bins() const { return nBins; }
+  int &Bins()       { return nBins; }
+  int  NumRows() const { return nRows; }
+
+  // FuzzySummary Methods
+  FuzzySummaryClass( FuzzyControlClass* lpFC );
+  ~FuzzySummaryClass();
+
+  int  AddExceedance    ( const string& varName, double threshold );
+  int  ReadInputDataFile( string* fileName );
+  int  Run              ();
+  int  WriteSummary     ( string* fileName, int topRules );
+  void EvaluateChunk    ( int threadIndex, int chunk );
+};
+
+#endif
@@ -0,0 +1,433 @@
+#include "FuzzySurface.h"
+#include <limits> // quiet_NaN
+
+//--------------------------------------------------------------
+// SurfaceRows
+//
+// Purpose: FCL_ParallelFor() worker for Evaluate(), the items are
+//          the rows of the y grid
+//
+// Arguments: arg         : pointer to the FuzzySurfaceClass
+//            threadIndex : model clone of the thread
+//            begin, end  : range of rows
+//
+// Return:
+//--------------------------------------------------------------
+static void SurfaceRows( void* arg, int threadIndex, int begin, int end ) {
+
+  FuzzySurfaceClass* lpFS = (FuzzySurfaceClass*) arg;
+
+  for ( int row = begin; row < end; row++ ) {
+    lpFS->EvaluateRow( threadIndex, row );
+  }
+}
+
+//--------------------------------------------------------------
+// FuzzySurfaceClass
+//
+// Purpose: Constructor for FuzzySurfaceClass, the inputs are fixed
+//          at the middle of their term span
+//
+// Arguments: lpFC : parsed model
+//
+// Return:
+//--------------------------------------------------------------
+FuzzySurfaceClass::FuzzySurfaceClass( FuzzyControlClass* lpFC ) {
+
+  status     = 0;
+  this->lpFC = lpFC;
+
+  for ( int axis = 0; axis < 2; axis++ ) {
+    axisInput[axis] = -1;
+    nPoints[axis]   = 1;
+    lower[axis]     = 0.;
+    upper[axis]     = 0.;
+  }
+
+  fixedInputs.assign( lpFC->NumInputs(), 0. );
+  for ( int j = 0; j < lpFC->NumInputs(); j++ ) {
+    double low = 0., high = 0.;
+    InputSpan( j, &low, &high );
+    fixedInputs[j] = 0.5 * ( low + high );
+  }
+}
+
+//--------------------------------------------------------------
+// ~FuzzySurfaceClass
+//
+// Purpose: Destructor for FuzzySurfaceClass, delete the model clones
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzySurfaceClass::~FuzzySurfaceClass() {
+
+  for ( int i = 0; i < (int) Workers.size(); i++ ) {
+    delete Workers[i];
+  }
+}
+
+//--------------------------------------------------------------
+// InputSpan
+//
+// Purpose: The smallest and largest x of the term points of an
+//          input, inputs have no RANGE
+//
+// Arguments: inputHandle  : handle of the input
+//            lower, upper : set to the span
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySurfaceClass::InputSpan( int inputHandle,
+				  double* lower, double* upper ) {
+
+  if ( inputHandle < 0 or inputHandle >= lpFC->NumInputs() ) {
+    ErrMsg( "InputSpan() Invalid input handle", inputHandle, -1 );
+    return -1;
+  }
+
+  FuzzyInputClass* lpFIC = lpFC->InputVariablesVector()[ inputHandle ];
+  map< string, FuzzyInputTerm* >::iterator fiti;
+
+  *lower =  HUGE_VAL;
+  *upper = -HUGE_VAL;
+  for ( fiti = lpFIC->InputTerms.begin();
+	fiti != lpFIC->InputTerms.end(); ++fiti ) {
+    vector< XY* >& xy = fiti->second->xy;
+    for ( unsigned int i = 0; i < xy.size(); i++ ) {
+      *lower = min( *lower, xy[i]->x );
+      *upper = max( *upper, xy[i]->x );
+    }
+  }
+  if ( *lower > *upper ) {
+    *lower = *upper = 0.;
+    ErrMsg( "InputSpan() Input has no term points", lpFIC->varName, -1 );
+    return -1;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// SetAxis
+//
+// Purpose: Grid an input along the x (0) or y (1) axis
+//
+// Arguments: axis         : 0 or 1
+//            varName      : name of the input
+//            n            : number of grid points
+//            lower, upper : grid range, the term span of the input
+//                           if lower is not below upper
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySurfaceClass::SetAxis( int axis, const string& varName, int n,
+				double lower, double upper ) {
+
+  int handle = lpFC->InputHandle( varName );
+  if ( handle < 0 ) {
+    ErrMsg( "SetAxis() Unknown input", varName, -1 );
+    return -1;
+  }
+  if ( axis < 0 or axis > 1 or n < 1 ) {
+    ErrMsg( "SetAxis() Invalid axis or number of points for", varName, -1 );
+    return -1;
+  }
+  if ( axisInput[ 1 - axis ] == handle ) {
+    ErrMsg( "SetAxis() Input is on both axes", varName, -1 );
+    return -1;
+  }
+  if ( not ( lower < upper ) ) {
+    if ( InputSpan( handle, &lower, &upper ) != 0 ) {
+      return -1;
+    }
+  }
+  axisInput[axis]   = handle;
+  nPoints[axis]     = n;
+  this->lower[axis] = lower;
+  this->upper[axis] = upper;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// SetFixedInput
+//
+// Purpose: Hold an input that is not on an axis at a value
+//
+// Arguments: varName : name of the input
+//            value   : its value
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySurfaceClass::SetFixedInput( const string& varName,
+				      double value ) {
+
+  int handle = lpFC->InputHandle( varName );
+  if ( handle < 0 ) {
+    ErrMsg( "SetFixedInput() Unknown input", varName, -1 );
+    return -1;
+  }
+  fixedInputs[ handle ] = value;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// GridValue
+//
+// Purpose: The input value of a grid point along an axis
+//
+// Arguments: axis : 0 or 1
+//            i    : grid point
+//
+// Return: input value
+//--------------------------------------------------------------
+double FuzzySurfaceClass::GridValue( int axis, int i ) const {
+
+  if ( nPoints[axis] < 2 ) {
+    return lower[axis];
+  }
+  return lower[axis] +
+         ( upper[axis] - lower[axis] ) * i / ( nPoints[axis] - 1 );
+}
+
+//--------------------------------------------------------------
+// EvaluateRow
+//
+// Purpose: Evaluate a row of the grid, the x axis at one y value,
+//          on the model clone of a thread. Each point starts from
+//          the outputs of the parsed model, so a cell does not
+//          depend on the grid around it, a failed point is NaN.
+//
+// Arguments: threadIndex : index into Workers
+//            row         : y grid point
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzySurfaceClass::EvaluateRow( int threadIndex, int row ) {
+
+  FuzzyControlClass* lpModel = Workers[ threadIndex ];
+  vector< FuzzyOutputClass* > &outputVariables =
+    lpModel->OutputVariablesVector();
+  int nInputs  = lpModel->NumInputs();
+  int nOutputs = lpModel->NumOutputs();
+  int nx       = nPoints[0];
+  int ny       = nPoints[1];
+
+  vector< double > inputs ( nx * nInputs );
+  vector< double > outputs( nx * nOutputs );
+
+  for ( int i = 0; i < nx; i++ ) {
+    double* lpInputs = &inputs[ i * nInputs ];
+    for ( int j = 0; j < nInputs; j++ ) {
+      lpInputs[j] = fixedInputs[j];
+    }
+    lpInputs[ axisInput[0] ] = GridValue( 0, i );
+    if ( axisInput[1] >= 0 ) {
+      lpInputs[ axisInput[1] ] = GridValue( 1, row );
+    }
+  }
+
+  rowFailed[ row ] = 0;
+  for ( int i = 0; i < nx; i++ ) {
+    double* lpOutputs = &outputs[ i * nOutputs ];
+    for ( int k = 0; k < nOutputs; k++ ) {
+      outputVariables[k]->defuzzOut = initialOutputs[k];
+    }
+    if ( lpModel->SetInputs( &inputs[ i * nInputs ] ) != 0 or
+	 lpModel->Evaluate() != 0 ) {
+      for ( int k = 0; k < nOutputs; k++ ) {
+	lpOutputs[k] = numeric_limits< double >::quiet_NaN();
+      }
+      rowFailed[ row ]++;
+      continue;
+    }
+    lpModel->GetOutputs( lpOutputs );
+  }
+
+  for ( int k = 0; k < nOutputs; k++ ) {
+    double* lpSurface = &Surface[ ( k * ny + row ) * nx ];
+    for ( int i = 0; i < nx; i++ ) {
+      lpSurface[i] = outputs[ i * nOutputs + k ];
+    }
+  }
+}
+
+//--------------------------------------------------------------
+// Evaluate
+//
+// Purpose: Evaluate the grid on the FCL_ParallelFor() thread pool
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySurfaceClass::Evaluate() {
+
+  int nThreads = FCL_NumThreads();
+
+  if ( axisInput[0] < 0 ) {
+    status = -1;
+    ErrMsg( "Evaluate() No x axis input for surface of",
+	    lpFC->FCLFile(), status );
+    return status;
+  }
+  if ( nPoints[0] > FCL_SURFACE_MAX_POINTS / nPoints[1] ) {
+    status = -1;
+    ErrMsg( "Evaluate() Surface has more points than",
+	    FCL_SURFACE_MAX_POINTS, status );
+    return status;
+  }
+
+  // A model clone per thread, from one parsed model
+  status = FCL_CloneModels( lpFC, nThreads, &Workers );
+  if ( status != 0 ) {
+    ErrMsg( "Evaluate() Failed to clone model", lpFC->FCLFile(), status );
+    return status;
+  }
+  initialOutputs.assign( lpFC->NumOutputs(), 0. );
+  lpFC->GetOutputs( &initialOutputs[0] );
+
+  Surface.assign( lpFC->NumOutputs() * nPoints[1] * nPoints[0], 0. );
+  rowFailed.assign( nPoints[1], 0 );
+
+  status = FCL_ParallelFor( nPoints[1], 1, SurfaceRows, this,
+			    Workers.size() );
+  if ( status != 0 ) {
+    ErrMsg( "Evaluate() Failed to evaluate surface of",
+	    lpFC->FCLFile(), status );
+    return status;
+  }
+
+  int nFailed = 0;
+  for ( int row = 0; row < nPoints[1]; row++ ) {
+    nFailed += rowFailed[ row ];
+  }
+  if ( nFailed ) {
+    ConsoleMsg( "Evaluate() Grid points failed, set to NaN, in",
+		lpFC->FCLFile(), nFailed );
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// WriteCSV
+//
+// Purpose: Write the surface of each output to baseName.output.csv,
+//          a matrix with the x grid in the first row and the y grid
+//          in the first column
+//
+// Arguments: baseName : output file name without .output.csv
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySurfaceClass::WriteCSV( string* baseName ) {
+
+  int nx = nPoints[0];
+  int ny = nPoints[1];
+
+  for ( int k = 0; k < lpFC->NumOutputs(); k++ ) {
+    const string& varName = lpFC->OutputVariablesVector()[k]->varName;
+    string   fileName = *baseName + "." + varName + ".csv";
+    ofstream SurfaceStream;
+
+    SurfaceStream.open( fileName.c_str(), ios::out );
+    if ( not SurfaceStream ) {
+      ErrMsg( "Failed to open surface file:", fileName, -1 );
+      return -1;
+    }
+    SurfaceStream.precision( 10 );
+
+    // Corner label: the row (y) input, then the column (x) input
+    if ( axisInput[1] >= 0 ) {
+      SurfaceStream << lpFC->InputVariablesVector()[ axisInput[1] ]->varName
+		    << " \\ ";
+    }
+    SurfaceStream << lpFC->InputVariablesVector()[ axisInput[0] ]->varName;
+    for ( int i = 0; i < nx; i++ ) {
+      SurfaceStream << ", " << GridValue( 0, i );
+    }
+    SurfaceStream << endl;
+
+    for ( int row = 0; row < ny; row++ ) {
+      const double* lpSurface = &Surface[ ( k * ny + row ) * nx ];
+      SurfaceStream << GridValue( 1, row );
+      for ( int i = 0; i < nx; i++ ) {
+	SurfaceStream << ", " << lpSurface[i];
+      }
+      SurfaceStream << "\n";
+    }
+    SurfaceStream.close();
+    if ( SurfaceStream.fail() ) {
+      ErrMsg( "Failed to write surface file:", fileName, -1 );
+      return -1;
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// WriteBinary
+//
+// Purpose: Write the surface of each output to baseName.output.bin,
+//          ny rows of nx doubles, and the axes, fixed inputs and
+//          output files to baseName.grid
+//
+// Arguments: baseName : output file name without the extension
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySurfaceClass::WriteBinary( string* baseName ) {
+
+  int nx = nPoints[0];
+  int ny = nPoints[1];
+
+  string   gridFileName = *baseName + ".grid";
+  ofstream GridStream;
+
+  GridStream.open( gridFileName.c_str(), ios::out );
+  if ( not GridStream ) {
+    ErrMsg( "Failed to open surface grid file:", gridFileName, -1 );
+    return -1;
+  }
+  GridStream.precision( 17 );
+
+  for ( int axis = 0; axis < 2; axis++ ) {
+    if ( axisInput[axis] < 0 ) {
+      continue;
+    }
+    GridStream << ( axis == 0 ? "x " : "y " )
+	       << lpFC->InputVariablesVector()[ axisInput[axis] ]->varName
+	       << " " << lower[axis] << " " << upper[axis]
+	       << " " << nPoints[axis] << endl;
+  }
+  for ( int j = 0; j < lpFC->NumInputs(); j++ ) {
+    if ( j == axisInput[0] or j == axisInput[1] ) {
+      continue;
+    }
+    GridStream << "fixed " << lpFC->InputVariablesVector()[j]->varName
+	       << " " << fixedInputs[j] << endl;
+  }
+
+  for ( int k = 0; k < lpFC->NumOutputs(); k++ ) {
+    const string& varName = lpFC->OutputVariablesVector()[k]->varName;
+    string   fileName = *baseName + "." + varName + ".bin";
+    ofstream SurfaceStream;
+
+    SurfaceStream.open( fileName.c_str(), ios::out | ios::binary );
+    if ( not SurfaceStream ) {
+      ErrMsg( "Failed to open surface file:", fileName, -1 );
+      return -1;
+    }
+    SurfaceStream.write( (const char*) &Surface[ k * ny * nx ],
+			 sizeof( double ) * ny * nx );
+    SurfaceStream.close();
+    if ( SurfaceStream.fail() ) {
+      ErrMsg( "Failed to write surface file:", fileName, -1 );
+      return -1;
+    }
+    GridStream << "output " << varName << " " << fileName << endl;
+  }
+
+  GridStream.close();
+  return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef Fuzzy_Surface_H
+#define Fuzzy_Surface_H
+
+#include "FuzzyControl.h"
+
+// Default number of grid points along an axis
+#define FCL_SURFACE_POINTS 101
+
+// Largest number of grid points of a surface
+#define FCL_SURFACE_MAX_POINTS 100000000
+
+//---------------------------------------------------------------------
+// class FuzzySurfaceClass
+//
+// Purpose: Evaluate a model over a regular grid of one or two of its
+//          inputs, the control surface of each output, for plotting
+//          and review. The other inputs are held at fixed values,
+//          the middle of their term span by default. The grid rows
+//          are evaluated on the FCL_ParallelFor() thread pool, one
+//          model clone per thread, each grid point from the output
+//          state of the parsed model.
+//
+//          WriteCSV() writes a matrix per output, the first row is
+//          the x grid and the first column the y grid, with the
+//          corner cell named "y \ x". WriteBinary() writes the ny
+//          rows of nx doubles of each output, native byte order,
+//          and a .grid text file of the axes.
+//---------------------------------------------------------------------
+class FuzzySurfaceClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC; // the parsed model, not changed
+
+  // Model clones, one per thread
+  vector< FuzzyControlClass* > Workers;
+
+  // Output state of the parsed model, the start of each grid point
+  vector< double > initialOutputs;
+
+  // x and y axis: input handle, -1 for no y axis, grid points, range
+  int    axisInput[2];
+  int    nPoints[2];
+  double lower[2];
+  double upper[2];
+
+  vector< double > fixedInputs; // NumInputs() values off the axes
+
+  // Outputs, NumOutputs() surfaces of ny rows of nx values, NaN
+  // where the evaluation failed
+  vector< double > Surface;
+  vector< int >    rowFailed;
+
+  double GridValue( int axis, int i ) const;
+
+ public:
+  // Encapsulation methods for protected variables
+  int NumX() const { return nPoints[0]; }
+  int NumY() const { return nPoints[1]; }
+
+  // FuzzySurface Methods
+  FuzzySurfaceClass( FuzzyControlClass* lpFC );
+  ~FuzzySurfaceClass();
+
+  int InputSpan    ( int inputHandle, double* lower, double* upper );
+  int SetAxis      ( int axis, const string& varName, int n,
+		     double lower, double upper );
+  int SetFixedInput( const string& varName, double value );
+  int Evaluate     ();
+  int WriteCSV     ( string* baseName );
+  int WriteBinary  ( string* baseName );
+  void EvaluateRow ( int threadIndex, int row );
+};
+
+#endif
@@ -0,0 +1,612 @@
+#include "FuzzySweep.h"
+#include <cstring> // strchr
+
+//--------------------------------------------------------------
+// SweepVariant
+//
+// Purpose: FCL_ParallelFor() worker for Sweep(), the items are the
+//          variants
+//
+// Arguments: arg         : pointer to the FuzzySweepClass
+//            threadIndex : model clone of the thread
+//            begin, end  : range of variants
+//
+// Return:
+//--------------------------------------------------------------
+static void SweepVariant( void* arg, int threadIndex, int begin, int end ) {
+
+  FuzzySweepClass* lpFS = (FuzzySweepClass*) arg;
+
+  for ( int v = begin; v < end; v++ ) {
+    lpFS->EvaluateVariant( threadIndex, v );
+  }
+}
+
+//--------------------------------------------------------------
+// Trim
+//
+// Purpose: Remove leading and trailing whitespace
+//
+// Arguments: text
+//
+// Return: trimmed text
+//--------------------------------------------------------------
+static string Trim( const string& text ) {
+
+  const string& whitespace = " \t\r\n";
+
+  string::size_type first = text.find_first_not_of( whitespace );
+  if ( first == string::npos ) {
+    return string();
+  }
+  return text.substr( first,
+		      text.find_last_not_of( whitespace ) - first + 1 );
+}
+
+//--------------------------------------------------------------
+// FuzzySweepClass
+//
+// Purpose: Constructor for FuzzySweepClass
+//
+// Arguments: lpFC : parsed model
+//
+// Return:
+//--------------------------------------------------------------
+FuzzySweepClass::FuzzySweepClass( FuzzyControlClass* lpFC ) {
+
+  status     = 0;
+  this->lpFC = lpFC;
+  nVariants  = 0;
+  nRows      = 0;
+}
+
+//--------------------------------------------------------------
+// ~FuzzySweepClass
+//
+// Purpose: Destructor for FuzzySweepClass, delete the model clones
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzySweepClass::~FuzzySweepClass() {
+
+  for ( int i = 0; i < (int) Workers.size(); i++ ) {
+    delete Workers[i];
+  }
+}
+
+//--------------------------------------------------------------
+// ReadSweepFile
+//
+// Purpose: Read the parameters and their alternatives, see
+//          FuzzySweepParameter for the format. Statements end
+//          with ';', blank and comment lines are skipped.
+//
+// Arguments: fileName : sweep file
+//
+// Return: Number of variants, or error code
+//--------------------------------------------------------------
+int FuzzySweepClass::ReadSweepFile( string* fileName ) {
+
+  ifstream SweepStream;
+  string   inputLine;
+  string   statement;
+  vector< string > statements;
+
+  SweepStream.open( fileName->c_str(), ios::in );
+  if ( not SweepStream ) {
+    ErrMsg( "Failed to open sweep file:", *fileName, -1 );
+    return -1;
+  }
+  while ( getline( SweepStream, inputLine ) ) {
+    if ( Trim( inputLine ).empty() or lpFC->CommentLine( &inputLine ) ) {
+      continue;
+    }
+    statement += " " + inputLine;
+    string::size_type semicolon;
+    while ( ( semicolon = statement.find( ';' ) ) != string::npos ) {
+      statements.push_back( Trim( statement.substr( 0, semicolon ) ) );
+      statement.erase( 0, semicolon + 1 );
+    }
+  }
+  SweepStream.close();
+  if ( not Trim( statement ).empty() ) {
+    ErrMsg( "Sweep file statement has no ';'", Trim( statement ), -1 );
+    return -1;
+  }
+
+  Parameters.clear();
+  nVariants = 1;
+
+  for ( int s = 0; s < (int) statements.size(); s++ ) {
+    FuzzySweepParameter parameter;
+    string::size_type assign = statements[s].find( ":=" );
+    if ( assign == string::npos ) {
+      ErrMsg( "Sweep statement has no ':='", statements[s], -1 );
+      return -1;
+    }
+    string left  = Trim( statements[s].substr( 0, assign ) );
+    string right = statements[s].substr( assign + 2 );
+
+    string::size_type wordEnd = left.find_first_of( " \t" );
+    string kind   = left.substr( 0, wordEnd );
+    parameter.target = wordEnd == string::npos ?
+                       string() : Trim( left.substr( wordEnd ) );
+    parameter.name   = kind + ( parameter.target.empty() ?
+				"" : " " + parameter.target );
+    parameter.isInput = false;
+    parameter.handle  = -1;
+
+    // The allowed alternatives of a method
+    const char* methods = 0;
+    if      ( kind == "TERM"    ) parameter.kind = SweepTerm;
+    else if ( kind == "DEFAULT" ) parameter.kind = SweepDefault;
+    else if ( kind == "AND"  ) { parameter.kind = SweepAnd;
+                                 methods = " MIN PROD BDIF "; }
+    else if ( kind == "OR"   ) { parameter.kind = SweepOr;
+                                 methods = " MAX ASUM BSUM "; }
+    else if ( kind == "ACT"  ) { parameter.kind = SweepAct;
+                                 methods = " MIN PROD "; }
+    else if ( kind == "ACCU" ) { parameter.kind = SweepAccu;
+                                 methods = " MAX BSUM NSUM "; }
+    else {
+      ErrMsg( "Sweep statement has an unknown parameter", kind, -1 );
+      return -1;
+    }
+
+    // The variable or rule
+    if ( parameter.kind == SweepTerm ) {
+      string::size_type dot = parameter.target.find( '.' );
+      if ( dot == string::npos ) {
+	ErrMsg( "Sweep TERM is not variable.term", parameter.target, -1 );
+	return -1;
+      }
+      parameter.termName = parameter.target.substr( dot + 1 );
+      parameter.target   = parameter.target.substr( 0, dot );
+      parameter.handle   = lpFC->InputHandle( parameter.target );
+      parameter.isInput  = ( parameter.handle >= 0 );
+      if ( not parameter.isInput ) {
+	parameter.handle = lpFC->OutputHandle( parameter.target );
+      }
+    }
+    else if ( parameter.kind == SweepAccu or
+	      parameter.kind == SweepDefault ) {
+      parameter.handle = lpFC->OutputHandle( parameter.target );
+    }
+    else if ( not parameter.target.empty() and
+	      not lpFC->RulesMap().count( parameter.target ) ) {
+      ErrMsg( "Sweep statement has an unknown rule", parameter.name, -1 );
+      return -1;
+    }
+    if ( parameter.kind == SweepTerm or parameter.kind == SweepAccu or
+	 parameter.kind == SweepDefault ) {
+      if ( parameter.handle < 0 ) {
+	ErrMsg( "Sweep statement has an unknown variable",
+		parameter.name, -1 );
+	return -1;
+      }
+    }
+
+    // The alternatives, separated by '|'
+    string::size_type begin = 0;
+    while ( begin <= right.length() ) {
+      string::size_type end = right.find( '|', begin );
+      string alternative = Trim( right.substr( begin, end == string::npos ?
+					       string::npos : end - begin ) );
+      if ( alternative.empty() ) {
+	ErrMsg( "Sweep statement has an empty alternative",
+		parameter.name, -1 );
+	return -1;
+      }
+
+      vector< double > x, y;
+      double value = 0.;
+
+      if ( parameter.kind == SweepTerm ) {
+	// (x, y) points, or the x of an output Singleton
+	vector< double > numbers;
+	const char* lpText = alternative.c_str();
+	while ( *lpText ) {
+	  char* lpEnd = 0;
+	  double number = strtod( lpText, &lpEnd );
+	  if ( lpEnd != lpText ) {
+	    numbers.push_back( number );
+	    lpText = lpEnd;
+	  }
+	  else if ( strchr( " \t(),", *lpText ) ) {
+	    lpText++;
+	  }
+	  else {
+	    ErrMsg( "Sweep TERM has invalid points", alternative, -1 );
+	    return -1;
+	  }
+	}
+	if ( numbers.size() == 1 ) {
+	  x.push_back( numbers[0] );
+	  y.push_back( 1. );
+	}
+	else if ( numbers.size() and numbers.size() % 2 == 0 ) {
+	  for ( unsigned int i = 0; i < numbers.size(); i += 2 ) {
+	    x.push_back( numbers[i] );
+	    y.push_back( numbers[i+1] );
+	  }
+	}
+	else {
+	  ErrMsg( "Sweep TERM has invalid points", alternative, -1 );
+	  return -1;
+	}
+	// no ',' in a summary column
+	string::size_type comma;
+	while ( ( comma = alternative.find( ',' ) ) != string::npos ) {
+	  if ( comma + 1 < alternative.length() and
+	       alternative[ comma + 1 ] == ' ' ) {
+	    alternative.erase( comma, 1 );
+	  }
+	  else {
+	    alternative[ comma ] = ' ';
+	  }
+	}
+      }
+      else if ( parameter.kind == SweepDefault ) {
+	if ( alternative != "NC" ) {
+	  char* lpEnd = 0;
+	  value = strtod( alternative.c_str(), &lpEnd );
+	  if ( *lpEnd ) {
+	    ErrMsg( "Sweep DEFAULT is not a number or NC", alternative, -1 );
+	    return -1;
+	  }
+	}
+      }
+      else if ( string( methods ).find( " " + alternative + " " ) ==
+		string::npos ) {
+	ErrMsg( "Sweep statement has an invalid method " + alternative,
+		parameter.name, -1 );
+	return -1;
+      }
+
+      parameter.labels.push_back( alternative );
+      parameter.x.push_back( x );
+      parameter.y.push_back( y );
+      parameter.value.push_back( value );
+
+      if ( end == string::npos ) break;
+      begin = end + 1;
+    }
+
+    if ( nVariants > FCL_SWEEP_MAX_VARIANTS /
+	 (int) parameter.labels.size() ) {
+      ErrMsg( "Sweep has more variants than", FCL_SWEEP_MAX_VARIANTS, -1 );
+      return -1;
+    }
+    nVariants *= parameter.labels.size();
+    Parameters.push_back( parameter );
+  }
+
+  if ( Parameters.empty() ) {
+    ErrMsg( "Sweep file has no parameters", *fileName, -1 );
+    return -1;
+  }
+  return nVariants;
+}
+
+//--------------------------------------------------------------
+// ReadInputDataFile
+//
+// Purpose: Read the input data once for every variant, with
+//          FuzzyControlClass::ReadInputDataFile() of the model
+//
+// Arguments: fileName : input data file
+//
+// Return: Number of rows read, or error code
+//--------------------------------------------------------------
+int FuzzySweepClass::ReadInputDataFile( string* fileName ) {
+
+  int nInputs = lpFC->NumInputs();
+
+  nRows = lpFC->ReadInputDataFile( fileName );
+  if ( nRows < 1 ) {
+    ErrMsg( "Sweep input data file has no data", *fileName, -1 );
+    return -1;
+  }
+
+  Inputs.assign( nRows * nInputs, 0. );
+  for ( int j = 0; j < nInputs; j++ ) {
+    const string& varName = lpFC->InputVariablesVector()[j]->varName;
+    map< string, vector< double >* >::const_iterator idi =
+      lpFC->InputDataMap().find( varName );
+    if ( idi == lpFC->InputDataMap().end() or
+	 (int) idi->second->size() < nRows ) {
+      ErrMsg( "Sweep input data file has no column for input", varName, -1 );
+      return -1;
+    }
+    for ( int r = 0; r < nRows; r++ ) {
+      Inputs[ r * nInputs + j ] = (*idi->second)[r];
+    }
+  }
+  return nRows;
+}
+
+//--------------------------------------------------------------
+// ApplyVariant
+//
+// Purpose: Set every sweep parameter of a model clone to its
+//          alternative in a variant
+//
+// Arguments: lpModel : model clone
+//            variant : variant number
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySweepClass::ApplyVariant( FuzzyControlClass* lpModel,
+				   int variant ) {
+
+  int status = 0;
+  map< string, FuzzyRuleClass* >::iterator fri;
+
+  // The last parameter varies fastest
+  for ( int p = (int) Parameters.size() - 1; p >= 0; p-- ) {
+    FuzzySweepParameter& parameter = Parameters[p];
+    int nAlternatives = parameter.labels.size();
+    int a = variant % nAlternatives;
+    variant /= nAlternatives;
+
+    FCL_keyword* keyword = 0;
+    if ( parameter.kind != SweepTerm and parameter.kind != SweepDefault ) {
+      keyword = lpModel->FindFCLKeywordFromMap( parameter.labels[a], true );
+      if ( not keyword ) {
+	return -1;
+      }
+    }
+
+    switch ( parameter.kind ) {
+      case SweepTerm:
+	if ( parameter.isInput ) {
+	  status = lpModel->SetInputTermPoints( parameter.handle,
+						parameter.termName,
+						&parameter.x[a][0],
+						&parameter.y[a][0],
+						parameter.x[a].size() );
+	}
+	else {
+	  status = lpModel->SetOutputTermPoints( parameter.handle,
+						 parameter.termName,
+						 &parameter.x[a][0],
+						 &parameter.y[a][0],
+						 parameter.x[a].size() );
+	}
+	break;
+
+      case SweepAnd:
+      case SweepOr:
+      case SweepAct:
+	for ( fri = lpModel->RulesMap().begin();
+	      fri != lpModel->RulesMap().end(); ++fri ) {
+	  if ( not parameter.target.empty() and
+	       fri->first != parameter.target ) {
+	    continue;
+	  }
+	  if      ( parameter.kind == SweepAnd ) fri->second->andMethod = keyword;
+	  else if ( parameter.kind == SweepOr  ) fri->second->orMethod  = keyword;
+	  else                                   fri->second->actMethod = keyword;
+	}
+	break;
+
+      case SweepAccu:
+	lpModel->OutputVariablesVector()[ parameter.handle ]->accumulation =
+	  keyword;
+	break;
+
+      case SweepDefault: {
+	FuzzyOutputClass* lpFOC =
+	  lpModel->OutputVariablesVector()[ parameter.handle ];
+	if ( parameter.labels[a] == "NC" ) {
+	  lpFOC->defaultNC = lpModel->keyword_NC;
+	}
+	else {
+	  lpFOC->defaultNC  = 0;
+	  lpFOC->defaultOut = parameter.value[a];
+	}
+	break;
+      }
+    };
+
+    if ( status != 0 ) {
+      ErrMsg( "ApplyVariant() Failed to set " + parameter.name,
+	      parameter.labels[a], status );
+      return status;
+    }
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// EvaluateVariant
+//
+// Purpose: Apply a variant to the model clone of a thread, evaluate
+//          the input data and keep the summary of the outputs. A
+//          variant that can not be applied fails every row.
+//
+// Arguments: threadIndex : index into Workers
+//            variant     : variant number
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzySweepClass::EvaluateVariant( int threadIndex, int variant ) {
+
+  FuzzyControlClass* lpModel = Workers[ threadIndex ];
+  vector< FuzzyOutputClass* > &outputVariables = 
+    lpModel->OutputVariablesVector();
+  int nInputs  = lpModel->NumInputs();
+  int nOutputs = lpModel->NumOutputs();
+  int counted  = 0;
+
+  vector< double > outputs( nOutputs );
+  vector< double > sum   ( nOutputs, 0. );
+  vector< double > sumSq ( nOutputs, 0. );
+  vector< double > least ( nOutputs,  HUGE_VAL );
+  vector< double > most  ( nOutputs, -HUGE_VAL );
+
+  Failed[ variant ] = 0;
+  if ( ApplyVariant( lpModel, variant ) != 0 ) {
+    Failed[ variant ] = nRows;
+  }
+  else {
+    // The rows of a variant are a series from the parsed model
+    // outputs, not from the variant the worker ran before
+    for ( int k = 0; k < nOutputs; k++ ) {
+      outputVariables[k]->defuzzOut = initialOutputs[k];
+    }
+    for ( int r = 0; r < nRows; r++ ) {
+      if ( lpModel->SetInputs( &Inputs[ r * nInputs ] ) != 0 or
+	   lpModel->Evaluate() != 0 ) {
+	Failed[ variant ]++;
+	continue;
+      }
+      lpModel->GetOutputs( &outputs[0] );
+      for ( int k = 0; k < nOutputs; k++ ) {
+	sum[k]   += outputs[k];
+	sumSq[k] += outputs[k] * outputs[k];
+	least[k]  = min( least[k], outputs[k] );
+	most[k]   = max( most[k],  outputs[k] );
+      }
+      counted++;
+    }
+  }
+
+  double* lpSummary = &Summary[ variant * nOutputs * 4 ];
+  for ( int k = 0; k < nOutputs; k++ ) {
+    double mean     = counted ? sum[k] / counted : 0.;
+    double variance = counted ? sumSq[k] / counted - mean * mean : 0.;
+    lpSummary[ 4 * k     ] = mean;
+    lpSummary[ 4 * k + 1 ] = variance > 0. ? sqrt( variance ) : 0.;
+    lpSummary[ 4 * k + 2 ] = counted ? least[k] : 0.;
+    lpSummary[ 4 * k + 3 ] = counted ? most[k]  : 0.;
+  }
+}
+
+//--------------------------------------------------------------
+// Sweep
+//
+// Purpose: Evaluate every variant over the input data on the
+//          FCL_ParallelFor() thread pool
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySweepClass::Sweep() {
+
+  int nThreads = FCL_NumThreads();
+
+  if ( Parameters.empty() or nRows < 1 ) {
+    status = -1;
+    ErrMsg( "Sweep() No sweep file or input data for",
+	    lpFC->FCLFile(), status );
+    return status;
+  }
+
+  // A model clone per thread, from one parsed model
+  status = FCL_CloneModels( lpFC, nThreads, &Workers );
+  if ( status != 0 ) {
+    ErrMsg( "Sweep() Failed to clone model", lpFC->FCLFile(), status );
+    return status;
+  }
+  initialOutputs.assign( lpFC->NumOutputs(), 0. );
+  lpFC->GetOutputs( &initialOutputs[0] );
+
+  // Check the TERM alternatives once, rather than in every variant
+  for ( int p = 0; p < (int) Parameters.size(); p++ ) {
+    FuzzySweepParameter& parameter = Parameters[p];
+    if ( parameter.kind != SweepTerm ) {
+      continue;
+    }
+    for ( int a = 0; a < (int) parameter.labels.size(); a++ ) {
+      if ( parameter.isInput ) {
+	status = Workers[0]->SetInputTermPoints( parameter.handle,
+						 parameter.termName,
+						 &parameter.x[a][0],
+						 &parameter.y[a][0],
+						 parameter.x[a].size() );
+      }
+      else {
+	status = Workers[0]->SetOutputTermPoints( parameter.handle,
+						  parameter.termName,
+						  &parameter.x[a][0],
+						  &parameter.y[a][0],
+						  parameter.x[a].size() );
+      }
+      if ( status != 0 ) {
+	ErrMsg( "Sweep() Invalid " + parameter.name,
+		parameter.labels[a], status );
+	return status;
+      }
+    }
+  }
+
+  Summary.assign( nVariants * lpFC->NumOutputs() * 4, 0. );
+  Failed.assign( nVariants, 0 );
+
+  status = FCL_ParallelFor( nVariants, 1, SweepVariant, this,
+			    Workers.size() );
+  if ( status != 0 ) {
+    ErrMsg( "Sweep() Failed to evaluate variants", lpFC->FCLFile(), status );
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// WriteSummary
+//
+// Purpose: Write a row per variant: the variant number, the
+//          alternative of each parameter, the mean, standard
+//          deviation, min and max of each output, and the number
+//          of input rows that failed
+//
+// Arguments: fileName : summary file
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzySweepClass::WriteSummary( string* fileName ) {
+
+  ofstream SummaryStream;
+  int nOutputs = lpFC->NumOutputs();
+
+  SummaryStream.open( fileName->c_str(), ios::out );
+  if ( not SummaryStream ) {
+    ErrMsg( "Failed to open sweep summary file:", *fileName, -1 );
+    return -1;
+  }
+
+  SummaryStream << "variant";
+  for ( int p = 0; p < (int) Parameters.size(); p++ ) {
+    SummaryStream << ", " << Parameters[p].name;
+  }
+  for ( int k = 0; k < nOutputs; k++ ) {
+    const string& varName = lpFC->OutputVariablesVector()[k]->varName;
+    SummaryStream << ", " << varName << "_mean, " << varName << "_std, "
+		  << varName << "_min, " << varName << "_max";
+  }
+  SummaryStream << ", failed" << endl;
+
+  for ( int v = 0; v < nVariants; v++ ) {
+    SummaryStream << v;
+    int variant = v;
+    vector< string > labels( Parameters.size() );
+    for ( int p = (int) Parameters.size() - 1; p >= 0; p-- ) {
+      int nAlternatives = Parameters[p].labels.size();
+      labels[p] = Parameters[p].labels[ variant % nAlternatives ];
+      variant  /= nAlternatives;
+    }
+    for ( int p = 0; p < (int) Parameters.size(); p++ ) {
+      SummaryStream << ", " << labels[p];
+    }
+    for ( int i = 0; i < nOutputs * 4; i++ ) {
+      SummaryStream << ", " << Summary[ v * nOutputs * 4 + i ];
+    }
+    SummaryStream << ", " << Failed[v] << endl;
+  }
+
+  SummaryStream.close();
+  return 0;
+}
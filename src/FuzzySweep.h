@@ -0,0 +1,102 @@
+#ifndef Fuzzy_Sweep_H
+#define Fuzzy_Sweep_H
+
+#include "FuzzyControl.h"
+
+// Largest number of variants of a sweep
+#define FCL_SWEEP_MAX_VARIANTS 10000000
+
+// Parameter kinds of a sweep file line
+enum sweepKind { SweepTerm,
+		 SweepAnd,
+		 SweepOr,
+		 SweepAct,
+		 SweepAccu,
+		 SweepDefault };
+
+//---------------------------------------------------------------------
+// struct FuzzySweepParameter
+//
+// Purpose: A line of the sweep file, a model parameter and its
+//          alternative values
+//
+//          TERM var.term := (x, y) ... | (x, y) ... ;  term points
+//          TERM var.term := 25 | 30 ;                  output Singleton
+//          AND  [rule]   := MIN | PROD ;               every rule, or one
+//          OR   [rule]   := MAX | ASUM ;
+//          ACT  [rule]   := MIN | PROD ;
+//          ACCU var      := MAX | BSUM | NSUM ;
+//          DEFAULT var   := 0 | 50 | NC ;
+//---------------------------------------------------------------------
+struct FuzzySweepParameter {
+  int    kind;     // sweepKind
+  string name;     // summary column name
+  string target;   // variable, or rule name of AND/OR/ACT, empty for all
+  string termName; // TERM
+  bool   isInput;  // TERM of an input variable
+  int    handle;   // input or output handle of target
+
+  vector< string > labels; // each alternative, as in the summary
+
+  // TERM points, DEFAULT value, of each alternative
+  vector< vector< double > > x;
+  vector< vector< double > > y;
+  vector< double >           value;
+};
+
+//---------------------------------------------------------------------
+// class FuzzySweepClass
+//
+// Purpose: Evaluate variants of a model over one input data set, for
+//          sensitivity studies. The variants are every combination
+//          of the sweep file alternatives, the first line varies
+//          slowest. The FCL file is parsed and the input data read
+//          once, each thread evaluates its variants on a model clone
+//          loaded from a SaveModel() image. A summary row of the
+//          outputs is kept for each variant.
+//---------------------------------------------------------------------
+class FuzzySweepClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC; // the parsed model, not changed
+
+  // Model clones, one per thread
+  vector< FuzzyControlClass* > Workers;
+
+  // Output state of the parsed model, the start of each variant
+  vector< double > initialOutputs;
+
+  vector< FuzzySweepParameter > Parameters;
+  int nVariants;
+
+  // Input data, nRows rows of NumInputs() values
+  int              nRows;
+  vector< double > Inputs;
+
+  // Summary of each variant: mean, standard deviation, min and max
+  // of each output, and the number of rows that failed
+  vector< double > Summary;
+  vector< int >    Failed;
+
+  int ApplyVariant( FuzzyControlClass* lpModel, int variant );
+
+ public:
+  // Encapsulation methods for protected variables
+  int NumParameters() const { return Parameters.size(); }
+  int NumVariants()   const { return nVariants; }
+  int NumRows()       const { return nRows; }
+
+  // FuzzySweep Methods
+  FuzzySweepClass( FuzzyControlClass* lpFC );
+  ~FuzzySweepClass();
+
+  int ReadSweepFile    ( string* fileName );
+  int ReadInputDataFile( string* fileName );
+  int Sweep            ();
+  int WriteSummary     ( string* fileName );
+  void EvaluateVariant ( int threadIndex, int variant );
+};
+
+#endif
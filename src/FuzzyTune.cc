@@ -0,0 +1,654 @@
+#include "FuzzyTune.h"
+#include <sstream> // parameter names
+
+//--------------------------------------------------------------
+// struct TuneChunkArg
+//
+// Purpose: Shared argument to the TuneChunk() workers
+//--------------------------------------------------------------
+struct TuneChunkArg {
+  FuzzyTuneClass* lpFT;
+  int             batchBegin; // first sample of the batch
+};
+
+//--------------------------------------------------------------
+// TuneChunk
+//
+// Purpose: FCL_ParallelFor() worker for BatchGradient(), the items
+//          are the samples of the batch, one chunk per call
+//
+// Arguments: arg         : pointer to TuneChunkArg
+//            threadIndex : model clone of the thread
+//            begin, end  : range of samples in the batch
+//
+// Return:
+//--------------------------------------------------------------
+static void TuneChunk( void* arg, int threadIndex, int begin, int end ) {
+
+  TuneChunkArg* lpTCA = (TuneChunkArg*) arg;
+
+  lpTCA->lpFT->EvaluateChunk( threadIndex, begin / FCL_TUNE_CHUNK,
+			      lpTCA->batchBegin + begin,
+			      lpTCA->batchBegin + end );
+}
+
+//--------------------------------------------------------------
+// AddParameter
+//
+// Purpose: Append a parameter of the first worker model, or the
+//          value and seed of the same parameter in a later one
+//
+// Arguments: Parameters : the parameters
+//            worker     : index of the worker model
+//            p          : index of the parameter, incremented
+//            parameter  : name, links, scale and bounds
+//            value      : the parameter in the worker model
+//            seed       : its OutputTangents() seed
+//
+// Return: status
+//--------------------------------------------------------------
+static int AddParameter( vector< FuzzyTuneParameter >* Parameters,
+			 int worker, int* p,
+			 const FuzzyTuneParameter& parameter,
+			 double* value, const TangentSeed& seed ) {
+
+  if ( worker == 0 ) {
+    Parameters->push_back( parameter );
+  }
+  else if ( *p >= (int) Parameters->size() or
+	    (*Parameters)[*p].name != parameter.name ) {
+    ErrMsg( "AddParameters() Model clone differs at", parameter.name, -1 );
+    return -1;
+  }
+  (*Parameters)[*p].value.push_back( value );
+  (*Parameters)[*p].seed.push_back( seed );
+  (*p)++;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// FuzzyTuneClass
+//
+// Purpose: Constructor for FuzzyTuneClass
+//
+// Arguments: lpFC : parsed model to tune
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyTuneClass::FuzzyTuneClass( FuzzyControlClass* lpFC ) {
+
+  status     = 0;
+  this->lpFC = lpFC;
+  nSamples   = 0;
+  epochs     = FCL_TUNE_EPOCHS;
+  batchSize  = 0;
+  rate       = FCL_TUNE_RATE;
+
+  Workers.push_back( lpFC );
+}
+
+//--------------------------------------------------------------
+// ~FuzzyTuneClass
+//
+// Purpose: Destructor for FuzzyTuneClass, delete the model clones
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyTuneClass::~FuzzyTuneClass() {
+
+  for ( int i = 1; i < (int) Workers.size(); i++ ) {
+    delete Workers[i];
+  }
+}
+
+//--------------------------------------------------------------
+// ReadTrainingFile
+//
+// Purpose: Buffer the training data, same file format as
+//          FuzzyControlClass::ReadInputDataFile(), with a column
+//          for every input and a target column for the outputs
+//          to fit. Other columns are ignored. A .gz file is
+//          decompressed on its own thread as it is read.
+//
+// Arguments: fileName   : training data file
+//            delimeters : column delimeters
+//
+// Return: Number of samples read, or error code
+//--------------------------------------------------------------
+int FuzzyTuneClass::ReadTrainingFile( string* fileName,
+				      string* delimeters ) {
+
+  FuzzyGzipBufferClass InputBuffer; // InputDataStream of a .gz file
+  ifstream InputDataStream;
+  string   inputLine;
+  vector< string > inputWords;
+
+  const string& whitespace = " \t\r\n";
+
+  int nInputs  = lpFC->NumInputs();
+  int nOutputs = lpFC->NumOutputs();
+
+  if ( FCL_OpenInputStream( &InputDataStream, *fileName, &InputBuffer ) ) {
+    ErrMsg( "Failed to open training data file:", *fileName, -1 );
+    return -1;
+  }
+
+  // Get the variable names on the first line
+  getline( InputDataStream, inputLine );
+  if ( inputLine.find_first_not_of( whitespace ) == string::npos ) {
+    ErrMsg( "Training data file first line is blank, need variable names",
+	    *fileName, -1 );
+    return -1;
+  }
+  string::size_type CRPosition = inputLine.find( '\r' );
+  if ( CRPosition != string::npos ) {
+    inputLine.erase( CRPosition, 1 );
+  }
+  status = lpFC->SplitLine( &inputWords, &inputLine, delimeters );
+  if ( status != 0 ) {
+    ErrMsg( "Failed to split variable names from training data file:",
+	    *fileName, -2 );
+    return -2;
+  }
+
+  // Column of each input and output
+  vector< int > inputColumns ( nInputs,  -1 );
+  vector< int > outputColumns( nOutputs, -1 );
+  for ( int i = 0; i < (int) inputWords.size(); i++ ) {
+    for ( int j = 0; j < nInputs; j++ ) {
+      if ( inputWords[i] == lpFC->InputVariablesVector()[j]->varName ) {
+	inputColumns[j] = i;
+      }
+    }
+    for ( int k = 0; k < nOutputs; k++ ) {
+      if ( inputWords[i] == lpFC->OutputVariablesVector()[k]->varName ) {
+	outputColumns[k] = i;
+      }
+    }
+  }
+  for ( int j = 0; j < nInputs; j++ ) {
+    if ( inputColumns[j] < 0 ) {
+      ErrMsg( "Training data file has no column for input",
+	      lpFC->InputVariablesVector()[j]->varName, -1 );
+      return -1;
+    }
+  }
+  fitOutput.assign( nOutputs, false );
+  bool anyOutput = false;
+  for ( int k = 0; k < nOutputs; k++ ) {
+    fitOutput[k] = ( outputColumns[k] >= 0 );
+    anyOutput    = anyOutput or fitOutput[k];
+  }
+  if ( not anyOutput ) {
+    ErrMsg( "Training data file has no output column", *fileName, -1 );
+    return -1;
+  }
+
+  Inputs.clear();
+  Targets.clear();
+  nSamples = 0;
+
+  // Now read each line and get the inputs and targets
+  while ( not InputDataStream.eof() and InputDataStream.good() ) {
+
+    getline( InputDataStream, inputLine );
+
+    if ( inputLine.find_first_not_of( whitespace ) == string::npos ) {
+      continue; // no content
+    }
+    if ( lpFC->CommentLine( &inputLine ) ) {
+      continue;
+    }
+    CRPosition = inputLine.find( '\r' );
+    if ( CRPosition != string::npos ) {
+      inputLine.erase( CRPosition, 1 );
+    }
+
+    inputWords.clear();
+    status = lpFC->SplitLine( &inputWords, &inputLine, delimeters );
+    if ( status != 0 or inputWords.empty() ) {
+      continue;
+    }
+    for ( int j = 0; j < nInputs; j++ ) {
+      double value = 0.;
+      if ( inputColumns[j] < (int) inputWords.size() ) {
+	value = atof( inputWords[ inputColumns[j] ].c_str() );
+      }
+      Inputs.push_back( value );
+    }
+    for ( int k = 0; k < nOutputs; k++ ) {
+      double value = 0.;
+      if ( fitOutput[k] and outputColumns[k] < (int) inputWords.size() ) {
+	value = atof( inputWords[ outputColumns[k] ].c_str() );
+      }
+      Targets.push_back( value );
+    }
+    nSamples++;
+  }
+
+  if ( FCL_CloseStream( &InputDataStream, &InputBuffer ) != 0 ) {
+    ErrMsg( "Failed to read training data file:", *fileName, -1 );
+    return -1;
+  }
+  return nSamples;
+}
+
+//--------------------------------------------------------------
+// AddParameters
+//
+// Purpose: Find the tuned parameters of a worker model: the points
+//          of the Triangle, Ramp and Trapezoid terms, the output
+//          Singletons and the conclusion weights. Rectangle and
+//          input Singleton terms are not tuned. A point equal to
+//          the previous point of its term is tied to it.
+//
+// Arguments: lpModel : worker model
+//            worker  : its index in Workers
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyTuneClass::AddParameters( FuzzyControlClass* lpModel,
+				   int worker ) {
+
+  int p = 0;
+  int i;
+
+  map <string, FuzzyInputTerm*>  :: iterator fti;
+  map <string, FuzzyOutputTerm*> :: iterator oti;
+  map <string, FuzzyRuleClass*>  :: iterator fri;
+
+  for ( int j = 0; j < lpModel->NumInputs(); j++ ) {
+    FuzzyInputClass* lpFIC = lpModel->InputVariablesVector()[j];
+
+    // the span of the term points
+    double low  =  HUGE_VAL;
+    double high = -HUGE_VAL;
+    for ( fti = lpFIC->InputTerms.begin();
+	  fti != lpFIC->InputTerms.end(); ++fti ) {
+      for ( i = 0; i < (int) fti->second->xy.size(); i++ ) {
+	low  = min( low,  fti->second->xy[i]->x );
+	high = max( high, fti->second->xy[i]->x );
+      }
+    }
+
+    for ( fti = lpFIC->InputTerms.begin();
+	  fti != lpFIC->InputTerms.end(); ++fti ) {
+      FuzzyInputTerm* fit = fti->second;
+      if ( fit->termType == Rectangle or fit->termType == Singleton or
+	   fit->xy.size() > 4 ) {
+	continue;
+      }
+      for ( i = 0; i < (int) fit->xy.size(); i++ ) {
+	FuzzyTuneParameter parameter;
+	ostringstream name;
+	name << lpFIC->varName << "." << fit->termName << "[" << i << "]";
+	parameter.name     = name.str();
+	parameter.previous = i ? p - 1 : -1;
+	parameter.tiedTo   = -1;
+	if ( i and fit->xy[i]->x == fit->xy[i-1]->x ) {
+	  parameter.tiedTo = Parameters[p-1].tiedTo < 0 ?
+	                     p - 1 : Parameters[p-1].tiedTo;
+	}
+	parameter.scale = high > low ? high - low : 1.;
+	parameter.lower = -HUGE_VAL;
+	parameter.upper =  HUGE_VAL;
+
+	TangentSeed seed = { 0, fit, 0, 0, i };
+	status = AddParameter( &Parameters, worker, &p, parameter,
+			       &(fit->xy[i]->x), seed );
+	if ( status != 0 ) return status;
+      }
+    }
+  }
+
+  for ( int k = 0; k < lpModel->NumOutputs(); k++ ) {
+    FuzzyOutputClass* lpFOC = lpModel->OutputVariablesVector()[k];
+    double span = lpFOC->maxOut - lpFOC->minOut;
+
+    for ( oti = lpFOC->OutputTerms.begin();
+	  oti != lpFOC->OutputTerms.end(); ++oti ) {
+      FuzzyOutputTerm* lpFOT = oti->second;
+
+      if ( lpFOT->termType == Singleton ) {
+	FuzzyTuneParameter parameter;
+	parameter.name     = lpFOC->varName + "." + lpFOT->termName;
+	parameter.previous = -1;
+	parameter.tiedTo   = -1;
+	parameter.scale    = span > 0. ? span : 1.;
+	parameter.lower    = lpFOC->minOut;
+	parameter.upper    = lpFOC->maxOut;
+
+	TangentSeed seed = { 0, 0, lpFOT, 0, 0 };
+	status = AddParameter( &Parameters, worker, &p, parameter,
+			       &(lpFOT->singleton.x), seed );
+	if ( status != 0 ) return status;
+	continue;
+      }
+      if ( lpFOT->termType == Rectangle or lpFOT->xy.size() > 4 ) {
+	continue;
+      }
+      for ( i = 0; i < (int) lpFOT->xy.size(); i++ ) {
+	FuzzyTuneParameter parameter;
+	ostringstream name;
+	name << lpFOC->varName << "." << lpFOT->termName << "[" << i << "]";
+	parameter.name     = name.str();
+	parameter.previous = i ? p - 1 : -1;
+	parameter.tiedTo   = -1;
+	if ( i and lpFOT->xy[i]->x == lpFOT->xy[i-1]->x ) {
+	  parameter.tiedTo = Parameters[p-1].tiedTo < 0 ?
+	                     p - 1 : Parameters[p-1].tiedTo;
+	}
+	parameter.scale = span > 0. ? span : 1.;
+	parameter.lower = -HUGE_VAL;
+	parameter.upper =  HUGE_VAL;
+
+	TangentSeed seed = { 0, 0, lpFOT, 0, i };
+	status = AddParameter( &Parameters, worker, &p, parameter,
+			       &(lpFOT->xy[i]->x), seed );
+	if ( status != 0 ) return status;
+      }
+    }
+  }
+
+  for ( fri = lpModel->RulesMap().begin();
+	fri != lpModel->RulesMap().end(); ++fri ) {
+    FuzzyRuleClass* lpFRC = fri->second;
+    for ( i = 0; i < (int) lpFRC->Conclusions.size(); i++ ) {
+      Conclusion* lpConc = lpFRC->Conclusions[i];
+      FuzzyTuneParameter parameter;
+      parameter.name     = lpFRC->ruleName + "." +
+	                   lpConc->outputVariable->varName;
+      parameter.previous = -1;
+      parameter.tiedTo   = -1;
+      parameter.scale    = 1.;
+      parameter.lower    = 0.;
+      parameter.upper    = 1.;
+
+      TangentSeed seed = { 0, 0, 0, lpConc, 0 };
+      status = AddParameter( &Parameters, worker, &p, parameter,
+			     &(lpConc->weight), seed );
+      if ( status != 0 ) return status;
+    }
+  }
+
+  if ( p != (int) Parameters.size() ) {
+    ErrMsg( "AddParameters() Model clone differs", worker, -1 );
+    return -1;
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Project
+//
+// Purpose: Keep the parameters valid after a step: the points of
+//          a term increase, a tied point follows its point, the
+//          weights are in [0, 1] and the output Singletons in
+//          RANGE. Copy the values to every worker model.
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyTuneClass::Project() {
+
+  for ( int p = 0; p < (int) Parameters.size(); p++ ) {
+    FuzzyTuneParameter& parameter = Parameters[p];
+    double value = *(parameter.value[0]);
+
+    if ( parameter.tiedTo >= 0 ) {
+      value = *(Parameters[ parameter.tiedTo ].value[0]);
+    }
+    else {
+      value = max( parameter.lower, min( parameter.upper, value ) );
+      if ( parameter.previous >= 0 ) {
+	double least = *(Parameters[ parameter.previous ].value[0]) +
+	               FCL_TUNE_GAP * parameter.scale;
+	if ( value < least ) {
+	  value = least;
+	}
+      }
+    }
+    for ( int w = 0; w < (int) parameter.value.size(); w++ ) {
+      *(parameter.value[w]) = value;
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------
+// EvaluateChunk
+//
+// Purpose: Sum the loss and its gradient over the samples
+//          [begin, end) on the model of a thread, each sample from
+//          the outputs of the parsed model
+//
+// Arguments: threadIndex : index into Workers
+//            chunk       : index of the chunk sums
+//            begin, end  : range of samples
+//
+// Return:
+//--------------------------------------------------------------
+void FuzzyTuneClass::EvaluateChunk( int threadIndex, int chunk,
+				    int begin, int end ) {
+
+  FuzzyControlClass* lpModel  = Workers[ threadIndex ];
+  vector< FuzzyOutputClass* > &outputVariables =
+    lpModel->OutputVariablesVector();
+  vector< double >&  sum      = chunkGradient[ chunk ];
+  vector< double >&  outputs  = threadOutputs[ threadIndex ];
+  vector< double >&  tangents = threadTangents[ threadIndex ];
+  int nInputs  = lpModel->NumInputs();
+  int nOutputs = lpModel->NumOutputs();
+
+  vector< double > dLoss( nOutputs ); // d loss / d output
+
+  sum.assign( Parameters.size(), 0. );
+  chunkLoss[ chunk ]    = 0.;
+  chunkSamples[ chunk ] = 0;
+
+  for ( int s = begin; s < end; s++ ) {
+    for ( int k = 0; k < nOutputs; k++ ) {
+      outputVariables[k]->defuzzOut = initialOutputs[k];
+    }
+    if ( lpModel->EvaluateTangents( &Inputs[ s * nInputs ] ) != 0 or
+	 lpModel->GetOutputs( &outputs[0] ) != 0 ) {
+      continue; // the sample is not counted
+    }
+
+    for ( int k = 0; k < nOutputs; k++ ) {
+      dLoss[k] = 0.;
+      if ( fitOutput[k] ) {
+	double error = ( outputs[k] - Targets[ s * nOutputs + k ] ) /
+	               outputScale[k];
+	chunkLoss[ chunk ] += error * error;
+	dLoss[k] = 2. * error / outputScale[k];
+      }
+    }
+
+    for ( int p = 0; p < (int) Parameters.size(); p++ ) {
+      if ( lpModel->OutputTangents( &(Parameters[p].seed[ threadIndex ]),
+				    &tangents[0] ) != 0 ) {
+	continue;
+      }
+      for ( int k = 0; k < nOutputs; k++ ) {
+	sum[p] += dLoss[k] * tangents[k];
+      }
+    }
+    chunkSamples[ chunk ]++;
+  }
+}
+
+//--------------------------------------------------------------
+// BatchGradient
+//
+// Purpose: Mean loss of the samples [begin, end), and its gradient
+//          with respect to the free parameters in gradient. The
+//          gradient of a tied point is added to its point.
+//
+// Arguments: begin, end : range of samples
+//            loss       : mean loss
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyTuneClass::BatchGradient( int begin, int end, double* loss ) {
+
+  int nChunks = ( end - begin + FCL_TUNE_CHUNK - 1 ) / FCL_TUNE_CHUNK;
+  int counted = 0;
+
+  chunkGradient.resize( nChunks );
+  chunkLoss.resize( nChunks );
+  chunkSamples.resize( nChunks );
+
+  TuneChunkArg arg;
+  arg.lpFT       = this;
+  arg.batchBegin = begin;
+
+  status = FCL_ParallelFor( end - begin, FCL_TUNE_CHUNK, TuneChunk, &arg,
+			    Workers.size() );
+  if ( status != 0 ) {
+    ErrMsg( "BatchGradient() Failed to evaluate samples", begin, status );
+    return status;
+  }
+
+  // Sum the chunks in order
+  gradient.assign( Parameters.size(), 0. );
+  *loss = 0.;
+  for ( int c = 0; c < nChunks; c++ ) {
+    for ( int p = 0; p < (int) Parameters.size(); p++ ) {
+      gradient[p] += chunkGradient[c][p];
+    }
+    *loss   += chunkLoss[c];
+    counted += chunkSamples[c];
+  }
+  if ( not counted ) {
+    status = -1;
+    ErrMsg( "BatchGradient() No sample evaluated from", begin, status );
+    return status;
+  }
+
+  *loss /= counted;
+  for ( int p = (int) Parameters.size() - 1; p >= 0; p-- ) {
+    gradient[p] /= counted;
+    if ( Parameters[p].tiedTo >= 0 ) {
+      gradient[ Parameters[p].tiedTo ] += gradient[p];
+      gradient[p] = 0.;
+    }
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// Tune
+//
+// Purpose: Fit the model to the training data. Each epoch takes
+//          the samples in file order in batches of BatchSize(),
+//          with an Adam step of Rate() times the parameter scale
+//          after each batch. The RMS scaled output error is
+//          reported as the epochs progress.
+//
+// Arguments:
+//
+// Return: status, the tuned values are in the model
+//--------------------------------------------------------------
+int FuzzyTuneClass::Tune() {
+
+  const double beta1   = 0.9;
+  const double beta2   = 0.999;
+  const double epsilon = 1.E-8;
+
+  int nThreads = FCL_NumThreads();
+  int step     = 0;
+
+  if ( nSamples < 1 ) {
+    status = -1;
+    ErrMsg( "Tune() No training data for", lpFC->FCLFile(), status );
+    return status;
+  }
+
+  // A model clone per thread
+  status = FCL_CloneModels( lpFC, nThreads, &Workers );
+  if ( status != 0 ) {
+    ErrMsg( "Tune() Failed to clone model", lpFC->FCLFile(), status );
+    return status;
+  }
+  initialOutputs.assign( lpFC->NumOutputs(), 0. );
+  lpFC->GetOutputs( &initialOutputs[0] );
+
+  Parameters.clear();
+  for ( int w = 0; w < (int) Workers.size(); w++ ) {
+    status = AddParameters( Workers[w], w );
+    if ( status != 0 ) return status;
+  }
+  if ( Parameters.empty() ) {
+    status = -1;
+    ErrMsg( "Tune() No tunable terms or rules in", lpFC->FCLFile(), status );
+    return status;
+  }
+  ConsoleMsg( "Tune() parameters", lpFC->FCLFile(), Parameters.size() );
+
+  outputScale.assign( lpFC->NumOutputs(), 1. );
+  for ( int k = 0; k < lpFC->NumOutputs(); k++ ) {
+    FuzzyOutputClass* lpFOC = lpFC->OutputVariablesVector()[k];
+    if ( lpFOC->maxOut > lpFOC->minOut ) {
+      outputScale[k] = lpFOC->maxOut - lpFOC->minOut;
+    }
+  }
+  threadOutputs.assign ( Workers.size(),
+			 vector< double >( lpFC->NumOutputs() + 1 ) );
+  threadTangents.assign( Workers.size(),
+			 vector< double >( lpFC->NumOutputs() + 1 ) );
+  moment1.assign( Parameters.size(), 0. );
+  moment2.assign( Parameters.size(), 0. );
+
+  int batch = ( batchSize > 0 and batchSize < nSamples ) ?
+              batchSize : nSamples;
+  int report = max( 1, epochs / 10 );
+
+  for ( int epoch = 1; epoch <= epochs; epoch++ ) {
+    double epochLoss = 0.;
+
+    for ( int begin = 0; begin < nSamples; begin += batch ) {
+      int    end  = min( nSamples, begin + batch );
+      double loss = 0.;
+
+      status = BatchGradient( begin, end, &loss );
+      if ( status != 0 ) return status;
+      epochLoss += loss * ( end - begin );
+
+      // Adam step
+      step++;
+      double correction1 = 1. - pow( beta1, step );
+      double correction2 = 1. - pow( beta2, step );
+      for ( int p = 0; p < (int) Parameters.size(); p++ ) {
+	if ( Parameters[p].tiedTo >= 0 ) {
+	  continue;
+	}
+	moment1[p] = beta1 * moment1[p] + (1. - beta1) * gradient[p];
+	moment2[p] = beta2 * moment2[p] +
+	             (1. - beta2) * gradient[p] * gradient[p];
+	double m = moment1[p] / correction1;
+	double v = moment2[p] / correction2;
+	*(Parameters[p].value[0]) -= rate * Parameters[p].scale * m /
+	                             ( sqrt( v ) + epsilon );
+      }
+      Project();
+    }
+
+    if ( epoch == 1 or epoch == epochs or epoch % report == 0 ) {
+      ConsoleMsg( "Tune() epoch RMS scaled error",
+		  sqrt( epochLoss / nSamples ), epoch );
+    }
+  }
+
+  // The tuned model is left as parsed, not at the last sample
+  vector< FuzzyOutputClass* > &outputVariables =
+    lpFC->OutputVariablesVector();
+  for ( int k = 0; k < lpFC->NumOutputs(); k++ ) {
+    outputVariables[k]->defuzzOut = initialOutputs[k];
+  }
+
+  return status;
+}
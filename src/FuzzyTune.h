@@ -0,0 +1,119 @@
+#ifndef Fuzzy_Tune_H
+#define Fuzzy_Tune_H
+
+#include "FuzzyControl.h"
+
+// Default number of passes over the training data
+#define FCL_TUNE_EPOCHS 100
+
+// Default Adam step, a fraction of the parameter scale
+#define FCL_TUNE_RATE 0.01
+
+// Training samples per thread pool work item
+#define FCL_TUNE_CHUNK 16
+
+// Smallest gap between tuned term points, a fraction of the scale
+#define FCL_TUNE_GAP 1.E-3
+
+//---------------------------------------------------------------------
+// struct FuzzyTuneParameter
+//
+// Purpose: A tuned value: the x of a term point, the x of an output
+//          Singleton, or a conclusion WITH weight. value and seed
+//          hold the parameter in each worker model, in Workers order.
+//---------------------------------------------------------------------
+struct FuzzyTuneParameter {
+  string name;     // variable.term[point] or rule.variable, for messages
+  int    previous; // parameter of the previous point of the term, -1
+  int    tiedTo;   // parameter of an equal previous point, it moves
+                   // with that one, -1 if the parameter is free
+  double scale;    // variable span, 1 for a weight
+  double lower;    // bounds, the points of a term stay ordered
+  double upper;
+
+  vector< double* >     value;
+  vector< TangentSeed > seed;
+};
+
+//---------------------------------------------------------------------
+// class FuzzyTuneClass
+//
+// Purpose: Fit the term points and WITH weights of a model to
+//          training data of inputs and target outputs, in the manner
+//          of ANFIS. The loss is the mean squared output error, each
+//          output scaled by its RANGE, its gradient comes from
+//          OutputTangents(). The samples of a batch are evaluated on
+//          the FCL_ParallelFor() thread pool, one model clone per
+//          thread, and the parameters are updated by Adam.
+//
+//          The model passed to the constructor is tuned in place,
+//          FuzzyControlClass::WriteFCLFile() then writes it.
+//---------------------------------------------------------------------
+class FuzzyTuneClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC; // the tuned model, Workers[0]
+
+  // lpFC and its clones, one per thread
+  vector< FuzzyControlClass* > Workers;
+
+  // Output state of the parsed model, the start of each sample
+  vector< double > initialOutputs;
+
+  vector< FuzzyTuneParameter > Parameters;
+
+  // Training data, nSamples rows of NumInputs() inputs and of
+  // NumOutputs() targets. An output without a target column is
+  // not fitted.
+  int              nSamples;
+  vector< double > Inputs;
+  vector< double > Targets;
+  vector< bool >   fitOutput;
+  vector< double > outputScale; // RANGE of each output
+
+  int    epochs;
+  int    batchSize; // samples per step, 0 for all
+  double rate;
+
+  // Mean loss gradient of the last BatchGradient(), and the Adam
+  // moments, of each parameter
+  vector< double > gradient;
+  vector< double > moment1;
+  vector< double > moment2;
+
+  // Work space, sums of each chunk of a batch, so the sums do not
+  // depend on the thread that took the chunk
+  vector< vector< double > > chunkGradient;
+  vector< double >           chunkLoss;
+  vector< int >              chunkSamples;
+  vector< vector< double > > threadOutputs;  // NumOutputs() per thread
+  vector< vector< double > > threadTangents;
+
+  int AddParameters( FuzzyControlClass* lpModel, int worker );
+  int Project();
+
+ public:
+  // Encapsulation methods for protected variables
+  int     Epochs()    const { return epochs; }
+  int    &Epochs()          { return epochs; }
+  int     BatchSize() const { return batchSize; }
+  int    &BatchSize()       { return batchSize; }
+  double  Rate()      const { return rate; }
+  double &Rate()            { return rate; }
+
+  int NumParameters() const { return Parameters.size(); }
+  int NumSamples()    const { return nSamples; }
+
+  // FuzzyTune Methods
+  FuzzyTuneClass( FuzzyControlClass* lpFC );
+  ~FuzzyTuneClass();
+
+  int ReadTrainingFile( string* fileName, string* delimeters );
+  int Tune();
+  int BatchGradient( int begin, int end, double* loss );
+  void EvaluateChunk( int threadIndex, int chunk, int begin, int end );
+};
+
+#endif
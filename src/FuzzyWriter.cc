@@ -0,0 +1,417 @@
+#include "FuzzyWriter.h"
+#include <cstring> // memcpy
+
+//---------------------------------------------------------------------
+// struct WriterFile
+//
+// Purpose: Open file state of the built-in writers
+//---------------------------------------------------------------------
+struct WriterFile {
+  FuzzyGzipBufferClass buffer; // stream of a .gz file
+  ofstream stream;
+  int      nColumns; // value columns
+};
+
+//--------------------------------------------------------------
+// OpenWriterFile
+//
+// Purpose: Allocate the state of a built-in writer, open its file,
+//          compressed if it is a .gz file
+//
+// Arguments: fileName : output file
+//            columns  : value columns
+//            mode     : ofstream open mode
+//
+// Return: the state, 0 on failure
+//--------------------------------------------------------------
+static WriterFile* OpenWriterFile( const string& fileName,
+				   const vector< string >& columns,
+				   ios::openmode mode ) {
+
+  WriterFile* lpFile = 0;
+  try {
+    lpFile = new WriterFile;
+  }
+  catch ( ... ) {
+    ErrMsg( "OpenWriterFile() Failed to allocate writer", fileName, -1 );
+    return 0;
+  }
+  lpFile->nColumns = columns.size();
+  if ( FCL_OpenOutputStream( &lpFile->stream, fileName, mode,
+			     &lpFile->buffer ) ) {
+    ErrMsg( "Failed to open output data file:", fileName, -1 );
+    delete lpFile;
+    return 0;
+  }
+  return lpFile;
+}
+
+//--------------------------------------------------------------
+// CloseWriterFile
+//
+// Purpose: Close the file of a built-in writer, free its state
+//
+// Arguments: arg : the state
+//
+// Return: status
+//--------------------------------------------------------------
+static int CloseWriterFile( void* arg ) {
+
+  WriterFile* lpFile = (WriterFile*) arg;
+  int status = FCL_CloseStream( &lpFile->stream, &lpFile->buffer );
+  delete lpFile;
+  return status;
+}
+
+//--------------------------------------------------------------
+// TextOpen, TextRow
+//
+// Purpose: text row writer, see FuzzyWriter.h
+//
+// Arguments: see FCL_WriterOpen, FCL_WriterRow
+//
+// Return: status
+//--------------------------------------------------------------
+static int TextOpen( void** arg, const string& fileName,
+		     const string& labelName,
+		     const vector< string >& columns ) {
+
+  WriterFile* lpFile = OpenWriterFile( fileName, columns, ios::out );
+  if ( not lpFile ) {
+    return -1;
+  }
+
+  lpFile->stream << "index, ";
+  if ( not labelName.empty() ) {
+    lpFile->stream << labelName << ", ";
+  }
+  for ( unsigned int i = 0; i < columns.size(); i++ ) {
+    lpFile->stream << columns[i] << ", ";
+  }
+  lpFile->stream << "\n";
+
+  *arg = lpFile;
+  return 0;
+}
+
+static int TextRow( void* arg, int index, const string* label,
+		    const double* values ) {
+
+  WriterFile* lpFile = (WriterFile*) arg;
+
+  lpFile->stream << index << ", ";
+  if ( label ) {
+    lpFile->stream << *label << ", ";
+  }
+  for ( int i = 0; i < lpFile->nColumns; i++ ) {
+    lpFile->stream << values[i] << ", ";
+  }
+  lpFile->stream << "\n";
+  return lpFile->stream.good() ? 0 : -1;
+}
+
+//--------------------------------------------------------------
+// PutBinaryString
+//
+// Purpose: Write a uint32 length and the characters of a string
+//
+// Arguments: lpStream : binary stream
+//            text
+//
+// Return:
+//--------------------------------------------------------------
+static void PutBinaryString( ofstream* lpStream, const string& text ) {
+
+  uint32_t length = text.size();
+  lpStream->write( (const char*) &length, sizeof( length ) );
+  lpStream->write( text.data(), length );
+}
+
+//--------------------------------------------------------------
+// BinaryOpen, BinaryRow
+//
+// Purpose: binary row writer, see FuzzyWriter.h
+//
+// Arguments: see FCL_WriterOpen, FCL_WriterRow
+//
+// Return: status
+//--------------------------------------------------------------
+static int BinaryOpen( void** arg, const string& fileName,
+		       const string& labelName,
+		       const vector< string >& columns ) {
+
+  WriterFile* lpFile = OpenWriterFile( fileName, columns,
+				       ios::out | ios::binary );
+  if ( not lpFile ) {
+    return -1;
+  }
+
+  char     magic[8];
+  uint32_t nColumns = columns.size();
+  uint32_t hasLabel = labelName.empty() ? 0 : 1;
+  memcpy( magic, FCL_ROWS_MAGIC, 8 );
+  lpFile->stream.write( magic, 8 );
+  lpFile->stream.write( (const char*) &nColumns, sizeof( nColumns ) );
+  lpFile->stream.write( (const char*) &hasLabel, sizeof( hasLabel ) );
+  if ( hasLabel ) {
+    PutBinaryString( &lpFile->stream, labelName );
+  }
+  for ( unsigned int i = 0; i < columns.size(); i++ ) {
+    PutBinaryString( &lpFile->stream, columns[i] );
+  }
+
+  *arg = lpFile;
+  return 0;
+}
+
+static int BinaryRow( void* arg, int index, const string* label,
+		      const double* values ) {
+
+  WriterFile* lpFile = (WriterFile*) arg;
+  int32_t     row    = index;
+
+  lpFile->stream.write( (const char*) &row, sizeof( row ) );
+  if ( label ) {
+    PutBinaryString( &lpFile->stream, *label );
+  }
+  lpFile->stream.write( (const char*) values,
+			lpFile->nColumns * sizeof( double ) );
+  return lpFile->stream.good() ? 0 : -1;
+}
+
+//--------------------------------------------------------------
+// FCL_FindWriter
+//
+// Purpose: A built-in row writer by name
+//
+// Arguments: name   : text or binary
+//            writer : set to the writer
+//
+// Return: status
+//--------------------------------------------------------------
+int FCL_FindWriter( const string& name, FuzzyWriter* writer ) {
+
+  writer->name  = name;
+  writer->close = CloseWriterFile;
+  if ( name == "text" ) {
+    writer->open = TextOpen;
+    writer->row  = TextRow;
+    return 0;
+  }
+  if ( name == "binary" ) {
+    writer->open = BinaryOpen;
+    writer->row  = BinaryRow;
+    return 0;
+  }
+  ErrMsg( "FCL_FindWriter() Unknown output format", name, -1 );
+  return -1;
+}
+
+//--------------------------------------------------------------
+// FuzzyDeltaClass
+//
+// Purpose: Constructor for FuzzyDeltaClass
+//
+// Arguments: lpFC   : the model of the series
+//            writer : output row format
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyDeltaClass::FuzzyDeltaClass( FuzzyControlClass* lpFC,
+				  const FuzzyWriter& writer ) {
+
+  status       = 0;
+  this->lpFC   = lpFC;
+  this->writer = writer;
+  arg          = 0;
+  tolerance    = 0.;
+  lastIndex    = -1;
+  pending      = false;
+  nRows        = 0;
+  nWritten     = 0;
+}
+
+//--------------------------------------------------------------
+// ~FuzzyDeltaClass
+//
+// Purpose: Destructor for FuzzyDeltaClass, close an open file
+//
+// Arguments:
+//
+// Return:
+//--------------------------------------------------------------
+FuzzyDeltaClass::~FuzzyDeltaClass() {
+
+  if ( arg ) {
+    writer.close( arg );
+  }
+}
+
+//--------------------------------------------------------------
+// Open
+//
+// Purpose: Open the output file, the columns are the outputs of
+//          the model
+//
+// Arguments: fileName : output file
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyDeltaClass::Open( string* fileName ) {
+
+  vector< string > columns;
+  for ( int k = 0; k < lpFC->NumOutputs(); k++ ) {
+    columns.push_back( lpFC->OutputVariablesVector()[k]->varName );
+  }
+  string labelName = lpFC->InputLabelsVector().empty() ?
+                     string() : lpFC->InputDataLabel();
+
+  status = writer.open( &arg, *fileName, labelName, columns );
+  if ( status != 0 ) {
+    arg = 0;
+    ErrMsg( "Open() Failed to open delta output", *fileName, status );
+    return status;
+  }
+  outputs.assign( columns.size(), 0. );
+  lastWritten.assign( columns.size(), 0. );
+  lastIndex = -1;
+  pending   = false;
+  nRows     = 0;
+  nWritten  = 0;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Write
+//
+// Purpose: Write a row of the current outputs
+//
+// Arguments: index : input data row
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyDeltaClass::Write( int index ) {
+
+  const vector< string >& labels = lpFC->InputLabelsVector();
+  const string* label = index < (int) labels.size() ? &labels[ index ] : 0;
+
+  status = writer.row( arg, index, label,
+		       outputs.empty() ? 0 : &outputs[0] );
+  if ( status != 0 ) {
+    ErrMsg( "Write() Failed to write delta output row", index, status );
+    return status;
+  }
+  lastWritten = outputs;
+  pending     = false;
+  nWritten++;
+  return 0;
+}
+
+//--------------------------------------------------------------
+// Row
+//
+// Purpose: After the evaluation of a row, write it if it is the
+//          first row or an output has changed more than
+//          Tolerance() from the last row written. A NaN output, or
+//          a NaN last written value, counts as a change.
+//
+// Arguments: index : input data row
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyDeltaClass::Row( int index ) {
+
+  if ( not arg ) {
+    status = -1;
+    ErrMsg( "Row() Delta output is not open", lpFC->FCLFile(), status );
+    return status;
+  }
+  if ( not outputs.empty() ) {
+    lpFC->GetOutputs( &outputs[0] );
+  }
+  lastIndex = index;
+  nRows++;
+
+  bool changed = nWritten == 0;
+  for ( unsigned int k = 0; k < outputs.size() and not changed; k++ ) {
+    changed = fabs( outputs[k] - lastWritten[k] ) > tolerance or
+              outputs[k] != outputs[k] or
+              lastWritten[k] != lastWritten[k];
+  }
+  if ( not changed ) {
+    pending = true;
+    return 0;
+  }
+  return Write( index );
+}
+
+//--------------------------------------------------------------
+// Close
+//
+// Purpose: Write the last row if it was not written, close the
+//          output file
+//
+// Arguments:
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyDeltaClass::Close() {
+
+  if ( not arg ) {
+    return 0;
+  }
+  status = 0;
+  if ( pending ) {
+    status = Write( lastIndex );
+  }
+  int closeStatus = writer.close( arg );
+  arg = 0;
+  if ( status == 0 and closeStatus != 0 ) {
+    status = closeStatus;
+    ErrMsg( "Close() Failed to write delta output", lpFC->FCLFile(),
+	    status );
+  }
+  return status;
+}
+
+//--------------------------------------------------------------
+// FuzzyControl_DeltaSeriesInput
+//
+// Purpose: FuzzyControl_SeriesInput() writing the changed rows
+//          with a FuzzyDeltaClass instead of WriteTimestepOutput()
+//
+// Arguments: lpFC          : the model
+//            lpDelta       : open delta output
+//            numDataPoints : number of InputData rows
+//
+// Return: status
+//--------------------------------------------------------------
+int FuzzyControl_DeltaSeriesInput( FuzzyControlClass* lpFC,
+				   FuzzyDeltaClass* lpDelta,
+				   int numDataPoints ) {
+
+  int status = 0;
+  if ( not lpFC or not lpDelta ) {
+    status = -1;
+    ErrMsg( "FuzzyControl_DeltaSeriesInput()",
+	    "Invalid FuzzyControlClass or FuzzyDeltaClass", status );
+    return status;
+  }
+
+  for ( int i = 0; i < numDataPoints; i++ ) {
+    status = lpFC->Fuzzification( i );
+    if ( status != 0 ) {
+      ErrMsg( "Fuzzification Failed.", "", status );
+      break;
+    }
+    status = lpFC->Evaluate();
+    if ( status != 0 ) {
+      break;
+    }
+    status = lpDelta->Row( i );
+    if ( status != 0 ) {
+      break;
+    }
+  }
+  return status;
+}
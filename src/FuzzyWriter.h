@@ -0,0 +1,98 @@
+#ifndef Fuzzy_Writer_H
+#define Fuzzy_Writer_H
+
+#include "FuzzyControl.h"
+
+// Binary row file magic
+#define FCL_ROWS_MAGIC "FCLROWS1"
+
+// Row writer callbacks, the state of an open file is *arg. Return
+// status.
+//
+//   open  : create fileName, the columns are the index, the label
+//           column if labelName is not empty, and the value columns
+//   row   : write a row, label is 0 without a label column
+//   close : finish the file, free the state
+typedef int (*FCL_WriterOpen) ( void** arg, const string& fileName,
+				const string& labelName,
+				const vector< string >& columns );
+typedef int (*FCL_WriterRow)  ( void* arg, int index, const string* label,
+				const double* values );
+typedef int (*FCL_WriterClose)( void* arg );
+
+//---------------------------------------------------------------------
+// struct FuzzyWriter
+//
+// Purpose: An output row format. The built-in formats are:
+//
+//          text   : "index, [label, ]values, " lines after a header
+//                   line of the column names, as WriteTimestepOutput()
+//          binary : FCL_ROWS_MAGIC, uint32 number of value columns,
+//                   uint32 1 if there is a label column, then the
+//                   column names, label column first, each a uint32
+//                   length and the characters. Each row is an int32
+//                   index, the label as a uint32 length and the
+//                   characters, and the values as doubles. Native
+//                   byte order.
+//---------------------------------------------------------------------
+struct FuzzyWriter {
+  string name;
+
+  FCL_WriterOpen  open;
+  FCL_WriterRow   row;
+  FCL_WriterClose close;
+};
+
+int FCL_FindWriter( const string& name, FuzzyWriter* writer );
+
+//---------------------------------------------------------------------
+// class FuzzyDeltaClass
+//
+// Purpose: Write the outputs of a series only at the rows where an
+//          output has moved more than Tolerance() from the last row
+//          written, as the index, the input label if any, and the
+//          outputs in declaration order. The first and last rows are
+//          always written, so the output of a row is that of the
+//          last row written at or before it, within Tolerance().
+//---------------------------------------------------------------------
+class FuzzyDeltaClass {
+
+ protected:
+  int status; // Error code variable
+
+  FuzzyControlClass* lpFC;
+
+  FuzzyWriter writer;
+  void*       arg;    // open file state of the writer
+
+  double           tolerance;
+  vector< double > outputs;     // of the last row
+  vector< double > lastWritten; // outputs of the last row written
+  int              lastIndex;   // last row
+  bool             pending;     // last row is not written
+  long             nRows;
+  long             nWritten;
+
+  int Write( int index );
+
+ public:
+  // Encapsulation methods for protected variables
+  double  Tolerance() const { return tolerance; }
+  double &Tolerance()       { return tolerance; }
+  long    NumRows()    const { return nRows; }
+  long    NumWritten() const { return nWritten; }
+
+  // FuzzyDelta Methods
+  FuzzyDeltaClass( FuzzyControlClass* lpFC, const FuzzyWriter& writer );
+  ~FuzzyDeltaClass();
+
+  int Open ( string* fileName );
+  int Row  ( int index );
+  int Close();
+};
+
+int FuzzyControl_DeltaSeriesInput( FuzzyControlClass* lpFC,
+				   FuzzyDeltaClass* lpDelta,
+				   int numDataPoints );
+
+#endif
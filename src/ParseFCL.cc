@@ -1,4 +1,5 @@
 #include "FuzzyControl.h"
+#include <sstream> // ostringstream for RuleErrMsg()
 
 //--------------------------------------------------------------
 // ParseFCLFile
@@ -93,6 +94,9 @@ int FuzzyControlClass::ParseFCL_Rules() {
   string::size_type stringKeyEnd;
   vector<string>::iterator FCLFileIterator = FCLFileVector.begin();
 
+  // RULE statements in file order, with the methods of their RULEBLOCK
+  vector<RuleStatement> ruleStatements;
+
   while (FCLFileIterator != FCLFileVector.end()) {
     FCLFileLine = *FCLFileIterator;
 
@@ -354,464 +358,595 @@ int FuzzyControlClass::ParseFCL_Rules() {
 	  DebugAllMsg("Found ACT method", ACT_Method->keyword, status);
 	}
 
-	// Look for RULE
+	// Look for RULE, collect it to be parsed after the RULEBLOCKs
 	else if ( RuleStartPosition != FCLFileLine.npos ) {
-	  // Found RULE
-	  string ruleName;
-	  string::size_type RuleNameStartPosition = 0;
-	  string::size_type RuleNameEndPosition   = 0;
-	  string::size_type WithStartPosition     = 0;
-	  string::size_type IfStartPosition       = 0;
-	  string::size_type ThenStartPosition     = 0;
-	  string::size_type IsStartPosition       = 0;
-
-	  int nSubConditions  = 0;
-	  int nSubConclusions = 0;
-
-	  // Get the rule name
-	  RuleNameStartPosition = 
-	    FindNoWhiteSpace( FCLFileLine,
-			      RuleStartPosition + 
-			      keyword_Rule->keyword.length(),
-			      forward );
-	  // Find end of rule name
-	  RuleNameEndPosition = FCLFileLine.find(":");
-	  if ( RuleNameEndPosition == FCLFileLine.npos ) {
-	    status = -1;
-	    ErrMsg("Failed to find end of rule name delimeter ':'",
-		   ruleBlockName + " in [" + FCLFileLine + "]", status);
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
-	  RuleNameEndPosition = FindNoWhiteSpace( FCLFileLine, 
-						  --RuleNameEndPosition, back );
-	  if ( RuleNameEndPosition < RuleNameStartPosition ) {
-	    status = -1;
-	    ErrMsg("Failed to find end of ruleblock name",
-		   ruleBlockName + " in [" + FCLFileLine + "]", status);
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
-	  // Assign the ruleBlock name string
-	  ruleName = FCLFileLine.substr(RuleNameStartPosition, 
-					RuleNameEndPosition - 
-					RuleNameStartPosition + 1);
+	  RuleStatement ruleStatement;
+	  ruleStatement.FCLFileLine   = FCLFileLine;
+	  ruleStatement.ruleBlockName = ruleBlockName;
+	  ruleStatement.andMethod     = AND_Method;
+	  ruleStatement.orMethod      = OR_Method;
+	  ruleStatement.actMethod     = ACT_Method;
+	  ruleStatements.push_back( ruleStatement );
+	} // Found RULE
+
+      } // iterate until END_RULEBLOCK
+
+    } // found RULEBLOCK
+
+    FCLFileIterator++;
+  } // while (FCLFileIterator != FCLFileVector.end())
+
+  // Parse the RULE statements. The statements only read the term
+  // tables built by the fuzzify/defuzzify parsers, so when the
+  // RULEBLOCKs hold 2 * RULE_PARSE_CHUNK rules or more in total they
+  // are split into chunks parsed on the thread pool, each rule
+  // written into its own slot of parsedRules.
+  int nRules = ruleStatements.size();
+  vector< FuzzyRuleClass* > parsedRules( nRules, (FuzzyRuleClass*) 0 );
+  vector< int >             ruleStatus ( nRules, 0 );
+
+  RuleChunkArg ruleChunkArg;
+  ruleChunkArg.lpFC           = this;
+  ruleChunkArg.ruleStatements = &ruleStatements;
+  ruleChunkArg.parsedRules    = &parsedRules;
+  ruleChunkArg.ruleStatus     = &ruleStatus;
+
+  if ( nRules < 2 * RULE_PARSE_CHUNK ) {
+    ParseFCL_RuleChunk( &ruleChunkArg, 0, 0, nRules );
+  }
+  else {
+    FCL_ParallelFor( nRules, RULE_PARSE_CHUNK, ParseFCL_RuleChunk, 
+		     &ruleChunkArg, 0 );
+  }
+
+  // Merge into the Rules map in file order, printing the messages of
+  // each rule, so that the first failing or redundant rule is the one
+  // reported, regardless of thread timing
+  int i = 0;
+  for ( i = 0; i < nRules; i++ ) {
+    cerr << ruleStatements[i].errMsg;
+    if ( ruleStatus[i] != 0 ) {
+      status = ruleStatus[i];
+      break;
+    }
+    if ( Rules.find( parsedRules[i]->ruleName ) != Rules.end() ) {
+      status = -1;
+      ErrMsg("Found redundant rule definition", 
+	     parsedRules[i]->ruleName, status);
+      break;
+    }
+    Rules[ parsedRules[i]->ruleName ] = parsedRules[i];
+    tangentIndexValid = false;
+  }
+  if ( status != 0 ) {
+    // release the parsed rules that were not merged
+    for ( ; i < nRules; i++ ) {
+      if ( parsedRules[i] ) {
+	DeleteRule( parsedRules[i] );
+      }
+    }
+  }
+
+  DebugAllMsg("<-ParseFCL_Rules()","", status);
+  return status;
+}
+
+//--------------------------------------------------------------
+// ParseFCL_RuleChunk
+//
+// Purpose: FCL_ParallelFor() worker for ParseFCL_Rules(), parses
+//          the RULE statements [begin, end) into their slots in 
+//          the parsedRules vector, recording a status for each
+//
+// Arguments: arg         : pointer to RuleChunkArg
+//            threadIndex : unused
+//            begin, end  : range of rule statements
+//           
+// Return: 
+//--------------------------------------------------------------
+void ParseFCL_RuleChunk( void* arg, int threadIndex, int begin, int end ) {
+
+  RuleChunkArg* lpRCA = (RuleChunkArg*) arg;
+
+  for ( int i = begin; i < end; i++ ) {
+    (*lpRCA->ruleStatus)[i] = 
+      lpRCA->lpFC->ParseFCL_Rule( &((*lpRCA->ruleStatements)[i]), 
+				  &((*lpRCA->parsedRules)[i]) );
+  }
+}
+
+//--------------------------------------------------------------
+// RuleErrMsg
+//
+// Purpose: ErrMsg() into the errMsg of a RULE statement, printed
+//          by the caller of ParseFCL_Rule() so that the messages of
+//          concurrently parsed rules come out in file order
+//
+// Arguments: lpRS   : RULE statement being parsed
+//            msg    : message
+//            arg    : message argument
+//            status : status
+//           
+// Return: 
+//--------------------------------------------------------------
+static void RuleErrMsg( RuleStatement* lpRS, string msg, string arg,
+			int status ) {
+  ostringstream oss;
+  oss << msg << " : " << arg <<  " : (" << status << ")\n";
+  lpRS->errMsg += oss.str();
+}
+
+//--------------------------------------------------------------
+// ParseFCL_Rule
+//
+// Purpose: Parse a single RULE statement collected from a RULEBLOCK
+//          by ParseFCL_Rules() into a new FuzzyRuleClass.
+//          Only reads the keyword and variable maps, and does not
+//          touch the Rules map or the class status, so that it can
+//          be called concurrently by the ParseFCL_Rules() workers.
+//
+// Arguments: lpRS  : pointer to the RULE statement and its methods
+//            lpFRC : address of pointer set to the new FuzzyRuleClass
+//           
+// Return: status
+//--------------------------------------------------------------
+int FuzzyControlClass::ParseFCL_Rule( RuleStatement*   lpRS,
+				      FuzzyRuleClass** lpFRC ) {
+
+  int status = 0;
+  DebugAllMsg("->ParseFCL_Rule()","", status);
+
+  *lpFRC = 0;
+
+  string       FCLFileLine   = lpRS->FCLFileLine;
+  string       ruleBlockName = lpRS->ruleBlockName;
+  FCL_keyword* AND_Method    = lpRS->andMethod;
+  FCL_keyword* OR_Method     = lpRS->orMethod;
+  FCL_keyword* ACT_Method    = lpRS->actMethod;
+
+  string::size_type RuleStartPosition = 
+    FCLFileLine.find(keyword_Rule->keyword);
+
+  string ruleName;
+  string::size_type RuleNameStartPosition = 0;
+  string::size_type RuleNameEndPosition   = 0;
+  string::size_type WithStartPosition     = 0;
+  string::size_type IfStartPosition       = 0;
+  string::size_type ThenStartPosition     = 0;
+  string::size_type IsStartPosition       = 0;
+
+  int nSubConditions  = 0;
+  int nSubConclusions = 0;
+
+  // Get the rule name
+  RuleNameStartPosition = 
+    FindNoWhiteSpace( FCLFileLine,
+		      RuleStartPosition + 
+		      keyword_Rule->keyword.length(),
+		      forward );
+  // Find end of rule name
+  RuleNameEndPosition = FCLFileLine.find(":");
+  if ( RuleNameEndPosition == FCLFileLine.npos ) {
+    status = -1;
+    RuleErrMsg(lpRS, "Failed to find end of rule name delimeter ':'",
+	       ruleBlockName + " in [" + FCLFileLine + "]", status);
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+  RuleNameEndPosition = FindNoWhiteSpace( FCLFileLine, 
+					  --RuleNameEndPosition, back );
+  if ( RuleNameEndPosition < RuleNameStartPosition ) {
+    status = -1;
+    RuleErrMsg(lpRS, "Failed to find end of ruleblock name",
+	       ruleBlockName + " in [" + FCLFileLine + "]", status);
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+  // Assign the ruleBlock name string
+  ruleName = FCLFileLine.substr(RuleNameStartPosition, 
+				RuleNameEndPosition - 
+				RuleNameStartPosition + 1);
   
-	  DebugAllMsg("Found RULE", ruleName, status);
-
-	  // Create a FuzzyRuleClass, pass in pointers to needed keywords
-	  // I don't like this passing in of keywords, there should be a better
-	  // way to get access to the keyword pointers in FuzzyControlClass from
-	  // the FuzzyRuleClass
-	  FuzzyRuleClass* frc = new FuzzyRuleClass(keyword_Min,
-						   keyword_Max,  keyword_Prod,
-						   keyword_Bdif, keyword_Asum, 
-						   keyword_Bsum);
-	  if ( not frc ) {
-	    status = -1;
-	    ErrMsg("ParseFCL_IO_Rules() Failed to create FuzzyRuleClass for ", 
-		   ruleName, status);
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
-	  // set the rule name
-	  frc->ruleName = ruleName;
-	  // set the methods
-	  if ( AND_Method ) {
-	    frc->andMethod = AND_Method;
-	  }
-	  if ( OR_Method ) {
-	    frc->orMethod = OR_Method;
-	  }
-	  if ( ACT_Method ) {
-	    frc->actMethod = ACT_Method;
-	  }
+  DebugAllMsg("Found RULE", ruleName, status);
+
+  // Create a FuzzyRuleClass, pass in pointers to needed keywords
+  // I don't like this passing in of keywords, there should be a better
+  // way to get access to the keyword pointers in FuzzyControlClass from
+  // the FuzzyRuleClass
+  FuzzyRuleClass* frc = new FuzzyRuleClass(keyword_Min,
+					   keyword_Max,  keyword_Prod,
+					   keyword_Bdif, keyword_Asum, 
+					   keyword_Bsum);
+  if ( not frc ) {
+    status = -1;
+    RuleErrMsg(lpRS, "ParseFCL_IO_Rules() Failed to create FuzzyRuleClass for ", 
+	       ruleName, status);
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+  // set the rule name
+  frc->ruleName = ruleName;
+  // set the methods
+  if ( AND_Method ) {
+    frc->andMethod = AND_Method;
+  }
+  if ( OR_Method ) {
+    frc->orMethod = OR_Method;
+  }
+  if ( ACT_Method ) {
+    frc->actMethod = ACT_Method;
+  }
 
-	  // Validate the rule syntax
-	  IfStartPosition   = FCLFileLine.find(keyword_IF->keyword);
-	  ThenStartPosition = FCLFileLine.find(keyword_Then->keyword);
-	  if ( IfStartPosition == FCLFileLine.npos ) {
-	    status = -1;
-	    ErrMsg("Failed to find IF in rule",
-		   ruleName + " in [" + FCLFileLine + "]", status);
-	    delete frc;
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
-	  if ( ThenStartPosition == FCLFileLine.npos ) {
-	    status = -1;
-	    ErrMsg("Failed to find THEN in rule",
-		   ruleName + " in [" + FCLFileLine + "]", status);
-	    delete frc;
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
+  // Validate the rule syntax
+  IfStartPosition   = FCLFileLine.find(keyword_IF->keyword);
+  ThenStartPosition = FCLFileLine.find(keyword_Then->keyword);
+  if ( IfStartPosition == FCLFileLine.npos ) {
+    status = -1;
+    RuleErrMsg(lpRS, "Failed to find IF in rule",
+	       ruleName + " in [" + FCLFileLine + "]", status);
+    delete frc;
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+  if ( ThenStartPosition == FCLFileLine.npos ) {
+    status = -1;
+    RuleErrMsg(lpRS, "Failed to find THEN in rule",
+	       ruleName + " in [" + FCLFileLine + "]", status);
+    delete frc;
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
 
-          // Read Conditions
-	  // Isolate the conditions into a local string 
-	  string conditionString;
-	  IfStartPosition = FindNoWhiteSpace( FCLFileLine, 
-					      IfStartPosition + 
-					      keyword_IF->keyword.length(),
-					      forward );
-	  ThenStartPosition = FindNoWhiteSpace( FCLFileLine, 
-						--ThenStartPosition, back );
-	  if ( ThenStartPosition <= IfStartPosition ) {
-	    status = -1;
-	    ErrMsg("Failed to find condition in rule",
-		   ruleName + " in [" + FCLFileLine + "]", status);
-	    delete frc;
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
-	  // conditions are between IF ... THEN
-	  conditionString = FCLFileLine.substr( IfStartPosition, 
-						ThenStartPosition - 
-						IfStartPosition + 1);
-	  DebugAllMsg("Condition", conditionString, 0);
-	  
-	  // count the IS keywords to find the nSubConditions
-	  while (( IsStartPosition = 
-		   conditionString.find(keyword_IS->keyword, 
-					IsStartPosition + 1) )
-		    != conditionString.npos ) {
-	    nSubConditions++;
-	  }
-	  frc->nSubConditions = nSubConditions;
-	  DebugAllMsg("Found subconditions", nSubConditions, 0);
-
-	  // Find the inputVariables and the inputFuzzifyTerms
-	  // First, split the condition string into words
-	  vector<string> subCondWords;
-	  string delimeters = " \t,\r\n:;()";
-	  status = SplitLine( &subCondWords, &conditionString, &delimeters );
-	  if ( status != 0 ) {
-	    ErrMsg("Failed to split rule conditions",
-		   ruleName + " in [" + FCLFileLine + "]", status);
-	    delete frc;
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
+  // Read Conditions
+  // Isolate the conditions into a local string 
+  string conditionString;
+  IfStartPosition = FindNoWhiteSpace( FCLFileLine, 
+				      IfStartPosition + 
+				      keyword_IF->keyword.length(),
+				      forward );
+  ThenStartPosition = FindNoWhiteSpace( FCLFileLine, 
+					--ThenStartPosition, back );
+  if ( ThenStartPosition <= IfStartPosition ) {
+    status = -1;
+    RuleErrMsg(lpRS, "Failed to find condition in rule",
+	       ruleName + " in [" + FCLFileLine + "]", status);
+    delete frc;
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+  // conditions are between IF ... THEN
+  conditionString = FCLFileLine.substr( IfStartPosition, 
+					ThenStartPosition - 
+					IfStartPosition + 1);
+  DebugAllMsg("Condition", conditionString, 0);
+  
+  // count the IS keywords to find the nSubConditions
+  while (( IsStartPosition = 
+	   conditionString.find(keyword_IS->keyword, 
+				IsStartPosition + 1) )
+	    != conditionString.npos ) {
+    nSubConditions++;
+  }
+  frc->nSubConditions = nSubConditions;
+  DebugAllMsg("Found subconditions", nSubConditions, 0);
+
+  // Find the inputVariables and the inputFuzzifyTerms
+  // First, split the condition string into words
+  vector<string> subCondWords;
+  string delimeters = " \t,\r\n:;()";
+  status = SplitLine( &subCondWords, &conditionString, &delimeters );
+  if ( status != 0 ) {
+    RuleErrMsg(lpRS, "Failed to split rule conditions",
+	       ruleName + " in [" + FCLFileLine + "]", status);
+    delete frc;
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
 
-	  // Create a Condition struct, this holds subConditions in 
-	  // one of two vectors:
-	  // AND_SubConditions or OR_SubConditions 
-	  // depending on how the subConditions are
-	  // to be combined based on the AND/OR usage
-	  Condition* condition = new Condition;
-	  if ( not condition ) {
-	    status = -1; delete frc;
-	    ErrMsg("ParseFCL_IO_Rules() Failed to create condition struct for", 
+  // Create a Condition struct, this holds subConditions in 
+  // one of two vectors:
+  // AND_SubConditions or OR_SubConditions 
+  // depending on how the subConditions are
+  // to be combined based on the AND/OR usage
+  Condition* condition = new Condition;
+  if ( not condition ) {
+    status = -1; delete frc;
+    RuleErrMsg(lpRS, "ParseFCL_IO_Rules() Failed to create condition struct for", 
+	       ruleName + " in [" + FCLFileLine + "]", status);
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+  condition->result = 0.;
+
+  // Iterate through the subCondWords, creating the 
+  // SubCondition structs, and populating the Condition struct 
+  vector<string>::iterator sci = subCondWords.begin();
+  FCL_keyword*     Combination_FCL_KeyWord = 0;
+  FCL_keyword*     FCL_KeyWord   = 0;
+  FuzzyInputClass* inputVariable = 0;
+  FuzzyInputTerm*  inputTerm     = 0;
+  string variableName;
+  string termName;
+  bool   termNegate      = false;
+  bool   conditionNegate = false;
+
+  while ( sci != subCondWords.end() ) {
+    FCL_KeyWord = FindFCLKeywordFromMap( *sci, false);
+    if ( FCL_KeyWord ) {
+      // Found FCL keyword, should be IS, AND, OR, NOT
+      if ( FCL_KeyWord != keyword_And and FCL_KeyWord != keyword_Or and 
+	   FCL_KeyWord != keyword_IS  and FCL_KeyWord != keyword_Not ) {
+	RuleErrMsg(lpRS, "Invalid keyword found in rule subCondition",
+		   FCL_KeyWord->keyword + " in [" + FCLFileLine + "]", 1);
+      }
+      if ( FCL_KeyWord != keyword_IS and FCL_KeyWord != keyword_Not ) {
+	Combination_FCL_KeyWord = FCL_KeyWord;
+      }
+    }
+    else if ( InputVariables.find(*sci) != InputVariables.end() ) {
+      // Found input variable
+      inputVariable = InputVariables.find(*sci)->second;
+      variableName = *sci;
+
+      // Check to see if NOT was preceeding this variable
+      // This is for cases of: IF NOT (temp is hot) where the 
+      // condition is negated, not just the term (hot)
+      if ( sci != subCondWords.begin() ) {
+	if ( *(sci - 1) == keyword_Not->keyword ) {
+	  conditionNegate = true;
+	}
+      }
+    }
+    else if ( inputVariable ) {
+      if ( inputVariable->InputTerms.find( *sci ) != 
+	   inputVariable->InputTerms.end() ) {
+	// Found inputTerm for inputVariable
+	inputTerm = inputVariable->InputTerms.find(*sci)->second;
+	termName = *sci;
+	// Check to see if NOT was preceeding this term
+	if ( *(sci - 1) == keyword_Not->keyword ) {
+	    termNegate = true;
+	}
+      }
+      else {
+	status = -1;
+	RuleErrMsg(lpRS, "ParseFCL_IO_Rules() Failed find Rule term",
+		   *sci + " in [" + FCLFileLine + "]", status);
+	delete frc; delete condition;
+	DebugAllMsg("<-ParseFCL_Rule()","", status);
+	return status;
+      }
+    }
+    else {
+      status = -1;
+      RuleErrMsg(lpRS, "ParseFCL_IO_Rules() Failed find Rule item",
+		 *sci + " in [" + FCLFileLine + "]", status);
+      delete frc; delete condition;
+      DebugAllMsg("<-ParseFCL_Rule()","", status);
+      return status;
+    }
+    // If found inputVar/inputTerm pair, then create subCondition
+    if ( inputVariable and inputTerm ) {
+      // Create a SubCondition struct
+      SubCondition* subCondition = new SubCondition;
+      if ( not subCondition ) {
+	status = -1; delete frc; delete condition;
+	RuleErrMsg(lpRS, "ParseFCL_IO_Rules() Failed to create "
+		   "subCondition struct for rule",
 		   ruleName + " in [" + FCLFileLine + "]", status);
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
-	  condition->result = 0.;
-
-	  // Iterate through the subCondWords, creating the 
-	  // SubCondition structs, and populating the Condition struct 
-	  vector<string>::iterator sci = subCondWords.begin();
-	  FCL_keyword*     Combination_FCL_KeyWord = 0;
-	  FCL_keyword*     FCL_KeyWord   = 0;
-	  FuzzyInputClass* inputVariable = 0;
-	  FuzzyInputTerm*  inputTerm     = 0;
-	  string variableName;
-	  string termName;
-	  bool   termNegate      = false;
-	  bool   conditionNegate = false;
-
-	  while ( sci != subCondWords.end() ) {
-	    FCL_KeyWord = FindFCLKeywordFromMap( *sci, false);
-	    if ( FCL_KeyWord ) {
-	      // Found FCL keyword, should be IS, AND, OR, NOT
-	      if ( FCL_KeyWord != keyword_And and FCL_KeyWord != keyword_Or and 
-		   FCL_KeyWord != keyword_IS  and FCL_KeyWord != keyword_Not ) {
-		ErrMsg("Invalid keyword found in rule subCondition",
-		       FCL_KeyWord->keyword + " in [" + FCLFileLine + "]", 1);
-	      }
-	      if ( FCL_KeyWord != keyword_IS and FCL_KeyWord != keyword_Not ) {
-		Combination_FCL_KeyWord = FCL_KeyWord;
-	      }
-	    }
-	    else if ( InputVariables.find(*sci) != InputVariables.end() ) {
-	      // Found input variable
-	      inputVariable = InputVariables[*sci];
-	      variableName = *sci;
-
-	      // Check to see if NOT was preceeding this variable
-	      // This is for cases of: IF NOT (temp is hot) where the 
-	      // condition is negated, not just the term (hot)
-	      if ( sci != subCondWords.begin() ) {
-		if ( *(sci - 1) == keyword_Not->keyword ) {
-		  conditionNegate = true;
-		}
-	      }
-	    }
-	    else if ( inputVariable ) {
-	      if ( inputVariable->InputTerms.find( *sci ) != 
-		   inputVariable->InputTerms.end() ) {
-		// Found inputTerm for inputVariable
-		inputTerm = inputVariable->InputTerms[*sci];
-		termName = *sci;
-		// Check to see if NOT was preceeding this term
-		if ( *(sci - 1) == keyword_Not->keyword ) {
-		    termNegate = true;
-		}
-	      }
-	      else {
-		status = -1;
-		ErrMsg("ParseFCL_IO_Rules() Failed find Rule term",
-		       *sci + " in [" + FCLFileLine + "]", status);
-		delete frc; delete condition;
-		DebugAllMsg("<-ParseFCL_Rules()","", status);
-		return status;
-	      }
-	    }
-	    else {
-	      status = -1;
-	      ErrMsg("ParseFCL_IO_Rules() Failed find Rule item",
-		     *sci + " in [" + FCLFileLine + "]", status);
-	      delete frc; delete condition;
-	      DebugAllMsg("<-ParseFCL_Rules()","", status);
-	      return status;
-	    }
-	    // If found inputVar/inputTerm pair, then create subCondition
-	    if ( inputVariable and inputTerm ) {
-	      // Create a SubCondition struct
-	      SubCondition* subCondition = new SubCondition;
-	      if ( not subCondition ) {
-		status = -1; delete frc; delete condition;
-		ErrMsg("ParseFCL_IO_Rules() Failed to create "
-		       "subCondition struct for rule",
-		       ruleName + " in [" + FCLFileLine + "]", status);
-		DebugAllMsg("<-ParseFCL_Rules()","", status);
-		return status;
-	      }
-	      DebugAllMsg("Created SubCondition", variableName + 
-			  " IS " + termName, 0);
-
-	      // Assign the input variable/term to the subCondition struct
-	      subCondition->inputVariable    = inputVariable;
-	      subCondition->inputFuzzifyTerm = inputTerm;
-	      subCondition->notTerm          = termNegate;
-	      subCondition->notCondition     = conditionNegate;
-	      subCondition->subResult        = 0.;
-
-	      // Assign the subCondition struct to the AND/OR Condition stack
-	      if ( not Combination_FCL_KeyWord ) {
-		// This is the first (or only) variable/term set.
-		// If it's the only one, then it goes into AND_SubConditions
-		// If there are more, then it depends on the following 
-		// Combination_FCL_KeyWord
-		if ( conditionString.find(keyword_Or->keyword) != 
-		     conditionString.npos ) {
-		  // first variable/term followed by OR
-		  condition->OR_SubConditions.push_back(subCondition);
-		  DebugAllMsg("First SubCondition OR", variableName + 
-			      " IS " + termName, 0);
-		}
-		else if ( conditionString.find(keyword_And->keyword) != 
-			  conditionString.npos ) {
-		  // first variable/term followed by AND
-		  condition->AND_SubConditions.push_back(subCondition);
-		  DebugAllMsg("First SubCondition AND", variableName + 
-			      " IS " + termName, 0);
-		}
-		else {
-		  // only subcondition
-		  condition->AND_SubConditions.push_back(subCondition);
-		  DebugAllMsg("Only SubCondition AND", variableName + 
-			      " IS " + termName, 0);
-		}
-	      }
-	      else if ( Combination_FCL_KeyWord == keyword_Or ) {
-		// multiple variable/term preceeded by OR
-		condition->OR_SubConditions.push_back(subCondition);
-		DebugAllMsg("Multiple SubCondition OR", variableName + 
-			    " IS " + termName, 0);
-	      }
-	      else if ( Combination_FCL_KeyWord == keyword_And ) {
-		// multiple variable/term preceeded by AND
-		condition->AND_SubConditions.push_back(subCondition);
-		DebugAllMsg("Multiple SubCondition AND", variableName + 
-			    " IS " + termName, 0);
-	      }
+	DebugAllMsg("<-ParseFCL_Rule()","", status);
+	return status;
+      }
+      DebugAllMsg("Created SubCondition", variableName + 
+		  " IS " + termName, 0);
+
+      // Assign the input variable/term to the subCondition struct
+      subCondition->inputVariable    = inputVariable;
+      subCondition->inputFuzzifyTerm = inputTerm;
+      subCondition->notTerm          = termNegate;
+      subCondition->notCondition     = conditionNegate;
+      subCondition->subResult        = 0.;
+
+      // Assign the subCondition struct to the AND/OR Condition stack
+      if ( not Combination_FCL_KeyWord ) {
+	// This is the first (or only) variable/term set.
+	// If it's the only one, then it goes into AND_SubConditions
+	// If there are more, then it depends on the following 
+	// Combination_FCL_KeyWord
+	if ( conditionString.find(keyword_Or->keyword) != 
+	     conditionString.npos ) {
+	  // first variable/term followed by OR
+	  condition->OR_SubConditions.push_back(subCondition);
+	  DebugAllMsg("First SubCondition OR", variableName + 
+		      " IS " + termName, 0);
+	}
+	else if ( conditionString.find(keyword_And->keyword) != 
+		  conditionString.npos ) {
+	  // first variable/term followed by AND
+	  condition->AND_SubConditions.push_back(subCondition);
+	  DebugAllMsg("First SubCondition AND", variableName + 
+		      " IS " + termName, 0);
+	}
+	else {
+	  // only subcondition
+	  condition->AND_SubConditions.push_back(subCondition);
+	  DebugAllMsg("Only SubCondition AND", variableName + 
+		      " IS " + termName, 0);
+	}
+      }
+      else if ( Combination_FCL_KeyWord == keyword_Or ) {
+	// multiple variable/term preceeded by OR
+	condition->OR_SubConditions.push_back(subCondition);
+	DebugAllMsg("Multiple SubCondition OR", variableName + 
+		    " IS " + termName, 0);
+      }
+      else if ( Combination_FCL_KeyWord == keyword_And ) {
+	// multiple variable/term preceeded by AND
+	condition->AND_SubConditions.push_back(subCondition);
+	DebugAllMsg("Multiple SubCondition AND", variableName + 
+		    " IS " + termName, 0);
+      }
 
-	      inputVariable = 0; inputTerm = 0; Combination_FCL_KeyWord = 0;
-	      termNegate = false; conditionNegate = false;
-	    } // If found inputVar/inputTerm pair
-	    
-	    sci++;
-	  } // while ( sci != subCondWords.end() ) 
-
-	  // Assign the Condition struct to the FuzzyRuleClass->Conditions
-	  frc->Conditions.push_back(condition);
-
-	  // Read Conclusions
-	  // Isolate the conclusions into a local string 
-	  string conclusionString;
-	  string::size_type endConclusionPosition = 0;
-
-	  ThenStartPosition = FCLFileLine.find(keyword_Then->keyword);
-	  if ( ThenStartPosition == FCLFileLine.npos ) {
-	    status = -1; delete frc; delete condition;
-	    ErrMsg("Failed to find THEN in rule conclusion",
-		   ruleName + " in [" + FCLFileLine + "]", status);
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
-	  ThenStartPosition = 
-	    FindNoWhiteSpace( FCLFileLine, 
-			      ThenStartPosition + 
-			      keyword_Then->keyword.length(), forward );
-
-	  endConclusionPosition = FCLFileLine.find(";");
-	  if ( endConclusionPosition == FCLFileLine.npos ) {
-	    status = -1; delete frc; delete condition;
-	    ErrMsg("Failed to find end-of-line delimeter ';' for rule",
-		   ruleName + " in [" + FCLFileLine + "]", status);
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
-	  endConclusionPosition = FindNoWhiteSpace( FCLFileLine, 
-						    --endConclusionPosition, 
-						    back );
-	  if ( endConclusionPosition <= ThenStartPosition ) {
-	    status = -1;
-	    ErrMsg("Failed to find conclusion in rule",
+      inputVariable = 0; inputTerm = 0; Combination_FCL_KeyWord = 0;
+      termNegate = false; conditionNegate = false;
+    } // If found inputVar/inputTerm pair
+    
+    sci++;
+  } // while ( sci != subCondWords.end() ) 
+
+  // Assign the Condition struct to the FuzzyRuleClass->Conditions
+  frc->Conditions.push_back(condition);
+
+  // Read Conclusions
+  // Isolate the conclusions into a local string 
+  string conclusionString;
+  string::size_type endConclusionPosition = 0;
+
+  ThenStartPosition = FCLFileLine.find(keyword_Then->keyword);
+  if ( ThenStartPosition == FCLFileLine.npos ) {
+    status = -1; delete frc; delete condition;
+    RuleErrMsg(lpRS, "Failed to find THEN in rule conclusion",
+	       ruleName + " in [" + FCLFileLine + "]", status);
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+  ThenStartPosition = 
+    FindNoWhiteSpace( FCLFileLine, 
+		      ThenStartPosition + 
+		      keyword_Then->keyword.length(), forward );
+
+  endConclusionPosition = FCLFileLine.find(";");
+  if ( endConclusionPosition == FCLFileLine.npos ) {
+    status = -1; delete frc; delete condition;
+    RuleErrMsg(lpRS, "Failed to find end-of-line delimeter ';' for rule",
+	       ruleName + " in [" + FCLFileLine + "]", status);
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+  endConclusionPosition = FindNoWhiteSpace( FCLFileLine, 
+					    --endConclusionPosition, 
+					    back );
+  if ( endConclusionPosition <= ThenStartPosition ) {
+    status = -1;
+    RuleErrMsg(lpRS, "Failed to find conclusion in rule",
+	       ruleName + " in [" + FCLFileLine + "]", status);
+    delete frc;
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+  // conclusions are between THEN .... ;
+  conclusionString = FCLFileLine.substr( ThenStartPosition, 
+					 endConclusionPosition - 
+					 ThenStartPosition + 1);
+  DebugAllMsg("Conclusion", conclusionString, 0);
+  
+  // Find the outputVariables and the outputDefuzzifyTerms
+  // First, split the condition string into words
+  vector<string> subConclusionWords;
+  status = SplitLine( &subConclusionWords, &conclusionString, 
+		      &delimeters );
+  if ( status != 0 ) {
+    RuleErrMsg(lpRS, "Failed to split rule conclusion",
+	       ruleName + " in [" + FCLFileLine + "]", status);
+    delete frc; delete condition;
+    DebugAllMsg("<-ParseFCL_Rule()","", status);
+    return status;
+  }
+
+  // Iterate through the subConclusionWords, 
+  // creating the Conclusion structs,
+  sci = subConclusionWords.begin();
+  FuzzyOutputClass* outputVariable = 0;
+  FuzzyOutputTerm*  outputTerm     = 0;
+  double            outputScale    = 1.; // default is weight = 1. 
+  Conclusion*       lpConclusion   = 0;
+
+  while ( sci != subConclusionWords.end() ) {
+    FCL_KeyWord = FindFCLKeywordFromMap( *sci, false);
+    if ( FCL_KeyWord ) {
+      // Found FCL keyword, should be IS, WITH
+      if ( FCL_KeyWord != keyword_IS and FCL_KeyWord != keyword_With ) {
+	RuleErrMsg(lpRS, "Invalid keyword found in rule Conclusion",
+		   FCL_KeyWord->keyword + " in [" + FCLFileLine + "]", 1);
+      }
+    }
+    else if ( OutputVariables.find(*sci) != OutputVariables.end() ) {
+      // Found output variable
+      outputVariable = OutputVariables.find(*sci)->second;
+      variableName = *sci;
+    }
+    else if ( outputVariable ) {
+      if ( outputVariable->OutputTerms.find(*sci) != 
+	   outputVariable->OutputTerms.end() ) {
+	// Found outputTerm for outputVariable
+	outputTerm = outputVariable->OutputTerms.find(*sci)->second;
+	termName = *sci;
+      }
+    }
+    else if ( *(sci-1) == keyword_With->keyword ) {
+      // WITH was the preceeding keyword, so this should be a number
+      outputScale = atof ( sci->c_str() );
+      // assumes that the WITH follows a valid creation 
+      // of output/defuzzTerm pair
+      if ( lpConclusion ) {
+	lpConclusion->weight = outputScale;
+      }
+      else {
+	status = -1; delete frc; delete condition;
+	RuleErrMsg(lpRS, "ParseFCL_IO_Rules() Failed to find Conclusion for WITH",
 		   ruleName + " in [" + FCLFileLine + "]", status);
-	    delete frc;
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
-	  // conclusions are between THEN .... ;
-	  conclusionString = FCLFileLine.substr( ThenStartPosition, 
-						 endConclusionPosition - 
-						 ThenStartPosition + 1);
-	  DebugAllMsg("Conclusion", conclusionString, 0);
-	  
-	  // Find the outputVariables and the outputDefuzzifyTerms
-	  // First, split the condition string into words
-	  vector<string> subConclusionWords;
-	  status = SplitLine( &subConclusionWords, &conclusionString, 
-			      &delimeters );
-	  if ( status != 0 ) {
-	    ErrMsg("Failed to split rule conclusion",
+	DebugAllMsg("<-ParseFCL_Rule()","", status);
+	return status;
+      }
+      outputScale = 1.;
+      DebugAllMsg("WITH", outputScale, 0);
+    }
+    else {
+      status = -1;
+      RuleErrMsg(lpRS, "ParseFCL_IO_Rules() Failed to find Rule item",
+		 *sci + " in [" + FCLFileLine + "]", status);
+      delete frc; delete condition;
+      DebugAllMsg("<-ParseFCL_Rule()","", status);
+      return status;
+    }
+    // If found outputVar/outputTerm pair, then create Conclusion
+    if ( outputVariable and outputTerm ) {
+      // Create a Conclusion struct
+      lpConclusion = new Conclusion;
+      if ( not lpConclusion ) {
+	status = -1; delete frc; delete condition;
+	RuleErrMsg(lpRS, "ParseFCL_IO_Rules() Failed to create "
+		   "Conclusion struct for rule",
 		   ruleName + " in [" + FCLFileLine + "]", status);
-	    delete frc; delete condition;
-	    DebugAllMsg("<-ParseFCL_Rules()","", status);
-	    return status;
-	  }
+	DebugAllMsg("<-ParseFCL_Rule()","", status);
+	return status;
+      }
+      DebugAllMsg("Created Conclusion", variableName + 
+		  " IS " + termName, 0);
 
-	  // Iterate through the subConclusionWords, 
-	  // creating the Conclusion structs,
-	  sci = subConclusionWords.begin();
-	  FuzzyOutputClass* outputVariable = 0;
-	  FuzzyOutputTerm*  outputTerm     = 0;
-	  double            outputScale    = 1.; // default is weight = 1. 
-	  Conclusion*       lpConclusion   = 0;
-
-	  while ( sci != subConclusionWords.end() ) {
-	    FCL_KeyWord = FindFCLKeywordFromMap( *sci, false);
-	    if ( FCL_KeyWord ) {
-	      // Found FCL keyword, should be IS, WITH
-	      if ( FCL_KeyWord != keyword_IS and FCL_KeyWord != keyword_With ) {
-		ErrMsg("Invalid keyword found in rule Conclusion",
-		       FCL_KeyWord->keyword + " in [" + FCLFileLine + "]", 1);
-	      }
-	    }
-	    else if ( OutputVariables.find(*sci) != OutputVariables.end() ) {
-	      // Found output variable
-	      outputVariable = OutputVariables[*sci];
-	      variableName = *sci;
-	    }
-	    else if ( outputVariable ) {
-	      if ( outputVariable->OutputTerms.find(*sci) != 
-		   outputVariable->OutputTerms.end() ) {
-		// Found outputTerm for outputVariable
-		outputTerm = outputVariable->OutputTerms[*sci];
-		termName = *sci;
-	      }
-	    }
-	    else if ( *(sci-1) == keyword_With->keyword ) {
-	      // WITH was the preceeding keyword, so this should be a number
-	      outputScale = atof ( sci->c_str() );
-	      // assumes that the WITH follows a valid creation 
-	      // of output/defuzzTerm pair
-	      if ( lpConclusion ) {
-		lpConclusion->weight = outputScale;
-	      }
-	      else {
-		status = -1; delete frc; delete condition;
-		ErrMsg("ParseFCL_IO_Rules() Failed to find Conclusion for WITH",
-		       ruleName + " in [" + FCLFileLine + "]", status);
-		DebugAllMsg("<-ParseFCL_Rules()","", status);
-		return status;
-	      }
-	      outputScale = 1.;
-	      DebugAllMsg("WITH", outputScale, 0);
-	    }
-	    else {
-	      status = -1;
-	      ErrMsg("ParseFCL_IO_Rules() Failed to find Rule item",
-		     *sci + " in [" + FCLFileLine + "]", status);
-	      delete frc; delete condition;
-	      DebugAllMsg("<-ParseFCL_Rules()","", status);
-	      return status;
-	    }
-	    // If found outputVar/outputTerm pair, then create Conclusion
-	    if ( outputVariable and outputTerm ) {
-	      // Create a Conclusion struct
-	      lpConclusion = new Conclusion;
-	      if ( not lpConclusion ) {
-		status = -1; delete frc; delete condition;
-		ErrMsg("ParseFCL_IO_Rules() Failed to create "
-		       "Conclusion struct for rule",
-		       ruleName + " in [" + FCLFileLine + "]", status);
-		DebugAllMsg("<-ParseFCL_Rules()","", status);
-		return status;
-	      }
-	      DebugAllMsg("Created Conclusion", variableName + 
-			  " IS " + termName, 0);
-
-	      // Assign the output variable/term to the subConclusion struct
-	      lpConclusion->outputVariable  = outputVariable;
-	      lpConclusion->outputDefuzzify = outputTerm;
-	      lpConclusion->weight          = 1.; // default weight is 1.
-	      // Assign the activationTerm varName and termName
-	      lpConclusion->activationTerm.varName  = outputVariable->varName;
-	      lpConclusion->activationTerm.termName = outputTerm->termName;
-	      lpConclusion->activationTerm.termType = -1;
-	      lpConclusion->activationTerm.singleton.x = 0.;
-	      lpConclusion->activationTerm.singleton.y = 0.;
-
-	      // Assign the Conclusion struct to the FuzzyRuleClass->Conclusions
-	      frc->Conclusions.push_back(lpConclusion);
-
-	      outputVariable = 0; outputTerm = 0;
-	    } // if ( outputVariable and outputTerm )
-
-	    sci++;
-	  } // while ( sci != subConclusionWords.end() )
-
-	  // Assign the FuzzyRuleClass to the Rules map
-	  if ( Rules.find(ruleName) != Rules.end() ) {
-	    status = -1;
-	    ErrMsg("Found redundant rule definition", ruleName, status);
-	    return status;
-	  }
-	  Rules[ruleName] = frc;
+      // Assign the output variable/term to the subConclusion struct
+      lpConclusion->outputVariable  = outputVariable;
+      lpConclusion->outputDefuzzify = outputTerm;
+      lpConclusion->weight          = 1.; // default weight is 1.
+      // Assign the activationTerm varName and termName
+      lpConclusion->activationTerm.varName  = outputVariable->varName;
+      lpConclusion->activationTerm.termName = outputTerm->termName;
+      lpConclusion->activationTerm.termType = -1;
+      lpConclusion->activationTerm.singleton.x = 0.;
+      lpConclusion->activationTerm.singleton.y = 0.;
 
-	} // Found RULE
+      // Assign the Conclusion struct to the FuzzyRuleClass->Conclusions
+      frc->Conclusions.push_back(lpConclusion);
 
-      } // iterate until END_RULEBLOCK
+      outputVariable = 0; outputTerm = 0;
+    } // if ( outputVariable and outputTerm )
 
-    } // found RULEBLOCK
+    sci++;
+  } // while ( sci != subConclusionWords.end() )
 
-    FCLFileIterator++;
-  } // while (FCLFileIterator != FCLFileVector.end())
+  *lpFRC = frc;
 
-  DebugAllMsg("<-ParseFCL_Rules()","", status);
+  DebugAllMsg("<-ParseFCL_Rule()","", status);
   return status;
 }
 
@@ -1867,7 +2002,15 @@ int FuzzyControlClass::ParseFCL_IO_Vars(FCL_keyword* keywordStart,
       }
       fic->varName = variableName;
       fic->varType = variableType;
-      // Insert the new input variable into the InputVariables map
+      // Insert the new input variable into the InputVariables map,
+      // a redeclared variable keeps its first declaration position
+      if ( InputVariables.find(variableName) == InputVariables.end() ) {
+	InputVariableVector.push_back( fic );
+      }
+      else {
+	replace( InputVariableVector.begin(), InputVariableVector.end(),
+		 InputVariables[variableName], fic );
+      }
       InputVariables[variableName] = fic;
 
       DebugAllMsg("Created input variable", variableName, status);
@@ -1885,7 +2028,15 @@ int FuzzyControlClass::ParseFCL_IO_Vars(FCL_keyword* keywordStart,
       }
       foc->varName = variableName;
       foc->varType = variableType;
-      // Insert the new output variable into the OutputVariables map
+      // Insert the new output variable into the OutputVariables map,
+      // a redeclared variable keeps its first declaration position
+      if ( OutputVariables.find(variableName) == OutputVariables.end() ) {
+	OutputVariableVector.push_back( foc );
+      }
+      else {
+	replace( OutputVariableVector.begin(), OutputVariableVector.end(),
+		 OutputVariables[variableName], foc );
+      }
       OutputVariables[variableName] = foc;
 
       DebugAllMsg("Created output variable", variableName, status);
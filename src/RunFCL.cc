@@ -9,6 +9,107 @@
 
 // Import the FuzzyControl definitions
 #include "FuzzyControl.h"
+#include "FuzzyGraph.h"
+#include "FuzzyServer.h"
+#include "FuzzyRing.h"
+#include "FuzzyTune.h"
+#include "FuzzySweep.h"
+#include "FuzzySurface.h"
+#include "FuzzyMonteCarlo.h"
+#include "FuzzySimulate.h"
+#include "FuzzyRuleGen.h"
+#include "FuzzyShadow.h"
+#include "FuzzyGroup.h"
+#include "FuzzyRaster.h"
+#include "FuzzySummary.h"
+#include "FuzzyWriter.h"
+#include <csignal> // sigwait
+#include <cctype>  // isalnum
+
+//--------------------------------------------------------------
+// Run modes, at most one is given. "rows" is the plain row
+// evaluation, with no mode option.
+//--------------------------------------------------------------
+static const char* runModes[] = {
+  "--serve", "--ring", "--tune", "--surface", "--raster", "--rulegen",
+  "--sweep", "--summary", "--montecarlo", "--simulate", "--graph",
+  "--delta", "--group-by", "--shadow", 0
+};
+
+// The options that apply to some modes only
+struct RunOption {
+  const char* option;
+  const char* modes; // the modes, space separated
+};
+
+static const RunOption modeOptions[] = {
+  { "--snapshot",       "rows --ring --surface --raster --delta "
+                        "--group-by --shadow" },
+  { "--epochs",         "--tune" },
+  { "--rate",           "--tune" },
+  { "--grid",           "--surface" },
+  { "--binary",         "--surface" },
+  { "--tile",           "--raster" },
+  { "--bins",           "--summary" },
+  { "--exceed",         "--summary" },
+  { "--top-rules",      "--summary" },
+  { "--samples",        "--montecarlo" },
+  { "--quantiles",      "--montecarlo" },
+  { "--seed",           "--montecarlo" },
+  { "--end-time",       "--simulate" },
+  { "--dt",             "--simulate" },
+  { "--control-period", "--simulate" },
+  { "--integrator",     "--simulate" },
+  { "--shadow-output",  "--shadow" },
+  { "--output-format",  "--delta" },
+  { 0, 0 }
+};
+
+//--------------------------------------------------------------
+// CheckOptions
+//
+// Purpose: Reject a command line with two run modes, or with an
+//          option the run mode does not use, rather than ignore it
+//
+// Arguments: options : the -- option names given, without =value
+//
+// Return: status
+//--------------------------------------------------------------
+static int CheckOptions( const vector< string >& options ) {
+
+  int    status = 0;
+  string mode   = "rows";
+
+  for ( unsigned int i = 0; i < options.size(); i++ ) {
+    for ( int m = 0; runModes[m]; m++ ) {
+      if ( options[i] != runModes[m] or options[i] == mode ) {
+	continue;
+      }
+      if ( mode != "rows" ) {
+	status = -1;
+	ErrMsg( mode + " is not available with", options[i], status );
+	return status;
+      }
+      mode = options[i];
+    }
+  }
+
+  for ( unsigned int i = 0; i < options.size(); i++ ) {
+    for ( int o = 0; modeOptions[o].option; o++ ) {
+      if ( options[i] != modeOptions[o].option ) {
+	continue;
+      }
+      string modes = string( " " ) + modeOptions[o].modes + " ";
+      if ( modes.find( " " + mode + " " ) == string::npos ) {
+	status = -1;
+	ErrMsg( options[i] + " is only available with",
+		modeOptions[o].modes, status );
+	return status;
+      }
+    }
+  }
+  return status;
+}
 
 int main( int argc, char* argv[] )
 {
@@ -18,6 +119,39 @@ int main( int argc, char* argv[] )
   string outputDataFileName; // Optional output data file
   string inputFileDelimeters;// Delimeters for data input file
   string inputDataLabel;     // Data input column name for row labels
+  string snapshotFileName;   // Optional binary model snapshot file
+  bool   graph = false;      // Run the FUNCTION_BLOCKs as a graph
+  string socketPath;         // Serve the FCL files on this socket
+  string ringName;           // Serve the FCL file on this shared memory ring
+  string tunedFCLFileName;   // Write the FCL file tuned to training data
+  string sweepFileName;      // Evaluate the variants of a sweep file
+  string surfaceBaseName;    // Write the control surfaces of the outputs
+  int    surfaceNX = FCL_SURFACE_POINTS;
+  int    surfaceNY = FCL_SURFACE_POINTS;
+  bool   surfaceBinary = false;
+  string noiseFileName;      // Monte Carlo evaluation with input noise
+  int    mcSamples = FCL_MC_SAMPLES;
+  unsigned long mcSeed = FCL_MC_SEED;
+  string mcQuantiles;
+  string plantName;          // Closed loop simulation with a plant
+  string simIntegratorName;
+  string partitionFileName;  // Generate a rule base from data
+  string shadowFCLFileName;  // Evaluate a candidate FCL file in shadow
+  string shadowOutputFileName;
+  string groupOrder;         // Process the rows as a series per label
+  string rasterBaseName;     // Evaluate raster inputs, write rasters
+  int    rasterTile = FCL_RASTER_TILE;
+  bool   summary = false;    // Write summary statistics, not rows
+  int    summaryBins     = FCL_SUMMARY_BINS;
+  int    summaryTopRules = FCL_SUMMARY_TOP_RULES;
+  string summaryExceed;
+  string deltaTolerance;     // Write only the rows where an output changed
+  string outputFormat = "text";
+  double simEndTime       = FCL_SIM_END_TIME;
+  double simTimeStep      = FCL_SIM_TIME_STEP;
+  double simControlPeriod = FCL_SIM_CONTROL_PERIOD;
+  int    tuneEpochs = FCL_TUNE_EPOCHS;
+  double tuneRate   = FCL_TUNE_RATE;
 
 #ifdef DEBUG
   ConsoleMsg("->", "RunFCL()", status);
@@ -40,6 +174,479 @@ int main( int argc, char* argv[] )
   // names must match those in the FCLFileName file.
   // Subsequent lines are list of input variable values.
   //
+  // Options start with -- and can be placed anywhere. At most one
+  // run mode is given, an option its mode does not use is an error,
+  // see CheckOptions():
+  //
+  //   --snapshot[=file] : load the parsed model from a binary
+  //                       snapshot, file defaults to fcl_file.snap
+  //   --graph           : run every FUNCTION_BLOCK in fcl_file as a
+  //                       dataflow graph, fcl_file can be a comma
+  //                       separated list of FCL files
+  //   --serve=socket    : RunFCL --serve=socket fcl_file [fcl_file ...]
+  //                       serve the FCL files on a Unix domain socket,
+  //                       see FuzzyServer.h for the protocol. Changed
+  //                       FCL files are reloaded.
+  //   --ring=name       : RunFCL --ring=/name fcl_file
+  //                       serve the FCL file on a shared memory ring,
+  //                       see FuzzyRing.h
+  //   --tune=out_fcl    : RunFCL --tune=out_fcl fcl_file training_data_file
+  //                       fit the term points and WITH weights of
+  //                       fcl_file to the training data, a column for
+  //                       each input and a target column for each
+  //                       output to fit, write the tuned FCL file
+  //   --epochs=N        : --tune passes over the training data
+  //   --rate=R          : --tune step, a fraction of each term span
+  //   --sweep=spec_file : RunFCL --sweep=spec_file fcl_file
+  //                       input_data_file summary_file
+  //                       [input_label input_file_delimeters]
+  //                       evaluate each variant of fcl_file in
+  //                       spec_file over the input data, write a
+  //                       summary row per variant, see FuzzySweep.h
+  //   --surface=base    : RunFCL --surface=base fcl_file x_input[:lo:hi]
+  //                       [y_input[:lo:hi]] [input=value ...]
+  //                       evaluate fcl_file over a grid of one or
+  //                       two inputs, the others fixed at value or
+  //                       the middle of their term span, write
+  //                       base.output.csv for each output
+  //   --grid=NX[,NY]    : --surface grid points, default 101
+  //   --binary          : --surface writes base.output.bin arrays
+  //                       of doubles and base.grid
+  //   --montecarlo=noise_file : RunFCL --montecarlo=noise_file fcl_file
+  //                       input_data_file output_data_file
+  //                       [input_label input_file_delimeters]
+  //                       evaluate each input row with the input
+  //                       noise of noise_file, write the mean,
+  //                       standard deviation and quantiles of each
+  //                       output, see FuzzyMonteCarlo.h
+  //   --samples=K       : --montecarlo evaluations per row, default 1000
+  //   --quantiles=q,... : --montecarlo quantiles, default 0.05,0.5,0.95
+  //   --seed=N          : --montecarlo random seed
+  //   --simulate=plant  : RunFCL --simulate=plant fcl_file scenario_file
+  //                       output_data_file 
+  //                       [input_label input_file_delimeters]
+  //                       run fcl_file in closed loop with a built-in
+  //                       plant (crane) for each scenario, write the
+  //                       settling time, overshoot and control
+  //                       effort, see FuzzySimulate.h
+  //   --end-time=T      : --simulate time, default 60
+  //   --dt=h            : --simulate integration step, default 0.01
+  //   --control-period=T: --simulate controller period, default 0.1
+  //   --integrator=name : --simulate euler, heun or rk4 (default)
+  //   --rulegen=partition_file : RunFCL --rulegen=partition_file 
+  //                       data_file out_fcl [input_file_delimeters]
+  //                       generate the rules of the variables and
+  //                       terms of partition_file from the data,
+  //                       write them as out_fcl, see FuzzyRuleGen.h
+  //   --shadow=candidate_fcl : evaluate candidate_fcl on each input row
+  //                       after fcl_file, write its outputs and the
+  //                       divergence from the fcl_file outputs, see
+  //                       FuzzyShadow.h
+  //   --shadow-output=file : --shadow output, default
+  //                       output_data_file.shadow
+  //   --group-by[=rows|groups] : process the rows of each
+  //                       input_label value as its own series, with
+  //                       its own NC output state, the groups in
+  //                       parallel. Write the rows in file order
+  //                       (rows, default) or group by group (groups),
+  //                       see FuzzyGroup.h
+  //   --raster=base     : RunFCL --raster=base fcl_file 
+  //                       input=raster_file [input=raster_file ...]
+  //                       evaluate fcl_file on each cell of the input
+  //                       rasters, write base.output.raster for each
+  //                       output, see FuzzyRaster.h
+  //   --tile=N          : --raster tile edge in cells, default 64
+  //   --summary         : RunFCL --summary fcl_file input_data_file
+  //                       summary_file [input_label
+  //                       input_file_delimeters]
+  //                       write the mean, std, min, max and histogram
+  //                       of each output, exceedance counts and the
+  //                       most fired rules, not the output rows, see
+  //                       FuzzySummary.h
+  //   --bins=N          : --summary histogram bins, default 20
+  //   --exceed=output:threshold[,output:threshold ...] :
+  //                       --summary rows with output above threshold
+  //   --top-rules=N     : --summary most fired rules, default 10,
+  //                       -1 for all
+  //   --delta=tolerance : write the index, label and outputs only at
+  //                       the rows where an output changed more than
+  //                       tolerance since the last row written, and
+  //                       the first and last rows, see FuzzyWriter.h
+  //   --output-format=text|binary : --delta row format, default text
+  //
+  // An input_data_file or output_data_file ending in .gz is read or
+  // written gzip compressed, the data streamed through its own
+  // thread, see FuzzyGzip.h
+  //
+  vector< string > args( 1, argv[0] );
+  vector< string > options; // the -- option names given
+  for ( int i = 1; i < argc; i++ ) {
+    string arg = argv[i];
+    if ( arg.compare( 0, 2, "--" ) != 0 ) {
+      args.push_back( arg );
+      continue;
+    }
+    options.push_back( arg.substr( 0, arg.find( '=' ) ) );
+
+    if ( arg == "--snapshot" ) {
+      snapshotFileName = "*";
+    }
+    else if ( arg.compare( 0, 11, "--snapshot=" ) == 0 ) {
+      snapshotFileName = arg.substr( 11 );
+    }
+    else if ( arg == "--graph" ) {
+      graph = true;
+    }
+    else if ( arg.compare( 0, 8, "--serve=" ) == 0 ) {
+      socketPath = arg.substr( 8 );
+    }
+    else if ( arg.compare( 0, 7, "--ring=" ) == 0 ) {
+      ringName = arg.substr( 7 );
+    }
+    else if ( arg.compare( 0, 7, "--tune=" ) == 0 ) {
+      tunedFCLFileName = arg.substr( 7 );
+    }
+    else if ( arg.compare( 0, 9, "--epochs=" ) == 0 ) {
+      tuneEpochs = atoi( arg.substr( 9 ).c_str() );
+    }
+    else if ( arg.compare( 0, 7, "--rate=" ) == 0 ) {
+      tuneRate = atof( arg.substr( 7 ).c_str() );
+    }
+    else if ( arg.compare( 0, 8, "--sweep=" ) == 0 ) {
+      sweepFileName = arg.substr( 8 );
+    }
+    else if ( arg.compare( 0, 10, "--surface=" ) == 0 ) {
+      surfaceBaseName = arg.substr( 10 );
+    }
+    else if ( arg.compare( 0, 7, "--grid=" ) == 0 ) {
+      string::size_type comma = arg.find( ',' );
+      surfaceNX = atoi( arg.substr( 7 ).c_str() );
+      surfaceNY = comma == string::npos ? 
+	surfaceNX : atoi( arg.substr( comma + 1 ).c_str() );
+    }
+    else if ( arg == "--binary" ) {
+      surfaceBinary = true;
+    }
+    else if ( arg.compare( 0, 13, "--montecarlo=" ) == 0 ) {
+      noiseFileName = arg.substr( 13 );
+    }
+    else if ( arg.compare( 0, 10, "--samples=" ) == 0 ) {
+      mcSamples = atoi( arg.substr( 10 ).c_str() );
+    }
+    else if ( arg.compare( 0, 12, "--quantiles=" ) == 0 ) {
+      mcQuantiles = arg.substr( 12 );
+    }
+    else if ( arg.compare( 0, 7, "--seed=" ) == 0 ) {
+      mcSeed = strtoul( arg.substr( 7 ).c_str(), 0, 10 );
+    }
+    else if ( arg.compare( 0, 11, "--simulate=" ) == 0 ) {
+      plantName = arg.substr( 11 );
+    }
+    else if ( arg.compare( 0, 11, "--end-time=" ) == 0 ) {
+      simEndTime = atof( arg.substr( 11 ).c_str() );
+    }
+    else if ( arg.compare( 0, 5, "--dt=" ) == 0 ) {
+      simTimeStep = atof( arg.substr( 5 ).c_str() );
+    }
+    else if ( arg.compare( 0, 17, "--control-period=" ) == 0 ) {
+      simControlPeriod = atof( arg.substr( 17 ).c_str() );
+    }
+    else if ( arg.compare( 0, 13, "--integrator=" ) == 0 ) {
+      simIntegratorName = arg.substr( 13 );
+    }
+    else if ( arg.compare( 0, 10, "--rulegen=" ) == 0 ) {
+      partitionFileName = arg.substr( 10 );
+    }
+    else if ( arg.compare( 0, 9, "--shadow=" ) == 0 ) {
+      shadowFCLFileName = arg.substr( 9 );
+    }
+    else if ( arg.compare( 0, 16, "--shadow-output=" ) == 0 ) {
+      shadowOutputFileName = arg.substr( 16 );
+    }
+    else if ( arg == "--summary" ) {
+      summary = true;
+    }
+    else if ( arg.compare( 0, 7, "--bins=" ) == 0 ) {
+      summaryBins = atoi( arg.substr( 7 ).c_str() );
+    }
+    else if ( arg.compare( 0, 9, "--exceed=" ) == 0 ) {
+      summaryExceed = arg.substr( 9 );
+    }
+    else if ( arg.compare( 0, 12, "--top-rules=" ) == 0 ) {
+      summaryTopRules = atoi( arg.substr( 12 ).c_str() );
+    }
+    else if ( arg.compare( 0, 8, "--delta=" ) == 0 ) {
+      deltaTolerance = arg.substr( 8 );
+    }
+    else if ( arg.compare( 0, 16, "--output-format=" ) == 0 ) {
+      outputFormat = arg.substr( 16 );
+    }
+    else if ( arg.compare( 0, 9, "--raster=" ) == 0 ) {
+      rasterBaseName = arg.substr( 9 );
+    }
+    else if ( arg.compare( 0, 7, "--tile=" ) == 0 ) {
+      rasterTile = atoi( arg.substr( 7 ).c_str() );
+    }
+    else if ( arg == "--group-by" ) {
+      groupOrder = "rows";
+    }
+    else if ( arg.compare( 0, 11, "--group-by=" ) == 0 ) {
+      groupOrder = arg.substr( 11 );
+      if ( groupOrder != "rows" and groupOrder != "groups" ) {
+	status = -1;
+	ErrMsg("--group-by is not rows or groups", groupOrder, status);
+	return status;
+      }
+    }
+    else {
+      status = -1;
+      ErrMsg("Unknown option", arg, status);
+      return status;
+    }
+  }
+  argc = args.size();
+
+  // One run mode, and only the options it uses
+  status = CheckOptions( options );
+  if ( status ) return status;
+
+  cout << FCL_VersionString();
+
+  //----------------------------------------------------------------
+  // Serve the FCL files until the process is stopped
+  if ( not socketPath.empty() ) {
+    if ( argc < 2 ) {
+      status = -1;
+      ErrMsg("Usage:", "RunFCL --serve=socket fcl_file [fcl_file ...]", 
+	     status);
+      return status;
+    }
+    FuzzyServerClass FuzzyServer( socketPath, 1000 );
+    for ( int i = 1; i < argc; i++ ) {
+      status = FuzzyServer.AddModel( args[i] );
+      if ( status ) return status;
+    }
+    status = FuzzyServer.Serve();
+    return status;
+  }
+
+  //----------------------------------------------------------------
+  // Serve the FCL file on a shared memory ring until stopped
+  if ( not ringName.empty() ) {
+    if ( argc != 2 ) {
+      status = -1;
+      ErrMsg("Usage:", "RunFCL --ring=/name fcl_file", status);
+      return status;
+    }
+    FuzzyControlClass FuzzyControl( args[1], "", "" );
+    FuzzyControl.SnapshotFile() = snapshotFileName == "*" ? 
+      args[1] + ".snap" : snapshotFileName;
+    status = FuzzyControl_ReadFCL( &FuzzyControl );
+    if ( status ) return status;
+
+    FuzzyRingClass FuzzyRing;
+    status = FuzzyRing.Create( ringName, FuzzyControl.NumInputs(),
+			       FuzzyControl.NumOutputs(), FCL_RING_CAPACITY );
+    if ( status ) return status;
+
+    for ( int i = 0; i < FuzzyControl.NumInputs(); i++ ) {
+      ConsoleMsg( "Ring input", 
+		  FuzzyControl.InputVariablesVector()[i]->varName, i );
+    }
+    for ( int i = 0; i < FuzzyControl.NumOutputs(); i++ ) {
+      ConsoleMsg( "Ring output", 
+		  FuzzyControl.OutputVariablesVector()[i]->varName, i );
+    }
+    // Run the controller until SIGINT or SIGTERM, then remove the ring
+    sigset_t stopSignals;
+    sigemptyset( &stopSignals );
+    sigaddset( &stopSignals, SIGINT );
+    sigaddset( &stopSignals, SIGTERM );
+    pthread_sigmask( SIG_BLOCK, &stopSignals, 0 );
+
+    status = FuzzyRing.Start( &FuzzyControl );
+    if ( status ) return status;
+
+    int stopSignal = 0;
+    sigwait( &stopSignals, &stopSignal );
+    FuzzyRing.Close();
+    return status;
+  }
+
+  //----------------------------------------------------------------
+  // Tune the FCL file to the training data and write it
+  if ( not tunedFCLFileName.empty() ) {
+    if ( argc != 3 ) {
+      status = -1;
+      ErrMsg("Usage:", "RunFCL --tune=out_fcl [--epochs=N] [--rate=R] "
+	     "fcl_file training_data_file", status);
+      return status;
+    }
+    FuzzyControlClass FuzzyControl( args[1], "", "" );
+    status = FuzzyControl_ReadFCL( &FuzzyControl );
+    if ( status ) return status;
+
+    FuzzyTuneClass FuzzyTune( &FuzzyControl );
+    FuzzyTune.Epochs() = tuneEpochs;
+    FuzzyTune.Rate()   = tuneRate;
+    string delimeters  = ",";
+    int numSamples = FuzzyTune.ReadTrainingFile( &args[2], &delimeters );
+    if ( numSamples < 1 ) return -1;
+    ConsoleMsg( "Training samples", args[2], numSamples );
+
+    status = FuzzyTune.Tune();
+    if ( status ) return status;
+
+    status = FuzzyControl.WriteFCLFile( &tunedFCLFileName );
+    if ( status ) return status;
+    ConsoleMsg( "Wrote tuned FCL file", tunedFCLFileName, status );
+    return status;
+  }
+
+  //----------------------------------------------------------------
+  // Evaluate the FCL file over a grid of inputs, write the surfaces
+  if ( not surfaceBaseName.empty() ) {
+    if ( argc < 3 ) {
+      status = -1;
+      ErrMsg("Usage:", "RunFCL --surface=base [--grid=NX[,NY]] [--binary] "
+	     "fcl_file x_input[:lo:hi] [y_input[:lo:hi]] [input=value ...]",
+	     status);
+      return status;
+    }
+    FuzzyControlClass FuzzyControl( args[1], "", "" );
+    FuzzyControl.SnapshotFile() = snapshotFileName == "*" ? 
+      args[1] + ".snap" : snapshotFileName;
+    status = FuzzyControl_ReadFCL( &FuzzyControl );
+    if ( status ) return status;
+
+    FuzzySurfaceClass FuzzySurface( &FuzzyControl );
+    int axis = 0;
+    for ( int i = 2; i < argc; i++ ) {
+      vector< string > fields;
+      string::size_type equals = args[i].find( '=' );
+      if ( equals != string::npos ) {
+	status = FuzzySurface.SetFixedInput( args[i].substr( 0, equals ),
+			       atof( args[i].substr( equals + 1 ).c_str() ) );
+      }
+      else if ( axis < 2 ) {
+	string delimeters = ":";
+	FuzzyControl.SplitLine( &fields, &args[i], &delimeters );
+	double lower = 0., upper = 0.;
+	if ( fields.size() == 3 ) {
+	  lower = atof( fields[1].c_str() );
+	  upper = atof( fields[2].c_str() );
+	}
+	status = FuzzySurface.SetAxis( axis, fields[0], 
+				       axis == 0 ? surfaceNX : surfaceNY,
+				       lower, upper );
+	axis++;
+      }
+      else {
+	status = -1;
+	ErrMsg("Surface has more than two axes", args[i], status);
+      }
+      if ( status ) return status;
+    }
+
+    status = FuzzySurface.Evaluate();
+    if ( status ) return status;
+
+    if ( surfaceBinary ) {
+      status = FuzzySurface.WriteBinary( &surfaceBaseName );
+    }
+    else {
+      status = FuzzySurface.WriteCSV( &surfaceBaseName );
+    }
+    if ( status ) return status;
+    ConsoleMsg( "Wrote surfaces", surfaceBaseName, 
+		FuzzySurface.NumX() * FuzzySurface.NumY() );
+    return status;
+  }
+
+  //----------------------------------------------------------------
+  // Evaluate the FCL file on each cell of the input rasters
+  if ( not rasterBaseName.empty() ) {
+    if ( argc < 3 ) {
+      status = -1;
+      ErrMsg("Usage:", "RunFCL --raster=base [--tile=N] fcl_file "
+	     "input=raster_file [input=raster_file ...]", status);
+      return status;
+    }
+    FuzzyControlClass FuzzyControl( args[1], "", "" );
+    FuzzyControl.SnapshotFile() = snapshotFileName == "*" ? 
+      args[1] + ".snap" : snapshotFileName;
+    status = FuzzyControl_ReadFCL( &FuzzyControl );
+    if ( status ) return status;
+
+    FuzzyRasterClass FuzzyRaster( &FuzzyControl );
+    FuzzyRaster.TileSize() = rasterTile;
+    for ( int i = 2; i < argc; i++ ) {
+      string::size_type equals = args[i].find( '=' );
+      if ( equals == string::npos ) {
+	status = -1;
+	ErrMsg("Raster input is not input=raster_file", args[i], status);
+	return status;
+      }
+      status = FuzzyRaster.SetInput( args[i].substr( 0, equals ),
+				     args[i].substr( equals + 1 ) );
+      if ( status ) return status;
+    }
+
+    status = FuzzyRaster.Evaluate( rasterBaseName );
+    FuzzyRaster.Close();
+    if ( status ) return status;
+    ConsoleMsg( "Wrote rasters", rasterBaseName, FuzzyRaster.NumCells() );
+    if ( FuzzyRaster.NumNoData() or FuzzyRaster.NumFailed() ) {
+      ConsoleMsg( "Raster cells without data", rasterBaseName,
+		  FuzzyRaster.NumNoData() );
+      ConsoleMsg( "Raster cells failed", rasterBaseName,
+		  FuzzyRaster.NumFailed() );
+    }
+    return status;
+  }
+
+  //----------------------------------------------------------------
+  // Generate a rule base from data, write it as an FCL file
+  if ( not partitionFileName.empty() ) {
+    if ( argc < 3 or argc > 4 ) {
+      status = -1;
+      ErrMsg("Usage:", "RunFCL --rulegen=partition_file data_file out_fcl "
+	     "[input_file_delimeters]", status);
+      return status;
+    }
+    string delimeters = argc > 3 ? args[3] : ",";
+
+    FuzzyRuleGenClass FuzzyRuleGen;
+    if ( FuzzyRuleGen.ReadPartitionFile( &partitionFileName ) < 1 ) {
+      return -1;
+    }
+    int numRows = FuzzyRuleGen.ReadDataFile( &args[1], &delimeters );
+    if ( numRows < 1 ) return -1;
+    ConsoleMsg( "Rule data rows", args[1], numRows );
+
+    status = FuzzyRuleGen.Generate();
+    if ( status ) return status;
+
+    // FUNCTION_BLOCK name from the file name
+    string blockName = args[2].substr( args[2].find_last_of( '/' ) + 1 );
+    blockName = blockName.substr( 0, blockName.find( '.' ) );
+    for ( unsigned int i = 0; i < blockName.length(); i++ ) {
+      if ( not isalnum( blockName[i] ) ) blockName[i] = '_';
+    }
+    if ( blockName.empty() or isdigit( blockName[0] ) ) {
+      blockName = "FB_" + blockName;
+    }
+    status = FuzzyRuleGen.WriteFCLFile( &args[2], blockName );
+    if ( status ) return status;
+
+    // Check that the rule base parses
+    FuzzyControlClass FuzzyControl( args[2], "", "" );
+    status = FuzzyControl_ReadFCL( &FuzzyControl );
+    if ( status ) return status;
+    ConsoleMsg( "Wrote rules", args[2], FuzzyControl.NumRules() );
+    return status;
+  }
+
   if ( argc < 2 ) {
     ConsoleMsg("No input files specified", 
 	       "Using test.fcl, test.in, test.out", status);
@@ -50,28 +657,202 @@ int main( int argc, char* argv[] )
   else {
     if ( argc < 4 ) {
       status = -1;
-      ErrMsg("Usage:", "RunFCL fcl_file input_data_file "
-	     "output_data_file [input_label input_file_delimeters]", status);
+      ErrMsg("Usage:", "RunFCL [--snapshot[=file]] [--graph] fcl_file "
+	     "input_data_file output_data_file [input_label input_file_delimeters]", status);
       return status;  
     }
 
-    FCLFileName        = argv[1];
-    inputDataFileName  = argv[2];
-    outputDataFileName = argv[3];
+    FCLFileName        = args[1];
+    inputDataFileName  = args[2];
+    outputDataFileName = args[3];
 
     // Handle optional parameters
     if ( argc > 4 ) {
-      inputDataLabel = argv[4];
+      inputDataLabel = args[4];
     }
 
     if ( argc > 5 ) {
-      inputFileDelimeters = argv[5];
+      inputFileDelimeters = args[5];
     }
     else {
       inputFileDelimeters = ",";  // = " ,\t;:";
     }
   }
 
+  //----------------------------------------------------------------
+  // Evaluate the variants of the sweep file, write the summary
+  if ( not sweepFileName.empty() ) {
+    FuzzyControlClass FuzzyControl( FCLFileName, 
+				    inputFileDelimeters,
+				    inputDataLabel );
+    status = FuzzyControl_ReadFCL( &FuzzyControl );
+    if ( status ) return status;
+
+    FuzzySweepClass FuzzySweep( &FuzzyControl );
+    int numVariants = FuzzySweep.ReadSweepFile( &sweepFileName );
+    if ( numVariants < 1 ) return -1;
+    ConsoleMsg( "Sweep variants", sweepFileName, numVariants );
+
+    if ( FuzzySweep.ReadInputDataFile( &inputDataFileName ) < 1 ) return -1;
+
+    status = FuzzySweep.Sweep();
+    if ( status ) return status;
+
+    status = FuzzySweep.WriteSummary( &outputDataFileName );
+    if ( status ) return status;
+    ConsoleMsg( "Wrote sweep summary", outputDataFileName, status );
+    return status;
+  }
+
+  //----------------------------------------------------------------
+  // Evaluate the input rows, write only the summary statistics
+  if ( summary ) {
+    FuzzyControlClass FuzzyControl( FCLFileName, 
+				    inputFileDelimeters,
+				    inputDataLabel );
+    status = FuzzyControl_ReadFCL( &FuzzyControl );
+    if ( status ) return status;
+
+    FuzzySummaryClass FuzzySummary( &FuzzyControl );
+    FuzzySummary.Bins() = summaryBins;
+    if ( not summaryExceed.empty() ) {
+      vector< string > fields;
+      string delimeters = ",";
+      FuzzyControl.SplitLine( &fields, &summaryExceed, &delimeters );
+      for ( unsigned int i = 0; i < fields.size(); i++ ) {
+	string::size_type colon = fields[i].find( ':' );
+	if ( colon == string::npos ) {
+	  status = -1;
+	  ErrMsg("--exceed is not output:threshold", fields[i], status);
+	  return status;
+	}
+	status = FuzzySummary.AddExceedance( fields[i].substr( 0, colon ),
+			   atof( fields[i].substr( colon + 1 ).c_str() ) );
+	if ( status ) return status;
+      }
+    }
+    if ( FuzzySummary.ReadInputDataFile( &inputDataFileName ) < 1 ) {
+      return -1;
+    }
+
+    status = FuzzySummary.Run();
+    if ( status ) return status;
+
+    status = FuzzySummary.WriteSummary( &outputDataFileName, 
+					summaryTopRules );
+    if ( status ) return status;
+    ConsoleMsg( "Wrote summary", outputDataFileName, 
+		FuzzySummary.NumRows() );
+    return status;
+  }
+
+  //----------------------------------------------------------------
+  // Evaluate the input rows with input noise, write the statistics
+  if ( not noiseFileName.empty() ) {
+    FuzzyControlClass FuzzyControl( FCLFileName, 
+				    inputFileDelimeters,
+				    inputDataLabel );
+    status = FuzzyControl_ReadFCL( &FuzzyControl );
+    if ( status ) return status;
+
+    FuzzyMonteCarloClass FuzzyMonteCarlo( &FuzzyControl );
+    FuzzyMonteCarlo.Samples() = mcSamples;
+    FuzzyMonteCarlo.Seed()    = mcSeed;
+    if ( not mcQuantiles.empty() ) {
+      vector< string > fields;
+      string delimeters = ",";
+      FuzzyControl.SplitLine( &fields, &mcQuantiles, &delimeters );
+      FuzzyMonteCarlo.Quantiles().clear();
+      for ( unsigned int i = 0; i < fields.size(); i++ ) {
+	FuzzyMonteCarlo.Quantiles().push_back( atof( fields[i].c_str() ) );
+      }
+    }
+    if ( FuzzyMonteCarlo.ReadNoiseFile( &noiseFileName ) < 1 ) return -1;
+    if ( FuzzyMonteCarlo.ReadInputDataFile( &inputDataFileName ) < 1 ) {
+      return -1;
+    }
+
+    status = FuzzyMonteCarlo.Run();
+    if ( status ) return status;
+
+    status = FuzzyMonteCarlo.WriteOutput( &outputDataFileName );
+    if ( status ) return status;
+    ConsoleMsg( "Wrote Monte Carlo output", outputDataFileName, 
+		FuzzyMonteCarlo.NumRows() );
+    return status;
+  }
+
+  //----------------------------------------------------------------
+  // Run the closed loop scenarios, write the results
+  if ( not plantName.empty() ) {
+    FuzzyPlant plant;
+    status = FCL_FindPlant( plantName, &plant );
+    if ( status ) return status;
+
+    FuzzyControlClass FuzzyControl( FCLFileName, 
+				    inputFileDelimeters,
+				    inputDataLabel );
+    status = FuzzyControl_ReadFCL( &FuzzyControl );
+    if ( status ) return status;
+
+    FuzzySimulateClass FuzzySimulate( &FuzzyControl, plant );
+    FuzzySimulate.EndTime()       = simEndTime;
+    FuzzySimulate.TimeStep()      = simTimeStep;
+    FuzzySimulate.ControlPeriod() = simControlPeriod;
+    if ( simIntegratorName == "euler" ) {
+      FuzzySimulate.Integrator() = SimEuler;
+    }
+    else if ( simIntegratorName == "heun" ) {
+      FuzzySimulate.Integrator() = SimHeun;
+    }
+    else if ( not simIntegratorName.empty() and 
+	      simIntegratorName != "rk4" ) {
+      status = -1;
+      ErrMsg("Unknown integrator", simIntegratorName, status);
+      return status;
+    }
+
+    if ( FuzzySimulate.ReadScenarioFile( &inputDataFileName ) < 1 ) {
+      return -1;
+    }
+    status = FuzzySimulate.Simulate();
+    if ( status ) return status;
+
+    status = FuzzySimulate.WriteResults( &outputDataFileName );
+    if ( status ) return status;
+    ConsoleMsg( "Wrote simulation results", outputDataFileName, 
+		FuzzySimulate.NumScenarios() );
+    return status;
+  }
+
+  //----------------------------------------------------------------
+  // Run the FUNCTION_BLOCKs of the FCL files as a dataflow graph
+  if ( graph ) {
+    FuzzyGraphClass FuzzyGraph( inputFileDelimeters, inputDataLabel );
+    vector< string > FCLFiles;
+    string delimeters = ",";
+    FuzzyControlClass::SplitLine( &FCLFiles, &FCLFileName, &delimeters );
+
+    status = FuzzyControl_GraphReadFCL( &FuzzyGraph, &FCLFiles );
+    if ( status ) return status;
+
+    int numPointsRead = 0;
+    status = FuzzyControl_GraphIO_Files( &FuzzyGraph, &inputDataFileName,
+					 &outputDataFileName, &numPointsRead );
+    if ( status ) return status;
+
+    status = FuzzyControl_GraphSeriesInput( &FuzzyGraph, numPointsRead );
+    if ( status ) return status;
+
+    status = FuzzyControl_GraphCloseOutputFile( &FuzzyGraph );
+    if ( status ) return status;
+
+    string Msg = "Processed " + FCLFileName + " with input " + 
+      inputDataFileName + " status";
+    ConsoleMsg( "RunFCL", Msg, status );
+    return status;
+  }
+
   //----------------------------------------------------------------
   // Instantiate the main FuzzyControlClass, initialize keywords map
   FuzzyControlClass *lpFC = 0;
@@ -80,6 +861,11 @@ int main( int argc, char* argv[] )
 				  inputDataLabel );
   lpFC = &FuzzyControl;
 
+  if ( snapshotFileName == "*" ) {
+    snapshotFileName = FCLFileName + ".snap";
+  }
+  lpFC->SnapshotFile() = snapshotFileName;
+
   // Open the FCL file. Parse the FCL file and create/initialize
   // the FuzzyControl data structures
   status = FuzzyControl_ReadFCL( lpFC );
@@ -87,13 +873,88 @@ int main( int argc, char* argv[] )
 
   // Read in the timeseries data file, open an output data file
   int numPointsRead = 0;
-  status = FuzzyControl_IO_Files( lpFC, &inputDataFileName,
-				  &outputDataFileName, &numPointsRead );
+  if ( not deltaTolerance.empty() ) {
+    // The delta output has its own writer
+    string noOutputFile;
+    status = FuzzyControl_IO_Files( lpFC, &inputDataFileName,
+				    &noOutputFile, &numPointsRead );
+  }
+  else {
+    status = FuzzyControl_IO_Files( lpFC, &inputDataFileName,
+				    &outputDataFileName, &numPointsRead );
+  }
   if ( status ) return status;
 
   // Run the FuzzyControl on the input data, write output data
-  status = FuzzyControl_SeriesInput( lpFC, numPointsRead );
-  if ( status ) return status;
+  if ( not deltaTolerance.empty() ) {
+    // The rows where an output changed
+    FuzzyWriter writer;
+    status = FCL_FindWriter( outputFormat, &writer );
+    if ( status ) return status;
+
+    FuzzyDeltaClass FuzzyDelta( lpFC, writer );
+    FuzzyDelta.Tolerance() = atof( deltaTolerance.c_str() );
+    status = FuzzyDelta.Open( &outputDataFileName );
+    if ( status ) return status;
+
+    status = FuzzyControl_DeltaSeriesInput( lpFC, &FuzzyDelta, 
+					    numPointsRead );
+    int closeStatus = FuzzyDelta.Close();
+    if ( status ) return status;
+    if ( closeStatus ) return closeStatus;
+    ConsoleMsg( "Delta rows written", outputDataFileName, 
+		FuzzyDelta.NumWritten() );
+  }
+  else if ( not groupOrder.empty() ) {
+    // A series per input label, the groups in parallel
+    if ( inputDataLabel.empty() ) {
+      status = -1;
+      ErrMsg("Usage:", "RunFCL --group-by[=rows|groups] fcl_file "
+	     "input_data_file output_data_file input_label "
+	     "[input_file_delimeters]", status);
+      return status;
+    }
+    FuzzyGroupClass FuzzyGroup( lpFC );
+    status = FuzzyGroup.Partition( numPointsRead );
+    if ( status ) return status;
+
+    status = FuzzyGroup.Run();
+    if ( status ) return status;
+
+    status = FuzzyGroup.WriteOutput( groupOrder == "groups" );
+    if ( status ) return status;
+    ConsoleMsg( "Processed label groups", inputDataLabel, 
+		FuzzyGroup.NumGroups() );
+  }
+  else if ( shadowFCLFileName.empty() ) {
+    status = FuzzyControl_SeriesInput( lpFC, numPointsRead );
+    if ( status ) return status;
+  }
+  else {
+    // The candidate model, evaluated after the production model
+    FuzzyControlClass Candidate( shadowFCLFileName, 
+				 inputFileDelimeters,
+				 inputDataLabel );
+    status = FuzzyControl_ReadFCL( &Candidate );
+    if ( status ) return status;
+
+    FuzzyShadowClass FuzzyShadow( lpFC, &Candidate );
+    status = FuzzyShadow.Link();
+    if ( status ) return status;
+
+    if ( shadowOutputFileName.empty() ) {
+      shadowOutputFileName = outputDataFileName + ".shadow";
+    }
+    status = FuzzyShadow.OpenOutputFile( &shadowOutputFileName );
+    if ( status ) return status;
+
+    status = FuzzyControl_ShadowSeriesInput( lpFC, &FuzzyShadow, 
+					     numPointsRead );
+    FuzzyShadow.CloseOutputFile();
+    FuzzyShadow.WriteStatistics();
+    ConsoleMsg( "Wrote shadow output", shadowOutputFileName, 0 );
+    if ( status ) return status;
+  }
 
   // Close the output file
   status = FuzzyControl_CloseOutputFile( lpFC );